@@ -0,0 +1,57 @@
+/**
+ * @file BayConfig.cpp
+ * @brief 充電ベイのハードウェア構成
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ */
+
+#include "BayConfig.h"
+
+#include "pinConfig.h"
+
+/**
+ * ベイごとの構成（ベイ番号の順）。
+ * PWMチャンネルは2チャンネルごとにタイマを共有するため、サーボごとに
+ * 別のタイマとなるよう偶数番を割り当てる
+ */
+static const BayConfig BAYS[BAY_NUM] = {
+    {0, SERVO_CATCH_PIN, SERVO_USB_PIN, CHARGE_CONTROL_PIN, INA_ADDRESS, 0, 2},
+#if BAY_NUM > 1
+    {1, SERVO_CATCH_PIN_1, SERVO_USB_PIN_1, CHARGE_CONTROL_PIN_1,
+     INA_ADDRESS_1, 4, 6},
+#endif
+};
+
+/**
+ * @brief ベイごとのNVSの名前空間を取得する
+ *
+ * @details ベイ0は従来の名前空間をそのまま使い、単一ベイ時の保存値を引き継ぐ。
+ * NVSに保存するクラス（ServoCalibration・ServoStallDetector・ChargePolicy・
+ * TraceRecorder）はクラス定数NAMESPACEを基本名とし、生成時にこの関数で
+ * ベイごとの名前空間を決める。そのうちコンストラクタでNVSを読み込むクラスは
+ * NVSの初期化後（setup()以降）に生成すること
+ *
+ * @param base 名前空間（例: "servo"）
+ * @return String ベイ0は base、それ以外は base にベイ番号を付けたもの
+ */
+String BayConfig::getNamespace(const char *base) const {
+  return id == 0 ? String(base) : String(base) + String(id);
+}
+
+/**
+ * @brief ベイ数を取得する
+ *
+ * @return uint8_t ベイ数
+ */
+uint8_t BayConfig::getNum(void) { return BAY_NUM; }
+
+/**
+ * @brief ベイの構成を取得する
+ *
+ * @param bay ベイ番号
+ * @return const BayConfig* 構成（範囲外ならNULL）
+ */
+const BayConfig *BayConfig::get(uint8_t bay) {
+  return bay < BAY_NUM ? &BAYS[bay] : NULL;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file BayConfig.h
+ * @brief 充電ベイのハードウェア構成
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 1台のマイコンで複数の充電ベイ（サーボ2個・MOSFET・INA219の組）を
+ * 制御するための、ベイごとのピン番号・I2Cアドレス・PWMチャンネル。
+ * ベイ数はビルドフラグBAY_NUM（既定1）で指定し、ピン番号はpinConfig.hで
+ * 定義する。INA219は全ベイで1本のI2Cバスを共有し、アドレスで区別する
+ */
+
+#pragma once
+#include <Arduino.h>
+
+struct BayConfig {
+  /** ベイ番号（0から） */
+  uint8_t id;
+  /** 捕獲サーボのピン番号 */
+  uint8_t servoCatchPin;
+  /** USBサーボのピン番号 */
+  uint8_t servoUsbPin;
+  /** MOSFETのピン番号 */
+  uint8_t chargeControlPin;
+  /** INA219のI2Cアドレス */
+  uint8_t inaAddress;
+  /** 捕獲サーボのPWMチャンネル */
+  uint8_t servoCatchChannel;
+  /** USBサーボのPWMチャンネル */
+  uint8_t servoUsbChannel;
+
+  String getNamespace(const char *) const;
+  static uint8_t getNum(void);
+  static const BayConfig *get(uint8_t);
+};
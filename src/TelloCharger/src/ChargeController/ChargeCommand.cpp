@@ -0,0 +1,86 @@
+/**
+ * @file ChargeCommand.cpp
+ * @brief 充電制御へのコマンド
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ */
+
+#include "ChargeCommand.h"
+
+#include <string.h>
+
+const uint8_t ChargeCommand::REQUEST_ID_SIZE;
+const uint8_t ChargeCommand::PROFILE_DEFAULT;
+
+/**
+ * @brief Construct a new Charge Command:: Charge Command object
+ *
+ */
+ChargeCommand::ChargeCommand()
+    : ChargeCommand(COMMAND_STOP_CHARGE, SOURCE_INTERNAL) {}
+
+/**
+ * @brief Construct a new Charge Command:: Charge Command object
+ *
+ * @param type コマンドの種類
+ * @param source 送信元
+ * @param requestId リクエストID（REQUEST_ID_SIZE以上は切り詰める）
+ */
+ChargeCommand::ChargeCommand(CommandType type, SourceType source,
+                             const char *requestId)
+    : type(type),
+      source(source),
+      catchCnt(0),
+      retryCnt(0),
+      profile(PROFILE_DEFAULT),
+      targetSoc(100),
+      time(0) {
+  strncpy(this->requestId, requestId != NULL ? requestId : "",
+          REQUEST_ID_SIZE - 1);
+  this->requestId[REQUEST_ID_SIZE - 1] = '\0';
+}
+
+/**
+ * @brief コマンドの名前を取得する
+ *
+ * @param type コマンドの種類
+ * @return const char* 名前
+ */
+const char *ChargeCommand::getName(CommandType type) {
+  switch (type) {
+    case COMMAND_START_CHARGE:
+      return "startCharge";
+    case COMMAND_STOP_CHARGE:
+      return "stopCharge";
+    case COMMAND_POWER_ON_DRONE:
+      return "powerOnDrone";
+    case COMMAND_CALIBRATE:
+      return "calibrate";
+    case COMMAND_SET_TARGET_SOC:
+      return "setTargetSoc";
+    default:
+      return "unknown";
+  }
+}
+
+/**
+ * @brief 送信元の名前を取得する
+ *
+ * @param source 送信元
+ * @return const char* 名前
+ */
+const char *ChargeCommand::getSourceName(SourceType source) {
+  switch (source) {
+    case SOURCE_INTERNAL:
+      return "internal";
+    case SOURCE_HTTP:
+      return "http";
+    case SOURCE_MQTT:
+      return "mqtt";
+    case SOURCE_BUTTON:
+      return "button";
+    default:
+      return "unknown";
+  }
+}
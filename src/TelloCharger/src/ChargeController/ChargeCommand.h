@@ -0,0 +1,70 @@
+/**
+ * @file ChargeCommand.h
+ * @brief 充電制御へのコマンド
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details WebAPI・MQTT・ボタンなどから充電制御へ渡すコマンド。
+ * タスク間のキューで受け渡すため、固定長のデータのみを持つ
+ */
+
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief 充電制御へのコマンド
+ */
+struct ChargeCommand {
+  typedef enum eCommand {
+    /** 充電開始 */
+    COMMAND_START_CHARGE,
+    /** 充電停止 */
+    COMMAND_STOP_CHARGE,
+    /** ドローン電源ON */
+    COMMAND_POWER_ON_DRONE,
+    /** アーム角度キャリブレーション */
+    COMMAND_CALIBRATE,
+    /** リリースする充電率の設定 */
+    COMMAND_SET_TARGET_SOC,
+    COMMAND_TYPE_NUM,
+  } CommandType;
+
+  typedef enum eSource {
+    /** 制御ループ内部 */
+    SOURCE_INTERNAL,
+    /** WebAPI */
+    SOURCE_HTTP,
+    /** MQTT */
+    SOURCE_MQTT,
+    /** 本体のボタン */
+    SOURCE_BUTTON,
+    SOURCE_TYPE_NUM,
+  } SourceType;
+
+  /** リクエストIDの最大長（終端文字を含む） */
+  static const uint8_t REQUEST_ID_SIZE = 40;
+  /** 充電プロファイルの指定なし（既定のプロファイルで充電する） */
+  static const uint8_t PROFILE_DEFAULT = 0xFF;
+
+  ChargeCommand();
+  ChargeCommand(CommandType, SourceType, const char *requestId = "");
+  static const char *getName(CommandType);
+  static const char *getSourceName(SourceType);
+
+  /** コマンドの種類 */
+  CommandType type;
+  /** 送信元 */
+  SourceType source;
+  /** 捕獲繰り返し回数（充電開始のみ。0なら既定値） */
+  uint8_t catchCnt;
+  /** USB接続までの動作をリトライする回数（充電開始のみ） */
+  uint8_t retryCnt;
+  /** 充電プロファイル（充電開始のみ。ChargePolicy::ProfileTypeの値） */
+  uint8_t profile;
+  /** リリースする充電率[%]（充電率の設定のみ） */
+  uint8_t targetSoc;
+  /** 受付時刻[us] */
+  uint32_t time;
+  /** リクエストID（MQTTのreq_idなど。なければ空文字） */
+  char requestId[REQUEST_ID_SIZE];
+};
@@ -8,31 +8,74 @@
  */
 
 #include "ChargeController.h"
-#include "pinConfig.h"
 
 #include <Log.h>
 
-// この電流[mA]より大きければ充電中
-const float ChargeController::CHARGE_CURRENT_CHARGING_THREASHOLD = 100.0;
-// この電流[mA]より小さくなると充電を終了する
-const float ChargeController::CHARGE_CURRENT_STOP_THREASHOLD = 200.0;
+// この電流[mA]より小さくなればバッテリは満充電（充電率推定の基準。
+// 充電を終了する電流はプロファイルで設定する）
+const float ChargeController::FULL_CHARGE_CURRENT = 200.0;
+// ループ処理時間の最大値をログ出力する周期[ms]
+const uint32_t ChargeController::LOOP_TIME_LOG_CYCLE = 10000;
+// 充電開始からこの時間[ms]が経過すれば定常充電とみなす
+const uint32_t ChargeController::STEADY_CHARGE_TIME = 30000;
+// バッテリ容量[mAh]（Tello純正バッテリの公称値）
+const float ChargeController::BATTERY_CAPACITY = 1100.0;
+// 充電電流の移動平均フィルタの更新周期[ms]
+const uint32_t ChargeController::CURRENT_CYCLE_TIME = 200;
 
 /**
  * @brief Construct a new Servo Controller:: Servo Controller object
  *
+ * @param bay 充電ベイの構成
+ * @param scheduler 制御ループのスケジューラ（全ベイで共有）
+ * @param bus 電流センサのI2Cバス（全ベイで共有）
  */
-ChargeController::ChargeController()
-    : _servo(ServoController(SERVO_CATCH_PIN, SERVO_USB_PIN)),
-      _fet(FETController(CHARGE_CONTROL_PIN)),
-      _current(CurrentReader(200)),
+ChargeController::ChargeController(const BayConfig &bay,
+                                   ControlScheduler *scheduler, I2cBus *bus)
+    : _bay(bay),
+      _scheduler(scheduler),
+      _mailbox(),
+      _servo(bay),
+      _fet(FETController(bay.chargeControlPin)),
+      _current(bus, bay.inaAddress, CURRENT_CYCLE_TIME),
+      _policy(bay),
+      _profileType(_policy.getDefault()),
+      _profile(_policy.getProfile(_profileType)),
       _chargeTimer(Timer()),
-      _controlStartCharge(
-          ControlStartCharge(&_servo, &_fet, &_current, &_chargeTimer)),
-      _controlStopCharge(
-          ControlStopCharge(&_servo, &_fet, &_current, &_chargeTimer)),
-      _controlPowerOnDrone(
-          ControlPowerOnDrone(&_servo, &_fet, &_current, &_chargeTimer)),
-      _checkServoCurrent(CheckServoCurrent(&_servo, &_fet, &_current)) {}
+      _estimator(FULL_CHARGE_CURRENT, BATTERY_CAPACITY),
+      _session(),
+      _queue(),
+      _targetSoc(_profile.targetSoc),
+      _maxLoopTime(0),
+      _profiler(),
+      _loopTimeLogTimer(Timer(LOOP_TIME_LOG_CYCLE)),
+      _chargeStatsTimer(Timer(CURRENT_CYCLE_TIME)),
+      _resetSessionStats(false),
+      _requestedStopCharge(false),
+      _controlStartCharge(&_servo, &_fet, &_current, &_chargeTimer),
+      _controlStopCharge(&_servo, &_fet, &_current, &_chargeTimer),
+      _controlPowerOnDrone(&_servo, &_fet, &_current, &_chargeTimer),
+      _controlCalibrate(&_servo, &_fet, &_current, &_chargeTimer),
+      _checkServoCurrent(&_servo, &_fet, &_current, bay),
+      _trace(&_servo, &_fet, &_current, bay),
+      _wasCatchReached(true),
+      _wasUsbReached(true),
+      _wasUsbClear(true),
+      _wasServoMoving(false),
+      _wasFetOn(false),
+      _lastMoveId(_servo.getMoveId()),
+      _isCommandPending(false),
+      _executedCommandCount(0),
+      _snapshot(),
+      _commandTime(0),
+      _commandMoveId(0) {
+  _current.setScheduler(_scheduler);
+  _trace.addControl(&_controlStartCharge);
+  _trace.addControl(&_controlStopCharge);
+  _trace.addControl(&_controlPowerOnDrone);
+  _trace.addControl(&_controlCalibrate);
+  _trace.addControl(&_checkServoCurrent);
+}
 
 /**
  * @brief Destroy the Servo Controller:: Servo Controller object
@@ -40,6 +83,34 @@ ChargeController::ChargeController()
  */
 ChargeController::~ChargeController() {}
 
+/**
+ * @brief コマンドを送信する（他タスクから呼び出してよい）
+ *
+ * @details コマンドは制御ループのloop()の先頭で受け付けた順に実行する。
+ * 状態機械を操作するのは制御ループのみとするため、WebAPI・MQTTなどの
+ * 他タスクからはstartCharge()などを直接呼ばずにこちらを使うこと
+ *
+ * @param command コマンド
+ * @return CommandFuture 実行結果を参照するハンドル
+ */
+CommandFuture ChargeController::submit(ChargeCommand command) {
+  CommandFuture future = _mailbox.submit(command);
+  if (future.getStatus() != CommandFuture::STATUS_REJECTED) {
+    _scheduler->wake(ControlScheduler::WAKE_COMMAND);
+  }
+  return future;
+}
+
+/**
+ * @brief 送信したコマンドのハンドルを取得する（他タスクから呼び出してよい）
+ *
+ * @param sequence submit()で返したハンドルの通し番号
+ * @return CommandFuture 実行結果を参照するハンドル
+ */
+CommandFuture ChargeController::findCommand(uint32_t sequence) {
+  return _mailbox.find(sequence);
+}
+
 /**
  * @brief 処理を停止する
  *
@@ -48,25 +119,40 @@ void ChargeController::stop(void) {
   _controlStartCharge.stop();
   _controlStopCharge.stop();
   _controlPowerOnDrone.stop();
+  _controlCalibrate.stop();
 }
 
 /**
- * @brief 充電を開始する
+ * @brief 既定のプロファイルで充電を開始する
  *
+ * @details 制御ループから呼び出すこと（他タスクからはsubmit()を使う）
  */
-void ChargeController::startCharge(void) {
-  stop();
-  _controlStartCharge.start();
+void ChargeController::startCharge(void) { startCharge(_policy.getDefault()); }
+
+/**
+ * @brief プロファイルを指定して充電を開始する
+ *
+ * @details 制御ループから呼び出すこと（他タスクからはsubmit()を使う）
+ *
+ * @param type プロファイルの種類
+ */
+void ChargeController::startCharge(ChargePolicy::ProfileType type) {
+  _applyProfile(type);
+  startCharge(_profile.catchCnt, _profile.retryCnt);
 }
 
 /**
- * @brief 充電を開始する
+ * @brief 捕獲回数を指定して充電を開始する
+ *
+ * @details 充電の判定は現在のプロファイルで行う。
+ * 制御ループから呼び出すこと（他タスクからはsubmit()を使う）
  *
  * @param catchCnt 捕獲繰り返し回数
  * @param retryCnt USB接続するまでの動作をリトライする回数
  */
 void ChargeController::startCharge(uint8_t catchCnt, uint8_t retryCnt) {
   stop();
+  _resetSessionStats = true;
   _controlStartCharge.start(catchCnt, retryCnt);
 }
 
@@ -83,6 +169,7 @@ bool ChargeController::isStartChargeExecuting(void) {
 /**
  * @brief 充電を停止する
  *
+ * @details 制御ループから呼び出すこと（他タスクからはsubmit()を使う）
  */
 void ChargeController::stopCharge(void) {
   stop();
@@ -102,6 +189,7 @@ bool ChargeController::isStopChargeExecuting(void) {
 /**
  * @brief ドローンの電源をONにする
  *
+ * @details 制御ループから呼び出すこと（他タスクからはsubmit()を使う）
  */
 void ChargeController::powerOnDrone(void) {
   stop();
@@ -118,12 +206,62 @@ bool ChargeController::isPowerOnExecuting(void) {
   return _controlPowerOnDrone.isExecuting();
 }
 
+/**
+ * @brief アーム角度の自動キャリブレーションを開始する
+ *
+ * @details 充電台にドローンを載せた状態で実行すること。
+ * 制御ループから呼び出すこと（他タスクからはsubmit()を使う）
+ */
+void ChargeController::calibrate(void) {
+  stop();
+  _controlCalibrate.start();
+}
+
+/**
+ * @brief キャリブレーション処理中かどうか
+ *
+ * @return true
+ * @return false
+ */
+bool ChargeController::isCalibrateExecuting(void) {
+  return _controlCalibrate.isExecuting();
+}
+
+/**
+ * @brief 最後に実行したキャリブレーションの結果を取得する
+ *
+ * @return ControlCalibrate::CalibrateResultType 実行結果
+ */
+ControlCalibrate::CalibrateResultType ChargeController::getCalibrateResult(
+    void) {
+  return _controlCalibrate.getResult();
+}
+
+/**
+ * @brief サーボの角度テーブルを取得する
+ *
+ * @return ServoCalibration* 角度テーブル
+ */
+ServoCalibration *ChargeController::getServoCalibration(void) {
+  return _servo.calibration();
+}
+
 /**
  * @brief WASDでサーボの角度を微調整する
  *
+ * @details eでサーボ電流の学習結果を消去する。
+ * その他のキーはServoController::wasdControl()を参照
+ *
  * @param input キーボード入力
  */
-void ChargeController::wasdControl(char input) { _servo.wasdControl(input); }
+void ChargeController::wasdControl(char input) {
+  if (input == 'e') {
+    // サーボ電流の正常範囲を学習し直す（角度の再調整後など）
+    _checkServoCurrent.getStallDetector()->reset();
+    return;
+  }
+  _servo.wasdControl(input);
+}
 
 /**
  * @brief 充電中かどうか
@@ -163,6 +301,24 @@ float ChargeController::getChargeTimeSec(void) {
   return float(_chargeTimer.getTime()) / 1000;
 }
 
+/**
+ * @brief 充電開始からの充電電荷量を取得する
+ *
+ * @return float 充電電荷量[mAh]
+ */
+float ChargeController::getChargeAmount(void) {
+  return _current.getChargeAmount();
+}
+
+/**
+ * @brief 充電開始からの充電電力量を取得する
+ *
+ * @return float 充電電力量[mWh]
+ */
+float ChargeController::getChargeEnergy(void) {
+  return _current.getChargeEnergy();
+}
+
 /**
  * @brief ドローンをキャッチしているかどうか
  *
@@ -212,6 +368,163 @@ bool ChargeController::isTargetAngle(void) { return _servo.isTargetAngle(); }
  */
 float ChargeController::getCurrent(void) { return _current.getCurrent(); }
 
+/**
+ * @brief バス電圧を取得する
+ *
+ * @return float バス電圧[V]
+ */
+float ChargeController::getBusVoltage(void) { return _current.getBusVoltage(); }
+
+/**
+ * @brief 充電開始からのバス電圧の最小値を取得する
+ *
+ * @return float バス電圧の最小値[V]
+ */
+float ChargeController::getMinBusVoltage(void) {
+  return _current.getMinBusVoltage();
+}
+
+/**
+ * @brief 電力を取得する
+ *
+ * @return float 電力[mW]
+ */
+float ChargeController::getPower(void) { return _current.getPower(); }
+
+/**
+ * @brief 電流センサの最新の計測値を取得する
+ *
+ * @return PowerSample 最新の計測値（フィルタ前）
+ */
+PowerSample ChargeController::getLatestSample(void) {
+  return _current.getLatestSample();
+}
+
+/**
+ * @brief 電流波形キャプチャを取得する
+ *
+ * @return CurrentCapture* 電流波形キャプチャ
+ */
+CurrentCapture *ChargeController::getCapture(void) {
+  return _current.getCapture();
+}
+
+/**
+ * @brief 状態遷移トレースの記録部を取得する
+ *
+ * @return TraceRecorder* 記録部
+ */
+TraceRecorder *ChargeController::getTrace(void) { return &_trace; }
+
+/**
+ * @brief 電流センサの状態を取得する
+ *
+ * @return CurrentReader::SensorHealthType 電流センサの状態
+ */
+CurrentReader::SensorHealthType ChargeController::getSensorHealth(void) {
+  return _current.getSensorHealth();
+}
+
+/**
+ * @brief 電流センサとの通信異常の累計回数を取得する
+ *
+ * @return uint32_t 通信異常の回数
+ */
+uint32_t ChargeController::getSensorFailedCount(void) {
+  return _current.getFailedTransactions();
+}
+
+/**
+ * @brief 電流センサの復旧に成功した累計回数を取得する
+ *
+ * @return uint32_t 復旧回数
+ */
+uint32_t ChargeController::getSensorRecoveredCount(void) {
+  return _current.getRecoveredCount();
+}
+
+/**
+ * @brief 電流センサの現在のサンプリングレートを取得する
+ *
+ * @return uint16_t サンプリングレート[Hz]
+ */
+uint16_t ChargeController::getSamplingRate(void) {
+  return _current.getSamplingRate();
+}
+
+/**
+ * @brief 電流センサのサンプリングモードごとの累積時間を取得する
+ *
+ * @param mode サンプリングモード
+ * @return uint32_t 累積時間[ms]
+ */
+uint32_t ChargeController::getSamplingModeTime(
+    CurrentReader::SamplingModeType mode) {
+  return _current.getSamplingModeTime(mode);
+}
+
+/**
+ * @brief 電流センサのサンプリングモードを選択する
+ *
+ * @details サーボ稼働中・制御シーケンス実行中は過電流検知のため高レート、
+ * 待機中や定常充電中は低レートとする
+ *
+ * @return CurrentReader::SamplingModeType サンプリングモード
+ */
+CurrentReader::SamplingModeType ChargeController::_selectSamplingMode(void) {
+  if (isActive()) return CurrentReader::SAMPLING_HIGH;
+  if (!isCharging() || getChargeTimeMillis() > STEADY_CHARGE_TIME) {
+    return CurrentReader::SAMPLING_LOW;
+  }
+  return CurrentReader::SAMPLING_NORMAL;
+}
+
+/**
+ * @brief 動作中（サーボ稼働中・制御シーケンス実行中）かどうか
+ *
+ * @details 動作中は制御ループを一定周期で実行し、それ以外は起床要因を待つ
+ *
+ * @return true
+ * @return false
+ */
+bool ChargeController::isActive(void) {
+  return !_servo.isTargetAngle() || isStartChargeExecuting() ||
+         isStopChargeExecuting() || isPowerOnExecuting() ||
+         isCalibrateExecuting() || _checkServoCurrent.isExecuting();
+}
+
+/**
+ * @brief 制御ループのスケジューラを取得する
+ *
+ * @details 制御タスクはループ処理の間にControlScheduler::wait()で待機する。
+ * ボタン・シリアル入力などの起床要因もここへ通知する
+ *
+ * @return ControlScheduler* スケジューラ
+ */
+ControlScheduler *ChargeController::getScheduler(void) { return _scheduler; }
+
+/**
+ * @brief 充電ベイの番号を取得する
+ *
+ * @return uint8_t ベイ番号（0から）
+ */
+uint8_t ChargeController::getBayId(void) { return _bay.id; }
+
+/**
+ * @brief 状態のスナップショットを取得する（他タスクから呼び出してよい）
+ *
+ * @details 制御ループが前回の周期の終わりに公開した値を、ロックを取らずに
+ * 読み出す。各値は同じ周期で取得したものとなる。
+ * 通信タスクからの状態の参照はgetCurrent()などを個別に呼ばずにこちらを使うこと
+ *
+ * @return ChargeSnapshot スナップショット（versionが0なら未公開）
+ */
+ChargeSnapshot ChargeController::getSnapshot(void) {
+  ChargeSnapshot snapshot;
+  snapshot.version = _snapshot.read(snapshot);
+  return snapshot;
+}
+
 /**
  * @brief 充電中の電流かどうか
  *
@@ -219,29 +532,503 @@ float ChargeController::getCurrent(void) { return _current.getCurrent(); }
  * @return false
  */
 bool ChargeController::isChargingCurrent(void) {
-  return getCurrent() >= CHARGE_CURRENT_CHARGING_THREASHOLD;
+  return getCurrent() >= _profile.chargingCurrent;
 }
 
 /**
  * @brief 満充電かどうか
  *
+ * @details 電流センサが応答しない間は電流値が更新されないため判定しない
+ *
  * @return true 満充電である
  * @return false
  */
 bool ChargeController::isFullCharge(void) {
-  return isCharging() && isChargingCurrent() &&
-         getCurrent() < CHARGE_CURRENT_STOP_THREASHOLD &&
-         getChargeTimeMillis() > 30000;
+  return _current.isConnect() && isCharging() && isChargingCurrent() &&
+         getCurrent() < _profile.stopCurrent &&
+         getChargeTimeMillis() > _profile.fullChargeTime;
 }
 
 /**
  * @brief アームをリリースすべきかどうか
  *
+ * @details 電流センサが応答しない間は電流が流れていないと誤判定しないよう判定しない
+ *
  * @return true
  * @return false
  */
 bool ChargeController::haveToRelease(void) {
-  return isCharging() && !isChargingCurrent() && getChargeTimeMillis() > 60000;
+  return _current.isConnect() && isCharging() && !isChargingCurrent() &&
+         getChargeTimeMillis() > _profile.noCurrentTime;
+}
+
+/**
+ * @brief 充電フェーズを取得する
+ *
+ * @return ChargeEstimator::ChargePhaseType 充電フェーズ
+ */
+ChargeEstimator::ChargePhaseType ChargeController::getChargePhase(void) {
+  return _estimator.getPhase();
+}
+
+/**
+ * @brief 推定充電率（SoC）を取得する
+ *
+ * @details CV充電に移行し、電流減衰を近似できるまでは推定できない
+ *
+ * @return float 充電率[%]（推定不可なら-1）
+ */
+float ChargeController::getSoc(void) { return _estimator.getSoc(); }
+
+/**
+ * @brief 満充電までの推定残り時間を取得する
+ *
+ * @return float 残り時間[sec]（推定不可なら-1）
+ */
+float ChargeController::getTimeToFull(void) {
+  return _estimator.getTimeToFull();
+}
+
+/**
+ * @brief リリースする充電率を設定する
+ *
+ * @details 推定充電率がこの値に達すれば満充電を待たずに充電を終了する
+ * （CV区間で推定できるようになるまでは終了しない）。
+ * 充電開始時にプロファイルの値に戻る。
+ * 制御ループから呼び出すこと（他タスクからはsubmit()を使う）
+ *
+ * @param targetSoc 充電率[%]（100なら満充電まで充電する）
+ */
+void ChargeController::setTargetSoc(uint8_t targetSoc) {
+  _targetSoc = constrain(targetSoc, ChargePolicy::MIN_TARGET_SOC, 100);
+  logger.info("ChargeController.setTargetSoc(): targetSoc = " +
+              String(_targetSoc));
+}
+
+/**
+ * @brief リリースする充電率を取得する
+ *
+ * @return uint8_t 充電率[%]
+ */
+uint8_t ChargeController::getTargetSoc(void) { return _targetSoc; }
+
+/**
+ * @brief 推定充電率がリリースする充電率に達したかどうか
+ *
+ * @details 充電率はCV区間の近似が有効になってから推定できる。
+ * 充電前の残量は計測できない（バス電圧は5V電源の電圧）ため、
+ * それまで（CC区間）はリリースしない
+ *
+ * @return true
+ * @return false
+ */
+bool ChargeController::isTargetSoc(void) {
+  return _targetSoc < 100 && _current.isConnect() && isCharging() &&
+         _estimator.isValid() && getSoc() >= _targetSoc;
+}
+
+/**
+ * @brief 充電ポリシーを取得する
+ *
+ * @details プロファイルの変更・NVSへの保存は他タスクから行ってよい。
+ * 変更したプロファイルは次の充電開始から反映する
+ *
+ * @return ChargePolicy* 充電ポリシー
+ */
+ChargePolicy *ChargeController::getPolicy(void) { return &_policy; }
+
+/**
+ * @brief 充電の判定に使用中のプロファイルを取得する
+ *
+ * @return ChargePolicy::ProfileType プロファイルの種類
+ */
+ChargePolicy::ProfileType ChargeController::getProfileType(void) {
+  return _profileType;
+}
+
+/**
+ * @brief プロファイルを充電の判定に反映する
+ *
+ * @details プロファイルを複写し、制御ループの判定では複写した値を参照する。
+ * リリースする充電率はプロファイルの値に戻る
+ *
+ * @param type プロファイルの種類
+ */
+void ChargeController::_applyProfile(ChargePolicy::ProfileType type) {
+  _profileType = type < ChargePolicy::PROFILE_NUM ? type : _policy.getDefault();
+  _profile = _policy.getProfile(_profileType);
+  _targetSoc = _profile.targetSoc;
+  logger.info("ChargeController._applyProfile(): profile = " +
+              String(ChargePolicy::getName(_profileType)) +
+              ", targetSoc = " + String(_targetSoc));
+}
+
+/**
+ * @brief 充電ベイの予約キューを取得する
+ *
+ * @details 予約の操作は他タスクから行ってよい
+ *
+ * @return ChargeQueue* 予約キュー
+ */
+ChargeQueue *ChargeController::getQueue(void) { return &_queue; }
+
+/**
+ * @brief 充電ベイが空くまでの推定時間を取得する
+ *
+ * @details 電流減衰を近似できれば、プロファイルの満充電の電流または
+ * リリースする充電率に達するまでの時間とする。
+ * 近似できない間（CC充電中など）は、プロファイルの充電時間の学習値から
+ * 経過時間を引いた時間とする（学習値を超えて充電中なら推定不可）
+ *
+ * @return float 推定時間[sec]（空いていれば0、推定不可なら-1）
+ */
+float ChargeController::getTimeToRelease(void) {
+  if (!_session.isActive()) {
+    // 充電開始処理中は、これから1回分の充電を行う
+    return isStartChargeExecuting() ? _session.getExpectedTime(_profileType)
+                                    : 0;
+  }
+  if (_session.isReleased()) return 0;
+  float elapsed = getChargeTimeSec();
+  if (_estimator.isValid()) {
+    float time = _estimator.getTimeToCurrent(_profile.stopCurrent);
+    float minTime = _profile.fullChargeTime / 1000.0f - elapsed;
+    if (time < minTime) time = minTime;
+    if (_targetSoc < 100) {
+      float socTime = _estimator.getTimeToSoc(_targetSoc);
+      if (socTime < time) time = socTime;
+    }
+    return time > 0 ? time : 0;
+  }
+  float expected = _session.getExpectedTime(_profileType);
+  return expected > elapsed ? expected - elapsed : -1;
+}
+
+/**
+ * @brief 制御部を取得する（状態遷移の統計の参照用）
+ *
+ * @param type 制御の種類
+ * @return ControlBase* 制御部（範囲外ならNULL）
+ */
+ControlBase *ChargeController::getControl(ControlType type) {
+  switch (type) {
+    case CONTROL_START_CHARGE:
+      return &_controlStartCharge;
+    case CONTROL_STOP_CHARGE:
+      return &_controlStopCharge;
+    case CONTROL_POWER_ON_DRONE:
+      return &_controlPowerOnDrone;
+    case CONTROL_CALIBRATE:
+      return &_controlCalibrate;
+    case CONTROL_CHECK_SERVO_CURRENT:
+      return &_checkServoCurrent;
+    default:
+      return NULL;
+  }
+}
+
+/**
+ * @brief サーボ・電流・MOSFETの変化を検出して各制御にイベントを通知する
+ *
+ * @details 変化の検出はここで1回だけ行い、各制御は通知されたイベントでのみ
+ * 遷移の判定を行う
+ */
+void ChargeController::_postControlEvents(void) {
+  uint32_t moveId = _servo.getMoveId();
+  if (moveId != _lastMoveId) {
+    _lastMoveId = moveId;
+    _postControlEvent(ControlBase::EVENT_SERVO_STARTED);
+  }
+  bool isCatchReached = _servo.servoCatch()->isTargetAngle();
+  bool isUsbReached = _servo.servoUsb()->isTargetAngle();
+  if ((isCatchReached && !_wasCatchReached) ||
+      (isUsbReached && !_wasUsbReached)) {
+    _postControlEvent(ControlBase::EVENT_SERVO_REACHED);
+  }
+  _wasCatchReached = isCatchReached;
+  _wasUsbReached = isUsbReached;
+  bool isUsbClear = _servo.isUsbClear();
+  if (isUsbClear && !_wasUsbClear) {
+    _postControlEvent(ControlBase::EVENT_USB_CLEAR);
+  }
+  _wasUsbClear = isUsbClear;
+  if (_current.isConnect()) {
+    bool isServoMoving =
+        CheckServoCurrent::isServoMoving(_current.getServoCurrent());
+    if (isServoMoving != _wasServoMoving) {
+      _postControlEvent(isServoMoving ? ControlBase::EVENT_SERVO_MOVING
+                                      : ControlBase::EVENT_SERVO_IDLE);
+    }
+    _wasServoMoving = isServoMoving;
+  }
+  bool isFetOn = _fet.read();
+  if (isFetOn != _wasFetOn) {
+    _postControlEvent(ControlBase::EVENT_FET_CHANGED);
+  }
+  _wasFetOn = isFetOn;
+}
+
+/**
+ * @brief 全ての制御にイベントを通知する
+ *
+ * @param event イベント
+ */
+void ChargeController::_postControlEvent(ControlBase::ControlEventType event) {
+  for (uint8_t type = 0; type < CONTROL_TYPE_NUM; type++) {
+    getControl((ControlType)type)->post(event);
+  }
+}
+
+/**
+ * @brief 実行中の制御を停止し、サーボを現在の指示角度で止める
+ *
+ * @details 電流センサが応答しない間に呼び出す。過電流・ストールを検知できない
+ * ため、非常停止処理も含めて停止する。電流センサが復帰するまで、
+ * サーボを動かすコマンドは_execute()で拒否する
+ */
+void ChargeController::_holdServo(void) {
+  bool isExecuting = isStartChargeExecuting() || isStopChargeExecuting() ||
+                     isPowerOnExecuting() || isCalibrateExecuting() ||
+                     _checkServoCurrent.isExecuting();
+  if (!isExecuting && _servo.isTargetAngle()) return;
+  stop();
+  if (_checkServoCurrent.isExecuting()) _checkServoCurrent.stop();
+  _servo.hold();
+  logger.error("ChargeController._holdServo(): current sensor lost. bay = " +
+               String(_bay.id) + ", catch = " +
+               String(_servo.servoCatch()->getPresentAngle()) +
+               ", usb = " + String(_servo.servoUsb()->getPresentAngle()));
+}
+
+/**
+ * @brief 他タスクから送信されたコマンドを受け付けた順に実行する
+ *
+ * @details 完了の通知はスナップショットの公開後に行う（完了を受け取った
+ * 送信側が、コマンドの結果を反映したスナップショットを読めるようにするため）
+ */
+void ChargeController::_processCommands(void) {
+  ChargeCommand command;
+  while (_mailbox.receive(command)) {
+    uint32_t sequence = _mailbox.getCompletedCount() + _executedCommandCount;
+    logger.info("ChargeController._processCommands(): " +
+                String(ChargeCommand::getName(command.type)) + " from " +
+                String(ChargeCommand::getSourceName(command.source)) +
+                ", seq = " + String(sequence) +
+                ", req_id = " + String(command.requestId));
+    _mailbox.setResult(sequence, _execute(command));
+    _executedCommandCount++;
+  }
+}
+
+/**
+ * @brief コマンドを実行する
+ *
+ * @param command コマンド
+ * @return CommandFuture::StatusType 実行結果
+ */
+CommandFuture::StatusType ChargeController::_execute(
+    const ChargeCommand &command) {
+  ChargePolicy::ProfileType profile =
+      command.profile < ChargePolicy::PROFILE_NUM
+          ? (ChargePolicy::ProfileType)command.profile
+          : _policy.getDefault();
+  if (command.type != ChargeCommand::COMMAND_SET_TARGET_SOC &&
+      !_current.isConnect()) {
+    // サーボ電流を監視できないため、サーボを動かすコマンドは実行しない
+    logger.error("ChargeController._execute(): current sensor lost, reject " +
+                 String(ChargeCommand::getName(command.type)));
+    return CommandFuture::STATUS_REFUSED;
+  }
+  switch (command.type) {
+    case ChargeCommand::COMMAND_START_CHARGE:
+      _beginCommand(command.time);
+      if (command.catchCnt == 0) {
+        startCharge(profile);
+      } else {
+        _applyProfile(profile);
+        startCharge(command.catchCnt, command.retryCnt);
+      }
+      break;
+    case ChargeCommand::COMMAND_STOP_CHARGE:
+      _beginCommand(command.time);
+      _releaseSession(ChargeSession::RELEASE_STOP_REQUEST);
+      stopCharge();
+      break;
+    case ChargeCommand::COMMAND_POWER_ON_DRONE:
+      _beginCommand(command.time);
+      powerOnDrone();
+      break;
+    case ChargeCommand::COMMAND_CALIBRATE:
+      _beginCommand(command.time);
+      calibrate();
+      break;
+    case ChargeCommand::COMMAND_SET_TARGET_SOC:
+      setTargetSoc(command.targetSoc);
+      break;
+    default:
+      logger.error("ChargeController._execute(): unknown command " +
+                   String(command.type));
+      return CommandFuture::STATUS_FAILED;
+  }
+  return CommandFuture::STATUS_DONE;
+}
+
+/**
+ * @brief コマンドの受付時刻を記録する（サーボ指示までの遅延の計測用）
+ *
+ * @param time コマンドの受付時刻[us]
+ */
+void ChargeController::_beginCommand(uint32_t time) {
+  _commandTime = time;
+  _commandMoveId = _servo.getMoveId();
+  _isCommandPending = true;
+}
+
+/**
+ * @brief コマンド受付から最初のサーボ指示までの時間を集計する
+ *
+ * @details サーボを動かさずに完了したコマンドは集計しない
+ */
+void ChargeController::_checkCommandLatency(void) {
+  if (!_isCommandPending) return;
+  if (_servo.getMoveId() != _commandMoveId) {
+    _addStats(STATS_COMMAND_LATENCY, micros() - _commandTime);
+    _isCommandPending = false;
+  } else if (!isActive()) {
+    _isCommandPending = false;
+  }
+}
+
+/**
+ * @brief 充電の終了理由と終了時の値を記録する
+ *
+ * @param release 終了理由
+ */
+void ChargeController::_releaseSession(ChargeSession::ReleaseType release) {
+  _session.release(release, getChargeTimeSec(), getChargeAmount(), getSoc());
+}
+
+/**
+ * @brief 充電の開始・完了を検出する
+ *
+ * @details 充電電流を流し始めてから、充電停止とアームのリリースが
+ * 完了するまでを1回の充電とする
+ */
+void ChargeController::_updateSession(void) {
+  if (isCharging()) {
+    _session.begin(_profileType);
+  } else if (_session.isActive() && !isStartChargeExecuting() &&
+             !isStopChargeExecuting()) {
+    // 停止要求・終了条件なしに充電が途切れた場合
+    _releaseSession(ChargeSession::RELEASE_UNKNOWN);
+    _session.end();
+  }
+}
+
+/**
+ * @brief 状態のスナップショットを公開し、実行済みのコマンドの完了を通知する
+ *
+ */
+void ChargeController::_publishSnapshot(void) {
+  ChargeSnapshot snapshot;
+  snapshot.version = 0;  // 読み出し時にSeqlockの版数で上書きする
+  snapshot.time = millis();
+  snapshot.isCharging = isCharging();
+  snapshot.current = getCurrent();
+  snapshot.chargeTime = getChargeTimeSec();
+  snapshot.chargeAmount = getChargeAmount();
+  snapshot.chargeEnergy = getChargeEnergy();
+  snapshot.busVoltage = getBusVoltage();
+  snapshot.minBusVoltage = getMinBusVoltage();
+  snapshot.power = getPower();
+  snapshot.samplingRate = getSamplingRate();
+  snapshot.chargePhase = getChargePhase();
+  snapshot.soc = getSoc();
+  snapshot.timeToFull = getTimeToFull();
+  snapshot.targetSoc = getTargetSoc();
+  snapshot.profile = _profileType;
+  snapshot.timeToRelease = getTimeToRelease();
+  for (uint8_t i = 0; i < ChargePolicy::PROFILE_NUM; i++) {
+    snapshot.expectedSessionTime[i] =
+        _session.getExpectedTime((ChargePolicy::ProfileType)i);
+  }
+  snapshot.lastSession = _session.getResult();
+  snapshot.sensorHealth = getSensorHealth();
+  snapshot.sensorFailedCount = getSensorFailedCount();
+  snapshot.sensorRecoveredCount = getSensorRecoveredCount();
+  for (uint8_t mode = 0; mode < CurrentReader::SAMPLING_MODE_NUM; mode++) {
+    snapshot.samplingModeTime[mode] =
+        getSamplingModeTime((CurrentReader::SamplingModeType)mode);
+  }
+  snapshot.isStartChargeExecuting = isStartChargeExecuting();
+  snapshot.isStopChargeExecuting = isStopChargeExecuting();
+  snapshot.isPowerOnExecuting = isPowerOnExecuting();
+  snapshot.isCalibrateExecuting = isCalibrateExecuting();
+  snapshot.calibrateResult = getCalibrateResult();
+  snapshot.latestSample = getLatestSample();
+  _snapshot.write(snapshot);
+
+  for (; _executedCommandCount > 0; _executedCommandCount--) {
+    _mailbox.complete();
+  }
+}
+
+/**
+ * @brief 制御を実行し、処理時間を計測する
+ *
+ * @param control 制御部
+ * @param section 計測する処理
+ * @return true 制御が完了した
+ * @return false
+ */
+bool ChargeController::_loopControl(ControlBase *control,
+                                    LoopProfiler::SectionType section) {
+  uint32_t start = _profiler.begin();
+  bool isFinished = control->loop();
+  _profiler.end(section, start);
+  return isFinished;
+}
+
+/**
+ * @brief ループ処理時間の最大値を取得する
+ *
+ * @details 値はLOOP_TIME_LOG_CYCLEごとにログ出力してリセットされる
+ *
+ * @return uint32_t ループ処理時間の最大値[us]
+ */
+uint32_t ChargeController::getMaxLoopTime(void) { return _maxLoopTime; }
+
+#ifdef LOOP_PROFILE
+/**
+ * @brief ループ処理時間・周期の計測部を取得する
+ *
+ * @return LoopProfiler* 計測部
+ */
+LoopProfiler *ChargeController::getLoopProfiler(void) { return &_profiler; }
+#endif
+
+/**
+ * @brief 統計量を取得する
+ *
+ * @param type 統計の対象
+ * @param scope 統計の範囲
+ * @return StreamingStats* 統計量
+ */
+StreamingStats *ChargeController::getStats(StatsType type,
+                                           StatsScopeType scope) {
+  return &_stats[type][scope];
+}
+
+/**
+ * @brief 統計量にサンプルを追加する
+ *
+ * @param type 統計の対象
+ * @param value サンプル
+ */
+void ChargeController::_addStats(StatsType type, float value) {
+  for (uint8_t scope = 0; scope < STATS_SCOPE_NUM; scope++) {
+    _stats[type][scope].add(value);
+  }
 }
 
 /**
@@ -249,47 +1036,131 @@ bool ChargeController::haveToRelease(void) {
  *
  */
 void ChargeController::loop(void) {
-  static bool requestedStopCharge = false;
+  _profiler.beginLoop();
+  uint32_t profileStart = _profiler.begin();
+  uint32_t loopStart = micros();
+  _processCommands();
+  _current.setSamplingMode(_selectSamplingMode());
+  uint32_t sectionStart = _profiler.begin();
   _current.loop();
-  if (!requestedStopCharge && isFullCharge()) {
+  _profiler.end(LoopProfiler::SECTION_CURRENT_READER, sectionStart);
+  if (_resetSessionStats) {
+    // 他タスクからの充電開始要求で初期化すると更新中の値が壊れるため、ここで行う
+    for (uint8_t type = 0; type < STATS_TYPE_NUM; type++) {
+      _stats[type][STATS_SESSION].reset();
+    }
+    _resetSessionStats = false;
+  }
+  // 充電電流はフィルタの更新周期ごと、サーボ電流は稼働中のループごとに集計
+  if (_chargeStatsTimer.isCycleTime() && isCharging() &&
+      _current.isConnect()) {
+    _addStats(STATS_CHARGE_CURRENT, getCurrent());
+  }
+  if (!_servo.isTargetAngle() && _current.isConnect()) {
+    _addStats(STATS_SERVO_CURRENT, _current.getServoCurrent());
+  }
+  if (isCharging()) {
+    if (_estimator.getPhase() == ChargeEstimator::PHASE_IDLE) {
+      _estimator.start();
+    }
+    if (_current.isConnect()) {
+      _estimator.update(getChargeTimeMillis(), getCurrent());
+    }
+  } else {
+    _estimator.stop();
+  }
+  if (!_requestedStopCharge && isFullCharge()) {
     // 満充電になったら止める
     logger.info(
         "ChargeController.loop(): Stop charging due to full charge. current "
         "= " +
         String(_current.getCurrent()));
+    _releaseSession(ChargeSession::RELEASE_FULL_CHARGE);
+    stopCharge();
+    _requestedStopCharge = true;
+  } else if (!_requestedStopCharge && isTargetSoc()) {
+    // 推定充電率が目標に達したら止める
+    logger.info(
+        "ChargeController.loop(): Stop charging due to target SoC. soc = " +
+        String(getSoc()));
+    _releaseSession(ChargeSession::RELEASE_TARGET_SOC);
     stopCharge();
-    requestedStopCharge = true;
-  } else if (!requestedStopCharge && haveToRelease()) {
+    _requestedStopCharge = true;
+  } else if (!_requestedStopCharge && haveToRelease()) {
     // 充電開始したが電流が流れなかった場合
     logger.info(
         "ChargeController.loop(): Stop charging due to no current. current = " +
         String(_current.getCurrent()));
+    _releaseSession(ChargeSession::RELEASE_NO_CURRENT);
     stopCharge();
-    requestedStopCharge = true;
-  } else if (requestedStopCharge && !isFullCharge()) {
-    requestedStopCharge = false;
+    _requestedStopCharge = true;
+  } else if (_requestedStopCharge && !isFullCharge() && !isTargetSoc()) {
+    _requestedStopCharge = false;
   }
 
+  _postControlEvents();
+
+  // 電流センサが応答しない間はサーボ電流を監視できないため、サーボを動かさない
+  if (!_current.isConnect()) _holdServo();
+
   // サーボ電流監視
   if (_checkServoCurrent.haveToEmargencyStopServo()) {
     _controlStartCharge.stop();
     _controlStopCharge.stop();
     _controlPowerOnDrone.stop();
+    _controlCalibrate.stop();
   }
 
-  if (_controlStartCharge.loop()) {
-    logger.info("ChargeController.loop(): Finish to start charge");
+  if (_loopControl(&_controlStartCharge, LoopProfiler::SECTION_START_CHARGE)) {
+    logger.info("ChargeController.loop(): Finish to start charge. time = " +
+                String(_controlStartCharge.getElapsedTime()) + " ms");
   }
-  if (_controlStopCharge.loop()) {
-    logger.info("ChargeController.loop(): Finish to stop charge");
+  if (_loopControl(&_controlStopCharge, LoopProfiler::SECTION_STOP_CHARGE)) {
+    logger.info("ChargeController.loop(): Finish to stop charge. time = " +
+                String(_controlStopCharge.getElapsedTime()) + " ms");
   }
-  if (_controlPowerOnDrone.loop()) {
-    logger.info("ChargeController.loop(): Finish to power on Tello");
+  if (_loopControl(&_controlPowerOnDrone,
+                   LoopProfiler::SECTION_POWER_ON_DRONE)) {
+    logger.info("ChargeController.loop(): Finish to power on Tello. time = " +
+                String(_controlPowerOnDrone.getElapsedTime()) + " ms");
   }
-  if (_checkServoCurrent.loop()) {
+  if (_loopControl(&_controlCalibrate, LoopProfiler::SECTION_CALIBRATE)) {
+    logger.info("ChargeController.loop(): Finish to calibrate. time = " +
+                String(_controlCalibrate.getElapsedTime()) + " ms");
+    if (_controlCalibrate.getResult() ==
+        ControlCalibrate::CALIBRATE_SUCCEEDED) {
+      // 角度が変わるとサーボ電流の波形も変わるため学習し直す
+      _checkServoCurrent.getStallDetector()->reset();
+    }
+  }
+  if (_loopControl(&_checkServoCurrent,
+                   LoopProfiler::SECTION_CHECK_SERVO_CURRENT)) {
     logger.info("ChargeController.loop(): Finish to check servo current");
   }
+  sectionStart = _profiler.begin();
   _servo.loop();
+  _profiler.end(LoopProfiler::SECTION_SERVO, sectionStart);
+  _checkCommandLatency();
+  _updateSession();
+  _publishSnapshot();
+  for (uint8_t type = 0; type < CONTROL_TYPE_NUM; type++) {
+    if (getControl((ControlType)type)->hasEvent()) {
+      // 状態遷移で発行されたイベントは次の周期を待たずに処理する
+      _scheduler->wake(ControlScheduler::WAKE_EVENT);
+      break;
+    }
+  }
+
+  // ループ処理時間の計測
+  _profiler.end(LoopProfiler::SECTION_LOOP, profileStart);
+  uint32_t loopTime = micros() - loopStart;
+  if (loopTime > _maxLoopTime) _maxLoopTime = loopTime;
+  _addStats(STATS_LOOP_TIME, loopTime);
+  if (_loopTimeLogTimer.isCycleTime()) {
+    logger.debug("ChargeController.loop(): bay = " + String(_bay.id) +
+                 ", max loop time = " + String(_maxLoopTime) + " us");
+    _maxLoopTime = 0;
+  }
 }
 
 /**
@@ -11,26 +11,80 @@
 #include <Arduino.h>
 #include <Timer.h>
 
+#include "BayConfig.h"
+#include "ChargeEstimator.h"
+#include "ChargePolicy.h"
+#include "ChargeQueue.h"
+#include "ChargeSession.h"
+#include "ChargeSnapshot.h"
 #include "CheckServoCurrent.h"
+#include "CommandMailbox.h"
+#include "ControlCalibrate.h"
+#include "ControlScheduler.h"
 #include "ControlPowerOnDrone.h"
 #include "ControlStartCharge.h"
 #include "ControlStopCharge.h"
 #include "CurrentReader.h"
 #include "FETController.h"
+#include "LoopProfiler.h"
+#include "Seqlock.h"
 #include "ServoController.h"
+#include "StreamingStats.h"
+#include "TraceRecorder.h"
 
 class ChargeController {
  public:
-  ChargeController();
+  typedef enum eStats {
+    /** 充電電流[mA]（充電中のみ） */
+    STATS_CHARGE_CURRENT,
+    /** サーボ電流[mA]（サーボ稼働中のみ） */
+    STATS_SERVO_CURRENT,
+    /** ループ処理時間[us] */
+    STATS_LOOP_TIME,
+    /** コマンド受付から最初のサーボ指示までの時間[us] */
+    STATS_COMMAND_LATENCY,
+    STATS_TYPE_NUM,
+  } StatsType;
+
+  typedef enum eStatsScope {
+    /** 充電開始要求からの統計 */
+    STATS_SESSION,
+    /** 起動からの統計 */
+    STATS_LIFETIME,
+    STATS_SCOPE_NUM,
+  } StatsScopeType;
+
+  typedef enum eControl {
+    /** 充電開始 */
+    CONTROL_START_CHARGE,
+    /** 充電停止 */
+    CONTROL_STOP_CHARGE,
+    /** ドローン電源ON */
+    CONTROL_POWER_ON_DRONE,
+    /** アーム角度キャリブレーション */
+    CONTROL_CALIBRATE,
+    /** サーボ電流監視 */
+    CONTROL_CHECK_SERVO_CURRENT,
+    CONTROL_TYPE_NUM,
+  } ControlType;
+
+  ChargeController(const BayConfig &, ControlScheduler *, I2cBus *);
   ~ChargeController();
+  CommandFuture submit(ChargeCommand);
+  CommandFuture findCommand(uint32_t);
   void stop(void);
   void startCharge(void);
+  void startCharge(ChargePolicy::ProfileType);
   void startCharge(uint8_t, uint8_t);
   bool isStartChargeExecuting(void);
   void stopCharge(void);
   bool isStopChargeExecuting(void);
   void powerOnDrone(void);
   bool isPowerOnExecuting(void);
+  void calibrate(void);
+  bool isCalibrateExecuting(void);
+  ControlCalibrate::CalibrateResultType getCalibrateResult(void);
+  ServoCalibration *getServoCalibration(void);
   void wasdControl(char);
   bool isCharging(void);
   bool isInitPos(void);
@@ -41,30 +95,112 @@ class ChargeController {
   bool isTargetAngle(void);
   uint32_t getChargeTimeMillis(void);
   float getChargeTimeSec(void);
+  float getChargeAmount(void);
+  float getChargeEnergy(void);
 
   float getCurrent(void);
+  float getBusVoltage(void);
+  float getMinBusVoltage(void);
+  float getPower(void);
+  PowerSample getLatestSample(void);
+  CurrentCapture *getCapture(void);
+  TraceRecorder *getTrace(void);
+  CurrentReader::SensorHealthType getSensorHealth(void);
+  uint32_t getSensorFailedCount(void);
+  uint32_t getSensorRecoveredCount(void);
+  uint16_t getSamplingRate(void);
+  uint32_t getSamplingModeTime(CurrentReader::SamplingModeType);
   bool isChargingCurrent(void);
   bool isFullCharge(void);
   bool haveToRelease(void);
+  ChargeEstimator::ChargePhaseType getChargePhase(void);
+  float getSoc(void);
+  float getTimeToFull(void);
+  void setTargetSoc(uint8_t);
+  uint8_t getTargetSoc(void);
+  bool isTargetSoc(void);
+  ChargePolicy *getPolicy(void);
+  ChargePolicy::ProfileType getProfileType(void);
+  ChargeQueue *getQueue(void);
+  float getTimeToRelease(void);
+  uint32_t getMaxLoopTime(void);
+  StreamingStats *getStats(StatsType, StatsScopeType);
+  ControlBase *getControl(ControlType);
+  ControlScheduler *getScheduler(void);
+  uint8_t getBayId(void);
+  bool isActive(void);
+  ChargeSnapshot getSnapshot(void);
+#ifdef LOOP_PROFILE
+  LoopProfiler *getLoopProfiler(void);
+#endif
 
   void loop(void);
   String toString(void);
 
  private:
+  CurrentReader::SamplingModeType _selectSamplingMode(void);
+  void _addStats(StatsType, float);
+  void _postControlEvents(void);
+  void _postControlEvent(ControlBase::ControlEventType);
+  void _applyProfile(ChargePolicy::ProfileType);
+  void _releaseSession(ChargeSession::ReleaseType);
+  void _updateSession(void);
+  void _holdServo(void);
+  void _processCommands(void);
+  CommandFuture::StatusType _execute(const ChargeCommand &);
+  void _beginCommand(uint32_t);
+  void _checkCommandLatency(void);
+  void _publishSnapshot(void);
+  bool _loopControl(ControlBase *, LoopProfiler::SectionType);
+
   typedef enum eCharge {
     IDLE,
     START_CHARGE,
     STOP_CHARGE,
 
   } ChargeStepType;
+  /** 充電ベイの構成 */
+  BayConfig _bay;
+  /** 制御ループの実行周期（全ベイで共有） */
+  ControlScheduler *_scheduler;
+  /** 他タスクからのコマンド */
+  CommandMailbox _mailbox;
   /** サーボ制御部 */
   ServoController _servo;
   /** MOSFET制御部 */
   FETController _fet;
   /** 電流計測部 */
   CurrentReader _current;
+  /** 充電ポリシー */
+  ChargePolicy _policy;
+  /** 充電の判定に使用中のプロファイルの種類 */
+  ChargePolicy::ProfileType _profileType;
+  /** 充電の判定に使用中のプロファイル（充電開始時に複写） */
+  ChargeProfile _profile;
   /** 充電時間計測タイマー */
   Timer _chargeTimer;
+  /** 充電状態推定部 */
+  ChargeEstimator _estimator;
+  /** 充電の記録 */
+  ChargeSession _session;
+  /** 充電ベイの予約キュー（通信タスクから操作する） */
+  ChargeQueue _queue;
+  /** リリースする充電率[%]（100なら満充電までリリースしない） */
+  uint8_t _targetSoc;
+  /** ループ処理時間の最大値[us] */
+  uint32_t _maxLoopTime;
+  /** ループ処理時間・周期の計測部（LOOP_PROFILE未定義なら何もしない） */
+  LoopProfiler _profiler;
+  /** ループ処理時間のログ出力タイマー */
+  Timer _loopTimeLogTimer;
+  /** 統計量 */
+  StreamingStats _stats[STATS_TYPE_NUM][STATS_SCOPE_NUM];
+  /** 充電電流の統計量の更新タイマー */
+  Timer _chargeStatsTimer;
+  /** 充電開始要求からの統計量を初期化するかどうか */
+  volatile bool _resetSessionStats;
+  /** 充電終了条件による充電停止を要求済みかどうか */
+  bool _requestedStopCharge;
 
   /** 充電開始制御部 */
   ControlStartCharge _controlStartCharge;
@@ -72,9 +208,38 @@ class ChargeController {
   ControlStopCharge _controlStopCharge;
   /** ドローン電源ON制御部 */
   ControlPowerOnDrone _controlPowerOnDrone;
+  /** アーム角度キャリブレーション制御部 */
+  ControlCalibrate _controlCalibrate;
   /** サーボ電流監視部 */
   CheckServoCurrent _checkServoCurrent;
+  /** 状態遷移トレースの記録部 */
+  TraceRecorder _trace;
+  /** 前回のループで捕獲サーボが指示値に到達していたか */
+  bool _wasCatchReached;
+  /** 前回のループでUSBサーボが指示値に到達していたか */
+  bool _wasUsbReached;
+  /** 前回のループでUSBアームが干渉領域の外にあったか */
+  bool _wasUsbClear;
+  /** 前回のループでサーボ電流が稼働中のしきい値以上だったか */
+  bool _wasServoMoving;
+  /** 前回のループでMOSFETがONだったか */
+  bool _wasFetOn;
+  /** 前回のループでのサーボの動作番号 */
+  uint32_t _lastMoveId;
+  /** コマンド受付後、最初のサーボ指示を待っているかどうか */
+  bool _isCommandPending;
+  /** 実行済みで完了を通知していないコマンド数 */
+  uint8_t _executedCommandCount;
+  /** 他タスクへ公開する状態のスナップショット */
+  Seqlock<ChargeSnapshot> _snapshot;
+  /** コマンドの受付時刻[us] */
+  uint32_t _commandTime;
+  /** コマンド実行時のサーボの動作番号 */
+  uint32_t _commandMoveId;
 
-  static const float CHARGE_CURRENT_CHARGING_THREASHOLD;
-  static const float CHARGE_CURRENT_STOP_THREASHOLD;
+  static const float FULL_CHARGE_CURRENT;
+  static const uint32_t LOOP_TIME_LOG_CYCLE;
+  static const uint32_t STEADY_CHARGE_TIME;
+  static const float BATTERY_CAPACITY;
+  static const uint32_t CURRENT_CYCLE_TIME;
 };
@@ -0,0 +1,242 @@
+/**
+ * @file ChargeEstimator.cpp
+ * @brief 充電状態推定クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 充電電流の推移から定電流(CC)→定電圧(CV)充電への移行を検出し、
+ * CV区間の電流減衰を指数関数 I(t) = I0 * exp(-t / tau) で近似する。
+ * 近似結果から満充電までの残り時間と残り充電電荷量、SoCを推定する
+ */
+
+#include "ChargeEstimator.h"
+
+#include <Log.h>
+#include <math.h>
+
+/** 推定の更新周期[ms] */
+const uint32_t ChargeEstimator::UPDATE_CYCLE = 1000;
+/** 充電開始直後の突入電流・ドローン起動を無視する時間[ms] */
+const uint32_t ChargeEstimator::IGNORE_TIME = 10000;
+/** 電流が最大値のこの割合を下回ればCV充電に移行したとみなす */
+const float ChargeEstimator::CV_DETECT_RATIO = 0.85;
+/** CV移行と判定するまでに最大値を下回り続ける回数 */
+const uint8_t ChargeEstimator::CV_DETECT_COUNT = 10;
+/** 推定値を有効とする近似サンプル数 */
+const uint16_t ChargeEstimator::MIN_FIT_COUNT = 30;
+/**
+ * 最小二乗法の忘却係数（1回の更新あたり）。
+ * 減衰の末尾ほど単一の指数関数から外れるため、直近約5分のサンプルを重視する
+ */
+const double ChargeEstimator::FORGETTING_FACTOR = 0.997;
+
+/**
+ * @brief Construct a new ChargeEstimator::ChargeEstimator object
+ *
+ * @param terminationCurrent 満充電とみなす電流値[mA]
+ * @param capacity バッテリ容量[mAh]（電流センサ側換算）
+ */
+ChargeEstimator::ChargeEstimator(float terminationCurrent, float capacity)
+    : _terminationCurrent(terminationCurrent),
+      _capacity(capacity),
+      _phase(PHASE_IDLE),
+      _lastUpdate(0),
+      _peakCurrent(0),
+      _belowPeakCount(0),
+      _cvStart(0),
+      _fitCount(0),
+      _sumW(0),
+      _sumT(0),
+      _sumY(0),
+      _sumTT(0),
+      _sumTY(0),
+      _lastT(0),
+      _intercept(0),
+      _slope(0) {}
+
+/**
+ * @brief Destroy the ChargeEstimator::ChargeEstimator object
+ *
+ */
+ChargeEstimator::~ChargeEstimator() {}
+
+/**
+ * @brief 推定を開始する（充電開始時に呼び出す）
+ *
+ */
+void ChargeEstimator::start(void) {
+  _phase = PHASE_CC;
+  _lastUpdate = 0;
+  _peakCurrent = 0;
+  _belowPeakCount = 0;
+  _cvStart = 0;
+  _fitCount = 0;
+  _sumW = _sumT = _sumY = _sumTT = _sumTY = 0;
+  _lastT = 0;
+  _intercept = 0;
+  _slope = 0;
+}
+
+/**
+ * @brief 推定を終了する（充電終了時に呼び出す）
+ *
+ */
+void ChargeEstimator::stop(void) { _phase = PHASE_IDLE; }
+
+/**
+ * @brief 充電電流を入力する
+ *
+ * @details 高頻度に呼び出してよい。UPDATE_CYCLEごとに推定を更新する
+ *
+ * @param chargeTime 充電開始からの経過時間[ms]
+ * @param current フィルタ後の充電電流[mA]
+ */
+void ChargeEstimator::update(uint32_t chargeTime, float current) {
+  if (_phase == PHASE_IDLE || chargeTime < IGNORE_TIME) return;
+  if (_lastUpdate != 0 && chargeTime - _lastUpdate < UPDATE_CYCLE) return;
+  _lastUpdate = chargeTime;
+
+  switch (_phase) {
+    case PHASE_CC:
+      if (current > _peakCurrent) _peakCurrent = current;
+      if (current < _peakCurrent * CV_DETECT_RATIO) {
+        if (_belowPeakCount == 0) _cvStart = chargeTime;
+        if (++_belowPeakCount >= CV_DETECT_COUNT) {
+          _phase = PHASE_CV;
+          logger.info("ChargeEstimator.update(): CV phase detected. peak = " +
+                      String(_peakCurrent) + ", current = " + String(current));
+        }
+      } else {
+        _belowPeakCount = 0;
+      }
+      break;
+    case PHASE_CV:
+      // 電流が0付近ではln(I)が発散するため近似に用いない
+      if (current > 0 && current >= _terminationCurrent / 2) {
+        _fit((chargeTime - _cvStart) / 1000.0f, current);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief CV区間のサンプルで近似直線 ln(I) = a + b * t を更新する
+ *
+ * @details 忘却係数付きの逐次最小二乗法。時刻は大きくなるため倍精度で累積する
+ *
+ * @param t CV区間開始からの経過時間[sec]
+ * @param current 充電電流[mA]
+ */
+void ChargeEstimator::_fit(float t, float current) {
+  double y = log(current);
+  _sumW = _sumW * FORGETTING_FACTOR + 1;
+  _sumT = _sumT * FORGETTING_FACTOR + t;
+  _sumY = _sumY * FORGETTING_FACTOR + y;
+  _sumTT = _sumTT * FORGETTING_FACTOR + (double)t * t;
+  _sumTY = _sumTY * FORGETTING_FACTOR + t * y;
+  _lastT = t;
+  if (_fitCount < UINT16_MAX) _fitCount++;
+
+  double det = _sumW * _sumTT - _sumT * _sumT;
+  if (det <= 0) return;
+  _slope = (_sumW * _sumTY - _sumT * _sumY) / det;
+  _intercept = (_sumY - _slope * _sumT) / _sumW;
+}
+
+/**
+ * @brief 充電フェーズを取得する
+ *
+ * @return ChargePhaseType 充電フェーズ
+ */
+ChargeEstimator::ChargePhaseType ChargeEstimator::getPhase(void) {
+  return _phase;
+}
+
+/**
+ * @brief 推定値が有効かどうか
+ *
+ * @return true CV区間の近似が完了し、電流が減衰している
+ * @return false 推定不可（CC充電中・サンプル不足など）
+ */
+bool ChargeEstimator::isValid(void) {
+  return _phase == PHASE_CV && _fitCount >= MIN_FIT_COUNT && _slope < 0;
+}
+
+/**
+ * @brief 電流減衰の時定数を取得する
+ *
+ * @return float 時定数[sec]（推定不可なら-1）
+ */
+float ChargeEstimator::getTimeConstant(void) {
+  if (!isValid()) return -1;
+  return -1 / _slope;
+}
+
+/**
+ * @brief 満充電までの残り時間を取得する
+ *
+ * @details 近似曲線が満充電電流に達するまでの時間
+ *
+ * @return float 残り時間[sec]（推定不可なら-1）
+ */
+float ChargeEstimator::getTimeToFull(void) {
+  return getTimeToCurrent(_terminationCurrent);
+}
+
+/**
+ * @brief 充電電流が指定値まで減衰するまでの残り時間を取得する
+ *
+ * @details 近似曲線が指定の電流値に達するまでの時間
+ *
+ * @param current 電流値[mA]
+ * @return float 残り時間[sec]（推定不可なら-1、到達済みなら0）
+ */
+float ChargeEstimator::getTimeToCurrent(float current) {
+  if (!isValid() || current <= 0) return -1;
+  float remaining = (log(current) - _intercept) / _slope - _lastT;
+  return remaining > 0 ? remaining : 0;
+}
+
+/**
+ * @brief 充電率が指定値に達するまでの残り時間を取得する
+ *
+ * @details 残り充電電荷量 tau * (I - I_term) が指定の充電率での値に
+ * 等しくなる電流値を求め、近似曲線がその電流値に達するまでの時間とする
+ *
+ * @param soc 充電率[%]
+ * @return float 残り時間[sec]（推定不可なら-1、到達済みなら0）
+ */
+float ChargeEstimator::getTimeToSoc(float soc) {
+  if (!isValid()) return -1;
+  float remainingCharge = _capacity * (1 - soc / 100);
+  if (remainingCharge <= 0) return getTimeToFull();
+  return getTimeToCurrent(_terminationCurrent +
+                          remainingCharge * 3600 / getTimeConstant());
+}
+
+/**
+ * @brief 満充電までの残り充電電荷量を取得する
+ *
+ * @details 近似曲線を現在から満充電電流に達するまで積分した値
+ *
+ * @return float 残り充電電荷量[mAh]（推定不可なら-1）
+ */
+float ChargeEstimator::getRemainingCharge(void) {
+  if (!isValid()) return -1;
+  float current = exp(_intercept + _slope * _lastT);
+  if (current <= _terminationCurrent) return 0;
+  return getTimeConstant() * (current - _terminationCurrent) / 3600;
+}
+
+/**
+ * @brief 充電率（SoC）を取得する
+ *
+ * @return float 充電率[%]（推定不可なら-1）
+ */
+float ChargeEstimator::getSoc(void) {
+  if (!isValid()) return -1;
+  float soc = 100 * (1 - getRemainingCharge() / _capacity);
+  return constrain(soc, 0.0f, 100.0f);
+}
@@ -0,0 +1,79 @@
+/**
+ * @file ChargeEstimator.h
+ * @brief 充電状態推定クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 充電電流の推移から定電流(CC)→定電圧(CV)充電への移行を検出し、
+ * CV区間の電流減衰を指数関数 I(t) = I0 * exp(-t / tau) で近似する。
+ * 近似結果から満充電までの残り時間と残り充電電荷量、SoCを推定する。
+ * 任意の電流値・充電率に達するまでの時間も同じ近似曲線から求める
+ */
+
+#pragma once
+#include <Arduino.h>
+
+class ChargeEstimator {
+ public:
+  typedef enum eChargePhase {
+    /** 充電していない */
+    PHASE_IDLE,
+    /** 定電流充電中 */
+    PHASE_CC,
+    /** 定電圧充電中 */
+    PHASE_CV,
+  } ChargePhaseType;
+
+  ChargeEstimator(float, float);
+  ~ChargeEstimator();
+  void start(void);
+  void stop(void);
+  void update(uint32_t, float);
+  ChargePhaseType getPhase(void);
+  bool isValid(void);
+  float getTimeConstant(void);
+  float getTimeToFull(void);
+  float getTimeToCurrent(float);
+  float getTimeToSoc(float);
+  float getRemainingCharge(void);
+  float getSoc(void);
+
+  static const uint32_t UPDATE_CYCLE;
+  static const uint32_t IGNORE_TIME;
+  static const float CV_DETECT_RATIO;
+  static const uint8_t CV_DETECT_COUNT;
+  static const uint16_t MIN_FIT_COUNT;
+  static const double FORGETTING_FACTOR;
+
+ private:
+  void _fit(float, float);
+
+  /** 満充電とみなす電流値[mA] */
+  float _terminationCurrent;
+  /** バッテリ容量[mAh] */
+  float _capacity;
+  /** 充電フェーズ */
+  ChargePhaseType _phase;
+  /** 前回の更新時刻[ms] */
+  uint32_t _lastUpdate;
+  /** CC区間の電流の最大値[mA] */
+  float _peakCurrent;
+  /** 電流が最大値を下回り続けている回数 */
+  uint8_t _belowPeakCount;
+  /** CV区間の開始時刻[ms] */
+  uint32_t _cvStart;
+  /** 近似に用いたサンプル数 */
+  uint16_t _fitCount;
+  /** 最小二乗法の重み付き累積値（t:経過時間[sec], y:ln(I[mA])） */
+  double _sumW;
+  double _sumT;
+  double _sumY;
+  double _sumTT;
+  double _sumTY;
+  /** 最新の近似時刻[sec] */
+  float _lastT;
+  /** 近似直線の切片 ln(I0) */
+  float _intercept;
+  /** 近似直線の傾き -1/tau[1/sec] */
+  float _slope;
+};
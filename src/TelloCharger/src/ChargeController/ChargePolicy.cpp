@@ -0,0 +1,266 @@
+/**
+ * @file ChargePolicy.cpp
+ * @brief 充電ポリシー（名前付きの充電プロファイル）の管理クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ */
+
+#include "ChargePolicy.h"
+
+#include <Log.h>
+#include <Preferences.h>
+#include <string.h>
+
+/** 既定のプロファイル（ProfileTypeの順） */
+const ChargeProfile ChargePolicy::DEFAULT_PROFILES[PROFILE_NUM] = {
+    // 満充電（従来の固定値）
+    {100.0, 200.0, 30000, 60000, 100, 2, 1},
+    // 早期リリース（CV区間の途中で止め、電流なしの判定も早める）
+    {100.0, 400.0, 20000, 30000, 90, 2, 1},
+};
+/** 設定可能なリリース充電率の最小値[%] */
+const uint8_t ChargePolicy::MIN_TARGET_SOC = 50;
+/** 設定可能な判定電流の最大値[mA] */
+const float ChargePolicy::MAX_CURRENT = 3000.0;
+/** 設定可能な判定時間の最小値[ms] */
+const uint32_t ChargePolicy::MIN_JUDGE_TIME = 5000;
+/** 設定可能な判定時間の最大値[ms] */
+const uint32_t ChargePolicy::MAX_JUDGE_TIME = 600000;
+/** 設定可能な捕獲繰り返し回数の最大値 */
+const uint8_t ChargePolicy::MAX_CATCH_CNT = 10;
+/** 設定可能なリトライ回数の最大値 */
+const uint8_t ChargePolicy::MAX_RETRY_CNT = 10;
+/** プロファイルと既定のプロファイルを保存する名前空間の基本名 */
+const char *ChargePolicy::NAMESPACE = "policy";
+/** NVSのキー（保存形式のバージョン） */
+const char *ChargePolicy::KEY_VERSION = "version";
+/** NVSのキー（プロファイル） */
+const char *ChargePolicy::KEY_PROFILES = "profiles";
+/** NVSのキー（既定のプロファイル） */
+const char *ChargePolicy::KEY_DEFAULT = "default";
+/** 保存形式のバージョン（ChargeProfileやプロファイルの構成を変えたら上げる） */
+const uint8_t ChargePolicy::VERSION = 2;
+
+/**
+ * @brief Construct a new Charge Policy:: Charge Policy object
+ *
+ * @details 組み込みのプロファイルを設定し、変更した値が保存されていれば
+ * 上書きする。ChargeControllerのメンバとして生成されるため、
+ * ChargeControllerの生成もBayConfig::getNamespace()の制約に従う
+ *
+ * @param bay 充電ベイの構成
+ */
+ChargePolicy::ChargePolicy(const BayConfig &bay)
+    : _mux(portMUX_INITIALIZER_UNLOCKED),
+      _default(PROFILE_FULL_CHARGE),
+      _isLoaded(false),
+      _namespace(bay.getNamespace(NAMESPACE)) {
+  reset();
+  load();
+}
+
+/**
+ * @brief Destroy the Charge Policy:: Charge Policy object
+ *
+ */
+ChargePolicy::~ChargePolicy() {}
+
+/**
+ * @brief NVSからプロファイルを読み込む
+ *
+ * @return true 読み込み成功
+ * @return false 保存値がない、または不正（現在の設定を維持する）
+ */
+bool ChargePolicy::load(void) {
+  Preferences prefs;
+  if (!prefs.begin(_namespace.c_str(), true)) return false;
+  ChargeProfile profiles[PROFILE_NUM];
+  bool isRead = prefs.getUChar(KEY_VERSION, 0) == VERSION &&
+                prefs.getBytesLength(KEY_PROFILES) == sizeof(profiles) &&
+                prefs.getBytes(KEY_PROFILES, profiles, sizeof(profiles)) ==
+                    sizeof(profiles);
+  uint8_t defaultType = prefs.getUChar(KEY_DEFAULT, PROFILE_FULL_CHARGE);
+  prefs.end();
+  if (!isRead) return false;
+  bool isValidPolicy = defaultType < PROFILE_NUM;
+  for (uint8_t i = 0; i < PROFILE_NUM; i++) {
+    isValidPolicy = isValidPolicy && isValid(profiles[i]);
+  }
+  if (!isValidPolicy) {
+    logger.warn("ChargePolicy.load(): Invalid policy in NVS");
+    return false;
+  }
+  portENTER_CRITICAL(&_mux);
+  memcpy(_profiles, profiles, sizeof(_profiles));
+  _default = (ProfileType)defaultType;
+  portEXIT_CRITICAL(&_mux);
+  _isLoaded = true;
+  logger.info("ChargePolicy.load(): default = " +
+              String(getName(_default)));
+  return true;
+}
+
+/**
+ * @brief 現在の設定をNVSに保存する
+ *
+ * @details NVSへの書き込みで数十msかかるため、通信タスクから呼び出すこと
+ *
+ * @return true 保存成功
+ * @return false 保存失敗
+ */
+bool ChargePolicy::save(void) {
+  ChargeProfile profiles[PROFILE_NUM];
+  portENTER_CRITICAL(&_mux);
+  memcpy(profiles, _profiles, sizeof(profiles));
+  uint8_t defaultType = _default;
+  portEXIT_CRITICAL(&_mux);
+  Preferences prefs;
+  if (!prefs.begin(_namespace.c_str(), false)) return false;
+  bool isWritten =
+      prefs.putBytes(KEY_PROFILES, profiles, sizeof(profiles)) ==
+          sizeof(profiles) &&
+      prefs.putUChar(KEY_DEFAULT, defaultType) == sizeof(uint8_t) &&
+      prefs.putUChar(KEY_VERSION, VERSION) == sizeof(uint8_t);
+  prefs.end();
+  if (isWritten) {
+    _isLoaded = true;
+    logger.info("ChargePolicy.save(): default = " +
+                String(getName((ProfileType)defaultType)));
+  } else {
+    logger.error("ChargePolicy.save(): Failed to write NVS");
+  }
+  return isWritten;
+}
+
+/**
+ * @brief 設定を既定値に戻す（NVSの保存値は変更しない）
+ *
+ */
+void ChargePolicy::reset(void) {
+  portENTER_CRITICAL(&_mux);
+  memcpy(_profiles, DEFAULT_PROFILES, sizeof(_profiles));
+  _default = PROFILE_FULL_CHARGE;
+  portEXIT_CRITICAL(&_mux);
+  _isLoaded = false;
+}
+
+/**
+ * @brief NVSの保存値を使用しているかどうか
+ *
+ * @return true NVSの保存値
+ * @return false 既定値
+ */
+bool ChargePolicy::isLoaded(void) { return _isLoaded; }
+
+/**
+ * @brief プロファイルを取得する
+ *
+ * @param type プロファイルの種類
+ * @return ChargeProfile プロファイルの複写（範囲外なら満充電）
+ */
+ChargeProfile ChargePolicy::getProfile(ProfileType type) {
+  if (type >= PROFILE_NUM) type = PROFILE_FULL_CHARGE;
+  portENTER_CRITICAL(&_mux);
+  ChargeProfile profile = _profiles[type];
+  portEXIT_CRITICAL(&_mux);
+  return profile;
+}
+
+/**
+ * @brief プロファイルを設定する（NVSへは保存しない）
+ *
+ * @details 次の充電開始から反映する（充電中の判定は変わらない）
+ *
+ * @param type プロファイルの種類
+ * @param profile プロファイル
+ * @return true 設定成功
+ * @return false 不正なプロファイル
+ */
+bool ChargePolicy::setProfile(ProfileType type, const ChargeProfile &profile) {
+  if (type >= PROFILE_NUM) return false;
+  if (!isValid(profile)) {
+    logger.warn("ChargePolicy.setProfile(): Invalid profile. name = " +
+                String(getName(type)));
+    return false;
+  }
+  portENTER_CRITICAL(&_mux);
+  _profiles[type] = profile;
+  portEXIT_CRITICAL(&_mux);
+  return true;
+}
+
+/**
+ * @brief 既定のプロファイルを取得する
+ *
+ * @return ProfileType 充電開始要求でプロファイルの指定がないときのプロファイル
+ */
+ChargePolicy::ProfileType ChargePolicy::getDefault(void) { return _default; }
+
+/**
+ * @brief 既定のプロファイルを設定する（NVSへは保存しない）
+ *
+ * @param type プロファイルの種類
+ * @return true 設定成功
+ * @return false 範囲外
+ */
+bool ChargePolicy::setDefault(ProfileType type) {
+  if (type >= PROFILE_NUM) return false;
+  _default = type;
+  return true;
+}
+
+/**
+ * @brief プロファイルの名前を取得する
+ *
+ * @param type プロファイルの種類
+ * @return const char* 名前
+ */
+const char *ChargePolicy::getName(ProfileType type) {
+  switch (type) {
+    case PROFILE_FULL_CHARGE:
+      return "fullCharge";
+    case PROFILE_FAST_TURNAROUND:
+      return "fastTurnaround";
+    default:
+      return "unknown";
+  }
+}
+
+/**
+ * @brief 名前からプロファイルを探す
+ *
+ * @param name 名前
+ * @return ProfileType プロファイルの種類（見つからなければPROFILE_NUM）
+ */
+ChargePolicy::ProfileType ChargePolicy::findByName(const char *name) {
+  for (uint8_t i = 0; i < PROFILE_NUM; i++) {
+    if (name != NULL && strcmp(name, getName((ProfileType)i)) == 0) {
+      return (ProfileType)i;
+    }
+  }
+  return PROFILE_NUM;
+}
+
+/**
+ * @brief プロファイルが正しいかどうか
+ *
+ * @details 満充電の判定は充電中（chargingCurrent以上）かつstopCurrent未満で
+ * 行うため、chargingCurrent < stopCurrent であること
+ *
+ * @param profile プロファイル
+ * @return true 正しい
+ * @return false 不正
+ */
+bool ChargePolicy::isValid(const ChargeProfile &profile) {
+  return profile.chargingCurrent > 0 &&
+         profile.chargingCurrent < profile.stopCurrent &&
+         profile.stopCurrent <= MAX_CURRENT &&
+         profile.fullChargeTime >= MIN_JUDGE_TIME &&
+         profile.fullChargeTime <= MAX_JUDGE_TIME &&
+         profile.noCurrentTime >= MIN_JUDGE_TIME &&
+         profile.noCurrentTime <= MAX_JUDGE_TIME &&
+         profile.targetSoc >= MIN_TARGET_SOC && profile.targetSoc <= 100 &&
+         profile.catchCnt >= 1 && profile.catchCnt <= MAX_CATCH_CNT &&
+         profile.retryCnt <= MAX_RETRY_CNT;
+}
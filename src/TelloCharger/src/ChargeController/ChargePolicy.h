@@ -0,0 +1,91 @@
+/**
+ * @file ChargePolicy.h
+ * @brief 充電ポリシー（名前付きの充電プロファイル）の管理クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 充電の判定しきい値・判定時間・リリースする充電率・捕獲回数を
+ * 用途ごとのプロファイル（満充電・早期リリース）としてまとめ、
+ * 実行時に変更してNVSに保存する。プロファイルは充電開始時に選択し、
+ * 制御ループは開始時点の値の複写で判定する（ループ中にメモリ確保しない）。
+ * 設定の変更は通信タスクから行ってよい（クリティカルセクションで排他する）
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#include "BayConfig.h"
+
+/**
+ * @brief 充電プロファイル
+ */
+struct ChargeProfile {
+  /** この電流[mA]以上なら充電中とみなす */
+  float chargingCurrent;
+  /** 充電中にこの電流[mA]を下回れば満充電とみなす */
+  float stopCurrent;
+  /** 充電開始からこの時間[ms]が経過するまでは満充電と判定しない */
+  uint32_t fullChargeTime;
+  /** 充電開始からこの時間[ms]が経過しても電流が流れなければリリースする */
+  uint32_t noCurrentTime;
+  /** リリースする充電率[%]（100なら満充電まで。CV区間の推定値で判定する） */
+  uint8_t targetSoc;
+  /** 捕獲繰り返し回数 */
+  uint8_t catchCnt;
+  /** USB接続するまでの動作をリトライする回数 */
+  uint8_t retryCnt;
+};
+
+class ChargePolicy {
+ public:
+  typedef enum eProfile {
+    /** 満充電（充電電流が下がりきるまで充電する） */
+    PROFILE_FULL_CHARGE,
+    /** 早期リリース（満充電の手前でリリースし、次の飛行までの時間を優先） */
+    PROFILE_FAST_TURNAROUND,
+    PROFILE_NUM,
+  } ProfileType;
+
+  ChargePolicy(const BayConfig &);
+  ~ChargePolicy();
+  bool load(void);
+  bool save(void);
+  void reset(void);
+  bool isLoaded(void);
+  ChargeProfile getProfile(ProfileType);
+  bool setProfile(ProfileType, const ChargeProfile &);
+  ProfileType getDefault(void);
+  bool setDefault(ProfileType);
+  static const char *getName(ProfileType);
+  static ProfileType findByName(const char *);
+  static bool isValid(const ChargeProfile &);
+
+  static const uint8_t MIN_TARGET_SOC;
+
+ private:
+  ChargePolicy(const ChargePolicy &) = delete;
+  ChargePolicy &operator=(const ChargePolicy &) = delete;
+
+  /** 設定の変更と読み出しを排他するクリティカルセクション */
+  portMUX_TYPE _mux;
+  /** プロファイル（ProfileTypeの順） */
+  ChargeProfile _profiles[PROFILE_NUM];
+  /** 充電開始要求でプロファイルの指定がないときのプロファイル */
+  ProfileType _default;
+  /** NVSの保存値を使用しているかどうか */
+  bool _isLoaded;
+  /** このベイのプロファイルを保存するNVSの名前空間 */
+  String _namespace;
+
+  static const ChargeProfile DEFAULT_PROFILES[PROFILE_NUM];
+  static const float MAX_CURRENT;
+  static const uint32_t MIN_JUDGE_TIME;
+  static const uint32_t MAX_JUDGE_TIME;
+  static const uint8_t MAX_CATCH_CNT;
+  static const uint8_t MAX_RETRY_CNT;
+  static const char *NAMESPACE;
+  static const char *KEY_VERSION;
+  static const char *KEY_PROFILES;
+  static const char *KEY_DEFAULT;
+  static const uint8_t VERSION;
+};
@@ -0,0 +1,189 @@
+/**
+ * @file ChargeQueue.cpp
+ * @brief 充電ベイの予約キュー
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ */
+
+#include "ChargeQueue.h"
+
+#include <Log.h>
+#include <string.h>
+
+const uint8_t ChargeReservation::DRONE_ID_SIZE;
+const uint8_t ChargeQueue::QUEUE_SIZE;
+
+/**
+ * @brief 予約の充電プロファイルを取得する
+ *
+ * @param defaultProfile プロファイルの指定がないときのプロファイル
+ * @return ChargePolicy::ProfileType プロファイル
+ */
+ChargePolicy::ProfileType ChargeReservation::getProfile(
+    ChargePolicy::ProfileType defaultProfile) const {
+  return profile < ChargePolicy::PROFILE_NUM
+             ? (ChargePolicy::ProfileType)profile
+             : defaultProfile;
+}
+
+/**
+ * @brief Construct a new Charge Queue:: Charge Queue object
+ *
+ */
+ChargeQueue::ChargeQueue()
+    : _mux(portMUX_INITIALIZER_UNLOCKED),
+      _length(0),
+      _nextTicket(1),
+      _revision(0) {}
+
+/**
+ * @brief Destroy the Charge Queue:: Charge Queue object
+ *
+ */
+ChargeQueue::~ChargeQueue() {}
+
+/**
+ * @brief 予約を末尾に追加する
+ *
+ * @param droneId ドローンID（1文字以上DRONE_ID_SIZE未満）
+ * @param profile 充電プロファイル（ChargeCommand::PROFILE_DEFAULTなら既定）
+ * @param reservation 追加した予約の格納先（成功時のみ）
+ * @return ResultType 結果
+ */
+ChargeQueue::ResultType ChargeQueue::enqueue(const char *droneId,
+                                             uint8_t profile,
+                                             ChargeReservation &reservation) {
+  size_t length = droneId != NULL ? strlen(droneId) : 0;
+  if (length == 0 || length >= ChargeReservation::DRONE_ID_SIZE) {
+    return RESULT_INVALID_ID;
+  }
+  ResultType result = RESULT_OK;
+  portENTER_CRITICAL(&_mux);
+  if (_find(droneId) >= 0) {
+    result = RESULT_DUPLICATE;
+  } else if (_length >= QUEUE_SIZE) {
+    result = RESULT_FULL;
+  } else {
+    ChargeReservation &added = _reservations[_length++];
+    added.ticket = _nextTicket++;
+    added.time = millis();
+    added.profile = profile;
+    memcpy(added.droneId, droneId, length + 1);
+    reservation = added;
+    _revision++;
+  }
+  portEXIT_CRITICAL(&_mux);
+  if (result == RESULT_OK) {
+    logger.info("ChargeQueue.enqueue(): droneId = " + String(droneId) +
+                ", ticket = " + String(reservation.ticket));
+  }
+  return result;
+}
+
+/**
+ * @brief 予約を取り出す
+ *
+ * @details ドローンIDを指定すれば順番によらずその予約を取り消し、
+ * 空文字（またはNULL）なら先頭の予約を取り出す
+ *
+ * @param droneId ドローンID
+ * @param reservation 取り出した予約の格納先（成功時のみ）
+ * @return ResultType 結果
+ */
+ChargeQueue::ResultType ChargeQueue::dequeue(const char *droneId,
+                                             ChargeReservation &reservation) {
+  bool isHead = droneId == NULL || droneId[0] == '\0';
+  ResultType result = RESULT_OK;
+  portENTER_CRITICAL(&_mux);
+  int8_t index = isHead ? (_length > 0 ? 0 : -1) : _find(droneId);
+  if (index < 0) {
+    result = RESULT_NOT_FOUND;
+  } else {
+    reservation = _reservations[index];
+    memmove(&_reservations[index], &_reservations[index + 1],
+            (_length - index - 1) * sizeof(ChargeReservation));
+    _length--;
+    _revision++;
+  }
+  portEXIT_CRITICAL(&_mux);
+  if (result == RESULT_OK) {
+    logger.info("ChargeQueue.dequeue(): droneId = " +
+                String(reservation.droneId) +
+                ", ticket = " + String(reservation.ticket));
+  }
+  return result;
+}
+
+/**
+ * @brief 予約数を取得する
+ *
+ * @return uint8_t 予約数
+ */
+uint8_t ChargeQueue::getLength(void) {
+  portENTER_CRITICAL(&_mux);
+  uint8_t length = _length;
+  portEXIT_CRITICAL(&_mux);
+  return length;
+}
+
+/**
+ * @brief 予約の変更回数を取得する（変更の検出用）
+ *
+ * @return uint32_t 変更回数
+ */
+uint32_t ChargeQueue::getRevision(void) {
+  portENTER_CRITICAL(&_mux);
+  uint32_t revision = _revision;
+  portEXIT_CRITICAL(&_mux);
+  return revision;
+}
+
+/**
+ * @brief 予約を複写し、それぞれの充電開始までの推定待ち時間を求める
+ *
+ * @details 先頭の予約は充電ベイが空くまでの推定時間、以降の予約は
+ * 1つ前の予約の待ち時間にその予約のプロファイルの充電時間の学習値を足した時間。
+ * 充電ベイが空くまでの時間を推定できなければ全予約を-1とする
+ *
+ * @param snapshot 充電制御の状態のスナップショット
+ * @param defaultProfile プロファイルの指定がない予約のプロファイル
+ * @param reservations 予約の格納先（受付順）
+ * @param etas 推定待ち時間[sec]の格納先
+ * @param size 格納先の要素数
+ * @return uint8_t 格納した予約数
+ */
+uint8_t ChargeQueue::estimate(const ChargeSnapshot &snapshot,
+                              ChargePolicy::ProfileType defaultProfile,
+                              ChargeReservation *reservations, float *etas,
+                              uint8_t size) {
+  portENTER_CRITICAL(&_mux);
+  uint8_t length = _length < size ? _length : size;
+  memcpy(reservations, _reservations, length * sizeof(ChargeReservation));
+  portEXIT_CRITICAL(&_mux);
+
+  float eta = snapshot.timeToRelease;
+  for (uint8_t i = 0; i < length; i++) {
+    etas[i] = eta;
+    if (eta < 0) continue;
+    eta += snapshot.expectedSessionTime[reservations[i].getProfile(
+        defaultProfile)];
+  }
+  return length;
+}
+
+/**
+ * @brief ドローンIDの予約を探す（クリティカルセクション内で呼び出す）
+ *
+ * @param droneId ドローンID
+ * @return int8_t 予約の位置（なければ-1）
+ */
+int8_t ChargeQueue::_find(const char *droneId) {
+  for (uint8_t i = 0; i < _length; i++) {
+    if (strncmp(_reservations[i].droneId, droneId,
+                ChargeReservation::DRONE_ID_SIZE) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file ChargeQueue.h
+ * @brief 充電ベイの予約キュー
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 充電ベイを共有する複数のドローンの充電待ちを受付順に管理する。
+ * 各予約の待ち時間は、充電中の充電の残り時間（電流減衰の近似、または
+ * 過去の充電時間と経過時間から推定）に、先に並ぶ予約のプロファイルごとの
+ * 充電時間の学習値を足して求める。
+ * 予約の操作は通信タスクから行う（クリティカルセクションで排他する）。
+ * 予約は起動時に空となり、NVSには保存しない
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#include "ChargePolicy.h"
+#include "ChargeSnapshot.h"
+
+/**
+ * @brief 充電の予約
+ */
+struct ChargeReservation {
+  /** ドローンIDの最大長（終端文字を含む） */
+  static const uint8_t DRONE_ID_SIZE = 32;
+
+  ChargePolicy::ProfileType getProfile(ChargePolicy::ProfileType) const;
+
+  /** 受付番号（起動からの通し番号、1から） */
+  uint32_t ticket;
+  /** 受付時刻[ms] */
+  uint32_t time;
+  /** 充電プロファイル（ChargeCommand::PROFILE_DEFAULTなら既定） */
+  uint8_t profile;
+  /** ドローンID */
+  char droneId[DRONE_ID_SIZE];
+};
+
+class ChargeQueue {
+ public:
+  typedef enum eResult {
+    /** 成功 */
+    RESULT_OK,
+    /** ドローンIDが空、または長すぎる */
+    RESULT_INVALID_ID,
+    /** 同じドローンIDの予約がある */
+    RESULT_DUPLICATE,
+    /** キューが一杯 */
+    RESULT_FULL,
+    /** 予約がない */
+    RESULT_NOT_FOUND,
+  } ResultType;
+
+  ChargeQueue();
+  ~ChargeQueue();
+  ResultType enqueue(const char *, uint8_t, ChargeReservation &);
+  ResultType dequeue(const char *, ChargeReservation &);
+  uint8_t getLength(void);
+  uint32_t getRevision(void);
+  uint8_t estimate(const ChargeSnapshot &, ChargePolicy::ProfileType,
+                   ChargeReservation *, float *, uint8_t);
+
+  /** キューの長さ */
+  static const uint8_t QUEUE_SIZE = 8;
+
+ private:
+  ChargeQueue(const ChargeQueue &) = delete;
+  ChargeQueue &operator=(const ChargeQueue &) = delete;
+  int8_t _find(const char *);
+
+  /** 予約の操作と読み出しを排他するクリティカルセクション */
+  portMUX_TYPE _mux;
+  /** 予約（受付順） */
+  ChargeReservation _reservations[QUEUE_SIZE];
+  /** 予約数 */
+  uint8_t _length;
+  /** 次の受付番号 */
+  uint32_t _nextTicket;
+  /** 予約の変更回数 */
+  uint32_t _revision;
+};
@@ -0,0 +1,145 @@
+/**
+ * @file ChargeSession.cpp
+ * @brief 1回の充電（充電開始からアームのリリースまで）の記録
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ */
+
+#include "ChargeSession.h"
+
+#include <Log.h>
+
+/** 学習前の充電時間[sec]（Tello純正バッテリの公称充電時間90分） */
+const float ChargeSession::NOMINAL_TIME = 5400.0;
+/** 充電時間の学習率（指数移動平均の重み） */
+const float ChargeSession::LEARNING_RATE = 0.3;
+
+/**
+ * @brief Construct a new Charge Session:: Charge Session object
+ *
+ */
+ChargeSession::ChargeSession()
+    : _isActive(false),
+      _isReleased(false),
+      _current({0, ChargePolicy::PROFILE_FULL_CHARGE, RELEASE_UNKNOWN, 0, 0,
+                -1}),
+      _last(_current) {
+  for (uint8_t i = 0; i < ChargePolicy::PROFILE_NUM; i++) {
+    _expectedTime[i] = NOMINAL_TIME;
+  }
+}
+
+/**
+ * @brief Destroy the Charge Session:: Charge Session object
+ *
+ */
+ChargeSession::~ChargeSession() {}
+
+/**
+ * @brief 充電を開始する（充電電流が流れ始めたときに呼び出す）
+ *
+ * @param profile 充電に使用するプロファイル
+ */
+void ChargeSession::begin(ChargePolicy::ProfileType profile) {
+  if (_isActive) return;
+  _isActive = true;
+  _isReleased = false;
+  _current = {_last.count + 1, profile, RELEASE_UNKNOWN, 0, 0, -1};
+}
+
+/**
+ * @brief 充電の終了理由と終了時の値を記録する（充電停止時に呼び出す）
+ *
+ * @details 最初に記録した終了理由を優先し、2回目以降は無視する。
+ * 充電していなければ何もしない
+ *
+ * @param release 終了理由
+ * @param chargeTime 充電時間[sec]
+ * @param chargeAmount 充電電荷量[mAh]
+ * @param soc 推定充電率[%]（推定不可なら-1）
+ */
+void ChargeSession::release(ReleaseType release, float chargeTime,
+                            float chargeAmount, float soc) {
+  if (!_isActive || _isReleased) return;
+  _isReleased = true;
+  _current.release = release;
+  _current.chargeTime = chargeTime;
+  _current.chargeAmount = chargeAmount;
+  _current.soc = soc;
+}
+
+/**
+ * @brief 充電を完了する（アームのリリースが完了したときに呼び出す）
+ *
+ * @details 満充電・目標充電率で終了した充電なら、充電時間を学習する。
+ * 充電電流なし・停止要求で終了した充電は本来の充電時間より短いため学習しない
+ */
+void ChargeSession::end(void) {
+  if (!_isActive) return;
+  _isActive = false;
+  _last = _current;
+  if (_last.release == RELEASE_FULL_CHARGE ||
+      _last.release == RELEASE_TARGET_SOC) {
+    float &expected = _expectedTime[_last.profile];
+    expected += LEARNING_RATE * (_last.chargeTime - expected);
+  }
+  logger.info("ChargeSession.end(): count = " + String(_last.count) +
+              ", release = " + String(getReleaseName(_last.release)) +
+              ", time = " + String(_last.chargeTime) + " sec");
+}
+
+/**
+ * @brief 充電中（リリース完了前）かどうか
+ *
+ * @return true 充電中
+ * @return false
+ */
+bool ChargeSession::isActive(void) { return _isActive; }
+
+/**
+ * @brief 実行中の充電の終了理由を記録済み（リリース中）かどうか
+ *
+ * @return true 記録済み
+ * @return false 充電していない、または充電を継続中
+ */
+bool ChargeSession::isReleased(void) { return _isActive && _isReleased; }
+
+/**
+ * @brief 直近に完了した充電の結果を取得する
+ *
+ * @return Result 結果（countが0なら完了した充電なし）
+ */
+ChargeSession::Result ChargeSession::getResult(void) { return _last; }
+
+/**
+ * @brief プロファイルごとの充電時間の学習値を取得する
+ *
+ * @param profile プロファイル
+ * @return float 充電時間[sec]
+ */
+float ChargeSession::getExpectedTime(ChargePolicy::ProfileType profile) {
+  return profile < ChargePolicy::PROFILE_NUM ? _expectedTime[profile]
+                                             : NOMINAL_TIME;
+}
+
+/**
+ * @brief 終了理由の名前を取得する
+ *
+ * @param release 終了理由
+ * @return const char* 名前
+ */
+const char *ChargeSession::getReleaseName(ReleaseType release) {
+  switch (release) {
+    case RELEASE_FULL_CHARGE:
+      return "fullCharge";
+    case RELEASE_TARGET_SOC:
+      return "targetSoc";
+    case RELEASE_NO_CURRENT:
+      return "noCurrent";
+    case RELEASE_STOP_REQUEST:
+      return "stopRequest";
+    default:
+      return "unknown";
+  }
+}
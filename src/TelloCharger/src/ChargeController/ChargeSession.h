@@ -0,0 +1,77 @@
+/**
+ * @file ChargeSession.h
+ * @brief 1回の充電（充電開始からアームのリリースまで）の記録
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 充電電流が流れ始めてから、充電を終了してアームのリリースが
+ * 完了するまでを1回の充電とし、終了理由と終了時の充電時間・充電電荷量・
+ * 推定充電率を記録する。満充電・目標充電率で終了した充電の時間から
+ * プロファイルごとの充電時間を学習し、充電ベイが空くまでの時間の推定に用いる。
+ * 制御ループからのみ呼び出す
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#include "ChargePolicy.h"
+
+class ChargeSession {
+ public:
+  typedef enum eRelease {
+    /** 不明（緊急停止などで充電が途切れた） */
+    RELEASE_UNKNOWN,
+    /** 満充電 */
+    RELEASE_FULL_CHARGE,
+    /** 推定充電率がリリースする充電率に達した */
+    RELEASE_TARGET_SOC,
+    /** 充電電流が流れなかった */
+    RELEASE_NO_CURRENT,
+    /** 充電停止要求 */
+    RELEASE_STOP_REQUEST,
+  } ReleaseType;
+
+  /**
+   * @brief 充電の結果
+   */
+  struct Result {
+    /** 起動からの充電の通し番号（0なら充電なし） */
+    uint32_t count;
+    /** 充電に使用したプロファイル */
+    ChargePolicy::ProfileType profile;
+    /** 終了理由 */
+    ReleaseType release;
+    /** 終了時の充電時間[sec] */
+    float chargeTime;
+    /** 終了時の充電電荷量[mAh] */
+    float chargeAmount;
+    /** 終了時の推定充電率[%]（推定不可なら-1） */
+    float soc;
+  };
+
+  ChargeSession();
+  ~ChargeSession();
+  void begin(ChargePolicy::ProfileType);
+  void release(ReleaseType, float, float, float);
+  void end(void);
+  bool isActive(void);
+  bool isReleased(void);
+  Result getResult(void);
+  float getExpectedTime(ChargePolicy::ProfileType);
+  static const char *getReleaseName(ReleaseType);
+
+  static const float NOMINAL_TIME;
+  static const float LEARNING_RATE;
+
+ private:
+  /** 充電中（リリース完了前）かどうか */
+  bool _isActive;
+  /** 実行中の充電の終了理由を記録済みかどうか */
+  bool _isReleased;
+  /** 実行中の充電 */
+  Result _current;
+  /** 直近に完了した充電 */
+  Result _last;
+  /** プロファイルごとの充電時間の学習値[sec] */
+  float _expectedTime[ChargePolicy::PROFILE_NUM];
+};
@@ -0,0 +1,85 @@
+/**
+ * @file ChargeSnapshot.h
+ * @brief 充電制御の状態のスナップショット
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 制御ループが周期ごとに公開する状態の複写。
+ * 通信タスクはこれを読み出すことで、制御ループが更新中の値を
+ * 直接参照せずに同じ時点の一貫した値を得られる。
+ * Seqlockで受け渡すため、固定長のデータのみを持つ
+ */
+
+#pragma once
+#include <stdint.h>
+
+#include "ChargeEstimator.h"
+#include "ChargePolicy.h"
+#include "ChargeSession.h"
+#include "ControlCalibrate.h"
+#include "CurrentReader.h"
+#include "PowerSample.h"
+
+/**
+ * @brief 充電制御の状態のスナップショット
+ */
+struct ChargeSnapshot {
+  /** 版数（公開回数。0なら未公開） */
+  uint32_t version;
+  /** 公開時刻[ms] */
+  uint32_t time;
+  /** 充電中かどうか */
+  bool isCharging;
+  /** 充電電流[mA] */
+  float current;
+  /** 充電時間[sec] */
+  float chargeTime;
+  /** 充電量[mAh] */
+  float chargeAmount;
+  /** 充電電力量[mWh] */
+  float chargeEnergy;
+  /** バス電圧[V] */
+  float busVoltage;
+  /** 充電中の最小バス電圧[V] */
+  float minBusVoltage;
+  /** 電力[mW] */
+  float power;
+  /** サンプリングレート[Hz] */
+  uint16_t samplingRate;
+  /** 充電フェーズ */
+  ChargeEstimator::ChargePhaseType chargePhase;
+  /** 推定充電率[%] */
+  float soc;
+  /** 満充電までの推定残り時間[sec] */
+  float timeToFull;
+  /** リリースする充電率[%] */
+  uint8_t targetSoc;
+  /** 充電の判定に使用中のプロファイル */
+  ChargePolicy::ProfileType profile;
+  /** 充電ベイが空くまでの推定時間[sec]（空いていれば0、推定不可なら-1） */
+  float timeToRelease;
+  /** プロファイルごとの1回の充電時間の学習値[sec] */
+  float expectedSessionTime[ChargePolicy::PROFILE_NUM];
+  /** 直近に完了した充電の結果 */
+  ChargeSession::Result lastSession;
+  /** 電流センサの状態 */
+  CurrentReader::SensorHealthType sensorHealth;
+  /** 電流センサの故障検出回数 */
+  uint32_t sensorFailedCount;
+  /** 電流センサの復帰回数 */
+  uint32_t sensorRecoveredCount;
+  /** サンプリングモードごとの滞在時間[ms] */
+  uint32_t samplingModeTime[CurrentReader::SAMPLING_MODE_NUM];
+  /** 充電開始制御の実行中かどうか */
+  bool isStartChargeExecuting;
+  /** 充電停止制御の実行中かどうか */
+  bool isStopChargeExecuting;
+  /** ドローン電源ON制御の実行中かどうか */
+  bool isPowerOnExecuting;
+  /** キャリブレーションの実行中かどうか */
+  bool isCalibrateExecuting;
+  /** キャリブレーションの結果 */
+  ControlCalibrate::CalibrateResultType calibrateResult;
+  /** 最新の電力サンプル */
+  PowerSample latestSample;
+};
@@ -0,0 +1,98 @@
+/**
+ * @file ChargeStation.cpp
+ * @brief 複数の充電ベイをまとめる充電ステーションクラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ */
+
+#include "ChargeStation.h"
+
+#include <Log.h>
+
+/** アイドル率をログ出力する周期[ms] */
+const uint32_t ChargeStation::IDLE_RATIO_LOG_CYCLE = 10000;
+
+/**
+ * @brief Construct a new Charge Station:: Charge Station object
+ *
+ * @details BayConfigに定義した全ベイの充電制御部を生成する。
+ * 電流センサのI2Cバスは全ベイで共有するため、ベイの生成前に1回だけ初期化する
+ */
+ChargeStation::ChargeStation()
+    : _scheduler(),
+      _i2cBus(),
+      _bayNum(BayConfig::getNum()),
+      _bays(new ChargeController *[_bayNum]),
+      _nextBay(0),
+      _idleRatioLogTimer(Timer(IDLE_RATIO_LOG_CYCLE)) {
+  _i2cBus.begin();
+  for (uint8_t i = 0; i < _bayNum; i++) {
+    _bays[i] = new ChargeController(*BayConfig::get(i), &_scheduler, &_i2cBus);
+  }
+}
+
+/**
+ * @brief Destroy the Charge Station:: Charge Station object
+ *
+ */
+ChargeStation::~ChargeStation() {
+  for (uint8_t i = 0; i < _bayNum; i++) delete _bays[i];
+  delete[] _bays;
+}
+
+/**
+ * @brief ベイ数を取得する
+ *
+ * @return uint8_t ベイ数
+ */
+uint8_t ChargeStation::getBayNum(void) { return _bayNum; }
+
+/**
+ * @brief ベイの充電制御部を取得する
+ *
+ * @param bay ベイ番号
+ * @return ChargeController* 充電制御部（範囲外ならNULL）
+ */
+ChargeController *ChargeStation::getBay(uint8_t bay) {
+  return bay < _bayNum ? _bays[bay] : NULL;
+}
+
+/**
+ * @brief 制御ループのスケジューラを取得する
+ *
+ * @return ControlScheduler* スケジューラ
+ */
+ControlScheduler *ChargeStation::getScheduler(void) { return &_scheduler; }
+
+/**
+ * @brief いずれかのベイが動作中かどうか
+ *
+ * @return true 動作中のベイがある
+ * @return false 全ベイが待機中
+ */
+bool ChargeStation::isActive(void) {
+  for (uint8_t i = 0; i < _bayNum; i++) {
+    if (_bays[i]->isActive()) return true;
+  }
+  return false;
+}
+
+/**
+ * @brief ループ処理
+ *
+ * @details 全ベイのループ処理を1回ずつ実行する。
+ * 先頭のベイを毎回ずらし、特定のベイの処理が常に後回しにならないようにする
+ */
+void ChargeStation::loop(void) {
+  for (uint8_t i = 0; i < _bayNum; i++) {
+    _bays[(_nextBay + i) % _bayNum]->loop();
+  }
+  _nextBay = (_nextBay + 1) % _bayNum;
+
+  if (_idleRatioLogTimer.isCycleTime()) {
+    logger.debug("ChargeStation.loop(): idle ratio = " +
+                 String(_scheduler.getIdleRatio() * 100) + " %");
+    _scheduler.resetIdleRatio();
+  }
+}
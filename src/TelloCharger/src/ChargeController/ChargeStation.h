@@ -0,0 +1,51 @@
+/**
+ * @file ChargeStation.h
+ * @brief 複数の充電ベイをまとめる充電ステーションクラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 充電ベイごとに充電制御部（状態機械・サーボ・MOSFET・電流計測）を
+ * 独立に持ち、1つの制御タスクから順番に実行する。
+ * 制御ループのスケジューラは全ベイで共有し、いずれかのベイが動作中なら
+ * 動作中の周期で実行する
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <Timer.h>
+
+#include "BayConfig.h"
+#include "ChargeController.h"
+#include "ControlScheduler.h"
+#include "I2cBus.h"
+
+class ChargeStation {
+ public:
+  ChargeStation();
+  ~ChargeStation();
+  uint8_t getBayNum(void);
+  ChargeController *getBay(uint8_t);
+  ControlScheduler *getScheduler(void);
+  bool isActive(void);
+
+  void loop(void);
+
+ private:
+  ChargeStation(const ChargeStation &) = delete;
+  ChargeStation &operator=(const ChargeStation &) = delete;
+
+  /** 制御ループの実行周期 */
+  ControlScheduler _scheduler;
+  /** 電流センサのI2Cバス（全ベイで共有） */
+  I2cBus _i2cBus;
+  /** ベイ数 */
+  uint8_t _bayNum;
+  /** ベイごとの充電制御部（ベイ番号の順） */
+  ChargeController **_bays;
+  /** 次のループで最初に実行するベイ番号 */
+  uint8_t _nextBay;
+  /** アイドル率のログ出力タイマー */
+  Timer _idleRatioLogTimer;
+
+  static const uint32_t IDLE_RATIO_LOG_CYCLE;
+};
@@ -4,40 +4,116 @@
  * @author Tatsuya Miyazaki
  * @date 2023/11/20
  *
- * @details サーボ電流を監視するクラス
+ * @details サーボ電流を監視するクラス。
+ * 学習済みの動作は電流波形の正常範囲からの逸脱でストールを検知し、
+ * 学習中の動作は指示値の収束後の過電流継続時間で検知する
  */
 
 #include "CheckServoCurrent.h"
 
 #include <Log.h>
 
+// この電流[mA]より大きければサーボモータ稼働中
+const float CheckServoCurrent::SERVO_CURRENT_MOVING_THREASHOLD = 150.0;
+// 以下の時間過電流を検知すればサーボを止める（電流波形が学習中の場合）
+const uint32_t CheckServoCurrent::SERVO_MOVING_TIMEOUT = 5000;
+// サーボ電流をログ出力する周期[ms]
+const uint32_t CheckServoCurrent::LOG_CYCLE = 500;
+
+/** 状態テーブル */
+const StateMachine<CheckServoCurrent>::State CheckServoCurrent::STATES[] = {
+    {STATE_MONITOR, "IDLE", NULL, NULL, 0},
+    {STATE_NONE, "DONE", NULL, NULL, 0},
+    {STATE_NONE, "MONITOR", NULL, NULL, 0},
+    {STATE_MONITOR, "OVER_CURRENT", &CheckServoCurrent::_startOverCurrent,
+     NULL, SERVO_MOVING_TIMEOUT},
+    {STATE_NONE, "EMERGENCY", &CheckServoCurrent::_startEmargencyStop, NULL,
+     0},
+    {STATE_EMERGENCY, "EMERGENCY_SELECT", NULL, NULL, 0},
+    {STATE_EMERGENCY, "EMERGENCY_OPEN", NULL, NULL, 0},
+    {STATE_EMERGENCY, "EMERGENCY_CLOSE", NULL, NULL, 0},
+};
+
+/**
+ * @brief 遷移テーブル
+ *
+ * @details ストールは監視中のどの状態でも検知し、両アームをその場で止めてから
+ * 非常停止に移る。非常停止で開く場合はUSBアーム→捕獲アームの順に開き、
+ * 閉じる場合は捕獲アーム→USBアームの順に閉じる（開く・閉じるの選択は
+ * _isOpenRequired()を参照）。動作途中で止めたアームもそこから動かす
+ */
+const StateMachine<CheckServoCurrent>::Transition
+    CheckServoCurrent::TRANSITIONS[] = {
+        {STATE_IDLE,
+         ON_SERVO_REACHED | eventMask(EVENT_SERVO_MOVING) |
+             eventMask(EVENT_FET_CHANGED),
+         &CheckServoCurrent::isServoOverCurrent, NULL, STATE_OVER_CURRENT},
+        {STATE_OVER_CURRENT, eventMask(EVENT_TIMEOUT),
+         &CheckServoCurrent::isServoOverCurrent, &CheckServoCurrent::_onTimeout,
+         STATE_EMERGENCY_SELECT},
+        {STATE_OVER_CURRENT,
+         eventMask(EVENT_TIMEOUT) | eventMask(EVENT_SERVO_IDLE) |
+             eventMask(EVENT_SERVO_STARTED) | eventMask(EVENT_FET_CHANGED),
+         &CheckServoCurrent::_isNotServoOverCurrent,
+         &CheckServoCurrent::_onFinish, STATE_DONE},
+        {STATE_MONITOR, eventMask(EVENT_STALL), NULL,
+         &CheckServoCurrent::_onStall, STATE_EMERGENCY_SELECT},
+        {STATE_EMERGENCY_SELECT, eventMask(EVENT_ENTERED),
+         &CheckServoCurrent::_isOpenRequired, NULL, STATE_EMERGENCY_OPEN},
+        {STATE_EMERGENCY_SELECT, eventMask(EVENT_ENTERED), NULL, NULL,
+         STATE_EMERGENCY_CLOSE},
+        {STATE_EMERGENCY_OPEN, ON_SERVO_REACHED,
+         &CheckServoCurrent::_isUsbStoppedAwayFromOff,
+         &CheckServoCurrent::_openUsb, STATE_NONE},
+        {STATE_EMERGENCY_OPEN, ON_SERVO_REACHED,
+         &CheckServoCurrent::_isDisconnectUsb, &CheckServoCurrent::_openCatch,
+         STATE_DONE},
+        {STATE_EMERGENCY_CLOSE, ON_SERVO_REACHED,
+         &CheckServoCurrent::_isCatchStoppedAwayFromCatch,
+         &CheckServoCurrent::_closeCatch, STATE_NONE},
+        {STATE_EMERGENCY_CLOSE, ON_SERVO_REACHED,
+         &CheckServoCurrent::_isCatchDrone, &CheckServoCurrent::_closeUsb,
+         STATE_DONE},
+};
+
 /**
  * @brief Construct a new Check Servo Current:: Check Servo Current object
  *
+ * @details 常に監視中のため開始・停止は行わず、待機中から遷移する
+ *
  * @param servo
  * @param fet
  * @param current
+ * @param bay 充電ベイの構成（ストール検知の学習値の保存先）
  */
 CheckServoCurrent::CheckServoCurrent(ServoController *servo, FETController *fet,
-                                     CurrentReader *current)
+                                     CurrentReader *current,
+                                     const BayConfig &bay)
     : ControlBase(servo, fet, current, "CheckServoCurrent"),
+      _stallDetector(bay),
+      _moveId(servo->getMoveId()),
+      _emergencyMoveId(_moveId),
+      _stalledMove(ServoController::MOVE_NONE),
       _isServoMovingPrevious(false),
-      _haveToEmargencyStopServo(false) {}
-
-// この電流[mA]より大きければサーボモータ稼働中
-const float CheckServoCurrent::SERVO_CURRENT_MOVING_THREASHOLD = 150.0;
-// 以下の時間過電流を検知すればサーボを止める
-const uint32_t CheckServoCurrent::SERVO_MOVING_TIMEOUT = 5000;
+      _haveToEmargencyStopServo(false),
+      _logTimer(Timer(LOG_CYCLE)),
+      _stateMachine(this, STATES, sizeof(STATES) / sizeof(STATES[0]),
+                    TRANSITIONS, sizeof(TRANSITIONS) / sizeof(TRANSITIONS[0])) {
+  _init(&_stateMachine, STATE_IDLE);
+}
 
 /**
- * @brief
+ * @brief 指示値の収束後もサーボ電流が流れているかどうか
+ *
+ * @details 電流センサが応答しない間は最後の値が残っているため判定しない
+ * （サーボの保持はChargeControllerが行う）
  *
  * @return true
  * @return false
  */
 bool CheckServoCurrent::isServoOverCurrent(void) {
-  return !_fet->read() && _servo->isTargetAngle() &&
-         isServoMoving(_current->getCurrent());
+  return _current->isConnect() && !_fet->read() && _servo->isTargetAngle() &&
+         isServoMoving(_current->getServoCurrent());
 }
 
 /**
@@ -55,83 +131,209 @@ bool CheckServoCurrent::haveToEmargencyStopServo(void) {
 }
 
 /**
- * @brief アームを初期位置に戻すループ処理
+ * @brief ストール検知部を取得する
+ *
+ * @return ServoStallDetector* ストール検知部
+ */
+ServoStallDetector *CheckServoCurrent::getStallDetector(void) {
+  return &_stallDetector;
+}
+
+/**
+ * @brief サーボ電流が学習した正常範囲を逸脱したかどうか
+ *
+ * @details 新しい動作の開始を検知して記録を切り替える。
+ * 非常停止で開始した動作は正常とは限らないため、学習もストール判定もしない
+ * （指示値の収束後の過電流継続のみで監視する）。
+ * 記録を終えた動作は、過電流の継続中や非常停止中でなくなってから学習する
+ * （タイムアウト・ストール・非常停止になれば学習せずに破棄する）。
+ * MOSFETがONの間は充電電流が含まれるため記録を破棄する
+ *
+ * @return true ストールを検知した
+ * @return false
+ */
+bool CheckServoCurrent::_isStall(void) {
+  if (_servo->getMoveId() != _moveId) {
+    _moveId = _servo->getMoveId();
+    _stallDetector.startMove(_servo->getMoveType(),
+                             _servo->getMoveStartTime());
+    if (_stateMachine.isIn(STATE_EMERGENCY) || _moveId == _emergencyMoveId) {
+      _stallDetector.abortMove();
+    }
+  }
+  if (!_stateMachine.isIn(STATE_OVER_CURRENT) &&
+      !_stateMachine.isIn(STATE_EMERGENCY)) {
+    _stallDetector.commitMove();
+  }
+  if (_fet->read() || !_current->isConnect()) {
+    _stallDetector.abortMove();
+    return false;
+  }
+  return _stallDetector.update(millis(), _current->getServoCurrent());
+}
+
+/**
+ * @brief 遷移条件: 非常停止でアームを開く方向に動かすかどうか
+ *
+ * @details ストールで中断した場合は、障害物から離れるよう中断した動作と
+ * 逆向きに動かす（閉じる動作なら開き、開く動作なら閉じる）。
+ * 過電流の継続で止めた場合はアームが目標角度にあるため、捕獲中なら開く
+ *
+ * @return true 開く
+ * @return false 閉じる
+ */
+bool CheckServoCurrent::_isOpenRequired(void) {
+  switch (_stalledMove) {
+    case ServoController::MOVE_CATCH:
+    case ServoController::MOVE_CATCH_ONCE:
+    case ServoController::MOVE_USB_ON:
+      return true;
+    case ServoController::MOVE_RELEASE:
+    case ServoController::MOVE_USB_OFF:
+      return false;
+    default:
+      return _servo->isCatchDrone();
+  }
+}
+
+/**
+ * @brief 遷移条件: 過電流が終わったかどうか
+ *
+ * @return true
+ * @return false
+ */
+bool CheckServoCurrent::_isNotServoOverCurrent(void) {
+  return !isServoOverCurrent();
+}
+
+/**
+ * @brief 入場処理: 過電流の継続時間の計測を開始する
+ *
+ */
+void CheckServoCurrent::_startOverCurrent(void) {
+  // サーボ指示値が収束した状態で過電流を検知した
+  _timer.startTimer();
+  _current->getCapture()->trigger(CurrentCapture::TRIGGER_SERVO_OVER_CURRENT);
+  logger.debug("checkServoTimeout(): start timer");
+}
+
+/**
+ * @brief 入場処理: 非常停止処理を開始する
+ *
+ * @details 過電流のタイムアウトやストールに至った動作は学習しない
+ */
+void CheckServoCurrent::_startEmargencyStop(void) {
+  _haveToEmargencyStopServo = true;
+  _stallDetector.rejectMove();
+}
+
+/**
+ * @brief 遷移処理: 過電流がタイムアウトした
+ *
+ */
+void CheckServoCurrent::_onTimeout(void) {
+  _stalledMove = ServoController::MOVE_NONE;
+  logger.error("checkServoTimeout(): servo moving timeout. time = " +
+               String(_timer.getTime()) +
+               ", current = " + String(_current->getServoCurrent()));
+}
+
+/**
+ * @brief 遷移処理: サーボの稼働が終了した
+ *
+ */
+void CheckServoCurrent::_onFinish(void) {
+  logger.debug("checkServoTimeout(): finish servo moving. time = " +
+               String(_timer.getTime()) +
+               ", current = " + String(_current->getServoCurrent()));
+}
+
+/**
+ * @brief 遷移処理: 電流波形が正常範囲を逸脱した
+ *
+ * @details 障害物へ押し付け続けないよう、非常停止の動作を選ぶ前に
+ * 両アームをその場で止める（サーボ電流は両サーボの合計のため、
+ * どちらのアームがストールしたかは区別できない）
+ */
+void CheckServoCurrent::_onStall(void) {
+  _stalledMove = _servo->getMoveType();
+  _servo->hold();
+  _current->getCapture()->trigger(CurrentCapture::TRIGGER_SERVO_OVER_CURRENT);
+  logger.error("checkServoTimeout(): servo stall detected. move = " +
+               String(_stalledMove) + ", elapsed = " +
+               String(millis() - _servo->getMoveStartTime()) +
+               ", current = " + String(_current->getServoCurrent()) +
+               ", catch = " + String(_servo->servoCatch()->getPresentAngle()) +
+               ", usb = " + String(_servo->servoUsb()->getPresentAngle()));
+}
+
+/**
+ * @brief 遷移処理: 非常停止でまずはUSBアームを離す
+ *
+ */
+void CheckServoCurrent::_openUsb(void) {
+  _servo->disconnectUsb();
+  _emergencyMoveId = _servo->getMoveId();
+  logger.info("emargencyStopServo(): Set USB servo angle from " +
+              String(_servo->servoUsb()->getPresentAngle()) + " to " +
+              String(_servo->servoUsb()->getTargetAngle()));
+}
+
+/**
+ * @brief 遷移処理: USBアームが離れてから捕獲アームを開く
+ *
+ */
+void CheckServoCurrent::_openCatch(void) {
+  _servo->releaseDrone();
+  _emergencyMoveId = _servo->getMoveId();
+  logger.info("emargencyStopServo(): Set Catch servo angle from " +
+              String(_servo->servoCatch()->getPresentAngle()) + " to " +
+              String(_servo->servoCatch()->getTargetAngle()));
+}
+
+/**
+ * @brief 遷移処理: 非常停止でまずは捕獲アームを閉じる
+ *
+ */
+void CheckServoCurrent::_closeCatch(void) {
+  _servo->catchDrone();
+  _emergencyMoveId = _servo->getMoveId();
+  logger.info("emargencyStopServo(): Set Catch servo angle from " +
+              String(_servo->servoCatch()->getPresentAngle()) + " to " +
+              String(_servo->servoCatch()->getTargetAngle()));
+}
+
+/**
+ * @brief 遷移処理: 捕獲アームが閉じてからUSBアームを接続する
+ *
+ */
+void CheckServoCurrent::_closeUsb(void) {
+  _servo->connectUsb();
+  _emergencyMoveId = _servo->getMoveId();
+  logger.info("emargencyStopServo(): Set USB servo angle from " +
+              String(_servo->servoUsb()->getPresentAngle()) + " to " +
+              String(_servo->servoUsb()->getTargetAngle()));
+}
+
+/**
+ * @brief サーボ電流を監視するループ処理
+ *
+ * @details ストール検知はサンプルごとに行い、検知すればEVENT_STALLを発行する。
+ * 完了後は待機中に戻り、過電流が続いていれば再び計測を開始する
  *
  * @return true 処理完了
  * @return false 処理中
  */
 bool CheckServoCurrent::loop(void) {
-  static Timer timer = Timer(500);
-  if (timer.isCycleTime()) {
-    logger.debug(
-        "checkServoTimeout(): current = " + String(_current->getCurrent()) +
-        ", isMoving = " + String(isServoOverCurrent()));
+  if (_logTimer.isCycleTime()) {
+    logger.debug("checkServoTimeout(): current = " +
+                 String(_current->getServoCurrent()) +
+                 ", isMoving = " + String(isServoOverCurrent()));
   }
-  switch (_step) {
-    case 0:
-      if (isServoOverCurrent()) {
-        // サーボ指示値が収束した状態で過電流を検知した
-        _timer.startTimer();
-        _step++;
-        logger.debug("checkServoTimeout(): start timer");
-      }
-      break;
-    case 1:
-      if (isServoOverCurrent() && _timer.getTime() >= SERVO_MOVING_TIMEOUT) {
-        // 過電流がタイムアウトした場合
-        logger.error("checkServoTimeout(): servo moving timeout. time = " +
-                     String(_timer.getTime()) +
-                     ", current = " + String(_current->getCurrent()));
-        _haveToEmargencyStopServo = true;
-        if (_servo->isCatchDrone())
-          _step = 10;
-        else
-          _step = 20;
-      } else if (!isServoOverCurrent()) {
-        // サーボの稼働が終了した
-        logger.debug("checkServoTimeout(): finish servo moving. time = " +
-                     String(_timer.getTime()) +
-                     ", current = " + String(_current->getCurrent()));
-        _step = 99;
-      }
-      break;
-    case 10:
-      // 非常停止処理（アームを開く）
-      if (_servo->isConnectUsb()) {
-        // まずはUSBアームを動かす
-        _servo->disconnectUsb();
-        logger.info("emargencyStopServo(): Set USB servo angle from " +
-                    String(_servo->servoUsb()->getPresentAngle()) + " to " +
-                    String(_servo->servoUsb()->getTargetAngle()));
-      } else if (_servo->isDisconnectUsb()) {
-        // USBアームが閉じてから捕獲アームを動かす
-        _servo->releaseDrone();
-        logger.info("emargencyStopServo(): Set Catch servo angle from " +
-                    String(_servo->servoCatch()->getPresentAngle()) + " to " +
-                    String(_servo->servoCatch()->getTargetAngle()));
-        _step = 99;
-      }
-      break;
-    case 20:
-      // 非常停止処理（アームを閉じる）
-      if (_servo->isReleaseDrone()) {
-        // まずは捕獲アームを動かす
-        _servo->catchDrone();
-        logger.info("emargencyStopServo(): Set Catch servo angle from " +
-                    String(_servo->servoCatch()->getPresentAngle()) + " to " +
-                    String(_servo->servoCatch()->getTargetAngle()));
-      } else if (_servo->isCatchDrone()) {
-        // 捕獲アームが閉じてからUSBアームを動かす
-        _servo->connectUsb();
-        logger.info("emargencyStopServo(): Set USB servo angle from " +
-                    String(_servo->servoUsb()->getPresentAngle()) + " to " +
-                    String(_servo->servoUsb()->getTargetAngle()));
-        _step = 99;
-      }
-      break;
-    default:
-      _step = 0;
-      return true;
+  if (_isStall()) post(EVENT_STALL);
+  if (ControlBase::loop()) {
+    _stateMachine.post(EVENT_ENTERED);
+    return true;
   }
   return false;
-}
\ No newline at end of file
+}
@@ -4,7 +4,9 @@
  * @author Tatsuya Miyazaki
  * @date 2023/11/20
  *
- * @details サーボ電流を監視するクラス
+ * @details サーボ電流を監視するクラス。
+ * 学習済みの動作は電流波形の正常範囲からの逸脱でストールを検知し、
+ * 学習中の動作は指示値の収束後の過電流継続時間で検知する
  */
 
 #pragma once
@@ -12,23 +14,69 @@
 #include <Timer.h>
 
 #include "ControlBase.h"
+#include "ServoStallDetector.h"
 
 class CheckServoCurrent : public ControlBase {
  public:
-  CheckServoCurrent(ServoController *, FETController *, CurrentReader *);
+  typedef enum eCheckServoCurrentState {
+    /** 監視中（子状態: STATE_IDLE, STATE_OVER_CURRENT） */
+    STATE_MONITOR = STATE_USER,
+    /** 指示値の収束後に過電流が続いている */
+    STATE_OVER_CURRENT,
+    /** 非常停止中（子状態: STATE_EMERGENCY_*） */
+    STATE_EMERGENCY,
+    /** アームを動かす方向を選ぶ */
+    STATE_EMERGENCY_SELECT,
+    /** アームを開く */
+    STATE_EMERGENCY_OPEN,
+    /** アームを閉じる */
+    STATE_EMERGENCY_CLOSE,
+    CHECK_SERVO_CURRENT_STATE_NUM,
+  } CheckServoCurrentStateType;
+
+  CheckServoCurrent(ServoController *, FETController *, CurrentReader *,
+                    const BayConfig &);
   static bool isServoMoving(float current) {
     return current >= SERVO_CURRENT_MOVING_THREASHOLD;
   }
   bool isServoOverCurrent(void);
   bool haveToEmargencyStopServo(void);
+  ServoStallDetector *getStallDetector(void);
   bool loop(void) override;
 
  private:
+  bool _isStall(void);
+  bool _isOpenRequired(void);
+  bool _isNotServoOverCurrent(void);
+  void _startOverCurrent(void);
+  void _startEmargencyStop(void);
+  void _onTimeout(void);
+  void _onFinish(void);
+  void _onStall(void);
+  void _openUsb(void);
+  void _openCatch(void);
+  void _closeCatch(void);
+  void _closeUsb(void);
+
+  /** 電流波形によるストール検知 */
+  ServoStallDetector _stallDetector;
+  /** ストール検知に反映済みの動作の番号 */
+  uint32_t _moveId;
+  /** 非常停止で最後に開始した動作の番号 */
+  uint32_t _emergencyMoveId;
+  /** ストールで中断した動作（MOVE_NONEなら過電流の継続による非常停止） */
+  ServoController::ServoMoveType _stalledMove;
   /** サーボモータの過電流対策 */
   bool _isServoMovingPrevious;
   /** サーボモータを異常停止すべきかどうか */
   bool _haveToEmargencyStopServo;
+  /** サーボ電流のログ出力タイマー */
+  Timer _logTimer;
+  StateMachine<CheckServoCurrent> _stateMachine;
 
   static const float SERVO_CURRENT_MOVING_THREASHOLD;
   static const uint32_t SERVO_MOVING_TIMEOUT;
+  static const uint32_t LOG_CYCLE;
+  static const StateMachine<CheckServoCurrent>::State STATES[];
+  static const StateMachine<CheckServoCurrent>::Transition TRANSITIONS[];
 };
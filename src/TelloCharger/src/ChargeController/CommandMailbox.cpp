@@ -0,0 +1,203 @@
+/**
+ * @file CommandMailbox.cpp
+ * @brief 充電制御へのコマンドの受け渡し
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ */
+
+#include "CommandMailbox.h"
+
+#include <Log.h>
+
+const uint8_t CommandMailbox::QUEUE_SIZE;
+const uint8_t CommandMailbox::RESULT_SIZE;
+
+/**
+ * @brief Construct a new Command Future:: Command Future object
+ *
+ * @details 受け付けられなかったコマンドのハンドルとなる
+ */
+CommandFuture::CommandFuture() : _mailbox(NULL), _sequence(0) {}
+
+/**
+ * @brief Construct a new Command Future:: Command Future object
+ *
+ * @param mailbox 送信先
+ * @param sequence 受付順の通し番号
+ */
+CommandFuture::CommandFuture(CommandMailbox *mailbox, uint32_t sequence)
+    : _mailbox(mailbox), _sequence(sequence) {}
+
+/**
+ * @brief 実行結果を取得する
+ *
+ * @return StatusType 実行結果
+ */
+CommandFuture::StatusType CommandFuture::getStatus(void) {
+  if (_mailbox == NULL) return STATUS_REJECTED;
+  return _mailbox->getResult(_sequence);
+}
+
+/**
+ * @brief コマンドの実行が完了するまで待つ
+ *
+ * @details 制御ループ以外のタスクから呼び出すこと（制御ループ内で待つと
+ * コマンドが実行されずタイムアウトする）
+ *
+ * @param timeout タイムアウト[ms]
+ * @return StatusType 実行結果（タイムアウトならSTATUS_PENDING）
+ */
+CommandFuture::StatusType CommandFuture::wait(uint32_t timeout) {
+  uint32_t start = millis();
+  StatusType status = getStatus();
+  while (status == STATUS_PENDING && millis() - start < timeout) {
+    vTaskDelay(1);
+    status = getStatus();
+  }
+  return status;
+}
+
+/**
+ * @brief 受付順の通し番号を取得する
+ *
+ * @return uint32_t 通し番号
+ */
+uint32_t CommandFuture::getSequence(void) { return _sequence; }
+
+/**
+ * @brief Construct a new Command Mailbox:: Command Mailbox object
+ *
+ */
+CommandMailbox::CommandMailbox() : _completedCount(0), _rejectedCount(0) {
+  for (uint8_t i = 0; i < RESULT_SIZE; i++) {
+    _results[i].store(CommandFuture::STATUS_EXPIRED,
+                      std::memory_order_relaxed);
+  }
+}
+
+/**
+ * @brief Destroy the Command Mailbox:: Command Mailbox object
+ *
+ */
+CommandMailbox::~CommandMailbox() {}
+
+/**
+ * @brief コマンドを送信する（複数のタスクから呼び出してよい）
+ *
+ * @param command コマンド（受付時刻はここで設定する）
+ * @return CommandFuture 実行結果を参照するハンドル
+ */
+CommandFuture CommandMailbox::submit(ChargeCommand command) {
+  command.time = micros();
+  uint32_t sequence;
+  if (!_commands.push(command, &sequence)) {
+    _rejectedCount.fetch_add(1, std::memory_order_relaxed);
+    logger.warn("CommandMailbox.submit(): Mailbox is full. command = " +
+                String(ChargeCommand::getName(command.type)) + ", source = " +
+                String(ChargeCommand::getSourceName(command.source)));
+    return CommandFuture();
+  }
+  return CommandFuture(this, sequence);
+}
+
+/**
+ * @brief 受付順の通し番号からコマンドのハンドルを取得する
+ *
+ * @param sequence submit()で返したハンドルの通し番号
+ * @return CommandFuture ハンドル（まだ受け付けていない番号なら
+ * 受け付けられなかったハンドル）
+ */
+CommandFuture CommandMailbox::find(uint32_t sequence) {
+  if ((int32_t)(sequence - _commands.getPushedCount()) >= 0) {
+    return CommandFuture();
+  }
+  return CommandFuture(this, sequence);
+}
+
+/**
+ * @brief 次に実行するコマンドを取り出す（制御ループからのみ呼び出すこと）
+ *
+ * @details 取り出したコマンドを実行したらcomplete()を呼び出すこと
+ *
+ * @param command 取り出したコマンドの格納先
+ * @return true 取り出せた
+ * @return false 実行待ちのコマンドがない
+ */
+bool CommandMailbox::receive(ChargeCommand &command) {
+  return _commands.pop(command);
+}
+
+/**
+ * @brief 取り出したコマンドの実行結果を記録する
+ *
+ * @details complete()で完了を通知する前に呼び出すこと
+ *
+ * @param sequence 取り出したコマンドの通し番号
+ * @param status 実行結果
+ */
+void CommandMailbox::setResult(uint32_t sequence,
+                               CommandFuture::StatusType status) {
+  _results[sequence % RESULT_SIZE].store((sequence << 8) | (uint8_t)status,
+                                         std::memory_order_relaxed);
+}
+
+/**
+ * @brief 取り出したコマンドの実行完了を通知する
+ *
+ */
+void CommandMailbox::complete(void) {
+  _completedCount.store(_completedCount.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_release);
+}
+
+/**
+ * @brief コマンドが実行済みかどうか
+ *
+ * @param sequence 受付順の通し番号
+ * @return true
+ * @return false
+ */
+bool CommandMailbox::isCompleted(uint32_t sequence) {
+  return (int32_t)(_completedCount.load(std::memory_order_acquire) -
+                   sequence) > 0;
+}
+
+/**
+ * @brief コマンドの実行結果を取得する
+ *
+ * @details 結果はcomplete()の通知より前に記録されるため、実行済みなら
+ * 記録済みである。後のコマンドの結果で上書きされていればSTATUS_EXPIRED
+ *
+ * @param sequence 受付順の通し番号
+ * @return CommandFuture::StatusType 実行結果
+ */
+CommandFuture::StatusType CommandMailbox::getResult(uint32_t sequence) {
+  if (!isCompleted(sequence)) return CommandFuture::STATUS_PENDING;
+  uint32_t result =
+      _results[sequence % RESULT_SIZE].load(std::memory_order_relaxed);
+  if ((result >> 8) != (sequence & 0x00FFFFFF)) {
+    return CommandFuture::STATUS_EXPIRED;
+  }
+  return (CommandFuture::StatusType)(result & 0xFF);
+}
+
+/**
+ * @brief 実行済みのコマンド数を取得する
+ *
+ * @details 取り出したコマンドの通し番号と一致する（complete()を呼ぶまで）
+ *
+ * @return uint32_t 実行済みのコマンド数
+ */
+uint32_t CommandMailbox::getCompletedCount(void) {
+  return _completedCount.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief キューが一杯のため受け付けられなかったコマンド数を取得する
+ *
+ * @return uint32_t コマンド数
+ */
+uint32_t CommandMailbox::getRejectedCount(void) {
+  return _rejectedCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,95 @@
+/**
+ * @file CommandMailbox.h
+ * @brief 充電制御へのコマンドの受け渡し
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 通信タスク（WebAPI・MQTT、Core 0）から制御ループ（Core 1）へ
+ * コマンドを受け渡すロックフリーのキュー。
+ * 制御ループは決まった位置でコマンドを受け付けた順に実行するため、
+ * 複数のクライアントから同時に要求が届いても状態機械を操作するのは
+ * 制御ループのみとなり、実行順も一意に決まる。
+ * 送信側は受け取ったCommandFutureで実行の完了を待つことができる。
+ * 待てない送信側（WebAPIのハンドラなど）は通し番号を控えておき、
+ * find()で後から実行結果を参照する。
+ * 実行結果は直近RESULT_SIZE件のみ保持する
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#include <atomic>
+
+#include "ChargeCommand.h"
+#include "MpscRingBuffer.h"
+
+class CommandMailbox;
+
+/**
+ * @brief 送信したコマンドの実行結果を参照するハンドル
+ */
+class CommandFuture {
+ public:
+  typedef enum eStatus {
+    /** 制御ループでの実行待ち */
+    STATUS_PENDING,
+    /** 実行済み */
+    STATUS_DONE,
+    /** 制御ループが実行を拒否した（電流センサが応答しないなど） */
+    STATUS_REFUSED,
+    /** 実行できなかった（未知のコマンドなど） */
+    STATUS_FAILED,
+    /** 実行済みだが結果の保持期間を過ぎた */
+    STATUS_EXPIRED,
+    /** キューが一杯のため受け付けられなかった */
+    STATUS_REJECTED,
+  } StatusType;
+
+  CommandFuture();
+  CommandFuture(CommandMailbox *, uint32_t);
+  StatusType getStatus(void);
+  StatusType wait(uint32_t);
+  uint32_t getSequence(void);
+
+ private:
+  /** 送信先（NULLなら受け付けられなかった） */
+  CommandMailbox *_mailbox;
+  /** 受付順の通し番号 */
+  uint32_t _sequence;
+};
+
+class CommandMailbox {
+ public:
+  CommandMailbox();
+  ~CommandMailbox();
+  CommandFuture submit(ChargeCommand);
+  CommandFuture find(uint32_t);
+  bool receive(ChargeCommand &);
+  void setResult(uint32_t, CommandFuture::StatusType);
+  void complete(void);
+  bool isCompleted(uint32_t);
+  CommandFuture::StatusType getResult(uint32_t);
+  uint32_t getCompletedCount(void);
+  uint32_t getRejectedCount(void);
+
+  /** キューの長さ（2のべき乗） */
+  static const uint8_t QUEUE_SIZE = 16;
+  /** 実行結果を保持するコマンド数 */
+  static const uint8_t RESULT_SIZE = 32;
+
+ private:
+  CommandMailbox(const CommandMailbox &) = delete;
+  CommandMailbox &operator=(const CommandMailbox &) = delete;
+
+  /** 実行待ちのコマンド */
+  MpscRingBuffer<ChargeCommand, QUEUE_SIZE> _commands;
+  /**
+   * 実行結果（通し番号の下位24ビットを上位に、StatusTypeを下位8ビットに
+   * 詰める。制御ループのみ更新）
+   */
+  std::atomic<uint32_t> _results[RESULT_SIZE];
+  /** 実行済みのコマンド数（制御ループのみ更新） */
+  std::atomic<uint32_t> _completedCount;
+  /** キューが一杯のため受け付けられなかったコマンド数 */
+  std::atomic<uint32_t> _rejectedCount;
+};
@@ -11,24 +11,82 @@
 
 #include <Log.h>
 
+/** USB接続後、サーボ電流がこの時間[ms]落ち着いていればMOSFETをONする */
+const uint32_t ControlArmCharge::SETTLE_TIME = 5000;
+
+/** 状態テーブル */
+const StateMachine<ControlArmCharge>::State ControlArmCharge::STATES[] = {
+    {STATE_NONE, "IDLE", NULL, NULL, 0},
+    {STATE_NONE, "DONE", NULL, NULL, 0},
+    {STATE_NONE, "CATCH", NULL, NULL, 0},
+    {STATE_NONE, "CONNECT_USB", NULL, NULL, 0},
+    {STATE_NONE, "SETTLE", NULL, NULL, SETTLE_TIME},
+    {STATE_NONE, "FET_ON", &ControlArmCharge::_startCharge, NULL, 0},
+    {STATE_NONE, "RETRY", &ControlArmCharge::_retry, NULL, 0},
+};
+
+/**
+ * @brief 遷移テーブル
+ *
+ * @details 指定した回数捕獲したら、捕獲アームの到達前でもUSBアームと
+ * 干渉しなくなった時点（捕獲時に設定したタイムアウト）でUSBを接続する。
+ * 干渉しない角度を実機で教示していなければ、捕獲アームの到達を待つ。
+ * サーボ電流が稼働中のしきい値をまたぐたびに待ち時間をやり直す
+ */
+const StateMachine<ControlArmCharge>::Transition
+    ControlArmCharge::TRANSITIONS[] = {
+        {STATE_CATCH, ON_SERVO_REACHED, &ControlArmCharge::_isReleaseDrone,
+         &ControlArmCharge::_catch, STATE_NONE},
+        {STATE_CATCH, ON_SERVO_REACHED | eventMask(EVENT_TIMEOUT),
+         &ControlArmCharge::_isCatchDone, NULL, STATE_CONNECT_USB},
+        {STATE_CATCH, ON_SERVO_REACHED, &ControlArmCharge::_isCatchDrone,
+         &ControlArmCharge::_releaseDrone, STATE_NONE},
+        {STATE_CONNECT_USB, ON_SERVO_REACHED,
+         &ControlArmCharge::_isDisconnectUsb, &ControlArmCharge::_connectUsb,
+         STATE_NONE},
+        {STATE_CONNECT_USB, ON_SERVO_REACHED, &ControlArmCharge::_canRetry,
+         NULL, STATE_RETRY},
+        {STATE_CONNECT_USB, ON_SERVO_REACHED, &ControlArmCharge::_isConnectUsb,
+         NULL, STATE_SETTLE},
+        {STATE_SETTLE,
+         eventMask(EVENT_SERVO_MOVING) | eventMask(EVENT_SERVO_IDLE), NULL,
+         NULL, STATE_SETTLE},
+        {STATE_SETTLE, eventMask(EVENT_TIMEOUT),
+         &ControlArmCharge::_isServoMoving, NULL, STATE_SETTLE},
+        {STATE_SETTLE, eventMask(EVENT_TIMEOUT), NULL, NULL, STATE_FET_ON},
+        {STATE_FET_ON, eventMask(EVENT_ENTERED), NULL, NULL, STATE_DONE},
+        {STATE_RETRY, ON_SERVO_REACHED, &ControlArmCharge::_isConnectUsb,
+         &ControlArmCharge::_disconnectUsb, STATE_NONE},
+        {STATE_RETRY, ON_SERVO_REACHED | eventMask(EVENT_USB_CLEAR),
+         &ControlArmCharge::_isUsbClear, NULL, STATE_CATCH},
+};
+
+/**
+ * @brief Construct a new Control Arm Charge:: Control Arm Charge object
+ *
+ * @param servo
+ * @param fet
+ * @param current
+ * @param chargeTimer
+ */
 ControlArmCharge::ControlArmCharge(ServoController *servo, FETController *fet,
                                    CurrentReader *current, Timer *chargeTimer)
     : ControlBase(servo, fet, current, "ControlArmCharge"),
       _chargeTimer(chargeTimer),
+      _stateMachine(this, STATES, sizeof(STATES) / sizeof(STATES[0]),
+                    TRANSITIONS, sizeof(TRANSITIONS) / sizeof(TRANSITIONS[0])),
       _catchCnt(0),
       _catchCntTarget(1),
       _retryCnt(0),
-      _retryCntTarget(0) {}
+      _retryCntTarget(0) {
+  _init(&_stateMachine, STATE_CATCH);
+}
 
 /**
  * @brief 処理を開始する
  *
  */
-void ControlArmCharge::start(void) {
-  ControlBase::start();
-  _catchCntTarget = 1;
-  _retryCntTarget = 0;
-}
+void ControlArmCharge::start(void) { start(1, 0); }
 
 /**
  * @brief 充電を開始する
@@ -37,9 +95,11 @@ void ControlArmCharge::start(void) {
  * @param retryCnt USB接続するまでの動作をリトライする回数
  */
 void ControlArmCharge::start(uint8_t catchCnt, uint8_t retryCnt) {
-  ControlBase::start();
   _catchCntTarget = catchCnt;
   _retryCntTarget = retryCnt;
+  _catchCnt = 0;
+  _retryCnt = 0;
+  ControlBase::start();
 }
 
 /**
@@ -50,83 +110,67 @@ void ControlArmCharge::stop(void) {
   ControlBase::stop();
   _fet->off();
   _chargeTimer->stopTimer();
+  _current->stopCoulombCounter();
+}
+
+/**
+ * @brief 遷移条件: 指定した回数捕獲し、USBを接続してよいかどうか
+ *
+ * @return true
+ * @return false
+ */
+bool ControlArmCharge::_isCatchDone(void) {
+  return _catchCnt >= _catchCntTarget &&
+         (_servo->isCatchDrone() || _servo->canConnectUsb());
 }
 
 /**
- * @brief 充電接続するループ処理
+ * @brief 遷移条件: USBを接続し、リトライ回数が残っているかどうか
  *
- * @return true 処理完了
- * @return false 処理中
+ * @return true
+ * @return false
  */
-bool ControlArmCharge::loop(void) {
-  switch (_step) {
-    case 0:
-      // 何もしない
-      break;
-    case 1:
-      // 初期化
-      _catchCnt = 0;
-      _retryCnt = 0;
-      _step++;
-    case 2:
-      // 捕獲する
-      if (_servo->isReleaseDrone()) {
-        if (_catchCntTarget - _catchCnt <= 1) {
-          _servo->catchDrone();
-        } else {
-          _servo->catchDroneOnce();
-        }
-        _catchCnt++;
-      } else if (_servo->isCatchDrone()) {
-        if (_catchCnt >= _catchCntTarget)
-          // 指定した回数捕獲したら次に進む
-          _step++;
-        else
-          _servo->releaseDrone();
-      }
-      break;
-    case 3:
-      // USBを接続する
-      if (_servo->isDisconnectUsb())
-        _servo->connectUsb();
-      else if (_servo->isConnectUsb()) {
-        if (_retryCnt < _retryCntTarget) {
-          _catchCnt = 0;
-          _step = 6;
-          _retryCnt++;
-        } else {
-          _timer.startTimer();
-          _step++;
-        }
-      }
-      break;
-    case 4:
-      if (CheckServoCurrent::isServoMoving(_current->getCurrent())) {
-        _timer.startTimer();
-      } else if (_timer.getTime() > 5000) {
-        _step++;
-      }
-      break;
-    case 5:
-      // MOSFETをONにする
-      if (!_fet->read()) {
-        _fet->on();
-        _chargeTimer->startTimer();
-        logger.info("chargeLoop(): start charge timer");
-      } else {
-        _step = 99;
-      }
-      break;
-    case 6:
-      if (_servo->isConnectUsb())
-        _servo->disconnectUsb();
-      else if (_servo->isDisconnectUsb())
-        _step = 2;
-      break;
-    default:
-      // 初期位置に戻す処理完了
-      _step = 0;
-      return true;
+bool ControlArmCharge::_canRetry(void) {
+  return _servo->isConnectUsb() && _retryCnt < _retryCntTarget;
+}
+
+/**
+ * @brief 遷移処理: 捕獲アームを捕獲位置に動かす
+ *
+ * @details 最後の捕獲では、USBアームを動かし始めてよくなる時刻に
+ * タイムアウトを設定する（判定できなければ設定しない）
+ */
+void ControlArmCharge::_catch(void) {
+  if (_catchCntTarget - _catchCnt <= 1) {
+    _servo->catchDrone();
+  } else {
+    _servo->catchDroneOnce();
+  }
+  _catchCnt++;
+  if (_catchCnt >= _catchCntTarget) {
+    int32_t delay = _servo->getConnectUsbDelay();
+    if (delay >= 0) _stateMachine.setTimeout(delay > 0 ? delay : 1);
   }
-  return false;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 入場処理: 捕獲をやり直す準備をする
+ *
+ */
+void ControlArmCharge::_retry(void) {
+  _catchCnt = 0;
+  _retryCnt++;
+}
+
+/**
+ * @brief 入場処理: MOSFETをONして充電を始める
+ *
+ */
+void ControlArmCharge::_startCharge(void) {
+  if (_fet->read()) return;
+  _fet->on();
+  _chargeTimer->startTimer();
+  _current->startCoulombCounter();
+  _current->resetMinBusVoltage();
+  logger.info("chargeLoop(): start charge timer");
+}
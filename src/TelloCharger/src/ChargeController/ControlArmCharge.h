@@ -19,15 +19,35 @@
 
 class ControlArmCharge : public ControlBase {
  public:
+  typedef enum eArmChargeState {
+    /** 捕獲する */
+    STATE_CATCH = STATE_USER,
+    /** USBを接続する */
+    STATE_CONNECT_USB,
+    /** サーボ電流が落ち着くのを待つ */
+    STATE_SETTLE,
+    /** MOSFETをONする */
+    STATE_FET_ON,
+    /** USBアームを離して捕獲をやり直す */
+    STATE_RETRY,
+    ARM_CHARGE_STATE_NUM,
+  } ArmChargeStateType;
+
   ControlArmCharge(ServoController *, FETController *, CurrentReader *,
                    Timer *);
   void start(void);
   void stop(void);
   void start(uint8_t, uint8_t);
-  bool loop(void) override;
 
  private:
+  bool _isCatchDone(void);
+  bool _canRetry(void);
+  void _catch(void);
+  void _retry(void);
+  void _startCharge(void);
+
   Timer *_chargeTimer;
+  StateMachine<ControlArmCharge> _stateMachine;
   /** 充電開始時の捕獲回数 */
   uint8_t _catchCnt;
   /** 充電開始時の捕獲目標回数 */
@@ -36,4 +56,8 @@ class ControlArmCharge : public ControlBase {
   uint8_t _retryCnt;
   /** USBを接続するまでの動作を行う目標回数 */
   uint8_t _retryCntTarget;
+
+  static const uint32_t SETTLE_TIME;
+  static const StateMachine<ControlArmCharge>::State STATES[];
+  static const StateMachine<ControlArmCharge>::Transition TRANSITIONS[];
 };
@@ -11,6 +11,36 @@
 
 #include <Log.h>
 
+/** 状態テーブル */
+const StateMachine<ControlArmInit>::State ControlArmInit::STATES[] = {
+    {STATE_NONE, "IDLE", NULL, NULL, 0},
+    {STATE_NONE, "DONE", NULL, NULL, 0},
+    {STATE_NONE, "FET_OFF", &ControlArmInit::_stopCharge, NULL, 0},
+    {STATE_NONE, "USB_OFF", NULL, NULL, 0},
+    {STATE_NONE, "CATCH_OFF", NULL, NULL, 0},
+};
+
+/**
+ * @brief 遷移テーブル
+ *
+ * @details USBアームは干渉領域から出れば到達を待たずに捕獲アームを戻し、
+ * 両アームが初期位置に到達すれば完了する。
+ * 非常停止などで動作途中に止めたアームも、止まっていれば初期位置へ戻す
+ */
+const StateMachine<ControlArmInit>::Transition ControlArmInit::TRANSITIONS[] = {
+    {STATE_FET_OFF, eventMask(EVENT_ENTERED), NULL, NULL, STATE_USB_OFF},
+    {STATE_USB_OFF, ON_SERVO_REACHED,
+     &ControlArmInit::_isUsbStoppedAwayFromOff, &ControlArmInit::_disconnectUsb,
+     STATE_NONE},
+    {STATE_USB_OFF, ON_SERVO_REACHED | eventMask(EVENT_USB_CLEAR),
+     &ControlArmInit::_isUsbClear, NULL, STATE_CATCH_OFF},
+    {STATE_CATCH_OFF, ON_SERVO_REACHED,
+     &ControlArmInit::_isCatchStoppedAwayFromRelease,
+     &ControlArmInit::_releaseDrone, STATE_NONE},
+    {STATE_CATCH_OFF, ON_SERVO_REACHED, &ControlArmInit::_isInitPos, NULL,
+     STATE_DONE},
+};
+
 /**
  * @brief Construct a new Control Arm Init:: Control Arm Init object
  * 
@@ -22,48 +52,22 @@
 ControlArmInit::ControlArmInit(ServoController *servo, FETController *fet,
                                CurrentReader *current, Timer *chargeTimer)
     : ControlBase(servo, fet, current, "ControlArmInit"),
-      _chargeTimer(chargeTimer) {}
+      _chargeTimer(chargeTimer),
+      _stateMachine(this, STATES, sizeof(STATES) / sizeof(STATES[0]),
+                    TRANSITIONS, sizeof(TRANSITIONS) / sizeof(TRANSITIONS[0])) {
+  _init(&_stateMachine, STATE_FET_OFF);
+}
 
 /**
- * @brief アームを初期位置に戻すループ処理
+ * @brief 入場処理: MOSFETがONであればOFFして充電を終える
  *
- * @return true 処理完了
- * @return false 処理中
  */
-bool ControlArmInit::loop(void) {
-  switch (_step) {
-    case 0:
-      // 何もしない
-      break;
-    case 1:
-      // MOSFETをOFFする
-      if (_fet->read()) {
-        _fet->off();
-        _chargeTimer->stopTimer();
-        logger.info("chargeLoop(): stop charge timer, " +
-                    String(_chargeTimer->getTime()));
-      } else {
-        _step++;
-      }
-      break;
-    case 2:
-      // USBアームが接続中であれば離す
-      if (_servo->isConnectUsb())
-        _servo->disconnectUsb();
-      else if (_servo->isDisconnectUsb())
-        _step++;
-      break;
-    case 3:
-      // 捕獲アームが捕獲中の場合は戻す
-      if (_servo->isCatchDrone())
-        _servo->releaseDrone();
-      else if (_servo->isReleaseDrone())
-        _step++;
-      break;
-    default:
-      // 初期位置に戻す処理完了
-      _step = 0;
-      return true;
-  }
-  return false;
-}
\ No newline at end of file
+void ControlArmInit::_stopCharge(void) {
+  if (!_fet->read()) return;
+  _fet->off();
+  _chargeTimer->stopTimer();
+  _current->stopCoulombCounter();
+  logger.info("chargeLoop(): stop charge timer, " +
+              String(_chargeTimer->getTime()) + ", charge amount = " +
+              String(_current->getChargeAmount()) + " mAh");
+}
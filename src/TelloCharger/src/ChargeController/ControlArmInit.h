@@ -18,9 +18,24 @@
 
 class ControlArmInit : public ControlBase {
  public:
+  typedef enum eArmInitState {
+    /** MOSFETをOFFする */
+    STATE_FET_OFF = STATE_USER,
+    /** USBアームを離す */
+    STATE_USB_OFF,
+    /** 捕獲アームを戻す */
+    STATE_CATCH_OFF,
+    ARM_INIT_STATE_NUM,
+  } ArmInitStateType;
+
   ControlArmInit(ServoController *, FETController *, CurrentReader *, Timer *);
-  bool loop(void) override;
 
  private:
+  void _stopCharge(void);
+
   Timer *_chargeTimer;
+  StateMachine<ControlArmInit> _stateMachine;
+
+  static const StateMachine<ControlArmInit>::State STATES[];
+  static const StateMachine<ControlArmInit>::Transition TRANSITIONS[];
 };
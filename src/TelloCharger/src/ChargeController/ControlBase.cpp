@@ -4,13 +4,16 @@
  * @author Tatsuya Miyazaki
  * @date 2023/11/18
  *
- * @details 充電器制御のベースクラス
+ * @details 充電器制御のベースクラス。
+ * 状態機械の開始・停止と、子制御へのイベントの受け渡しを行う
  */
 
 #include "ControlBase.h"
 
 #include <Log.h>
 
+#include "CheckServoCurrent.h"
+
 /**
  * @brief Construct a new Control Base:: Control Base object
  *
@@ -23,9 +26,12 @@ ControlBase::ControlBase(ServoController *servo, FETController *fet,
     : _servo(servo),
       _fet(fet),
       _current(current),
-      _step(0),
+      _machine(NULL),
+      _initialState(STATE_IDLE),
+      _childNum(0),
       _timer(Timer()),
-      _className(className) {}
+      _className(className),
+      _startTime(0) {}
 
 /**
  * @brief Destroy the Control Base:: Control Base object
@@ -33,22 +39,29 @@ ControlBase::ControlBase(ServoController *servo, FETController *fet,
  */
 ControlBase::~ControlBase() {}
 
+constexpr uint16_t ControlBase::ON_SERVO_REACHED;
+const uint8_t ControlBase::MAX_CHILD_NUM;
+
 /**
  * @brief 処理を開始する
  *
  */
 void ControlBase::start(void) {
-  _step = 1;
-  logger.info(_className + ".start(): _step = " + String(_step));
+  _startTime = millis();
+  _machine->start(_initialState);
+  logger.info(_className + ".start(): state = " +
+              _machine->getStateName(_machine->getState()));
 }
 
 /**
  * @brief 処理を終了する
  *
+ * @details 退出処理は行わない。子制御の停止は各制御で行う
  */
 void ControlBase::stop(void) {
-  _step = 0;
-  logger.info(_className + ".stop(): _step = " + String(_step));
+  _machine->reset(STATE_IDLE);
+  logger.info(_className + ".stop(): state = " +
+              _machine->getStateName(_machine->getState()));
 }
 
 /**
@@ -57,4 +70,232 @@ void ControlBase::stop(void) {
  * @return true
  * @return false
  */
-bool ControlBase::isExecuting(void) { return _step != 0; }
+bool ControlBase::isExecuting(void) {
+  return _machine->getState() != STATE_IDLE;
+}
+
+/**
+ * @brief 処理の開始からの経過時間を取得する
+ *
+ * @return uint32_t 経過時間[ms]
+ */
+uint32_t ControlBase::getElapsedTime(void) { return millis() - _startTime; }
+
+/**
+ * @brief イベントを通知する
+ *
+ * @details 実行中の子制御にも通知する
+ *
+ * @param event イベント
+ */
+void ControlBase::post(ControlEventType event) {
+  _machine->post(event);
+  for (uint8_t i = 0; i < _childNum; i++) {
+    if (_children[i]->isExecuting()) _children[i]->post(event);
+  }
+}
+
+/**
+ * @brief 未処理のイベントがあるかどうか
+ *
+ * @details 実行中の子制御のイベントも含める（遷移時に開始した子制御の
+ * EVENT_ENTEREDは次のloop()で処理される）
+ *
+ * @return true
+ * @return false
+ */
+bool ControlBase::hasEvent(void) {
+  if (_machine->hasEvent()) return true;
+  for (uint8_t i = 0; i < _childNum; i++) {
+    if (_children[i]->isExecuting() && _children[i]->hasEvent()) return true;
+  }
+  return false;
+}
+
+/**
+ * @brief 通知されたイベントを処理するループ処理
+ *
+ * @details 実行中の子制御の処理を先に行い、子制御が完了すれば
+ * EVENT_CHILD_DONEを発行する。イベントがなければ遷移の判定は行わない
+ *
+ * @return true 処理完了
+ * @return false 処理中
+ */
+bool ControlBase::loop(void) {
+  for (uint8_t i = 0; i < _childNum; i++) {
+    if (_children[i]->isExecuting() && _children[i]->loop()) {
+      _machine->post(EVENT_CHILD_DONE);
+    }
+  }
+  _machine->dispatch();
+  if (_machine->getState() == STATE_DONE) {
+    _machine->reset(STATE_IDLE);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief クラス名を取得する
+ *
+ * @return String クラス名
+ */
+String ControlBase::getName(void) { return _className; }
+
+/**
+ * @brief 状態機械を取得する（遷移回数・滞在時間の参照用）
+ *
+ * @return StateMachineBase* 状態機械
+ */
+StateMachineBase *ControlBase::getStateMachine(void) { return _machine; }
+
+/**
+ * @brief 子制御の数を取得する
+ *
+ * @return uint8_t 子制御の数
+ */
+uint8_t ControlBase::getChildNum(void) { return _childNum; }
+
+/**
+ * @brief 子制御を取得する
+ *
+ * @param index 番号
+ * @return ControlBase* 子制御（範囲外ならNULL）
+ */
+ControlBase *ControlBase::getChild(uint8_t index) {
+  return index < _childNum ? _children[index] : NULL;
+}
+
+/**
+ * @brief 状態機械を設定する（派生クラスのコンストラクタで呼ぶ）
+ *
+ * @param machine 状態機械
+ * @param initialState 開始時の状態
+ */
+void ControlBase::_init(StateMachineBase *machine, uint8_t initialState) {
+  _machine = machine;
+  _initialState = initialState;
+}
+
+/**
+ * @brief 子制御を登録する（派生クラスのコンストラクタで呼ぶ）
+ *
+ * @param child 子制御
+ */
+void ControlBase::_addChild(ControlBase *child) {
+  if (_childNum < MAX_CHILD_NUM) _children[_childNum++] = child;
+}
+
+/**
+ * @brief 遷移条件: 捕獲アームが捕獲位置にあるかどうか
+ *
+ * @return true
+ * @return false
+ */
+bool ControlBase::_isCatchDrone(void) { return _servo->isCatchDrone(); }
+
+/**
+ * @brief 遷移条件: 捕獲アームが解放位置にあるかどうか
+ *
+ * @return true
+ * @return false
+ */
+bool ControlBase::_isReleaseDrone(void) { return _servo->isReleaseDrone(); }
+
+/**
+ * @brief 遷移条件: USBアームが接続位置にあるかどうか
+ *
+ * @return true
+ * @return false
+ */
+bool ControlBase::_isConnectUsb(void) { return _servo->isConnectUsb(); }
+
+/**
+ * @brief 遷移条件: USBアームが切断位置にあるかどうか
+ *
+ * @return true
+ * @return false
+ */
+bool ControlBase::_isDisconnectUsb(void) { return _servo->isDisconnectUsb(); }
+
+/**
+ * @brief 遷移条件: USBアームが干渉領域の外にあるかどうか
+ *
+ * @return true
+ * @return false
+ */
+bool ControlBase::_isUsbClear(void) { return _servo->isUsbClear(); }
+
+/**
+ * @brief 遷移条件: USBアームが切断位置以外で止まっているかどうか
+ *
+ * @details 動作途中で止めたアームを含む
+ *
+ * @return true
+ * @return false
+ */
+bool ControlBase::_isUsbStoppedAwayFromOff(void) {
+  return _servo->servoUsb()->isTargetAngle() && !_servo->isDisconnectUsb();
+}
+
+/**
+ * @brief 遷移条件: 捕獲アームがリリース位置以外で止まっているかどうか
+ *
+ * @details 動作途中で止めたアームを含む
+ *
+ * @return true
+ * @return false
+ */
+bool ControlBase::_isCatchStoppedAwayFromRelease(void) {
+  return _servo->servoCatch()->isTargetAngle() && !_servo->isReleaseDrone();
+}
+
+/**
+ * @brief 遷移条件: 捕獲アームが捕獲位置以外で止まっているかどうか
+ *
+ * @details 動作途中で止めたアームを含む
+ *
+ * @return true
+ * @return false
+ */
+bool ControlBase::_isCatchStoppedAwayFromCatch(void) {
+  return _servo->servoCatch()->isTargetAngle() && !_servo->isCatchDrone();
+}
+
+/**
+ * @brief 遷移条件: 両アームが初期位置にあるかどうか
+ *
+ * @return true
+ * @return false
+ */
+bool ControlBase::_isInitPos(void) {
+  return _servo->isReleaseDrone() && _servo->isDisconnectUsb();
+}
+
+/**
+ * @brief 遷移条件: サーボ電流が稼働中のしきい値以上かどうか
+ *
+ * @return true
+ * @return false
+ */
+bool ControlBase::_isServoMoving(void) {
+  return CheckServoCurrent::isServoMoving(_current->getServoCurrent());
+}
+
+/**
+ * @brief 遷移処理: 捕獲アームを解放位置に動かす
+ *
+ */
+void ControlBase::_releaseDrone(void) { _servo->releaseDrone(); }
+
+/**
+ * @brief 遷移処理: USBアームを接続位置に動かす
+ *
+ */
+void ControlBase::_connectUsb(void) { _servo->connectUsb(); }
+
+/**
+ * @brief 遷移処理: USBアームを切断位置に動かす
+ *
+ */
+void ControlBase::_disconnectUsb(void) { _servo->disconnectUsb(); }
@@ -4,7 +4,10 @@
  * @author Tatsuya Miyazaki
  * @date 2023/11/18
  *
- * @details 充電器制御のベースクラス
+ * @details 充電器制御のベースクラス。
+ * 各制御は状態機械（StateMachine）で構成し、ChargeControllerが検出した
+ * イベント（サーボの到達、電流の変化など）で遷移する。
+ * 状態ID 0 を待機中、1 を完了とする
  */
 
 #pragma once
@@ -14,28 +17,106 @@
 #include "CurrentReader.h"
 #include "FETController.h"
 #include "ServoController.h"
+#include "StateMachine.h"
 
 class ControlBase {
  public:
+  typedef enum eControlEvent {
+    /** 状態に入場した（StateMachineBase::EVENT_ENTEREDと一致させる） */
+    EVENT_ENTERED,
+    /** タイムアウトが経過した（StateMachineBase::EVENT_TIMEOUTと一致させる） */
+    EVENT_TIMEOUT,
+    /** サーボが動作を開始した（指示値が変わった） */
+    EVENT_SERVO_STARTED,
+    /** いずれかのサーボが指示値に到達した */
+    EVENT_SERVO_REACHED,
+    /** USBアームが捕獲アームとの干渉領域から出た */
+    EVENT_USB_CLEAR,
+    /** サーボ電流が稼働中のしきい値を上回った */
+    EVENT_SERVO_MOVING,
+    /** サーボ電流が稼働中のしきい値を下回った */
+    EVENT_SERVO_IDLE,
+    /** MOSFETの状態が変わった */
+    EVENT_FET_CHANGED,
+    /** 子制御が完了した */
+    EVENT_CHILD_DONE,
+    /** サーボ電流が学習した正常範囲を逸脱した */
+    EVENT_STALL,
+    /** 掃引中のアームが接触した */
+    EVENT_CONTACT,
+    CONTROL_EVENT_NUM,
+  } ControlEventType;
+
+  typedef enum eControlState {
+    /** 待機中 */
+    STATE_IDLE,
+    /** 完了（loop()で待機中に戻る） */
+    STATE_DONE,
+    /** 各制御の状態はここから */
+    STATE_USER,
+    /** 状態なし（最上位の親状態・状態を変えない遷移先） */
+    STATE_NONE = StateMachineBase::NO_STATE,
+  } ControlStateType;
+
   ControlBase(ServoController *, FETController *, CurrentReader *,
               String className = "ControlBase");
-  ~ControlBase();
+  virtual ~ControlBase();
   void start(void);
   void stop(void);
   bool isExecuting(void);
-  virtual bool loop(void) = 0;
+  uint32_t getElapsedTime(void);
+  void post(ControlEventType);
+  bool hasEvent(void);
+  virtual bool loop(void);
+  String getName(void);
+  StateMachineBase *getStateMachine(void);
+  uint8_t getChildNum(void);
+  ControlBase *getChild(uint8_t);
+
+  /** 入場時とサーボの到達時に判定する遷移のイベントマスク */
+  static constexpr uint16_t ON_SERVO_REACHED =
+      eventMask(EVENT_ENTERED) | eventMask(EVENT_SERVO_REACHED);
+  static const uint8_t MAX_CHILD_NUM = 2;
 
  protected:
+  void _init(StateMachineBase *, uint8_t);
+  void _addChild(ControlBase *);
+  bool _isCatchDrone(void);
+  bool _isReleaseDrone(void);
+  bool _isConnectUsb(void);
+  bool _isDisconnectUsb(void);
+  bool _isUsbClear(void);
+  bool _isUsbStoppedAwayFromOff(void);
+  bool _isCatchStoppedAwayFromRelease(void);
+  bool _isCatchStoppedAwayFromCatch(void);
+  bool _isInitPos(void);
+  bool _isServoMoving(void);
+  void _releaseDrone(void);
+  void _connectUsb(void);
+  void _disconnectUsb(void);
+
   /** サーボ制御部 */
   ServoController *_servo;
   /** MOSFET制御部 */
   FETController *_fet;
   /** 電流計測部 */
   CurrentReader *_current;
-  /** 処理のステップ */
-  uint8_t _step;
+  /** 状態機械 */
+  StateMachineBase *_machine;
+  /** 開始時の状態 */
+  uint8_t _initialState;
+  /** 子制御 */
+  ControlBase *_children[MAX_CHILD_NUM];
+  /** 子制御の数 */
+  uint8_t _childNum;
   /** 制御用のタイマー */
   Timer _timer;
   /** クラス名 */
   String _className;
+  /** 処理の開始時刻[ms] */
+  uint32_t _startTime;
+
+ private:
+  ControlBase(const ControlBase &) = delete;
+  ControlBase &operator=(const ControlBase &) = delete;
 };
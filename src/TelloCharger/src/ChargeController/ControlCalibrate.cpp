@@ -0,0 +1,356 @@
+/**
+ * @file ControlCalibrate.cpp
+ * @brief アーム角度自動キャリブレーション制御クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details ドローンを載せた状態で各サーボをゆっくり動かし、
+ * サーボ電流の上昇からアームがドローンに接触した角度を検出する。
+ * 捕獲角度は接触角度にオフセットを加えた角度、USB接続角度は接触後に
+ * コネクタを押し込んだ角度として角度テーブルに登録してNVSに保存する
+ */
+
+#include "ControlCalibrate.h"
+
+#include <Log.h>
+
+/** 掃引時のサーボの最大速度[deg/s] */
+const float ControlCalibrate::SWEEP_VEL = 15;
+/** 掃引時のサーボの最大加速度[deg/s^2]（接触時に1deg以内で止まる） */
+const float ControlCalibrate::SWEEP_ACC = 150;
+/** 捕獲サーボを掃引する終端角度[deg] */
+const float ControlCalibrate::CATCH_SWEEP_END = 40;
+/** USBサーボを掃引する終端角度[deg] */
+const float ControlCalibrate::USB_SWEEP_END = 80;
+/** 掃引開始後にサーボ電流の基準値を計測する時間[ms] */
+const uint32_t ControlCalibrate::BASELINE_TIME = 300;
+/** 基準値からこの電流[mA]以上上昇すれば接触とみなす */
+const float ControlCalibrate::CONTACT_RISE = 150.0;
+/** 接触とみなす連続上昇回数 */
+const uint8_t ControlCalibrate::CONTACT_COUNT = 3;
+/** 捕獲角度の接触角度からのオフセット[deg]（押し付けないよう手前で止める） */
+const float ControlCalibrate::CATCH_OFFSET = -2;
+/** 位置決め捕獲角度の接触角度からのオフセット[deg] */
+const float ControlCalibrate::CATCH_ONCE_OFFSET = 4;
+/** USBコネクタの接触角度から押し込む最大の深さ[deg] */
+const float ControlCalibrate::USB_SEAT_DEPTH = 3;
+/**
+ * 押し込み中に基準値からこの電流[mA]以上上昇すれば押し込みを止める
+ * （コネクタが奥まで入り、サーボがストールし始めたとみなす）
+ */
+const float ControlCalibrate::SEAT_RISE = 300.0;
+
+/** 状態テーブル */
+const StateMachine<ControlCalibrate>::State ControlCalibrate::STATES[] = {
+    {STATE_NONE, "IDLE", NULL, NULL, 0},
+    {STATE_NONE, "DONE", NULL, NULL, 0},
+    {STATE_NONE, "ARM_INIT", &ControlCalibrate::_startArmInit, NULL, 0},
+    {STATE_NONE, "SWEEP", NULL, NULL, 0},
+    {STATE_SWEEP, "SWEEP_CATCH", &ControlCalibrate::_startCatchSweep, NULL,
+     0},
+    {STATE_NONE, "HOLD_CATCH", NULL, NULL, 0},
+    {STATE_SWEEP, "SWEEP_USB", &ControlCalibrate::_startUsbSweep, NULL, 0},
+    {STATE_SWEEP, "SEAT_USB", &ControlCalibrate::_startUsbSeat, NULL, 0},
+    {STATE_NONE, "RETURN", &ControlCalibrate::_startArmInit, NULL, 0},
+};
+
+/**
+ * @brief 遷移テーブル
+ *
+ * @details 掃引中はloop()でサーボ電流を監視し、接触すればEVENT_CONTACTを発行する。
+ * 接触せずに終端に到達すれば失敗とする。
+ * USBサーボは接触後もコネクタを押し込み、電流がSEAT_RISEまで上昇するか
+ * USB_SEAT_DEPTHだけ押し込んだ角度をUSB接続角度とする
+ */
+const StateMachine<ControlCalibrate>::Transition
+    ControlCalibrate::TRANSITIONS[] = {
+        {STATE_ARM_INIT, eventMask(EVENT_CHILD_DONE), NULL, NULL,
+         STATE_SWEEP_CATCH},
+        {STATE_SWEEP_CATCH, eventMask(EVENT_CONTACT), NULL,
+         &ControlCalibrate::_onCatchContact, STATE_HOLD_CATCH},
+        {STATE_SWEEP_CATCH, eventMask(EVENT_SERVO_REACHED),
+         &ControlCalibrate::_isSweepEnd, &ControlCalibrate::_onCatchNoContact,
+         STATE_RETURN},
+        {STATE_HOLD_CATCH, ON_SERVO_REACHED, &ControlCalibrate::_isTargetAngle,
+         NULL, STATE_SWEEP_USB},
+        {STATE_SWEEP_USB, eventMask(EVENT_CONTACT), NULL,
+         &ControlCalibrate::_onUsbContact, STATE_SEAT_USB},
+        {STATE_SWEEP_USB, eventMask(EVENT_SERVO_REACHED),
+         &ControlCalibrate::_isSweepEnd, &ControlCalibrate::_onUsbNoContact,
+         STATE_RETURN},
+        {STATE_SEAT_USB, eventMask(EVENT_CONTACT), NULL,
+         &ControlCalibrate::_onUsbSeated, STATE_RETURN},
+        {STATE_SEAT_USB, eventMask(EVENT_SERVO_REACHED),
+         &ControlCalibrate::_isSweepEnd, &ControlCalibrate::_onUsbSeated,
+         STATE_RETURN},
+        {STATE_RETURN, eventMask(EVENT_CHILD_DONE), NULL,
+         &ControlCalibrate::_onReturn, STATE_DONE},
+};
+
+/**
+ * @brief Construct a new Control Calibrate:: Control Calibrate object
+ *
+ * @param servo
+ * @param fet
+ * @param current
+ * @param chargeTimer
+ */
+ControlCalibrate::ControlCalibrate(ServoController *servo, FETController *fet,
+                                   CurrentReader *current, Timer *chargeTimer)
+    : ControlBase(servo, fet, current, "ControlCalibrate"),
+      _controlArmInit(servo, fet, current, chargeTimer),
+      _stateMachine(this, STATES, sizeof(STATES) / sizeof(STATES[0]),
+                    TRANSITIONS, sizeof(TRANSITIONS) / sizeof(TRANSITIONS[0])),
+      _sweepAxis(NULL),
+      _baselineSum(0),
+      _baselineCount(0),
+      _contactRise(CONTACT_RISE),
+      _contactCount(0),
+      _contactAngle(0),
+      _catchContactAngle(0),
+      _usbContactAngle(0),
+      _result(CALIBRATE_NONE) {
+  _init(&_stateMachine, STATE_ARM_INIT);
+  _addChild(&_controlArmInit);
+}
+
+/**
+ * @brief 処理を開始する
+ *
+ */
+void ControlCalibrate::start(void) {
+  _result = CALIBRATE_NONE;
+  ControlBase::start();
+}
+
+/**
+ * @brief 処理を終了する
+ *
+ * @details 掃引中に中断された場合もサーボの速度制限を元に戻す
+ */
+void ControlCalibrate::stop(void) {
+  if (isExecuting()) _servo->resetLimits();
+  ControlBase::stop();
+  _controlArmInit.stop();
+}
+
+/**
+ * @brief 実行結果を取得する
+ *
+ * @return CalibrateResultType 実行結果
+ */
+ControlCalibrate::CalibrateResultType ControlCalibrate::getResult(void) {
+  return _result;
+}
+
+/**
+ * @brief キャリブレーションのループ処理
+ *
+ * @details 掃引中はサンプルごとにサーボ電流を監視する
+ *
+ * @return true 処理完了
+ * @return false 処理中
+ */
+bool ControlCalibrate::loop(void) {
+  if (_stateMachine.isIn(STATE_SWEEP) && _sweep()) post(EVENT_CONTACT);
+  return ControlBase::loop();
+}
+
+/**
+ * @brief 入場処理: アームを初期位置に戻し始める
+ *
+ */
+void ControlCalibrate::_startArmInit(void) { _controlArmInit.start(); }
+
+/**
+ * @brief 入場処理: 捕獲サーボの掃引を開始する
+ *
+ */
+void ControlCalibrate::_startCatchSweep(void) {
+  _startSweep(_servo->servoCatch(), CATCH_SWEEP_END);
+}
+
+/**
+ * @brief 入場処理: USBサーボの掃引を開始する
+ *
+ */
+void ControlCalibrate::_startUsbSweep(void) {
+  _startSweep(_servo->servoUsb(), USB_SWEEP_END);
+}
+
+/**
+ * @brief 遷移条件: 掃引中のサーボが終端に到達したかどうか
+ *
+ * @return true
+ * @return false
+ */
+bool ControlCalibrate::_isSweepEnd(void) {
+  return _sweepAxis != NULL && _sweepAxis->isTargetAngle();
+}
+
+/**
+ * @brief 遷移条件: 両サーボが指示値に到達したかどうか
+ *
+ * @return true
+ * @return false
+ */
+bool ControlCalibrate::_isTargetAngle(void) { return _servo->isTargetAngle(); }
+
+/**
+ * @brief 遷移処理: 捕獲サーボが接触した
+ *
+ * @details 捕獲角度まで戻し、その位置でUSBの接触位置を決める
+ */
+void ControlCalibrate::_onCatchContact(void) {
+  _catchContactAngle = _contactAngle;
+  logger.info("ControlCalibrate.loop(): catch contact angle = " +
+              String(_catchContactAngle));
+  _servo->setServoCatch(_catchContactAngle + CATCH_OFFSET);
+}
+
+/**
+ * @brief 遷移処理: 捕獲サーボが接触せずに終端に到達した
+ *
+ */
+void ControlCalibrate::_onCatchNoContact(void) {
+  _fail("catch servo did not touch the drone");
+}
+
+/**
+ * @brief 遷移処理: USBサーボが接触した
+ *
+ */
+void ControlCalibrate::_onUsbContact(void) {
+  _usbContactAngle = _contactAngle;
+  logger.info("ControlCalibrate.loop(): usb contact angle = " +
+              String(_usbContactAngle));
+}
+
+/**
+ * @brief 入場処理: USBコネクタの押し込みを開始する
+ *
+ * @details 掃引と同じ速度で接触角度からUSB_SEAT_DEPTHまで動かし、
+ * 基準値からの電流の上昇がSEAT_RISEを超えないか監視する
+ */
+void ControlCalibrate::_startUsbSeat(void) {
+  float seatAngle = min(_usbContactAngle + USB_SEAT_DEPTH, USB_SWEEP_END);
+  _servo->setServoUsb(seatAngle);
+  _contactRise = SEAT_RISE;
+  _contactCount = 0;
+}
+
+/**
+ * @brief 遷移処理: USBコネクタを押し込んだ
+ *
+ * @details 電流が上昇し始めた角度（上昇しなければ押し込んだ角度）を
+ * USB接続角度とし、角度テーブルに登録して保存する。
+ * 登録・保存に失敗すれば登録前の角度テーブルに戻す
+ * （NVSに保存値がない場合も途中まで登録した角度を残さない）
+ */
+void ControlCalibrate::_onUsbSeated(void) {
+  float seatAngle = _sweepAxis->isTargetAngle()
+                        ? _sweepAxis->getTargetAngle()
+                        : max(_contactAngle, _usbContactAngle);
+  logger.info("ControlCalibrate.loop(): usb seat angle = " +
+              String(seatAngle));
+  // 押し付け続けないようUSBアームを離す
+  _servo->disconnectUsb();
+  ServoCalibration *calibration = _servo->calibration();
+  ServoCalibration backup = *calibration;
+  if (calibration->setAngle(ServoCalibration::ANGLE_DRONE_CATCH,
+                            _catchContactAngle + CATCH_OFFSET) &&
+      calibration->setAngle(ServoCalibration::ANGLE_DRONE_CATCH_ONCE,
+                            _catchContactAngle + CATCH_ONCE_OFFSET) &&
+      calibration->setAngle(ServoCalibration::ANGLE_USB_ON, seatAngle) &&
+      calibration->save()) {
+    _servo->resetLimits();
+    _result = CALIBRATE_SUCCEEDED;
+  } else {
+    *calibration = backup;
+    _fail("invalid angles");
+  }
+}
+
+/**
+ * @brief 遷移処理: USBサーボが接触せずに終端に到達した
+ *
+ */
+void ControlCalibrate::_onUsbNoContact(void) {
+  _fail("usb servo did not touch the drone");
+}
+
+/**
+ * @brief 遷移処理: アームが初期位置に戻った
+ *
+ */
+void ControlCalibrate::_onReturn(void) {
+  logger.info("ControlCalibrate.loop(): " + _servo->calibration()->toString());
+}
+
+/**
+ * @brief サーボの掃引を開始する
+ *
+ * @param axis 掃引するサーボ
+ * @param endAngle 終端角度[deg]
+ */
+void ControlCalibrate::_startSweep(ServoAxis *axis, float endAngle) {
+  axis->setLimits(SWEEP_VEL, SWEEP_ACC);
+  if (axis == _servo->servoCatch()) {
+    _servo->setServoCatch(endAngle);
+  } else {
+    _servo->setServoUsb(endAngle);
+  }
+  _baselineSum = 0;
+  _baselineCount = 0;
+  _contactRise = CONTACT_RISE;
+  _contactCount = 0;
+  _sweepAxis = axis;
+  _timer.startTimer();
+}
+
+/**
+ * @brief 掃引中のサーボ電流を監視する
+ *
+ * @details 掃引開始直後のサーボ電流を基準値とし、基準値から
+ * 接触とみなす上昇（掃引中はCONTACT_RISE、押し込み中はSEAT_RISE）以上が
+ * CONTACT_COUNT回続けば接触とみなす。
+ * 接触角度は上昇し始めた時点の角度とする。
+ * 接触を検出した場合、遷移処理ですぐにサーボを戻すか、
+ * 押し込む深さを制限した角度へ向かわせること
+ *
+ * @return true 接触を検出した
+ * @return false
+ */
+bool ControlCalibrate::_sweep(void) {
+  float current = _current->getServoCurrent();
+  if (_timer.getTime() < BASELINE_TIME) {
+    _baselineSum += current;
+    _baselineCount++;
+    return false;
+  }
+  float baseline = _baselineCount > 0 ? _baselineSum / _baselineCount : 0;
+  if (current >= baseline + _contactRise) {
+    if (_contactCount == 0) _contactAngle = _sweepAxis->getPresentAngle();
+    if (++_contactCount >= CONTACT_COUNT) return true;
+  } else {
+    _contactCount = 0;
+  }
+  return false;
+}
+
+/**
+ * @brief キャリブレーションを失敗として終了する
+ *
+ * @details 角度テーブルは変更せず、アームを初期位置に戻す。
+ * 掃引を終えたアームは角度テーブルのどの角度にもないため、
+ * 初期位置に戻す処理が判定できるよう先に離す方向へ動かしておく
+ *
+ * @param reason 失敗の理由
+ */
+void ControlCalibrate::_fail(const String &reason) {
+  logger.error("ControlCalibrate.loop(): Calibration failed, " + reason);
+  _servo->resetLimits();
+  _servo->disconnectUsb();
+  if (_servo->isUsbClear()) _servo->releaseDrone();
+  _result = CALIBRATE_FAILED;
+}
@@ -0,0 +1,110 @@
+/**
+ * @file ControlCalibrate.h
+ * @brief アーム角度自動キャリブレーション制御クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details ドローンを載せた状態で各サーボをゆっくり動かし、
+ * サーボ電流の上昇からアームがドローンに接触した角度を検出する。
+ * 捕獲角度は接触角度にオフセットを加えた角度、USB接続角度は接触後に
+ * コネクタを押し込んだ角度として角度テーブルに登録してNVSに保存する
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <Timer.h>
+
+#include "ControlArmInit.h"
+#include "ControlBase.h"
+#include "CurrentReader.h"
+#include "FETController.h"
+#include "ServoController.h"
+
+class ControlCalibrate : public ControlBase {
+ public:
+  typedef enum eCalibrateResult {
+    /** 未実行・実行中 */
+    CALIBRATE_NONE,
+    /** 成功（角度テーブルを保存した） */
+    CALIBRATE_SUCCEEDED,
+    /** 失敗（角度テーブルは変更していない） */
+    CALIBRATE_FAILED,
+  } CalibrateResultType;
+
+  typedef enum eCalibrateState {
+    /** アームを初期位置に戻す */
+    STATE_ARM_INIT = STATE_USER,
+    /** 掃引中（子状態: STATE_SWEEP_CATCH, STATE_SWEEP_USB, STATE_SEAT_USB） */
+    STATE_SWEEP,
+    /** 捕獲サーボを閉じる方向に掃引する */
+    STATE_SWEEP_CATCH,
+    /** 捕獲サーボを捕獲角度に戻す */
+    STATE_HOLD_CATCH,
+    /** USBサーボを接続する方向に掃引する */
+    STATE_SWEEP_USB,
+    /** 接触したUSBコネクタを押し込む */
+    STATE_SEAT_USB,
+    /** アームを初期位置に戻す（終了時） */
+    STATE_RETURN,
+    CALIBRATE_STATE_NUM,
+  } CalibrateStateType;
+
+  ControlCalibrate(ServoController *, FETController *, CurrentReader *,
+                   Timer *);
+  void start(void);
+  void stop(void);
+  bool loop(void) override;
+  CalibrateResultType getResult(void);
+
+ private:
+  void _startArmInit(void);
+  void _startCatchSweep(void);
+  void _startUsbSweep(void);
+  void _startSweep(ServoAxis *, float);
+  bool _sweep(void);
+  bool _isSweepEnd(void);
+  bool _isTargetAngle(void);
+  void _onCatchContact(void);
+  void _onCatchNoContact(void);
+  void _onUsbContact(void);
+  void _startUsbSeat(void);
+  void _onUsbSeated(void);
+  void _onUsbNoContact(void);
+  void _onReturn(void);
+  void _fail(const String &);
+
+  ControlArmInit _controlArmInit;
+  StateMachine<ControlCalibrate> _stateMachine;
+  /** 掃引中のサーボ */
+  ServoAxis *_sweepAxis;
+  /** 掃引中のサーボ電流の基準値の積算値[mA] */
+  float _baselineSum;
+  /** 基準値の積算回数 */
+  uint16_t _baselineCount;
+  /** 接触とみなす基準値からの上昇[mA] */
+  float _contactRise;
+  /** 基準値を連続して上回った回数 */
+  uint8_t _contactCount;
+  /** 基準値を上回り始めた角度[deg] */
+  float _contactAngle;
+  /** 捕獲サーボの接触角度[deg] */
+  float _catchContactAngle;
+  /** USBサーボの接触角度[deg] */
+  float _usbContactAngle;
+  /** 実行結果 */
+  CalibrateResultType _result;
+
+  static const float SWEEP_VEL;
+  static const float SWEEP_ACC;
+  static const float CATCH_SWEEP_END;
+  static const float USB_SWEEP_END;
+  static const uint32_t BASELINE_TIME;
+  static const float CONTACT_RISE;
+  static const uint8_t CONTACT_COUNT;
+  static const float CATCH_OFFSET;
+  static const float CATCH_ONCE_OFFSET;
+  static const float USB_SEAT_DEPTH;
+  static const float SEAT_RISE;
+  static const StateMachine<ControlCalibrate>::State STATES[];
+  static const StateMachine<ControlCalibrate>::Transition TRANSITIONS[];
+};
@@ -14,6 +14,30 @@
 /** 電源ON時に接続したアームを離すまでの時間[ms] */
 const uint16_t ControlPowerOnDrone::POWER_ON_WAIT = 2000;
 
+/** 状態テーブル */
+const StateMachine<ControlPowerOnDrone>::State ControlPowerOnDrone::STATES[] = {
+    {STATE_NONE, "IDLE", NULL, NULL, 0},
+    {STATE_NONE, "DONE", NULL, NULL, 0},
+    {STATE_NONE, "ARM_INIT", &ControlPowerOnDrone::_startArmInit, NULL, 0},
+    {STATE_NONE, "ARM_CHARGE", &ControlPowerOnDrone::_startArmCharge, NULL,
+     0},
+    {STATE_NONE, "WAIT", NULL, NULL, POWER_ON_WAIT},
+    {STATE_NONE, "ARM_RELEASE", &ControlPowerOnDrone::_startArmInit, NULL,
+     0},
+};
+
+/** 遷移テーブル */
+const StateMachine<ControlPowerOnDrone>::Transition
+    ControlPowerOnDrone::TRANSITIONS[] = {
+        {STATE_ARM_INIT, eventMask(EVENT_CHILD_DONE), NULL, NULL,
+         STATE_ARM_CHARGE},
+        {STATE_ARM_CHARGE, eventMask(EVENT_CHILD_DONE), NULL, NULL,
+         STATE_WAIT},
+        {STATE_WAIT, eventMask(EVENT_TIMEOUT), NULL, NULL, STATE_ARM_RELEASE},
+        {STATE_ARM_RELEASE, eventMask(EVENT_CHILD_DONE), NULL, NULL,
+         STATE_DONE},
+};
+
 /**
  * @brief Construct a new Control Power On Drone:: Control Power On Drone object
  *
@@ -27,8 +51,14 @@ ControlPowerOnDrone::ControlPowerOnDrone(ServoController *servo,
                                          CurrentReader *current,
                                          Timer *chargeTimer)
     : ControlBase(servo, fet, current, "ControlPowerOnDrone"),
-      _controlArmInit(ControlArmInit(servo, fet, current, chargeTimer)),
-      _controlArmCharge(ControlArmCharge(servo, fet, current, chargeTimer)) {}
+      _controlArmInit(servo, fet, current, chargeTimer),
+      _controlArmCharge(servo, fet, current, chargeTimer),
+      _stateMachine(this, STATES, sizeof(STATES) / sizeof(STATES[0]),
+                    TRANSITIONS, sizeof(TRANSITIONS) / sizeof(TRANSITIONS[0])) {
+  _init(&_stateMachine, STATE_ARM_INIT);
+  _addChild(&_controlArmInit);
+  _addChild(&_controlArmCharge);
+}
 
 /**
  * @brief 処理を終了する
@@ -41,51 +71,13 @@ void ControlPowerOnDrone::stop(void) {
 }
 
 /**
- * @brief ドローンの電源をONするループ処理
+ * @brief 入場処理: アームを初期位置に戻し始める
+ *
+ */
+void ControlPowerOnDrone::_startArmInit(void) { _controlArmInit.start(); }
+
+/**
+ * @brief 入場処理: 充電接続を始める
  *
- * @return true 処理完了
- * @return false 処理中
  */
-bool ControlPowerOnDrone::loop(void) {
-  switch (_step) {
-    case 0:
-      // 何もしない
-      break;
-    case 1:
-      // 初期処理
-      _controlArmInit.start();
-      _step++;
-      break;
-    case 2:
-      // アームを初期位置に戻す
-      if (_controlArmInit.loop()) {
-        _controlArmCharge.start();
-        _step++;
-      }
-      break;
-    case 3:
-      // 充電接続する
-      if (_controlArmCharge.loop()) {
-        _timer.startTimer();
-        _step++;
-      }
-      break;
-    case 4:
-      // 1秒後に充電を終了する
-      if (_timer.getTime() >= POWER_ON_WAIT) {
-        _controlArmInit.start();
-        _step++;
-      }
-      break;
-    case 5:
-      // アームを初期位置に戻す
-      if (_controlArmInit.loop()) {
-        _step++;
-      }
-      break;
-    default:
-      _step = 0;
-      return true;
-  }
-  return false;
-}
\ No newline at end of file
+void ControlPowerOnDrone::_startArmCharge(void) { _controlArmCharge.start(); }
@@ -20,13 +20,31 @@
 
 class ControlPowerOnDrone : public ControlBase {
  public:
+  typedef enum ePowerOnDroneState {
+    /** アームを初期位置に戻す */
+    STATE_ARM_INIT = STATE_USER,
+    /** 充電接続する */
+    STATE_ARM_CHARGE,
+    /** 電源が入るまで待つ */
+    STATE_WAIT,
+    /** アームを初期位置に戻す（電源ON後） */
+    STATE_ARM_RELEASE,
+    POWER_ON_DRONE_STATE_NUM,
+  } PowerOnDroneStateType;
+
   ControlPowerOnDrone(ServoController *, FETController *, CurrentReader *,
                       Timer *);
   void stop(void);
-  bool loop(void) override;
 
  private:
+  void _startArmInit(void);
+  void _startArmCharge(void);
+
   ControlArmInit _controlArmInit;
   ControlArmCharge _controlArmCharge;
+  StateMachine<ControlPowerOnDrone> _stateMachine;
+
   static const uint16_t POWER_ON_WAIT;
+  static const StateMachine<ControlPowerOnDrone>::State STATES[];
+  static const StateMachine<ControlPowerOnDrone>::Transition TRANSITIONS[];
 };
@@ -0,0 +1,162 @@
+/**
+ * @file ControlScheduler.cpp
+ * @brief 制御ループの実行周期を管理するクラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ */
+
+#include "ControlScheduler.h"
+
+#include <Log.h>
+
+/** 動作中の実行周期[ms] */
+const uint32_t ControlScheduler::ACTIVE_PERIOD = 10;
+/** 待機中に起床要因がなくても制御ループを実行する間隔[ms]（充電監視用） */
+const uint32_t ControlScheduler::IDLE_TIMEOUT = 100;
+/** 起床要因の受信後に動作中と同じ周期で実行する時間[ms]（ボタンの判定用） */
+const uint32_t ControlScheduler::WAKE_HOLD_TIME = 200;
+/** 起床要因のキューの長さ */
+const uint8_t ControlScheduler::QUEUE_SIZE = 8;
+
+/**
+ * @brief Construct a new Control Scheduler:: Control Scheduler object
+ *
+ * @param activePeriod 動作中の実行周期[ms]
+ * @param idleTimeout 待機中に起床要因がなくても制御ループを実行する間隔[ms]
+ */
+ControlScheduler::ControlScheduler(uint32_t activePeriod, uint32_t idleTimeout)
+    : _queue(xQueueCreate(QUEUE_SIZE, sizeof(uint8_t))),
+      _activePeriod(pdMS_TO_TICKS(activePeriod)),
+      _idleTimeout(pdMS_TO_TICKS(idleTimeout)),
+      _nextWake(xTaskGetTickCount()),
+      _holdUntil(_nextWake),
+      _wasPeriodic(false),
+      _wakeCount{0, 0, 0, 0, 0},
+      _overrunCount(0),
+      _idleRatioStart(micros()),
+      _blockedTime(0) {
+  if (_activePeriod == 0) _activePeriod = 1;
+  if (_queue == NULL) {
+    logger.error("ControlScheduler(): Failed to create wake queue");
+  }
+}
+
+/**
+ * @brief Destroy the Control Scheduler:: Control Scheduler object
+ *
+ */
+ControlScheduler::~ControlScheduler() {
+  if (_queue != NULL) vQueueDelete(_queue);
+}
+
+/**
+ * @brief 制御ループを起床させる（タスクから呼び出す）
+ *
+ * @param reason 起床要因
+ * @return true 通知した
+ * @return false キューが一杯（制御ループは起床済み）
+ */
+bool ControlScheduler::wake(WakeReasonType reason) {
+  if (_queue == NULL) return false;
+  uint8_t value = reason;
+  return xQueueSend(_queue, &value, 0) == pdTRUE;
+}
+
+/**
+ * @brief 制御ループを起床させる（割り込みから呼び出す）
+ *
+ * @param reason 起床要因
+ */
+void IRAM_ATTR ControlScheduler::wakeFromISR(WakeReasonType reason) {
+  if (_queue == NULL) return;
+  uint8_t value = reason;
+  BaseType_t woken = pdFALSE;
+  xQueueSendFromISR(_queue, &value, &woken);
+  if (woken == pdTRUE) portYIELD_FROM_ISR();
+}
+
+/**
+ * @brief 次に制御ループを実行するまで待機する
+ *
+ * @details 動作中は前回の周期を起点に一定周期で起床する（処理時間による周期の
+ * ずれが積み重ならない）。待機中は起床要因が届くか、IDLE_TIMEOUTが経過するまで
+ * ブロックする。どちらの場合も起床要因が届けば周期を待たずに起床し、
+ * その後WAKE_HOLD_TIMEの間は動作中と同じ周期で実行する
+ *
+ * @param isActive 動作中かどうか
+ * @return uint8_t 受信した起床要因のビットマスク（タイムアウトなら0）
+ */
+uint8_t ControlScheduler::wait(bool isActive) {
+  TickType_t now = xTaskGetTickCount();
+  bool isPeriodic = isActive || (int32_t)(_holdUntil - now) > 0;
+  TickType_t timeout = _idleTimeout;
+  if (isPeriodic) {
+    if (!_wasPeriodic) {
+      // 待機中からの復帰時は現在時刻を周期の起点にする
+      _nextWake = now + _activePeriod;
+    } else if ((int32_t)(_nextWake - now) <= 0) {
+      _nextWake += _activePeriod;
+      if ((int32_t)(_nextWake - now) <= 0) {
+        // 処理が周期に間に合わなかった（遅れを取り戻すための連続実行はしない）
+        _overrunCount++;
+        _nextWake = now;
+      }
+    }
+    timeout = _nextWake - now;
+  }
+  _wasPeriodic = isPeriodic;
+
+  uint32_t blockStart = micros();
+  uint8_t reasons = 0;
+  uint8_t reason;
+  if (_queue == NULL) {
+    vTaskDelay(timeout > 0 ? timeout : 1);
+  } else if (xQueueReceive(_queue, &reason, timeout) == pdTRUE) {
+    do {
+      if (reason < WAKE_REASON_NUM) {
+        reasons |= 1 << reason;
+        _wakeCount[reason]++;
+      }
+    } while (xQueueReceive(_queue, &reason, 0) == pdTRUE);
+    _holdUntil = xTaskGetTickCount() + pdMS_TO_TICKS(WAKE_HOLD_TIME);
+  }
+  _blockedTime += micros() - blockStart;
+  return reasons;
+}
+
+/**
+ * @brief 起床要因ごとの受信回数を取得する
+ *
+ * @param reason 起床要因
+ * @return uint32_t 受信回数
+ */
+uint32_t ControlScheduler::getWakeCount(WakeReasonType reason) {
+  return reason < WAKE_REASON_NUM ? _wakeCount[reason] : 0;
+}
+
+/**
+ * @brief 処理が周期に間に合わなかった回数を取得する
+ *
+ * @return uint32_t 回数
+ */
+uint32_t ControlScheduler::getOverrunCount(void) { return _overrunCount; }
+
+/**
+ * @brief 計測開始から制御タスクがブロックしていた時間の割合を取得する
+ *
+ * @return float 待機率（0〜1）
+ */
+float ControlScheduler::getIdleRatio(void) {
+  uint32_t elapsed = micros() - _idleRatioStart;
+  return elapsed > 0 ? float(_blockedTime) / elapsed : 0;
+}
+
+/**
+ * @brief 待機率の計測を開始し直す
+ *
+ */
+void ControlScheduler::resetIdleRatio(void) {
+  _idleRatioStart = micros();
+  _blockedTime = 0;
+}
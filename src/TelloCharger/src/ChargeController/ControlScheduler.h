@@ -0,0 +1,72 @@
+/**
+ * @file ControlScheduler.h
+ * @brief 制御ループの実行周期を管理するクラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 動作中（サーボ稼働中・制御シーケンス実行中）は一定周期で制御ループを
+ * 実行し、待機中は起床要因（コマンド・ボタン・シリアル入力・センサ）が
+ * キューに届くまでタスクをブロックする。
+ * 起床要因は他タスク・割り込みから通知でき、待機中でも即座に制御ループが動く
+ */
+
+#pragma once
+#include <Arduino.h>
+
+class ControlScheduler {
+ public:
+  typedef enum eWakeReason {
+    /** 制御コマンド（WebAPI・MQTT・ボタン等からの充電開始など） */
+    WAKE_COMMAND,
+    /** ボタン入力 */
+    WAKE_BUTTON,
+    /** シリアル入力 */
+    WAKE_SERIAL,
+    /** 電流センサの変化 */
+    WAKE_SENSOR,
+    /** 未処理の制御イベント（状態遷移の連鎖を周期を待たずに進める） */
+    WAKE_EVENT,
+    WAKE_REASON_NUM,
+  } WakeReasonType;
+
+  ControlScheduler(uint32_t activePeriod = ACTIVE_PERIOD,
+                   uint32_t idleTimeout = IDLE_TIMEOUT);
+  ~ControlScheduler();
+  bool wake(WakeReasonType);
+  void wakeFromISR(WakeReasonType);
+  uint8_t wait(bool);
+  uint32_t getWakeCount(WakeReasonType);
+  uint32_t getOverrunCount(void);
+  float getIdleRatio(void);
+  void resetIdleRatio(void);
+
+  static const uint32_t ACTIVE_PERIOD;
+  static const uint32_t IDLE_TIMEOUT;
+  static const uint32_t WAKE_HOLD_TIME;
+  static const uint8_t QUEUE_SIZE;
+
+ private:
+  ControlScheduler(const ControlScheduler &) = delete;
+  ControlScheduler &operator=(const ControlScheduler &) = delete;
+
+  /** 起床要因のキュー */
+  QueueHandle_t _queue;
+  /** 動作中の実行周期[tick] */
+  TickType_t _activePeriod;
+  /** 待機中に起床要因がなくても制御ループを実行する間隔[tick] */
+  TickType_t _idleTimeout;
+  /** 次の周期の起床時刻[tick] */
+  TickType_t _nextWake;
+  /** 動作中と同じ周期で実行する期限[tick]（起床要因の受信後） */
+  TickType_t _holdUntil;
+  /** 前回の待機で一定周期の実行だったかどうか */
+  bool _wasPeriodic;
+  /** 起床要因ごとの受信回数 */
+  uint32_t _wakeCount[WAKE_REASON_NUM];
+  /** 処理が周期に間に合わなかった回数 */
+  uint32_t _overrunCount;
+  /** 待機率の計測開始時刻[us] */
+  uint32_t _idleRatioStart;
+  /** 計測開始からのブロック時間の累計[us] */
+  uint32_t _blockedTime;
+};
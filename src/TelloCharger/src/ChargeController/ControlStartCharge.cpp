@@ -11,11 +11,28 @@
 
 #include <Log.h>
 
-/** 充電開始時に何回捕獲するか */
+/** 充電開始時に何回捕獲するか（回数の指定がない場合。通常はChargePolicyで指定） */
 const uint8_t ControlStartCharge::CATCH_CNT = 2;
-/** 充電開始時に何回USB接続をリトライするか */
+/** 充電開始時に何回USB接続をリトライするか（回数の指定がない場合） */
 const uint8_t ControlStartCharge::RETRY_CNT = 1;
 
+/** 状態テーブル */
+const StateMachine<ControlStartCharge>::State ControlStartCharge::STATES[] = {
+    {STATE_NONE, "IDLE", NULL, NULL, 0},
+    {STATE_NONE, "DONE", NULL, NULL, 0},
+    {STATE_NONE, "ARM_INIT", &ControlStartCharge::_startArmInit, NULL, 0},
+    {STATE_NONE, "ARM_CHARGE", &ControlStartCharge::_startArmCharge, NULL, 0},
+};
+
+/** 遷移テーブル */
+const StateMachine<ControlStartCharge>::Transition
+    ControlStartCharge::TRANSITIONS[] = {
+        {STATE_ARM_INIT, eventMask(EVENT_CHILD_DONE), NULL, NULL,
+         STATE_ARM_CHARGE},
+        {STATE_ARM_CHARGE, eventMask(EVENT_CHILD_DONE), NULL, NULL,
+         STATE_DONE},
+};
+
 /**
  * @brief Construct a new Control Start Charge:: Control Start Charge object
  *
@@ -29,20 +46,22 @@ ControlStartCharge::ControlStartCharge(ServoController *servo,
                                        CurrentReader *current,
                                        Timer *chargeTimer)
     : ControlBase(servo, fet, current, "ControlStartCharge"),
-      _controlArmInit(ControlArmInit(servo, fet, current, chargeTimer)),
-      _controlArmCharge(ControlArmCharge(servo, fet, current, chargeTimer)),
+      _controlArmInit(servo, fet, current, chargeTimer),
+      _controlArmCharge(servo, fet, current, chargeTimer),
+      _stateMachine(this, STATES, sizeof(STATES) / sizeof(STATES[0]),
+                    TRANSITIONS, sizeof(TRANSITIONS) / sizeof(TRANSITIONS[0])),
       _catchCntTarget(1),
-      _retryCntTarget(0) {}
+      _retryCntTarget(0) {
+  _init(&_stateMachine, STATE_ARM_INIT);
+  _addChild(&_controlArmInit);
+  _addChild(&_controlArmCharge);
+}
 
 /**
  * @brief 処理を開始する
  *
  */
-void ControlStartCharge::start(void) {
-  ControlBase::start();
-  _catchCntTarget = CATCH_CNT;
-  _retryCntTarget = RETRY_CNT;
-}
+void ControlStartCharge::start(void) { start(CATCH_CNT, RETRY_CNT); }
 
 /**
  * @brief 充電を開始する
@@ -51,9 +70,9 @@ void ControlStartCharge::start(void) {
  * @param retryCnt USB接続するまでの動作をリトライする回数
  */
 void ControlStartCharge::start(uint8_t catchCnt, uint8_t retryCnt) {
-  ControlBase::start();
   _catchCntTarget = catchCnt;
   _retryCntTarget = retryCnt;
+  ControlBase::start();
 }
 
 /**
@@ -67,38 +86,15 @@ void ControlStartCharge::stop(void) {
 }
 
 /**
- * @brief 充電を開始するループ処理
+ * @brief 入場処理: アームを初期位置に戻し始める
+ *
+ */
+void ControlStartCharge::_startArmInit(void) { _controlArmInit.start(); }
+
+/**
+ * @brief 入場処理: 充電接続を始める
  *
- * @return true 処理完了
- * @return false 処理中
  */
-bool ControlStartCharge::loop(void) {
-  switch (_step) {
-    case 0:
-      // 何もしない
-      break;
-    case 1:
-      // 初期処理
-      _controlArmInit.start();
-      _step++;
-      break;
-    case 2:
-      // アームを初期位置に戻す
-      if (_controlArmInit.loop()) {
-        _controlArmCharge.start(_catchCntTarget, _retryCntTarget);
-        _step++;
-      }
-      break;
-    case 3:
-      // 充電接続する
-      if (_controlArmCharge.loop()) {
-        _step++;
-      }
-      break;
-    default:
-      // 充電開始完了
-      _step = 0;
-      return true;
-  }
-  return false;
-}
\ No newline at end of file
+void ControlStartCharge::_startArmCharge(void) {
+  _controlArmCharge.start(_catchCntTarget, _retryCntTarget);
+}
@@ -20,16 +20,27 @@
 
 class ControlStartCharge : public ControlBase {
  public:
+  typedef enum eStartChargeState {
+    /** アームを初期位置に戻す */
+    STATE_ARM_INIT = STATE_USER,
+    /** 充電接続する */
+    STATE_ARM_CHARGE,
+    START_CHARGE_STATE_NUM,
+  } StartChargeStateType;
+
   ControlStartCharge(ServoController *, FETController *, CurrentReader *,
                      Timer *);
   void start(void);
   void start(uint8_t, uint8_t);
   void stop(void);
-  bool loop(void) override;
 
  private:
+  void _startArmInit(void);
+  void _startArmCharge(void);
+
   ControlArmInit _controlArmInit;
   ControlArmCharge _controlArmCharge;
+  StateMachine<ControlStartCharge> _stateMachine;
   /** 充電開始時の捕獲目標回数 */
   uint8_t _catchCntTarget;
   /** USBを接続するまでの動作を行う目標回数 */
@@ -37,4 +48,6 @@ class ControlStartCharge : public ControlBase {
 
   static const uint8_t CATCH_CNT;
   static const uint8_t RETRY_CNT;
+  static const StateMachine<ControlStartCharge>::State STATES[];
+  static const StateMachine<ControlStartCharge>::Transition TRANSITIONS[];
 };
@@ -11,6 +11,19 @@
 
 #include <Log.h>
 
+/** 状態テーブル */
+const StateMachine<ControlStopCharge>::State ControlStopCharge::STATES[] = {
+    {STATE_NONE, "IDLE", NULL, NULL, 0},
+    {STATE_NONE, "DONE", NULL, NULL, 0},
+    {STATE_NONE, "ARM_INIT", &ControlStopCharge::_startArmInit, NULL, 0},
+};
+
+/** 遷移テーブル */
+const StateMachine<ControlStopCharge>::Transition
+    ControlStopCharge::TRANSITIONS[] = {
+        {STATE_ARM_INIT, eventMask(EVENT_CHILD_DONE), NULL, NULL, STATE_DONE},
+};
+
 /**
  * @brief Construct a new Control Stop Charge:: Control Stop Charge object
  * 
@@ -22,7 +35,12 @@
 ControlStopCharge::ControlStopCharge(ServoController *servo, FETController *fet,
                                      CurrentReader *current, Timer *chargeTimer)
     : ControlBase(servo, fet, current, "ControlStopCharge"),
-      _controlArmInit(ControlArmInit(servo, fet, current, chargeTimer)) {}
+      _controlArmInit(servo, fet, current, chargeTimer),
+      _stateMachine(this, STATES, sizeof(STATES) / sizeof(STATES[0]),
+                    TRANSITIONS, sizeof(TRANSITIONS) / sizeof(TRANSITIONS[0])) {
+  _init(&_stateMachine, STATE_ARM_INIT);
+  _addChild(&_controlArmInit);
+}
 
 /**
  * @brief 処理を終了する
@@ -34,31 +52,7 @@ void ControlStopCharge::stop(void) {
 }
 
 /**
- * @brief 充電を停止するループ処理
+ * @brief 入場処理: アームを初期位置に戻し始める
  *
- * @return true 処理完了
- * @return false 処理中
  */
-bool ControlStopCharge::loop(void) {
-  switch (_step) {
-    case 0:
-      // 何もしない
-      break;
-    case 1:
-      // 初期処理
-      _controlArmInit.start();
-      _step++;
-      break;
-    case 2:
-      // アームを初期位置に戻す
-      if (_controlArmInit.loop()) {
-        _step++;
-      }
-      break;
-    default:
-      // 充電停止完了
-      _step = 0;
-      return true;
-  }
-  return false;
-}
\ No newline at end of file
+void ControlStopCharge::_startArmInit(void) { _controlArmInit.start(); }
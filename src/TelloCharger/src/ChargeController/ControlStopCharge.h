@@ -19,11 +19,22 @@
 
 class ControlStopCharge : public ControlBase {
  public:
+  typedef enum eStopChargeState {
+    /** アームを初期位置に戻す */
+    STATE_ARM_INIT = STATE_USER,
+    STOP_CHARGE_STATE_NUM,
+  } StopChargeStateType;
+
   ControlStopCharge(ServoController *, FETController *, CurrentReader *,
                     Timer *);
   void stop(void);
-  bool loop(void) override;
 
  private:
+  void _startArmInit(void);
+
   ControlArmInit _controlArmInit;
+  StateMachine<ControlStopCharge> _stateMachine;
+
+  static const StateMachine<ControlStopCharge>::State STATES[];
+  static const StateMachine<ControlStopCharge>::Transition TRANSITIONS[];
 };
@@ -0,0 +1,258 @@
+/**
+ * @file CurrentCapture.cpp
+ * @brief 電流波形キャプチャクラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 直近の生サンプルを常時リングバッファに記録し、
+ * トリガ発生時にトリガ前後の波形を凍結する（オシロスコープのシングルトリガ相当）
+ */
+
+#include "CurrentCapture.h"
+
+#include <Log.h>
+
+const uint16_t CurrentCapture::CAPTURE_SIZE;
+/** トリガ後に記録するサンプル数 */
+const uint16_t CurrentCapture::POST_TRIGGER_SIZE = 128;
+/** バイナリ形式のヘッダサイズ[byte] */
+const size_t CurrentCapture::HEADER_SIZE = 20;
+/** バイナリ形式の1サンプルあたりのサイズ[byte] */
+const size_t CurrentCapture::RECORD_SIZE = 4;
+
+/**
+ * @brief Construct a new CurrentCapture::CurrentCapture object
+ *
+ */
+CurrentCapture::CurrentCapture()
+    : _head(0),
+      _count(0),
+      _postRemaining(0),
+      _preTriggerCount(0),
+      _prevSample{0, 0, 0, 0, 0},
+      _firstTime(0),
+      _triggerTime(0),
+      _triggerType(TRIGGER_NONE),
+      _threshold(0),
+      _triggerRequest(TRIGGER_NONE),
+      _state(ARMED) {}
+
+/**
+ * @brief Destroy the CurrentCapture::CurrentCapture object
+ *
+ */
+CurrentCapture::~CurrentCapture() {}
+
+/**
+ * @brief 生サンプルを記録する
+ *
+ * @details 制御ループ（CurrentReader::loop()）からのみ呼び出すこと
+ *
+ * @param sample 電力サンプル
+ */
+void CurrentCapture::push(const PowerSample &sample) {
+  uint8_t state = _state.load(std::memory_order_acquire);
+  if (state == FROZEN) {
+    _prevSample = sample;
+    return;
+  }
+
+  uint32_t interval = _count == 0 ? 0 : sample.time - _prevSample.time;
+  int32_t current = sample.current / 100;
+  _current[_head] = (int16_t)constrain(current, INT16_MIN, INT16_MAX);
+  _interval[_head] = (uint16_t)(interval > UINT16_MAX ? UINT16_MAX : interval);
+  _head = (_head + 1) % CAPTURE_SIZE;
+  if (_count < CAPTURE_SIZE) _count++;
+
+  int32_t threshold = _threshold;
+  bool crossed = threshold > 0 && sample.current >= threshold &&
+                 _prevSample.current < threshold;
+  _prevSample = sample;
+
+  if (state == ARMED) {
+    uint8_t request = _triggerRequest.exchange(TRIGGER_NONE);
+    if (request != TRIGGER_NONE) {
+      _trigger((CaptureTriggerType)request, sample.time);
+    } else if (crossed) {
+      _trigger(TRIGGER_THRESHOLD, sample.time);
+    }
+  } else if (state == TRIGGERED) {
+    if (--_postRemaining == 0) _freeze(sample.time);
+  }
+}
+
+/**
+ * @brief トリガを要求する
+ *
+ * @details 次のサンプルを記録したときにトリガされる。
+ * トリガ待ち以外の状態では無視する
+ *
+ * @param type トリガ要因
+ */
+void CurrentCapture::trigger(CaptureTriggerType type) {
+  if (type == TRIGGER_NONE) return;
+  uint8_t expected = TRIGGER_NONE;
+  _triggerRequest.compare_exchange_strong(expected, type);
+}
+
+/**
+ * @brief トリガを確定する
+ *
+ * @param type トリガ要因
+ * @param time トリガ時刻[us]
+ */
+void CurrentCapture::_trigger(CaptureTriggerType type, uint32_t time) {
+  _triggerType = type;
+  _triggerTime = time;
+  _postRemaining = POST_TRIGGER_SIZE;
+  _state.store(TRIGGERED, std::memory_order_release);
+  logger.info("CurrentCapture._trigger(): type = " + String(type) +
+              ", current = " + String(_prevSample.current / 1000.0f));
+}
+
+/**
+ * @brief 波形を凍結する
+ *
+ * @param lastTime 最後のサンプルの計測時刻[us]
+ */
+void CurrentCapture::_freeze(uint32_t lastTime) {
+  _preTriggerCount = _count - POST_TRIGGER_SIZE;
+  // 先頭サンプルの時刻を経過時間の合計から逆算する
+  uint32_t elapsed = 0;
+  for (uint16_t i = 1; i < _count; i++) {
+    elapsed += _interval[(_head + CAPTURE_SIZE - _count + i) % CAPTURE_SIZE];
+  }
+  _firstTime = lastTime - elapsed;
+  _state.store(FROZEN, std::memory_order_release);
+  logger.info("CurrentCapture._freeze(): samples = " + String(_count) +
+              ", preTrigger = " + String(_preTriggerCount));
+}
+
+/**
+ * @brief キャプチャを再開する（トリガ待ちに戻す）
+ *
+ * @details 凍結中以外は何もしない。
+ * 再開すると記録中の波形は上書きされるため、凍結した波形を分割して送信する
+ * 場合は、送信開始時に readBinary() で複写してから送信すること
+ */
+void CurrentCapture::arm(void) {
+  if (_state.load(std::memory_order_acquire) != FROZEN) return;
+  _head = 0;
+  _count = 0;
+  _postRemaining = 0;
+  _preTriggerCount = 0;
+  _triggerType = TRIGGER_NONE;
+  _triggerRequest.store(TRIGGER_NONE);
+  _state.store(ARMED, std::memory_order_release);
+}
+
+/**
+ * @brief しきい値トリガの電流値を設定する
+ *
+ * @param threshold 電流値[mA]（0以下で無効）
+ */
+void CurrentCapture::setThreshold(float threshold) {
+  _threshold = (int32_t)(threshold * 1000);
+}
+
+/**
+ * @brief しきい値トリガの電流値を取得する
+ *
+ * @return float 電流値[mA]（0以下は無効）
+ */
+float CurrentCapture::getThreshold(void) { return _threshold / 1000.0f; }
+
+/**
+ * @brief キャプチャ状態を取得する
+ *
+ * @return CaptureStateType キャプチャ状態
+ */
+CurrentCapture::CaptureStateType CurrentCapture::getState(void) {
+  return (CaptureStateType)_state.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief 波形を凍結済みかどうか
+ *
+ * @return true 凍結済み（読み出し可能）
+ * @return false
+ */
+bool CurrentCapture::isFrozen(void) { return getState() == FROZEN; }
+
+/**
+ * @brief バイナリ形式のサイズを取得する
+ *
+ * @return size_t サイズ[byte]（凍結していなければ0）
+ */
+size_t CurrentCapture::getBinarySize(void) {
+  if (!isFrozen()) return 0;
+  return HEADER_SIZE + RECORD_SIZE * _count;
+}
+
+/**
+ * @brief 凍結した波形をバイナリ形式で読み出す
+ *
+ * @details HTTPレスポンスのように分割して読み出せるよう、
+ * 任意のオフセットから読み出せる
+ *
+ * @param buffer 格納先
+ * @param maxLen 格納先のサイズ[byte]
+ * @param index 読み出し開始位置[byte]
+ * @return size_t 格納したサイズ[byte]
+ */
+size_t CurrentCapture::readBinary(uint8_t *buffer, size_t maxLen,
+                                  size_t index) {
+  size_t total = getBinarySize();
+  if (index >= total) return 0;
+  size_t len = min(maxLen, total - index);
+
+  uint8_t header[HEADER_SIZE] = {
+      'T',
+      'C',
+      'A',
+      'P',
+      1,
+      (uint8_t)_triggerType,
+      (uint8_t)(_count & 0xFF),
+      (uint8_t)(_count >> 8),
+      (uint8_t)(_preTriggerCount & 0xFF),
+      (uint8_t)(_preTriggerCount >> 8),
+      0,
+      0,
+      (uint8_t)(_firstTime & 0xFF),
+      (uint8_t)((_firstTime >> 8) & 0xFF),
+      (uint8_t)((_firstTime >> 16) & 0xFF),
+      (uint8_t)(_firstTime >> 24),
+      (uint8_t)(_triggerTime & 0xFF),
+      (uint8_t)((_triggerTime >> 8) & 0xFF),
+      (uint8_t)((_triggerTime >> 16) & 0xFF),
+      (uint8_t)(_triggerTime >> 24),
+  };
+
+  for (size_t i = 0; i < len; i++) {
+    size_t pos = index + i;
+    if (pos < HEADER_SIZE) {
+      buffer[i] = header[pos];
+      continue;
+    }
+    size_t record = (pos - HEADER_SIZE) / RECORD_SIZE;
+    uint16_t n = (_head + CAPTURE_SIZE - _count + record) % CAPTURE_SIZE;
+    uint16_t current = (uint16_t)_current[n];
+    uint16_t interval = record == 0 ? 0 : _interval[n];
+    switch ((pos - HEADER_SIZE) % RECORD_SIZE) {
+      case 0:
+        buffer[i] = current & 0xFF;
+        break;
+      case 1:
+        buffer[i] = current >> 8;
+        break;
+      case 2:
+        buffer[i] = interval & 0xFF;
+        break;
+      default:
+        buffer[i] = interval >> 8;
+        break;
+    }
+  }
+  return len;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file CurrentCapture.h
+ * @brief 電流波形キャプチャクラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 直近の生サンプルを常時リングバッファに記録し、
+ * トリガ発生時にトリガ前後の波形を凍結する（オシロスコープのシングルトリガ相当）。
+ * 凍結した波形は以下のバイナリ形式（リトルエンディアン）で取り出す
+ *
+ * | オフセット | 型 | 内容 |
+ * |---|---|---|
+ * | 0 | char[4] | マジック "TCAP" |
+ * | 4 | uint8 | フォーマットバージョン（1） |
+ * | 5 | uint8 | トリガ要因（CaptureTriggerType） |
+ * | 6 | uint16 | サンプル数 |
+ * | 8 | uint16 | トリガ前のサンプル数 |
+ * | 10 | uint16 | 予約（0） |
+ * | 12 | uint32 | 先頭サンプルの計測時刻[us] |
+ * | 16 | uint32 | トリガ時刻[us] |
+ * | 20 | record[] | サンプル（古い順、1件4バイト） |
+ *
+ * record は int16 電流値[0.1mA] と uint16 直前サンプルからの経過時間[us]
+ * （先頭は0、65535で飽和）からなる
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#include <atomic>
+
+#include "PowerSample.h"
+
+class CurrentCapture {
+ public:
+  typedef enum eCaptureTrigger {
+    /** トリガなし */
+    TRIGGER_NONE,
+    /** サーボ過電流検知 */
+    TRIGGER_SERVO_OVER_CURRENT,
+    /** 電流のしきい値超え */
+    TRIGGER_THRESHOLD,
+    /** 外部からの手動トリガ */
+    TRIGGER_MANUAL,
+  } CaptureTriggerType;
+
+  typedef enum eCaptureState {
+    /** トリガ待ち（常時記録中） */
+    ARMED,
+    /** トリガ後のサンプルを記録中 */
+    TRIGGERED,
+    /** 波形を凍結済み */
+    FROZEN,
+  } CaptureStateType;
+
+  CurrentCapture();
+  ~CurrentCapture();
+  void push(const PowerSample &);
+  void trigger(CaptureTriggerType);
+  void arm(void);
+  void setThreshold(float);
+  float getThreshold(void);
+  CaptureStateType getState(void);
+  bool isFrozen(void);
+  size_t getBinarySize(void);
+  size_t readBinary(uint8_t *, size_t, size_t);
+
+  /** 記録するサンプル数 */
+  static const uint16_t CAPTURE_SIZE = 512;
+  static const uint16_t POST_TRIGGER_SIZE;
+  static const size_t HEADER_SIZE;
+  static const size_t RECORD_SIZE;
+
+ private:
+  CurrentCapture(const CurrentCapture &) = delete;
+  CurrentCapture &operator=(const CurrentCapture &) = delete;
+  void _trigger(CaptureTriggerType, uint32_t);
+  void _freeze(uint32_t);
+
+  /** 電流値[0.1mA] */
+  int16_t _current[CAPTURE_SIZE];
+  /** 直前サンプルからの経過時間[us] */
+  uint16_t _interval[CAPTURE_SIZE];
+  /** 次に書き込む位置 */
+  uint16_t _head;
+  /** 記録済みサンプル数 */
+  uint16_t _count;
+  /** トリガ後に記録する残りサンプル数 */
+  uint16_t _postRemaining;
+  /** トリガ前のサンプル数 */
+  uint16_t _preTriggerCount;
+  /** 直前のサンプル */
+  PowerSample _prevSample;
+  /** 凍結した波形の先頭サンプルの計測時刻[us] */
+  uint32_t _firstTime;
+  /** トリガ時刻[us] */
+  uint32_t _triggerTime;
+  /** トリガ要因 */
+  CaptureTriggerType _triggerType;
+  /** しきい値トリガの電流値[uA]（0以下で無効） */
+  volatile int32_t _threshold;
+  /** 外部から要求されたトリガ要因（次のサンプルで反映する） */
+  std::atomic<uint8_t> _triggerRequest;
+  /** キャプチャ状態（読み出し側と別コアから参照される） */
+  std::atomic<uint8_t> _state;
+};
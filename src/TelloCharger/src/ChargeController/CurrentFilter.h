@@ -0,0 +1,185 @@
+/**
+ * @file CurrentFilter.h
+ * @brief 電流サンプル用の固定小数点フィルタ群
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 各フィルタ段は整数（電流値[uA]）のみで演算する。
+ * FilterChainにフィルタ段を並べることで、コンパイル時にフィルタ構成を決定する。
+ * 各段は以下のインターフェースを持つ
+ * - bool push(int32_t in, int32_t &out) : 入力し、出力があればtrueを返す
+ * - void reset(int32_t value) : 内部状態をvalueで初期化する
+ */
+
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief メディアンフィルタ（スパイク除去）
+ *
+ * @tparam N 窓長（奇数）
+ */
+template <uint8_t N>
+class MedianFilter {
+  static_assert(N % 2 == 1, "N must be odd");
+
+ public:
+  MedianFilter() : _index(0) { reset(0); }
+
+  bool push(int32_t in, int32_t &out) {
+    _window[_index] = in;
+    _index = (_index + 1) % N;
+    // 窓長は小さいので挿入ソートで十分
+    int32_t sorted[N];
+    for (uint8_t i = 0; i < N; i++) {
+      int32_t value = _window[i];
+      uint8_t j = i;
+      for (; j > 0 && sorted[j - 1] > value; j--) sorted[j] = sorted[j - 1];
+      sorted[j] = value;
+    }
+    out = sorted[N / 2];
+    return true;
+  }
+
+  void reset(int32_t value) {
+    for (uint8_t i = 0; i < N; i++) _window[i] = value;
+    _index = 0;
+  }
+
+ private:
+  int32_t _window[N];
+  uint8_t _index;
+};
+
+/**
+ * @brief 指数移動平均フィルタ
+ *
+ * @details 係数は 1/2^SHIFT。内部状態は入力値の2^SHIFT倍で保持し、
+ * 右シフトによる切り捨て誤差が蓄積しないようにしている。
+ * ±3.2A（INA219の計測範囲）の入力でも桁あふれしないようSHIFTは8以下とする
+ *
+ * @tparam SHIFT 平滑化係数のシフト量
+ */
+template <uint8_t SHIFT>
+class EmaFilter {
+  static_assert(SHIFT > 0 && SHIFT <= 8, "SHIFT must be 1..8");
+
+ public:
+  EmaFilter() : _acc(0) {}
+
+  bool push(int32_t in, int32_t &out) {
+    _acc += in - (_acc >> SHIFT);
+    out = _acc >> SHIFT;
+    return true;
+  }
+
+  void reset(int32_t value) { _acc = value * (1 << SHIFT); }
+
+ private:
+  int32_t _acc;
+};
+
+/**
+ * @brief 移動平均フィルタ
+ *
+ * @tparam N 窓長
+ */
+template <uint8_t N>
+class WindowAverage {
+  static_assert(N > 0, "N must be positive");
+
+ public:
+  WindowAverage() : _index(0), _sum(0) { reset(0); }
+
+  bool push(int32_t in, int32_t &out) {
+    _sum += in - _window[_index];
+    _window[_index] = in;
+    _index = (_index + 1) % N;
+    out = _sum / N;
+    return true;
+  }
+
+  void reset(int32_t value) {
+    for (uint8_t i = 0; i < N; i++) _window[i] = value;
+    _index = 0;
+    _sum = value * N;
+  }
+
+ private:
+  int32_t _window[N];
+  uint8_t _index;
+  int32_t _sum;
+};
+
+/**
+ * @brief 間引きフィルタ
+ *
+ * @details N個の入力の平均を1個出力する
+ *
+ * @tparam N 間引き率
+ */
+template <uint8_t N>
+class Decimator {
+  static_assert(N > 0, "N must be positive");
+
+ public:
+  Decimator() : _count(0), _sum(0) {}
+
+  bool push(int32_t in, int32_t &out) {
+    _sum += in;
+    if (++_count < N) return false;
+    out = _sum / N;
+    _count = 0;
+    _sum = 0;
+    return true;
+  }
+
+  void reset(int32_t) {
+    _count = 0;
+    _sum = 0;
+  }
+
+ private:
+  uint8_t _count;
+  int32_t _sum;
+};
+
+/**
+ * @brief フィルタ段を直列に接続するフィルタチェーン
+ *
+ * @details 段の呼び出しはすべてインライン展開されるため、
+ * 仮想関数呼び出し等の実行時コストはかからない
+ *
+ * @tparam Stages フィルタ段（先頭から順に適用）
+ */
+template <typename... Stages>
+class FilterChain;
+
+template <>
+class FilterChain<> {
+ public:
+  bool push(int32_t in, int32_t &out) {
+    out = in;
+    return true;
+  }
+  void reset(int32_t) {}
+};
+
+template <typename Head, typename... Tail>
+class FilterChain<Head, Tail...> {
+ public:
+  bool push(int32_t in, int32_t &out) {
+    int32_t value;
+    if (!_head.push(in, value)) return false;
+    return _tail.push(value, out);
+  }
+
+  void reset(int32_t value) {
+    _head.reset(value);
+    _tail.reset(value);
+  }
+
+ private:
+  Head _head;
+  FilterChain<Tail...> _tail;
+};
@@ -8,77 +8,500 @@
 
 #include "CurrentReader.h"
 
-#include <Adafruit_INA219.h>
 #include <Log.h>
 #include <M5Unified.h>
-#include <Wire.h>
 
-#include "pinConfig.h"
-
-Adafruit_INA219 ina219;
+/** 通常時のデフォルトのサンプリングレート[Hz] */
+const uint16_t CurrentReader::DEFAULT_SAMPLING_RATE = 200;
+/** 待機中・定常充電中のサンプリングレート[Hz] */
+const uint16_t CurrentReader::LOW_SAMPLING_RATE = 20;
+/** 設定可能な最大サンプリングレート（サーボ稼働中のレート）[Hz] */
+const uint16_t CurrentReader::MAX_SAMPLING_RATE = 1000;
+/** この回数連続で通信異常になればセンサ応答なしとみなす */
+const uint8_t CurrentReader::SENSOR_LOST_ERROR_COUNT = 3;
+/** 復旧処理の最小間隔[ms] */
+const uint32_t CurrentReader::MIN_RECOVERY_BACKOFF = 100;
+/** 復旧処理の最大間隔[ms] */
+const uint32_t CurrentReader::MAX_RECOVERY_BACKOFF = 10000;
+/** 前回の通知からこの電流[uA]以上変化すれば制御ループを起床させる */
+const int32_t CurrentReader::ALERT_CURRENT_STEP = 100000;
 
 /**
  * @brief Constdsruct a new CurrentReader::CurrentReader object
  *
+ * @param bus 全ベイで共有するI2Cバス（初期化済みであること）
+ * @param address 電流センサのI2Cアドレス
+ * @param cycleTime 移動平均フィルタの更新周期[ms]
+ * @param samplingRate 通常時の電流センサのサンプリングレート[Hz]
  */
-CurrentReader::CurrentReader(uint32_t cycleTime)
-    : _isConnect(false),
-      _timer(Timer(cycleTime)),
-      _current(0.0),
-      _movAveFilter(MovAveFilter(10, 0)) {
-  Wire.begin(INA_SDA_PIN, INA_SCL_PIN);
-  if (!ina219.begin()) {
+CurrentReader::CurrentReader(I2cBus *bus, uint8_t address, uint32_t cycleTime,
+                             uint16_t samplingRate)
+    : _bus(bus),
+      _ina219(Ina219(address)),
+      _sensorHealth(SENSOR_LOST),
+      _consecutiveErrors(0),
+      _failedTransactions(0),
+      _recoveredCount(0),
+      _appliedRecoveredCount(0),
+      _lastRecoveryAttempt(0),
+      _recoveryBackoff(MIN_RECOVERY_BACKOFF),
+      _cycleTime(cycleTime),
+      _samplingRates{LOW_SAMPLING_RATE,
+                     constrain(samplingRate, LOW_SAMPLING_RATE,
+                               MAX_SAMPLING_RATE),
+                     MAX_SAMPLING_RATE},
+      _samplingMode(SAMPLING_NORMAL),
+      _samplingModeStart(millis()),
+      _samplingModeTime{0, 0, 0},
+      _current(0),
+      _servoCurrent(0),
+      _isFilterReady(false),
+      _busVoltage(0),
+      _minBusVoltage(INT32_MAX),
+      _latestSample{0, 0, 0, 0, 0},
+      _binStart(0),
+      _binSum(0),
+      _binCount(0),
+      _isCounting(false),
+      _hasPrevCountedSample(false),
+      _prevCountedSample{0, 0, 0, 0, 0},
+      _chargeAmount(0),
+      _chargeEnergy(0),
+      _droppedSamples(0),
+      _taskHandle(NULL),
+      _scheduler(NULL),
+      _alertCurrent(0) {
+  _bus->lock();
+  bool isFound = _ina219.begin();
+  _bus->unlock();
+  if (!isFound) {
+    // 電流取得タスクで復旧を試みる
+    _lastRecoveryAttempt = millis();
     logger.error("CurrentReader(): Failed to find INA219 chip");
   } else {
-    _isConnect = true;
-    _movAveFilter.setData(FLOAT_TO_FIX(_getCurrent()));
+    _sensorHealth = SENSOR_HEALTHY;
     logger.info("CurrentReader(): INA219 chip found!");
   }
+  // 電流取得タスクを起動 Core 1（loop()より高優先度）
+  xTaskCreatePinnedToCore(_taskSampling, "taskCurrent", 4096, this, 2,
+                          &_taskHandle, 1);
 }
 
 /**
  * @brief Destroy the CurrentReader::CurrentReader object
  *
  */
-CurrentReader::~CurrentReader() {}
+CurrentReader::~CurrentReader() {
+  if (_taskHandle != NULL) vTaskDelete(_taskHandle);
+}
+
+/**
+ * @brief 電流取得タスク
+ *
+ * @details サンプリングモードに応じた周期でINA219の変換結果を回収して
+ * 次の変換を開始し、時刻付きのサンプルをリングバッファへ格納する。
+ * I2C通信はこのタスク内でのみ行うため、制御ループがI2C通信でブロックされることはない。
+ * 通信・復旧処理の間はI2Cバスを占有し、他のベイのタスクと排他する。
+ * サンプリングモードが変更されると通知を受けて即座に新しい周期に切り替える。
+ * センサが応答しない間は、サンプリングの代わりに復旧処理を行う
+ *
+ * @param arg CurrentReaderのインスタンス
+ */
+void CurrentReader::_taskSampling(void *arg) {
+  CurrentReader *self = static_cast<CurrentReader *>(arg);
+  TickType_t lastWake = xTaskGetTickCount();
+  while (true) {
+    Ina219Reading reading;
+    if (self->_sensorHealth == SENSOR_LOST) {
+      self->_tryRecover();
+    } else {
+      self->_bus->lock();
+      Ina219::Ina219StatusType status = self->_ina219.poll(reading);
+      self->_bus->unlock();
+      if (status == Ina219::FAILED) {
+        self->_onTransactionFailed();
+      } else {
+        self->_onTransactionSucceeded();
+      }
+      if (status == Ina219::READY) {
+        PowerSample sample = {
+            micros(), reading.busVoltage, reading.shuntVoltage,
+            reading.current,
+            (int32_t)((int64_t)reading.current * reading.busVoltage / 1000)};
+        if (!self->_samples.push(sample)) {
+          // 制御ループが滞っている場合は新しいサンプルを捨てる
+          self->_droppedSamples++;
+        }
+        self->_checkAlert(sample.current);
+      }
+    }
+    TickType_t period =
+        pdMS_TO_TICKS(1000 / self->_samplingRates[self->_samplingMode]);
+    if (period == 0) period = 1;
+    lastWake += period;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(lastWake - now) <= 0) {
+      // 処理が周期に間に合わなかった
+      lastWake = now;
+    } else if (ulTaskNotifyTake(pdTRUE, lastWake - now) > 0) {
+      // サンプリングモードが変更された
+      lastWake = xTaskGetTickCount();
+    }
+  }
+}
+
+/**
+ * @brief センサとの通信成功時の処理
+ *
+ */
+void CurrentReader::_onTransactionSucceeded(void) {
+  _consecutiveErrors = 0;
+  if (_sensorHealth == SENSOR_DEGRADED) _sensorHealth = SENSOR_HEALTHY;
+}
+
+/**
+ * @brief センサとの通信失敗時の処理
+ *
+ * @details 連続して失敗すればセンサ応答なしとして復旧処理に移る
+ */
+void CurrentReader::_onTransactionFailed(void) {
+  _failedTransactions++;
+  if (++_consecutiveErrors < SENSOR_LOST_ERROR_COUNT) {
+    _sensorHealth = SENSOR_DEGRADED;
+    return;
+  }
+  _sensorHealth = SENSOR_LOST;
+  _recoveryBackoff = MIN_RECOVERY_BACKOFF;
+  _lastRecoveryAttempt = millis();
+  logger.error("CurrentReader._onTransactionFailed(): INA219 lost. failed = " +
+               String(_failedTransactions));
+  _wakeScheduler();
+}
+
+/**
+ * @brief センサの復旧を試みる
+ *
+ * @details I2Cバスを解放してからセンサを再初期化する。バスを占有して行うため、
+ * 他のベイの通信が途中で切断されることはない。
+ * 失敗するたびに次の復旧処理までの間隔を倍にする（MAX_RECOVERY_BACKOFFまで）
+ */
+void CurrentReader::_tryRecover(void) {
+  uint32_t now = millis();
+  if (now - _lastRecoveryAttempt < _recoveryBackoff) return;
+  _lastRecoveryAttempt = now;
+
+  _bus->lock();
+  _bus->reset();
+  bool isFound = _ina219.begin();
+  _bus->unlock();
+  if (isFound) {
+    _consecutiveErrors = 0;
+    _recoveryBackoff = MIN_RECOVERY_BACKOFF;
+    _recoveredCount++;
+    _sensorHealth = SENSOR_HEALTHY;
+    logger.info("CurrentReader._tryRecover(): INA219 recovered. count = " +
+                String(_recoveredCount));
+    _wakeScheduler();
+  } else {
+    _failedTransactions++;
+    _recoveryBackoff = min(_recoveryBackoff * 2, MAX_RECOVERY_BACKOFF);
+    logger.warn(
+        "CurrentReader._tryRecover(): INA219 not responding. retry in " +
+        String(_recoveryBackoff) + " ms");
+  }
+}
+
+/**
+ * @brief 電流が大きく変化した場合に制御ループを起床させる
+ *
+ * @details 待機中の制御ループは起床要因が届くまでブロックしているため、
+ * サーボの動き出しや充電電流の変化、リングバッファの溜まりすぎを通知する
+ *
+ * @param current 電流値[uA]
+ */
+void CurrentReader::_checkAlert(int32_t current) {
+  if (_samples.size() >= _samples.capacity() / 2 ||
+      abs(current - _alertCurrent) >= ALERT_CURRENT_STEP) {
+    _alertCurrent = current;
+    _wakeScheduler();
+  }
+}
+
+/**
+ * @brief 制御ループを起床させる
+ *
+ */
+void CurrentReader::_wakeScheduler(void) {
+  ControlScheduler *scheduler = _scheduler;
+  if (scheduler != NULL) scheduler->wake(ControlScheduler::WAKE_SENSOR);
+}
 
 /**
  * @brief 電流センサに接続しているかどうか
  *
  * @return true 接続している
- * @return false
+ * @return false 応答なし（復旧処理中）
+ */
+bool CurrentReader::isConnect(void) { return _sensorHealth != SENSOR_LOST; }
+
+/**
+ * @brief センサの状態を取得する
+ *
+ * @return SensorHealthType センサの状態
+ */
+CurrentReader::SensorHealthType CurrentReader::getSensorHealth(void) {
+  return _sensorHealth;
+}
+
+/**
+ * @brief センサとの通信異常の累計回数を取得する
+ *
+ * @return uint32_t 通信異常の回数（復旧処理の失敗を含む）
+ */
+uint32_t CurrentReader::getFailedTransactions(void) {
+  return _failedTransactions;
+}
+
+/**
+ * @brief センサの復旧に成功した累計回数を取得する
+ *
+ * @return uint32_t 復旧回数
+ */
+uint32_t CurrentReader::getRecoveredCount(void) { return _recoveredCount; }
+
+/**
+ * @brief 充電電流判定用の電流値を取得する
+ *
+ * @return float 電流値[mA]
  */
-bool CurrentReader::isConnect(void) { return _isConnect; }
+float CurrentReader::getCurrent(void) { return _current / 1000.0f; }
 
 /**
- * @brief 電流値を取得する
+ * @brief サーボ電流判定用の電流値を取得する
  *
  * @return float 電流値[mA]
  */
-float CurrentReader::_getCurrent(void) {
-  if (isConnect()) {
-    return ina219.getCurrent_mA();
+float CurrentReader::getServoCurrent(void) { return _servoCurrent / 1000.0f; }
+
+/**
+ * @brief フィルタ後のバス電圧を取得する
+ *
+ * @return float バス電圧[V]
+ */
+float CurrentReader::getBusVoltage(void) { return _busVoltage / 1000.0f; }
+
+/**
+ * @brief フィルタ後のバス電圧の最小値を取得する
+ *
+ * @details 複数台充電時の5V電源の電圧降下を検知するために使用する
+ *
+ * @return float resetMinBusVoltage()以降のバス電圧の最小値[V]
+ */
+float CurrentReader::getMinBusVoltage(void) {
+  if (_minBusVoltage == INT32_MAX) return getBusVoltage();
+  return _minBusVoltage / 1000.0f;
+}
+
+/**
+ * @brief バス電圧の最小値をリセットする
+ *
+ */
+void CurrentReader::resetMinBusVoltage(void) { _minBusVoltage = INT32_MAX; }
+
+/**
+ * @brief フィルタ後の電力を取得する
+ *
+ * @return float 電力[mW]
+ */
+float CurrentReader::getPower(void) {
+  return (int64_t)_current * _busVoltage / 1000000.0f;
+}
+
+/**
+ * @brief 最新の電力サンプルを取得する
+ *
+ * @return PowerSample 最新の電力サンプル（フィルタ前）
+ */
+PowerSample CurrentReader::getLatestSample(void) { return _latestSample; }
+
+/**
+ * @brief サンプリングモードを設定する
+ *
+ * @param mode サンプリングモード
+ */
+void CurrentReader::setSamplingMode(SamplingModeType mode) {
+  if (mode == _samplingMode || mode >= SAMPLING_MODE_NUM) return;
+  uint32_t now = millis();
+  _samplingModeTime[_samplingMode] += now - _samplingModeStart;
+  _samplingModeStart = now;
+  _samplingMode = mode;
+  if (_taskHandle != NULL) xTaskNotifyGive(_taskHandle);
+}
+
+/**
+ * @brief サンプリングモードを取得する
+ *
+ * @return SamplingModeType サンプリングモード
+ */
+CurrentReader::SamplingModeType CurrentReader::getSamplingMode(void) {
+  return _samplingMode;
+}
+
+/**
+ * @brief 現在のサンプリングレートを取得する
+ *
+ * @return uint16_t サンプリングレート[Hz]
+ */
+uint16_t CurrentReader::getSamplingRate(void) {
+  return _samplingRates[_samplingMode];
+}
+
+/**
+ * @brief サンプリングモードごとの累積時間を取得する
+ *
+ * @param mode サンプリングモード
+ * @return uint32_t 起動してからそのモードで動作した時間[ms]
+ */
+uint32_t CurrentReader::getSamplingModeTime(SamplingModeType mode) {
+  if (mode >= SAMPLING_MODE_NUM) return 0;
+  uint32_t time = _samplingModeTime[mode];
+  if (mode == _samplingMode) time += millis() - _samplingModeStart;
+  return time;
+}
+
+/**
+ * @brief バッファ溢れで破棄したサンプル数を取得する
+ *
+ * @return uint32_t 破棄したサンプル数
+ */
+uint32_t CurrentReader::getDroppedSamples(void) { return _droppedSamples; }
+
+/**
+ * @brief 電力サンプルを各フィルタに反映する
+ *
+ * @details サーボ電流フィルタには生サンプルをそのまま入力する。
+ * 充電電流フィルタにはサンプルの時刻で_cycleTimeごとに区間平均をとった値を
+ * 入力するため、サンプリングレートによらずフィルタの時定数は一定になる
+ *
+ * @param sample 電力サンプル
+ */
+void CurrentReader::_updateFilter(const PowerSample &sample) {
+  if (!_isFilterReady) {
+    // 最初のサンプルでフィルタの内部状態を初期化する
+    _current = _servoCurrent = sample.current;
+    _chargeFilter.reset(sample.current);
+    _servoFilter.reset(sample.current);
+    _busVoltage = sample.busVoltage;
+    _busVoltageFilter.reset(sample.busVoltage);
+    _isFilterReady = true;
+  }
+  int32_t out;
+  if (_servoFilter.push(sample.current, out)) _servoCurrent = out;
+  if (_busVoltageFilter.push(sample.busVoltage, out)) {
+    _busVoltage = out;
+    if (_busVoltage < _minBusVoltage) _minBusVoltage = _busVoltage;
+  }
+
+  if (_binCount == 0) _binStart = sample.time;
+  _binSum += sample.current;
+  _binCount++;
+  if (sample.time - _binStart >= _cycleTime * 1000) {
+    if (_chargeFilter.push((int32_t)(_binSum / _binCount), out)) _current = out;
+    _binSum = 0;
+    _binCount = 0;
   }
-  return 0.0;
 }
 
 /**
- * @brief 電流値を取得する
+ * @brief 充電量の積算を開始する
  *
- * @return float 電流値[mA]
+ * @details 積算値をリセットしてから積算を開始する
+ */
+void CurrentReader::startCoulombCounter(void) {
+  _chargeAmount = 0;
+  _chargeEnergy = 0;
+  _hasPrevCountedSample = false;
+  _isCounting = true;
+}
+
+/**
+ * @brief 充電量の積算を終了する
+ *
+ * @details 積算値は次に積算を開始するまで保持する
+ */
+void CurrentReader::stopCoulombCounter(void) { _isCounting = false; }
+
+/**
+ * @brief 積算した充電電荷量を取得する
+ *
+ * @return float 充電電荷量[mAh]
+ */
+float CurrentReader::getChargeAmount(void) { return _chargeAmount / 3.6e12; }
+
+/**
+ * @brief 積算した充電電力量を取得する
+ *
+ * @return float 充電電力量[mWh]
+ */
+float CurrentReader::getChargeEnergy(void) { return _chargeEnergy / 3.6e12; }
+
+/**
+ * @brief 電流波形キャプチャを取得する
+ *
+ * @return CurrentCapture* 電流波形キャプチャ
+ */
+CurrentCapture *CurrentReader::getCapture(void) { return &_capture; }
+
+/**
+ * @brief 電流の変化・センサの状態変化を通知する制御ループを設定する
+ *
+ * @param scheduler 制御ループのスケジューラ（NULLで通知しない）
  */
-float CurrentReader::getCurrent(void) { return _current; }
+void CurrentReader::setScheduler(ControlScheduler *scheduler) {
+  _scheduler = scheduler;
+}
+
+/**
+ * @brief 電力サンプルを電荷量・電力量に積算する
+ *
+ * @details サンプルの時刻差で台形積分するため、
+ * サンプリング周期がばらついても積算値は正しく求まる
+ *
+ * @param sample 電力サンプル
+ */
+void CurrentReader::_updateCoulombCounter(const PowerSample &sample) {
+  if (!_isCounting) return;
+  if (_hasPrevCountedSample) {
+    int64_t dt = (uint32_t)(sample.time - _prevCountedSample.time);
+    int64_t current = (int64_t)sample.current + _prevCountedSample.current;
+    int64_t power = (int64_t)sample.power + _prevCountedSample.power;
+    _chargeAmount += current * dt / 2;
+    _chargeEnergy += power * dt / 2;
+  }
+  _prevCountedSample = sample;
+  _hasPrevCountedSample = true;
+}
 
 /**
  * @brief ループ処理
  *
+ * @details 取得タスクが溜めたサンプルをすべて取り出してフィルタに反映する
  */
 void CurrentReader::loop() {
-  if (_timer.isCycleTime()) {
-    float current = _getCurrent();
-    _current = FIX_TO_FLOAT(_movAveFilter.movingAverage(FLOAT_TO_FIX(current)));
-    // logger.trace("CurrentReader.loop(): current = " + String(current) +
-    //              ", movave = " + String(_current));
+  uint32_t recoveredCount = _recoveredCount;
+  if (recoveredCount != _appliedRecoveredCount) {
+    // 復旧前の古い値とフィルタを混ぜないよう、復旧後の最初のサンプルで初期化する
+    _isFilterReady = false;
+    _appliedRecoveredCount = recoveredCount;
+  }
+  PowerSample sample;
+  while (_samples.pop(sample)) {
+    _latestSample = sample;
+    _updateFilter(sample);
+    _updateCoulombCounter(sample);
+    _capture.push(sample);
+    // logger.trace("CurrentReader.loop(): current = " +
+    //              String(sample.current) + ", filter = " + String(_current));
   }
 }
 
@@ -87,17 +510,12 @@ void CurrentReader::loop() {
  *
  */
 void CurrentReader::readIna219(void) {
-  float shuntvoltage = 0;
-  float busvoltage = 0;
-  float current_mA = 0;
-  float loadvoltage = 0;
-  float power_mW = 0;
-
-  shuntvoltage = ina219.getShuntVoltage_mV();
-  busvoltage = ina219.getBusVoltage_V();
-  current_mA = ina219.getCurrent_mA();
-  power_mW = ina219.getPower_mW();
-  loadvoltage = busvoltage + (shuntvoltage / 1000);
+  PowerSample sample = getLatestSample();
+  float shuntvoltage = sample.shuntVoltage / 1000.0f;
+  float busvoltage = sample.busVoltage / 1000.0f;
+  float current_mA = sample.current / 1000.0f;
+  float loadvoltage = busvoltage + (shuntvoltage / 1000);
+  float power_mW = sample.power / 1000.0f;
 
   Serial.print("Bus Voltage:   ");
   Serial.print(busvoltage);
@@ -4,26 +4,171 @@
  * @author Tatsuya Miyazaki
  * @date 2023-09-23
  *
+ * @details 電流センサ(INA219)の読込は専用タスクで行い、
+ * 電圧・電流・電力をまとめたサンプルとしてリングバッファ経由で制御ループへ受け渡す。
+ * 通信異常が続いた場合は同タスク内でI2Cバスを復旧し、センサを再初期化する。
+ * 複数の充電ベイはI2Cバスを共有し、センサのアドレスで区別する
+ * （通信・復旧処理はI2cBusで排他する）
  */
 
 #pragma once
 
-#include <Timer.h>
-#include <Filter.h>
+#include <Arduino.h>
+
+#include "ControlScheduler.h"
+#include "CurrentCapture.h"
+#include "CurrentFilter.h"
+#include "I2cBus.h"
+#include "Ina219.h"
+#include "PowerSample.h"
+#include "SpscRingBuffer.h"
+
+/** 充電電流判定用フィルタ（区間平均後の値に適用。ノイズ除去重視） */
+typedef FilterChain<MedianFilter<3>, WindowAverage<10> > ChargeCurrentFilter;
+/** サーボ電流判定用フィルタ（生サンプルに適用。応答性重視） */
+typedef FilterChain<MedianFilter<3>, Decimator<2>, EmaFilter<2> >
+    ServoCurrentFilter;
+/** バス電圧用フィルタ（生サンプルに適用） */
+typedef FilterChain<MedianFilter<3>, EmaFilter<3> > BusVoltageFilter;
 
 class CurrentReader {
  public:
-  CurrentReader(uint32_t);
+  typedef enum eSamplingMode {
+    /** 待機中・定常充電中 */
+    SAMPLING_LOW,
+    /** 通常 */
+    SAMPLING_NORMAL,
+    /** サーボ稼働中・制御シーケンス実行中 */
+    SAMPLING_HIGH,
+    SAMPLING_MODE_NUM,
+  } SamplingModeType;
+
+  typedef enum eSensorHealth {
+    /** 正常 */
+    SENSOR_HEALTHY,
+    /** 通信異常が発生している（計測値は更新されている） */
+    SENSOR_DEGRADED,
+    /** 応答なし（復旧処理中。計測値は更新されない） */
+    SENSOR_LOST,
+  } SensorHealthType;
+
+  CurrentReader(I2cBus *, uint8_t, uint32_t,
+                uint16_t samplingRate = DEFAULT_SAMPLING_RATE);
   ~CurrentReader();
   bool isConnect(void);
+  SensorHealthType getSensorHealth(void);
+  uint32_t getFailedTransactions(void);
+  uint32_t getRecoveredCount(void);
   float getCurrent(void);
+  float getServoCurrent(void);
+  float getBusVoltage(void);
+  float getMinBusVoltage(void);
+  void resetMinBusVoltage(void);
+  float getPower(void);
+  PowerSample getLatestSample(void);
+  void setSamplingMode(SamplingModeType);
+  SamplingModeType getSamplingMode(void);
+  uint16_t getSamplingRate(void);
+  uint32_t getSamplingModeTime(SamplingModeType);
+  uint32_t getDroppedSamples(void);
+  void startCoulombCounter(void);
+  void stopCoulombCounter(void);
+  float getChargeAmount(void);
+  float getChargeEnergy(void);
+  CurrentCapture *getCapture(void);
+  void setScheduler(ControlScheduler *);
   void readIna219(void);
   void loop(void);
 
+  static const uint16_t DEFAULT_SAMPLING_RATE;
+  static const uint16_t LOW_SAMPLING_RATE;
+  static const uint16_t MAX_SAMPLING_RATE;
+  static const uint8_t SENSOR_LOST_ERROR_COUNT;
+  static const uint32_t MIN_RECOVERY_BACKOFF;
+  static const uint32_t MAX_RECOVERY_BACKOFF;
+  static const int32_t ALERT_CURRENT_STEP;
+
  private:
-  float _getCurrent(void);
-  bool _isConnect;
-  Timer _timer;
-  float _current;
-  MovAveFilter _movAveFilter;
+  CurrentReader(const CurrentReader &) = delete;
+  CurrentReader &operator=(const CurrentReader &) = delete;
+  static void _taskSampling(void *);
+  void _onTransactionSucceeded(void);
+  void _onTransactionFailed(void);
+  void _tryRecover(void);
+  void _checkAlert(int32_t);
+  void _wakeScheduler(void);
+  void _updateFilter(const PowerSample &);
+  void _updateCoulombCounter(const PowerSample &);
+
+  /** 全ベイで共有するI2Cバス */
+  I2cBus *_bus;
+  /** 電流センサ */
+  Ina219 _ina219;
+  /** センサの状態 */
+  volatile SensorHealthType _sensorHealth;
+  /** 連続した通信異常の回数 */
+  uint8_t _consecutiveErrors;
+  /** 通信異常の累計回数 */
+  volatile uint32_t _failedTransactions;
+  /** 復旧に成功した累計回数 */
+  volatile uint32_t _recoveredCount;
+  /** フィルタに反映済みの復旧回数 */
+  uint32_t _appliedRecoveredCount;
+  /** 前回の復旧処理の時刻[ms] */
+  uint32_t _lastRecoveryAttempt;
+  /** 次の復旧処理までの待ち時間[ms] */
+  uint32_t _recoveryBackoff;
+  /** 充電電流フィルタの更新周期[ms] */
+  uint32_t _cycleTime;
+  /** サンプリングモードごとのサンプリングレート[Hz] */
+  uint16_t _samplingRates[SAMPLING_MODE_NUM];
+  /** 現在のサンプリングモード */
+  volatile SamplingModeType _samplingMode;
+  /** 現在のサンプリングモードになった時刻[ms] */
+  uint32_t _samplingModeStart;
+  /** サンプリングモードごとの累積時間[ms] */
+  uint32_t _samplingModeTime[SAMPLING_MODE_NUM];
+  /** 充電電流判定用のフィルタ後電流値[uA] */
+  int32_t _current;
+  /** サーボ電流判定用のフィルタ後電流値[uA] */
+  int32_t _servoCurrent;
+  /** フィルタを初期化済みかどうか */
+  bool _isFilterReady;
+  ChargeCurrentFilter _chargeFilter;
+  ServoCurrentFilter _servoFilter;
+  BusVoltageFilter _busVoltageFilter;
+  /** フィルタ後バス電圧[mV] */
+  int32_t _busVoltage;
+  /** フィルタ後バス電圧の最小値[mV] */
+  int32_t _minBusVoltage;
+  /** 最新の電力サンプル */
+  PowerSample _latestSample;
+  /** 平均化区間の開始時刻[us] */
+  uint32_t _binStart;
+  /** 平均化区間の電流積算値[uA] */
+  int64_t _binSum;
+  /** 平均化区間のサンプル数 */
+  uint32_t _binCount;
+  /** 電荷・電力量を積算中かどうか */
+  bool _isCounting;
+  /** 積算済みの直前サンプルがあるかどうか */
+  bool _hasPrevCountedSample;
+  /** 積算済みの直前サンプル */
+  PowerSample _prevCountedSample;
+  /** 積算電荷量[uA*us] */
+  int64_t _chargeAmount;
+  /** 積算電力量[uW*us] */
+  int64_t _chargeEnergy;
+  /** 電流波形キャプチャ */
+  CurrentCapture _capture;
+  /** バッファ溢れで破棄したサンプル数 */
+  volatile uint32_t _droppedSamples;
+  /** 取得タスクから制御ループへ受け渡すサンプル */
+  SpscRingBuffer<PowerSample, 256> _samples;
+  /** 電流取得タスク */
+  TaskHandle_t _taskHandle;
+  /** 電流の変化・センサの状態変化を通知する制御ループ（NULLで通知しない） */
+  ControlScheduler *volatile _scheduler;
+  /** 最後に通知した時点の電流値[uA] */
+  int32_t _alertCurrent;
 };
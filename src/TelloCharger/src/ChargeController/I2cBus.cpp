@@ -0,0 +1,104 @@
+/**
+ * @file I2cBus.cpp
+ * @brief 充電ベイで共有するI2Cバスクラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ */
+
+#include "I2cBus.h"
+
+#include <Log.h>
+#include <Wire.h>
+
+#include "pinConfig.h"
+
+/** I2Cのクロック周波数[Hz] */
+const uint32_t I2cBus::FREQUENCY = 400000;
+/** I2C通信のタイムアウト[ms] */
+const uint16_t I2cBus::TIMEOUT = 10;
+
+/**
+ * @brief Construct a new I2cBus::I2cBus object
+ *
+ */
+I2cBus::I2cBus() : _mutex(xSemaphoreCreateMutex()) {
+  if (_mutex == NULL) logger.error("I2cBus(): Failed to create mutex");
+}
+
+/**
+ * @brief Destroy the I2cBus::I2cBus object
+ *
+ */
+I2cBus::~I2cBus() {
+  if (_mutex != NULL) vSemaphoreDelete(_mutex);
+}
+
+/**
+ * @brief バスを初期化する（センサの初期化より前に1回だけ呼び出す）
+ *
+ */
+void I2cBus::begin(void) {
+  lock();
+  Wire.begin(INA_SDA_PIN, INA_SCL_PIN, FREQUENCY);
+  Wire.setTimeOut(TIMEOUT);
+  unlock();
+}
+
+/**
+ * @brief バスを占有する（他のタスクが占有中なら解放まで待つ）
+ *
+ * @details 一連の通信・復旧処理の前に呼び出し、終わったらunlock()を呼び出す
+ */
+void I2cBus::lock(void) {
+  if (_mutex != NULL) xSemaphoreTake(_mutex, portMAX_DELAY);
+}
+
+/**
+ * @brief バスの占有を解除する
+ *
+ */
+void I2cBus::unlock(void) {
+  if (_mutex != NULL) xSemaphoreGive(_mutex);
+}
+
+/**
+ * @brief バスを解放してから初期化し直す（lock()中に呼び出すこと）
+ *
+ */
+void I2cBus::reset(void) {
+  Wire.end();
+  _clearBus();
+  Wire.begin(INA_SDA_PIN, INA_SCL_PIN, FREQUENCY);
+  Wire.setTimeOut(TIMEOUT);
+}
+
+/**
+ * @brief I2Cバスを解放する
+ *
+ * @details 通信途中でリセット等が起きると、スレーブがSDAをLowに保持したまま
+ * バスが停止することがある。SCLを最大9回クロックしてスレーブに残りのビットを
+ * 送出させ、STOPコンディションを生成してバスを解放する
+ */
+void I2cBus::_clearBus(void) {
+  pinMode(INA_SDA_PIN, INPUT_PULLUP);
+  pinMode(INA_SCL_PIN, OUTPUT_OPEN_DRAIN);
+  digitalWrite(INA_SCL_PIN, HIGH);
+  for (uint8_t i = 0; i < 9 && digitalRead(INA_SDA_PIN) == LOW; i++) {
+    digitalWrite(INA_SCL_PIN, LOW);
+    delayMicroseconds(5);
+    digitalWrite(INA_SCL_PIN, HIGH);
+    delayMicroseconds(5);
+  }
+  // STOPコンディション（SCLがHighの間にSDAをLow→High）
+  digitalWrite(INA_SCL_PIN, LOW);
+  pinMode(INA_SDA_PIN, OUTPUT_OPEN_DRAIN);
+  digitalWrite(INA_SDA_PIN, LOW);
+  delayMicroseconds(5);
+  digitalWrite(INA_SCL_PIN, HIGH);
+  delayMicroseconds(5);
+  digitalWrite(INA_SDA_PIN, HIGH);
+  delayMicroseconds(5);
+  pinMode(INA_SDA_PIN, INPUT);
+  pinMode(INA_SCL_PIN, INPUT);
+}
@@ -0,0 +1,35 @@
+/**
+ * @file I2cBus.h
+ * @brief 充電ベイで共有するI2Cバスクラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 複数の充電ベイの電流センサは1つのI2Cバスを共有し、ベイごとの
+ * 電流取得タスクから通信する。バスの初期化・通信・復旧（バスの解放と
+ * 再初期化）はミューテックスで排他し、あるベイの復旧処理中に他のベイが
+ * 通信しないようにする。充電ステーション（ChargeStation）が1つだけ所有する
+ */
+
+#pragma once
+#include <Arduino.h>
+
+class I2cBus {
+ public:
+  I2cBus();
+  ~I2cBus();
+  void begin(void);
+  void lock(void);
+  void unlock(void);
+  void reset(void);
+
+  static const uint32_t FREQUENCY;
+  static const uint16_t TIMEOUT;
+
+ private:
+  I2cBus(const I2cBus &) = delete;
+  I2cBus &operator=(const I2cBus &) = delete;
+  static void _clearBus(void);
+
+  /** バスの排他用ミューテックス */
+  SemaphoreHandle_t _mutex;
+};
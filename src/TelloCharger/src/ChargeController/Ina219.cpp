@@ -0,0 +1,157 @@
+/**
+ * @file Ina219.cpp
+ * @brief 電流センサINA219のドライバクラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details INA219をトリガモードで使用し、変換開始と結果の回収を
+ * 別々の呼び出しで行う。1回のpoll()で行うI2C通信は数レジスタ分のみで、
+ * 変換待ちの間に呼び出し元をブロックしない
+ */
+
+#include "Ina219.h"
+
+/** デフォルトのI2Cアドレス */
+const uint8_t Ina219::DEFAULT_ADDRESS = 0x40;
+/** 設定レジスタ */
+const uint8_t Ina219::REG_CONFIG = 0x00;
+/** シャント電圧レジスタ（LSB = 10uV） */
+const uint8_t Ina219::REG_SHUNT_VOLTAGE = 0x01;
+/** バス電圧レジスタ（bit15-3: LSB = 4mV, bit1: CNVR） */
+const uint8_t Ina219::REG_BUS_VOLTAGE = 0x02;
+/** キャリブレーションレジスタ */
+const uint8_t Ina219::REG_CALIBRATION = 0x05;
+/** 32V, ±320mV, 12bit, シャント/バス電圧トリガモード */
+const uint16_t Ina219::CONFIG_TRIGGERED = 0x399B;
+/** 電流LSB = 0.1mA となるキャリブレーション値（0.1Ωシャント） */
+const uint16_t Ina219::CALIBRATION_VALUE = 4096;
+/** シャント抵抗[mΩ] */
+const int32_t Ina219::SHUNT_RESISTANCE = 100;
+/** 変換完了を待つ最大時間[us]（12bit変換は532us） */
+const uint32_t Ina219::CONVERSION_TIMEOUT = 5000;
+
+/**
+ * @brief Construct a new Ina219::Ina219 object
+ *
+ * @param address I2Cアドレス
+ * @param wire I2Cバス
+ */
+Ina219::Ina219(uint8_t address, TwoWire *wire)
+    : _address(address), _wire(wire), _step(TRIGGER), _triggerTime(0) {}
+
+/**
+ * @brief Destroy the Ina219::Ina219 object
+ *
+ */
+Ina219::~Ina219() {}
+
+/**
+ * @brief センサを初期化する
+ *
+ * @return true 初期化成功
+ * @return false センサが応答しない
+ */
+bool Ina219::begin(void) {
+  _step = TRIGGER;
+  return _writeRegister(REG_CALIBRATION, CALIBRATION_VALUE) &&
+         _writeRegister(REG_CONFIG, CONFIG_TRIGGERED);
+}
+
+/**
+ * @brief 読込処理を進める
+ *
+ * @details 変換が完了していれば結果を回収して次の変換を開始する。
+ * 変換中であれば通信せずにすぐに戻る。
+ * INA219はレジスタポインタが自動インクリメントされないため、1回の変換につき
+ * バス電圧とシャント電圧の2レジスタのみを読み、電流はシャント電圧から算出する
+ *
+ * @param reading 計測値の格納先（READYのときのみ更新）
+ * @return Ina219StatusType 読込状態
+ */
+Ina219::Ina219StatusType Ina219::poll(Ina219Reading &reading) {
+  switch (_step) {
+    case TRIGGER:
+      if (!_trigger()) return FAILED;
+      return BUSY;
+    case WAIT_CONVERSION: {
+      uint16_t bus;
+      if (!_readRegister(REG_BUS_VOLTAGE, bus)) {
+        _step = TRIGGER;
+        return FAILED;
+      }
+      if ((bus & 0x0002) == 0) {
+        // 変換中
+        if (micros() - _triggerTime > CONVERSION_TIMEOUT) {
+          _step = TRIGGER;
+          return FAILED;
+        }
+        return BUSY;
+      }
+      uint16_t shunt;
+      if (!_readRegister(REG_SHUNT_VOLTAGE, shunt)) {
+        _step = TRIGGER;
+        return FAILED;
+      }
+      reading.busVoltage = (int32_t)(bus >> 3) * 4;
+      reading.shuntVoltage = (int32_t)(int16_t)shunt * 10;
+      // I[uA] = V[uV] * 1000 / R[mΩ]
+      reading.current = reading.shuntVoltage * 1000 / SHUNT_RESISTANCE;
+      // 次の変換を開始しておく
+      if (!_trigger()) return FAILED;
+      return READY;
+    }
+    default:
+      _step = TRIGGER;
+      return BUSY;
+  }
+}
+
+/**
+ * @brief 変換を開始する
+ *
+ * @return true 成功
+ * @return false 通信失敗
+ */
+bool Ina219::_trigger(void) {
+  if (!_writeRegister(REG_CONFIG, CONFIG_TRIGGERED)) {
+    _step = TRIGGER;
+    return false;
+  }
+  _triggerTime = micros();
+  _step = WAIT_CONVERSION;
+  return true;
+}
+
+/**
+ * @brief レジスタに書き込む
+ *
+ * @param reg レジスタアドレス
+ * @param value 書き込む値
+ * @return true 成功
+ * @return false 通信失敗
+ */
+bool Ina219::_writeRegister(uint8_t reg, uint16_t value) {
+  _wire->beginTransmission(_address);
+  _wire->write(reg);
+  _wire->write((uint8_t)(value >> 8));
+  _wire->write((uint8_t)(value & 0xFF));
+  return _wire->endTransmission() == 0;
+}
+
+/**
+ * @brief レジスタを読み込む
+ *
+ * @param reg レジスタアドレス
+ * @param value 読み込んだ値の格納先
+ * @return true 成功
+ * @return false 通信失敗
+ */
+bool Ina219::_readRegister(uint8_t reg, uint16_t &value) {
+  _wire->beginTransmission(_address);
+  _wire->write(reg);
+  if (_wire->endTransmission(false) != 0) return false;
+  if (_wire->requestFrom(_address, (uint8_t)2) != 2) return false;
+  value = (uint16_t)_wire->read() << 8;
+  value |= (uint16_t)_wire->read();
+  return true;
+}
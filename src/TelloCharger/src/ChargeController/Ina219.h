@@ -0,0 +1,75 @@
+/**
+ * @file Ina219.h
+ * @brief 電流センサINA219のドライバクラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details INA219をトリガモードで使用し、変換開始と結果の回収を
+ * 別々の呼び出しで行う。1回のpoll()で行うI2C通信は数レジスタ分のみで、
+ * 変換待ちの間に呼び出し元をブロックしない
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+
+/**
+ * @brief INA219の計測値
+ */
+struct Ina219Reading {
+  /** バス電圧[mV] */
+  int32_t busVoltage;
+  /** シャント電圧[uV] */
+  int32_t shuntVoltage;
+  /** 電流値[uA] */
+  int32_t current;
+};
+
+class Ina219 {
+ public:
+  typedef enum eIna219Status {
+    /** 変換中（結果なし） */
+    BUSY,
+    /** 新しい計測値を取得した */
+    READY,
+    /** I2C通信に失敗した */
+    FAILED,
+  } Ina219StatusType;
+
+  Ina219(uint8_t address = DEFAULT_ADDRESS, TwoWire *wire = &Wire);
+  ~Ina219();
+  bool begin(void);
+  Ina219StatusType poll(Ina219Reading &);
+
+  static const uint8_t DEFAULT_ADDRESS;
+
+ private:
+  typedef enum eIna219Step {
+    /** 変換開始 */
+    TRIGGER,
+    /** 変換完了待ち */
+    WAIT_CONVERSION,
+  } Ina219StepType;
+
+  bool _writeRegister(uint8_t, uint16_t);
+  bool _readRegister(uint8_t, uint16_t &);
+  bool _trigger(void);
+
+  /** I2Cアドレス */
+  uint8_t _address;
+  /** I2Cバス */
+  TwoWire *_wire;
+  /** 読込処理のステップ */
+  Ina219StepType _step;
+  /** 変換開始時刻[us] */
+  uint32_t _triggerTime;
+
+  static const uint8_t REG_CONFIG;
+  static const uint8_t REG_SHUNT_VOLTAGE;
+  static const uint8_t REG_BUS_VOLTAGE;
+  static const uint8_t REG_CALIBRATION;
+  static const uint16_t CONFIG_TRIGGERED;
+  static const uint16_t CALIBRATION_VALUE;
+  static const int32_t SHUNT_RESISTANCE;
+  static const uint32_t CONVERSION_TIMEOUT;
+};
@@ -0,0 +1,239 @@
+/**
+ * @file LoopProfiler.cpp
+ * @brief 制御ループの処理時間・周期の計測
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ */
+
+#include "LoopProfiler.h"
+
+#ifdef LOOP_PROFILE
+#include <math.h>
+
+const uint8_t LoopHistogram::SUB_BUCKET_NUM;
+const uint8_t LoopHistogram::BUCKET_NUM;
+
+/**
+ * @brief Construct a new Loop Histogram:: Loop Histogram object
+ *
+ */
+LoopHistogram::LoopHistogram() { reset(); }
+
+/**
+ * @brief 集計をリセットする
+ *
+ */
+void LoopHistogram::reset(void) {
+  _count = 0;
+  _min = UINT32_MAX;
+  _max = 0;
+  _sum = 0;
+  _sumSq = 0;
+  for (uint8_t i = 0; i < BUCKET_NUM; i++) {
+    _buckets[i] = 0;
+  }
+}
+
+/**
+ * @brief 値を集計する
+ *
+ * @param value 値[ns]（uint32_tの範囲を超える値は丸める）
+ */
+void LoopHistogram::add(uint64_t value) {
+  uint32_t ns = value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+  uint32_t us = ns / 1000;
+  _buckets[_toBucket(us)]++;
+  _count++;
+  if (ns < _min) _min = ns;
+  if (ns > _max) _max = ns;
+  _sum += ns;
+  _sumSq += (uint64_t)us * us;
+}
+
+/**
+ * @brief サンプル数を取得する
+ *
+ * @return uint32_t サンプル数
+ */
+uint32_t LoopHistogram::getCount(void) const { return _count; }
+
+/**
+ * @brief 最小値を取得する
+ *
+ * @return float 最小値[us]（サンプルがなければ0）
+ */
+float LoopHistogram::getMin(void) const {
+  return _count == 0 ? 0 : _min / 1000.0;
+}
+
+/**
+ * @brief 最大値を取得する
+ *
+ * @return float 最大値[us]
+ */
+float LoopHistogram::getMax(void) const { return _max / 1000.0; }
+
+/**
+ * @brief 平均を取得する
+ *
+ * @return float 平均[us]（サンプルがなければ0）
+ */
+float LoopHistogram::getMean(void) const {
+  return _count == 0 ? 0 : (float)_sum / _count / 1000.0;
+}
+
+/**
+ * @brief 標準偏差を取得する
+ *
+ * @details 二乗和は1us単位で積算するため、1us未満の精度はない
+ *
+ * @return float 標準偏差[us]
+ */
+float LoopHistogram::getStdDev(void) const {
+  if (_count < 2) return 0;
+  float mean = getMean();
+  float variance = (float)_sumSq / _count - mean * mean;
+  return variance > 0 ? sqrtf(variance) : 0;
+}
+
+/**
+ * @brief パーセンタイルを取得する
+ *
+ * @details 該当する区間の中で線形補間した近似値（最小値・最大値の範囲に丸める）
+ *
+ * @param p パーセンタイル（0〜1）
+ * @return float パーセンタイル[us]（サンプルがなければ0）
+ */
+float LoopHistogram::getPercentile(float p) const {
+  if (_count == 0) return 0;
+  float rank = p * _count;
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < BUCKET_NUM; i++) {
+    if (_buckets[i] == 0) continue;
+    if (cumulative + _buckets[i] >= rank) {
+      float lower = i == 0 ? 0 : getBucketUpperBound(i - 1);
+      float upper = i == BUCKET_NUM - 1 ? getMax() : getBucketUpperBound(i);
+      float value =
+          lower + (upper - lower) * (rank - cumulative) / _buckets[i];
+      return constrain(value, getMin(), getMax());
+    }
+    cumulative += _buckets[i];
+  }
+  return getMax();
+}
+
+/**
+ * @brief 区間のサンプル数を取得する
+ *
+ * @param bucket 区間番号
+ * @return uint32_t サンプル数
+ */
+uint32_t LoopHistogram::getBucket(uint8_t bucket) const {
+  return bucket < BUCKET_NUM ? _buckets[bucket] : 0;
+}
+
+/**
+ * @brief 区間の上限を取得する
+ *
+ * @param bucket 区間番号
+ * @return float 上限[us]（この値を含まない。最後の区間は上限なしでINFINITY）
+ */
+float LoopHistogram::getBucketUpperBound(uint8_t bucket) {
+  if (bucket >= BUCKET_NUM - 1) return INFINITY;
+  if (bucket < SUB_BUCKET_NUM) return bucket + 1;
+  uint8_t shift = bucket / SUB_BUCKET_NUM - 1;
+  uint8_t sub = bucket % SUB_BUCKET_NUM;
+  return (float)((uint32_t)(SUB_BUCKET_NUM + sub + 1) << shift);
+}
+
+/**
+ * @brief 値が属する区間を取得する
+ *
+ * @param us 値[us]
+ * @return uint8_t 区間番号
+ */
+uint8_t LoopHistogram::_toBucket(uint32_t us) {
+  if (us < SUB_BUCKET_NUM) return us;
+  // 最上位ビットの位置で2のべき乗の範囲を、続く2ビットで分割した区間を求める
+  uint8_t msb = 31 - __builtin_clz(us);
+  uint8_t shift = msb - 2;
+  uint32_t bucket =
+      (shift + 1) * SUB_BUCKET_NUM + ((us >> shift) & (SUB_BUCKET_NUM - 1));
+  return bucket < BUCKET_NUM ? bucket : BUCKET_NUM - 1;
+}
+
+/**
+ * @brief Construct a new Loop Profiler:: Loop Profiler object
+ *
+ */
+LoopProfiler::LoopProfiler()
+    : _lastLoopTime(0),
+      _cpuFrequencyMhz(getCpuFrequencyMhz()),
+      _resetRequested(false) {}
+
+/**
+ * @brief 集計のリセットを要求する（他タスクから呼び出してよい）
+ *
+ * @details 集計中の値が壊れないよう、リセットは次のループの先頭で行う
+ */
+void LoopProfiler::reset(void) {
+  _resetRequested.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief 処理ごとのヒストグラムを取得する
+ *
+ * @details 制御ループが更新中の値をロックせずに参照するため、区間の間で
+ * 1サンプル分ずれることがある
+ *
+ * @param section 処理
+ * @return const LoopHistogram* ヒストグラム
+ */
+const LoopHistogram *LoopProfiler::getHistogram(SectionType section) {
+  return &_histograms[section];
+}
+
+/**
+ * @brief 処理の名前を取得する
+ *
+ * @param section 処理
+ * @return const char* 名前
+ */
+const char *LoopProfiler::getName(SectionType section) {
+  switch (section) {
+    case SECTION_LOOP:
+      return "loop";
+    case SECTION_PERIOD:
+      return "period";
+    case SECTION_CURRENT_READER:
+      return "currentReader";
+    case SECTION_START_CHARGE:
+      return "startCharge";
+    case SECTION_STOP_CHARGE:
+      return "stopCharge";
+    case SECTION_POWER_ON_DRONE:
+      return "powerOnDrone";
+    case SECTION_CALIBRATE:
+      return "calibrate";
+    case SECTION_CHECK_SERVO_CURRENT:
+      return "checkServoCurrent";
+    case SECTION_SERVO:
+      return "servo";
+    default:
+      return "unknown";
+  }
+}
+
+/**
+ * @brief 集計をリセットする（制御ループから呼び出す）
+ *
+ */
+void LoopProfiler::_reset(void) {
+  for (uint8_t section = 0; section < SECTION_NUM; section++) {
+    _histograms[section].reset();
+  }
+  _lastLoopTime = 0;
+}
+
+#endif
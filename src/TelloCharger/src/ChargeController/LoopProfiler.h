@@ -0,0 +1,168 @@
+/**
+ * @file LoopProfiler.h
+ * @brief 制御ループの処理時間・周期の計測
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details ChargeController::loop()全体と各処理の所要時間をCPUのサイクル
+ * カウンタで、ループの実行間隔をesp_timerで計測し、固定長のヒストグラムに
+ * 集計する。
+ * ビルドフラグLOOP_PROFILEを定義したときのみ有効。未定義のときは
+ * 計測処理が空のインライン関数となり、計測のコードもヒストグラムの領域も
+ * 生成されない
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#ifdef LOOP_PROFILE
+#include <esp_timer.h>
+
+#include <atomic>
+
+/**
+ * @brief 対数目盛りの固定長ヒストグラム
+ *
+ * @details 値[us]の2のべき乗ごとの範囲をさらにSUB_BUCKET_NUM個に等分した
+ * 区間で数える（4us未満は1us刻み）。区間幅は値の1/4以下となる。
+ * 最後の区間はそれ以上の値を全て含む
+ */
+class LoopHistogram {
+ public:
+  /** 2のべき乗ごとの区間の分割数（_toBucket()は4を前提とする） */
+  static const uint8_t SUB_BUCKET_NUM = 4;
+  /** 区間数（最後の区間の下限は約0.46s） */
+  static const uint8_t BUCKET_NUM = 72;
+
+  LoopHistogram();
+  void reset(void);
+  void add(uint64_t);
+  uint32_t getCount(void) const;
+  float getMin(void) const;
+  float getMax(void) const;
+  float getMean(void) const;
+  float getStdDev(void) const;
+  float getPercentile(float) const;
+  uint32_t getBucket(uint8_t) const;
+  static float getBucketUpperBound(uint8_t);
+
+ private:
+  static uint8_t _toBucket(uint32_t);
+
+  /** サンプル数 */
+  uint32_t _count;
+  /** 最小値[ns] */
+  uint32_t _min;
+  /** 最大値[ns] */
+  uint32_t _max;
+  /** 合計[ns] */
+  uint64_t _sum;
+  /** 二乗和[us^2] */
+  uint64_t _sumSq;
+  /** 区間ごとのサンプル数 */
+  uint32_t _buckets[BUCKET_NUM];
+};
+
+class LoopProfiler {
+ public:
+  typedef enum eSection {
+    /** loop()全体 */
+    SECTION_LOOP,
+    /** loop()の実行間隔 */
+    SECTION_PERIOD,
+    /** CurrentReader::loop() */
+    SECTION_CURRENT_READER,
+    /** ControlStartCharge::loop() */
+    SECTION_START_CHARGE,
+    /** ControlStopCharge::loop() */
+    SECTION_STOP_CHARGE,
+    /** ControlPowerOnDrone::loop() */
+    SECTION_POWER_ON_DRONE,
+    /** ControlCalibrate::loop() */
+    SECTION_CALIBRATE,
+    /** CheckServoCurrent::loop() */
+    SECTION_CHECK_SERVO_CURRENT,
+    /** ServoController::loop() */
+    SECTION_SERVO,
+    SECTION_NUM,
+  } SectionType;
+
+  LoopProfiler();
+
+  /**
+   * @brief ループの開始を記録する（制御ループの先頭で呼び出すこと）
+   *
+   * @details 前回の開始からの間隔を集計し、リセット要求があれば反映する
+   */
+  inline void beginLoop(void) {
+    if (_resetRequested.exchange(false, std::memory_order_acquire)) {
+      _reset();
+    }
+    int64_t now = esp_timer_get_time();
+    if (_lastLoopTime != 0) {
+      _histograms[SECTION_PERIOD].add((uint64_t)(now - _lastLoopTime) * 1000);
+    }
+    _lastLoopTime = now;
+  }
+
+  /**
+   * @brief 計測を開始する
+   *
+   * @return uint32_t 開始時のサイクルカウンタ（end()に渡す）
+   */
+  inline uint32_t begin(void) { return ESP.getCycleCount(); }
+
+  /**
+   * @brief 計測を終了し、所要時間を集計する
+   *
+   * @param section 計測した処理
+   * @param start begin()の戻り値
+   */
+  inline void end(SectionType section, uint32_t start) {
+    uint32_t cycles = ESP.getCycleCount() - start;
+    _histograms[section].add((uint64_t)cycles * 1000 / _cpuFrequencyMhz);
+  }
+
+  void reset(void);
+  const LoopHistogram *getHistogram(SectionType);
+  static const char *getName(SectionType);
+
+ private:
+  void _reset(void);
+
+  /** 処理ごとのヒストグラム */
+  LoopHistogram _histograms[SECTION_NUM];
+  /** 前回のループの開始時刻[us]（0なら未計測） */
+  int64_t _lastLoopTime;
+  /** CPUクロック[MHz] */
+  uint32_t _cpuFrequencyMhz;
+  /** 他タスクからのリセット要求 */
+  std::atomic<bool> _resetRequested;
+};
+
+#else
+
+/**
+ * @brief 計測を無効にしたときの空の実装
+ */
+class LoopProfiler {
+ public:
+  typedef enum eSection {
+    SECTION_LOOP,
+    SECTION_PERIOD,
+    SECTION_CURRENT_READER,
+    SECTION_START_CHARGE,
+    SECTION_STOP_CHARGE,
+    SECTION_POWER_ON_DRONE,
+    SECTION_CALIBRATE,
+    SECTION_CHECK_SERVO_CURRENT,
+    SECTION_SERVO,
+    SECTION_NUM,
+  } SectionType;
+
+  inline void beginLoop(void) {}
+  inline uint32_t begin(void) { return 0; }
+  inline void end(SectionType, uint32_t) {}
+};
+
+#endif
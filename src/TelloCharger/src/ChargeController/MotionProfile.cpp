@@ -0,0 +1,194 @@
+/**
+ * @file MotionProfile.cpp
+ * @brief 台形速度プロファイル生成クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 最大速度と最大加速度を制限した台形速度プロファイルで、
+ * 開始からの経過時間に対する位置・速度を求める。
+ * 移動中の目標変更に備えて初速を与えることができ、初速が目標と逆向きや
+ * 目標を行き過ぎる場合は一旦減速して停止してから目標へ向かう。
+ * Arduinoに依存しないため、PC上でも動作を確認できる
+ */
+
+#include "MotionProfile.h"
+
+#include <math.h>
+
+/**
+ * @brief Construct a new MotionProfile::MotionProfile object
+ *
+ * @param maxVel 最大速度[deg/s]
+ * @param maxAcc 最大加速度[deg/s^2]（0以下なら加減速なしの等速移動）
+ */
+MotionProfile::MotionProfile(float maxVel, float maxAcc)
+    : _maxVel(maxVel), _maxAcc(maxAcc) {
+  plan(0, 0);
+}
+
+/**
+ * @brief 速度・加速度の制限を設定する
+ *
+ * @details 次にplan()を呼び出したときから反映される
+ *
+ * @param maxVel 最大速度[deg/s]
+ * @param maxAcc 最大加速度[deg/s^2]（0以下なら加減速なしの等速移動）
+ */
+void MotionProfile::setLimits(float maxVel, float maxAcc) {
+  _maxVel = maxVel;
+  _maxAcc = maxAcc;
+}
+
+/**
+ * @brief プロファイルを生成する
+ *
+ * @param from 開始位置[deg]
+ * @param to 目標位置[deg]
+ * @param v0 初速[deg/s]
+ */
+void MotionProfile::plan(float from, float to, float v0) {
+  _from = from;
+  _to = to;
+  _v0 = v0;
+  _stopTime = 0;
+  _start = from;
+  float a = _maxAcc;
+
+  if (a <= 0) {
+    // 加減速なし（初速は無視して等速で移動する）
+    _v0 = 0;
+    _dir = to >= from ? 1 : -1;
+    _vStart = _vPeak = _maxVel;
+    _accTime = _decTime = 0;
+    _cruiseTime = fabsf(to - from) / _maxVel;
+    return;
+  }
+
+  float distance = to - from;
+  _dir = distance >= 0 ? 1 : -1;
+  float v = v0 * _dir;
+  if (v < 0 || v * v / (2 * a) > fabsf(distance)) {
+    // 逆向き、または減速しても行き過ぎる場合は一旦停止する
+    _stopTime = fabsf(v0) / a;
+    _start = from + v0 * _stopTime / 2;
+    distance = to - _start;
+    _dir = distance >= 0 ? 1 : -1;
+    v = 0;
+  } else {
+    _v0 = 0;
+  }
+  if (v > _maxVel) v = _maxVel;
+
+  float d = fabsf(distance);
+  _vStart = v;
+  // 最高速度まで加速してから減速する場合の加減速距離
+  float dAcc = (_maxVel * _maxVel - v * v) / (2 * a);
+  float dDec = _maxVel * _maxVel / (2 * a);
+  if (dAcc + dDec <= d) {
+    _vPeak = _maxVel;
+    _cruiseTime = (d - dAcc - dDec) / _maxVel;
+  } else {
+    // 最高速度に達しない（三角形プロファイル）
+    _vPeak = sqrtf(a * d + v * v / 2);
+    _cruiseTime = 0;
+  }
+  _accTime = (_vPeak - v) / a;
+  _decTime = _vPeak / a;
+}
+
+/**
+ * @brief 位置を取得する
+ *
+ * @param t プロファイル開始からの経過時間[sec]
+ * @return float 位置[deg]
+ */
+float MotionProfile::getPosition(float t) const {
+  if (t <= 0) return _from;
+  if (t < _stopTime) {
+    float a = _v0 > 0 ? -_maxAcc : _maxAcc;
+    return _from + _v0 * t + a * t * t / 2;
+  }
+  t -= _stopTime;
+  float s;
+  if (t < _accTime) {
+    s = _vStart * t + _maxAcc * t * t / 2;
+  } else if (t < _accTime + _cruiseTime) {
+    float sAcc = (_vStart + _vPeak) * _accTime / 2;
+    s = sAcc + _vPeak * (t - _accTime);
+  } else if (t < _accTime + _cruiseTime + _decTime) {
+    float sAcc = (_vStart + _vPeak) * _accTime / 2;
+    float td = t - _accTime - _cruiseTime;
+    s = sAcc + _vPeak * _cruiseTime + _vPeak * td - _maxAcc * td * td / 2;
+  } else {
+    return _to;
+  }
+  return _start + _dir * s;
+}
+
+/**
+ * @brief 速度を取得する
+ *
+ * @param t プロファイル開始からの経過時間[sec]
+ * @return float 速度[deg/s]
+ */
+float MotionProfile::getVelocity(float t) const {
+  if (t < 0) return _v0;
+  if (t < _stopTime) {
+    return _v0 > 0 ? _v0 - _maxAcc * t : _v0 + _maxAcc * t;
+  }
+  t -= _stopTime;
+  float v;
+  if (t < _accTime) {
+    v = _vStart + _maxAcc * t;
+  } else if (t < _accTime + _cruiseTime) {
+    v = _vPeak;
+  } else if (t < _accTime + _cruiseTime + _decTime) {
+    v = _vPeak - _maxAcc * (t - _accTime - _cruiseTime);
+  } else {
+    return 0;
+  }
+  return _dir * v;
+}
+
+/**
+ * @brief 移動時間を取得する
+ *
+ * @return float 移動時間[sec]
+ */
+float MotionProfile::getDuration(void) const {
+  return _stopTime + _accTime + _cruiseTime + _decTime;
+}
+
+/**
+ * @brief 指定した位置を通過する時刻を取得する
+ *
+ * @details 停止区間の後の単調な区間を二分探索する
+ *
+ * @param position 位置[deg]
+ * @return float プロファイル開始からの経過時間[sec]
+ * （開始時点で通過済みなら停止区間の終了時刻、到達しなければ移動時間）
+ */
+float MotionProfile::getTimeToReach(float position) const {
+  float lo = _stopTime;
+  float hi = getDuration();
+  if ((position - _start) * _dir <= 0) return lo;
+  if ((position - _to) * _dir >= 0) return hi;
+  for (uint8_t i = 0; i < 20; i++) {
+    float mid = (lo + hi) / 2;
+    if ((getPosition(mid) - position) * _dir < 0) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return hi;
+}
+
+/**
+ * @brief 移動が完了したかどうか
+ *
+ * @param t プロファイル開始からの経過時間[sec]
+ * @return true 完了
+ * @return false 移動中
+ */
+bool MotionProfile::isFinished(float t) const { return t >= getDuration(); }
@@ -0,0 +1,55 @@
+/**
+ * @file MotionProfile.h
+ * @brief 台形速度プロファイル生成クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 最大速度と最大加速度を制限した台形速度プロファイルで、
+ * 開始からの経過時間に対する位置・速度を求める。
+ * 移動中の目標変更に備えて初速を与えることができ、初速が目標と逆向きや
+ * 目標を行き過ぎる場合は一旦減速して停止してから目標へ向かう。
+ * Arduinoに依存しないため、PC上でも動作を確認できる
+ */
+
+#pragma once
+#include <stdint.h>
+
+class MotionProfile {
+ public:
+  MotionProfile(float, float);
+  void setLimits(float, float);
+  void plan(float, float, float v0 = 0);
+  float getPosition(float) const;
+  float getVelocity(float) const;
+  float getDuration(void) const;
+  float getTimeToReach(float) const;
+  bool isFinished(float) const;
+
+ private:
+  /** 最大速度[deg/s] */
+  float _maxVel;
+  /** 最大加速度[deg/s^2]（0以下なら加減速なしの等速移動） */
+  float _maxAcc;
+  /** 開始位置[deg] */
+  float _from;
+  /** 目標位置[deg] */
+  float _to;
+  /** 初速[deg/s] */
+  float _v0;
+  /** 初速を0まで減速する時間[sec] */
+  float _stopTime;
+  /** 台形区間の開始位置[deg] */
+  float _start;
+  /** 台形区間の移動方向（±1） */
+  float _dir;
+  /** 台形区間の初速（移動方向が正）[deg/s] */
+  float _vStart;
+  /** 台形区間の最高速度[deg/s] */
+  float _vPeak;
+  /** 加速時間[sec] */
+  float _accTime;
+  /** 等速時間[sec] */
+  float _cruiseTime;
+  /** 減速時間[sec] */
+  float _decTime;
+};
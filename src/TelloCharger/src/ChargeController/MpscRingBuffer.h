@@ -0,0 +1,122 @@
+/**
+ * @file MpscRingBuffer.h
+ * @brief 複数生産者/単一消費者のロックフリーリングバッファ
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 要素ごとにシーケンス番号を持つ有界キュー。
+ * 生産者は書き込み位置をCASで確保してから要素を書き込み、シーケンス番号を
+ * 更新して消費者に公開する。消費者は1つのタスクに限る。
+ * 書き込み位置は追加した順に連番で割り当てられ、消費者はその順に取り出す
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+template <typename T, uint32_t N>
+class MpscRingBuffer {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+ public:
+  MpscRingBuffer() : _head(0), _tail(0) {
+    for (uint32_t i = 0; i < N; i++) {
+      _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief データを追加する（複数のタスクから呼び出してよい）
+   *
+   * @param item 追加するデータ
+   * @param position 割り当てられた位置の格納先（NULLなら格納しない）
+   * @return true 追加できた
+   * @return false バッファが満杯のため追加できなかった
+   */
+  bool push(const T &item, uint32_t *position = NULL) {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+      cell = &_cells[head & (N - 1)];
+      uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+      int32_t diff = (int32_t)(sequence - head);
+      if (diff == 0) {
+        // 空き要素なので書き込み位置の確保を試みる（失敗時はheadが更新される）
+        if (_head.compare_exchange_weak(head, head + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // 消費者がまだ取り出していない
+        return false;
+      } else {
+        // 他の生産者が先に確保した
+        head = _head.load(std::memory_order_relaxed);
+      }
+    }
+    cell->item = item;
+    cell->sequence.store(head + 1, std::memory_order_release);
+    if (position != NULL) *position = head;
+    return true;
+  }
+
+  /**
+   * @brief データを取り出す（消費者側からのみ呼び出すこと）
+   *
+   * @param item 取り出したデータの格納先
+   * @return true 取り出せた
+   * @return false バッファが空だった（確保済みで書き込み中の要素を含む）
+   */
+  bool pop(T &item) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    Cell *cell = &_cells[tail & (N - 1)];
+    if (cell->sequence.load(std::memory_order_acquire) != tail + 1) {
+      return false;
+    }
+    item = cell->item;
+    cell->sequence.store(tail + N, std::memory_order_release);
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief これまでに確保した書き込み位置の数を取得する
+   *
+   * @details 次に割り当てる位置と一致する（複数のタスクから呼び出してよい）
+   *
+   * @return uint32_t 確保した位置の数
+   */
+  uint32_t getPushedCount(void) {
+    return _head.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief バッファの容量を取得する
+   *
+   * @return uint32_t 容量
+   */
+  static uint32_t capacity(void) { return N; }
+
+ private:
+  MpscRingBuffer(const MpscRingBuffer &) = delete;
+  MpscRingBuffer &operator=(const MpscRingBuffer &) = delete;
+
+  /**
+   * @brief データ格納要素
+   */
+  struct Cell {
+    /** シーケンス番号（位置と一致すれば空き、位置+1なら書き込み済み） */
+    std::atomic<uint32_t> sequence;
+    /** データ */
+    T item;
+  };
+
+  /** データ格納領域 */
+  Cell _cells[N];
+  /** 次に確保する書き込み位置（生産者がCASで更新） */
+  std::atomic<uint32_t> _head;
+  /** 読み出し位置（消費者のみ更新） */
+  std::atomic<uint32_t> _tail;
+};
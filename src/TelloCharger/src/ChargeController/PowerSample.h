@@ -0,0 +1,26 @@
+/**
+ * @file PowerSample.h
+ * @brief 電流センサの計測値
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ */
+
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief 電力サンプル
+ */
+struct PowerSample {
+  /** 計測時刻[us] */
+  uint32_t time;
+  /** バス電圧[mV] */
+  int32_t busVoltage;
+  /** シャント電圧[uV] */
+  int32_t shuntVoltage;
+  /** 電流値[uA] */
+  int32_t current;
+  /** 電力[uW] */
+  int32_t power;
+};
@@ -0,0 +1,101 @@
+/**
+ * @file Seqlock.h
+ * @brief 単一書き込み/複数読み出しのシーケンスロック
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 書き込み側は書き込み中にシーケンス番号を奇数にし、完了時に偶数に戻す。
+ * 読み出し側はロックを取らずにデータを複写し、前後でシーケンス番号が
+ * 変わっていなければ一貫した値として採用する（変わっていれば複写し直す）。
+ * 書き込み側が読み出し側を待つことはないため、遅いクライアントが
+ * 制御ループを止めることはない。
+ * 書き込みはクリティカルセクション内で行い、書き込み中のタスクが
+ * 読み出し側のタスクに横取りされないようにする（読み出し側の再試行は
+ * 書き込みにかかる数usで必ず終わる）。
+ * データは複写可能な固定長の型に限る。データ競合を避けるため、
+ * 格納領域は32bitのアトミック変数の配列とする
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <string.h>
+
+#include <atomic>
+#include <type_traits>
+
+template <typename T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "T must be trivially copyable");
+
+ public:
+  Seqlock() : _mux(portMUX_INITIALIZER_UNLOCKED), _sequence(0) {
+    for (uint32_t i = 0; i < WORD_NUM; i++) {
+      _words[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief データを書き込む（単一のタスクからのみ呼び出すこと）
+   *
+   * @param item 書き込むデータ
+   */
+  void write(const T &item) {
+    uint32_t words[WORD_NUM] = {};
+    memcpy(words, &item, sizeof(T));
+    portENTER_CRITICAL(&_mux);
+    uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+    _sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (uint32_t i = 0; i < WORD_NUM; i++) {
+      _words[i].store(words[i], std::memory_order_relaxed);
+    }
+    _sequence.store(sequence + 2, std::memory_order_release);
+    portEXIT_CRITICAL(&_mux);
+  }
+
+  /**
+   * @brief データを読み出す（複数のタスクから呼び出してよい）
+   *
+   * @param item 読み出したデータの格納先
+   * @return uint32_t 読み出したデータの版数（書き込み回数。0なら未書き込み）
+   */
+  uint32_t read(T &item) const {
+    uint32_t words[WORD_NUM];
+    uint32_t sequence;
+    while (true) {
+      sequence = _sequence.load(std::memory_order_acquire);
+      if (sequence & 1) continue;  // 書き込み中
+      for (uint32_t i = 0; i < WORD_NUM; i++) {
+        words[i] = _words[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (_sequence.load(std::memory_order_relaxed) == sequence) break;
+    }
+    memcpy(&item, words, sizeof(T));
+    return sequence / 2;
+  }
+
+  /**
+   * @brief 最新のデータの版数を取得する
+   *
+   * @return uint32_t 版数（書き込み回数）
+   */
+  uint32_t getVersion(void) const {
+    return _sequence.load(std::memory_order_acquire) / 2;
+  }
+
+ private:
+  Seqlock(const Seqlock &) = delete;
+  Seqlock &operator=(const Seqlock &) = delete;
+
+  /** 格納領域のワード数 */
+  static const uint32_t WORD_NUM = (sizeof(T) + 3) / 4;
+
+  /** 書き込み中の横取りを防ぐためのクリティカルセクション */
+  portMUX_TYPE _mux;
+  /** シーケンス番号（奇数なら書き込み中） */
+  std::atomic<uint32_t> _sequence;
+  /** データ格納領域 */
+  std::atomic<uint32_t> _words[WORD_NUM];
+};
@@ -0,0 +1,280 @@
+/**
+ * @file ServoAxis.cpp
+ * @brief 速度プロファイル付きサーボ軸クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details ServoESP32に台形速度プロファイルの途中位置を毎周期指示することで、
+ * 加減速を制限しながらサーボを動かす。
+ * ServoESP32自体の速度制限は途中位置に遅れなく追従できるよう十分大きくしている。
+ *
+ * ビルドフラグ SERVO_BACKEND_TIMER を定義すると、途中位置の計算とPWM出力を
+ * 高優先度のesp_timerタスクで一定周期に行い、loop()の呼び出し周期の揺らぎが
+ * サーボの動きに影響しないようにする（ServoESP32は使用しない）
+ */
+
+#include "ServoAxis.h"
+
+/** ServoESP32の速度[deg/s]（1周期で途中位置に追従できる速度） */
+const float ServoAxis::TRACKING_VEL = 2000;
+#ifdef SERVO_BACKEND_TIMER
+/** 途中位置の更新周期[us]（PWM周期20msの間に複数回更新する） */
+const uint32_t ServoAxis::UPDATE_PERIOD = 5000;
+/** PWM周波数[Hz] */
+const uint32_t ServoAxis::PWM_FREQUENCY = 50;
+/** PWM分解能[bit] */
+const uint8_t ServoAxis::PWM_RESOLUTION = 16;
+/** 0degのパルス幅[us]（ServoESP32と同じ対応にすること） */
+const float ServoAxis::PULSE_CENTER = 1500;
+/** 1degあたりのパルス幅[us]（±90degで500〜2500us） */
+const float ServoAxis::PULSE_PER_DEG = 1000.0 / 90.0;
+#endif
+
+/**
+ * @brief Construct a new ServoAxis::ServoAxis object
+ *
+ * @param channel PWMチャンネル
+ * @param pin 制御PIN
+ * @param initAngle 初期角度[deg]
+ * @param maxVel 最大速度[deg/s]
+ * @param maxAcc 最大加速度[deg/s^2]（0以下なら加減速なしの等速移動）
+ */
+ServoAxis::ServoAxis(uint8_t channel, uint8_t pin, float initAngle,
+                     float maxVel, float maxAcc)
+    :
+#ifdef SERVO_BACKEND_TIMER
+      _channel(channel),
+      _timer(NULL),
+      _mux(portMUX_INITIALIZER_UNLOCKED),
+#else
+      _servo(channel, pin, initAngle, TRACKING_VEL),
+#endif
+      _profile(maxVel, maxAcc),
+      _targetAngle(initAngle),
+      _presentAngle(initAngle),
+      _presentVelocity(0),
+      _startTime(0),
+      _isMoving(false) {
+#ifdef SERVO_BACKEND_TIMER
+  ledcSetup(_channel, PWM_FREQUENCY, PWM_RESOLUTION);
+  ledcAttachPin(pin, _channel);
+  _writeAngle(initAngle);
+  esp_timer_create_args_t args = {};
+  args.callback = &ServoAxis::_onTimer;
+  args.arg = this;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "servoAxis";
+  args.skip_unhandled_events = true;
+  if (esp_timer_create(&args, &_timer) == ESP_OK) {
+    esp_timer_start_periodic(_timer, UPDATE_PERIOD);
+  }
+#endif
+}
+
+/**
+ * @brief Destroy the ServoAxis::ServoAxis object
+ *
+ */
+ServoAxis::~ServoAxis() {
+#ifdef SERVO_BACKEND_TIMER
+  if (_timer != NULL) {
+    esp_timer_stop(_timer);
+    esp_timer_delete(_timer);
+  }
+#endif
+}
+
+/**
+ * @brief 目標角度を取得する
+ *
+ * @return float 目標角度[deg]
+ */
+float ServoAxis::getTargetAngle(void) { return _targetAngle; }
+
+/**
+ * @brief 目標角度を設定する
+ *
+ * @details 移動中に変更した場合は現在の速度から滑らかに目標を切り替える
+ *
+ * @param angle 目標角度[deg]
+ */
+void ServoAxis::setTargetAngle(float angle) {
+  if (angle == _targetAngle) return;
+  _lock();
+  _profile.plan(_presentAngle, angle, _presentVelocity);
+  _startTime = micros();
+  _targetAngle = angle;
+  _isMoving = true;
+  _unlock();
+}
+
+/**
+ * @brief 現在の指示角度を取得する
+ *
+ * @details 移動完了後は目標角度と厳密に一致する
+ *
+ * @return float 指示角度[deg]
+ */
+float ServoAxis::getPresentAngle(void) { return _presentAngle; }
+
+/**
+ * @brief 現在の指示速度を取得する
+ *
+ * @return float 指示速度[deg/s]
+ */
+float ServoAxis::getPresentVelocity(void) { return _presentVelocity; }
+
+/**
+ * @brief 指示値が目標角度に到達したかどうか
+ *
+ * @return true
+ * @return false
+ */
+bool ServoAxis::isTargetAngle(void) {
+#ifdef SERVO_BACKEND_TIMER
+  return !_isMoving;
+#else
+  return !_isMoving && _servo.isTargetAngle();
+#endif
+}
+
+/**
+ * @brief 目標角度に到達するまでの残り時間を取得する
+ *
+ * @return float 残り時間[sec]（停止中は0）
+ */
+float ServoAxis::getRemainingTime(void) {
+  if (!_isMoving) return 0;
+  float remaining =
+      _profile.getDuration() - (micros() - _startTime) / 1000000.0f;
+  return remaining > 0 ? remaining : 0;
+}
+
+/**
+ * @brief 移動を打ち切り、現在の指示角度で止める
+ *
+ * @details 減速せずにその場で止める（ストール時や電流を監視できないとき用）
+ */
+void ServoAxis::hold(void) {
+  _lock();
+  _targetAngle = _presentAngle;
+  _presentVelocity = 0;
+  _isMoving = false;
+  _unlock();
+#ifndef SERVO_BACKEND_TIMER
+  _servo.setTargetAngle(_presentAngle);
+#endif
+}
+
+/**
+ * @brief 現在の状態から目標角度へ移動したときに、指定角度を通過するまでの時間を
+ * 求める
+ *
+ * @details 実際には移動しない
+ *
+ * @param target 目標角度[deg]
+ * @param angle 通過する角度[deg]
+ * @return float 通過するまでの時間[sec]（通過済みなら0）
+ */
+float ServoAxis::getTimeToReach(float target, float angle) {
+  MotionProfile profile = _profile;
+  profile.plan(_presentAngle, target, _presentVelocity);
+  return profile.getTimeToReach(angle);
+}
+
+/**
+ * @brief 速度・加速度の制限を設定する
+ *
+ * @details 次に目標角度を設定したときから反映される
+ *
+ * @param maxVel 最大速度[deg/s]
+ * @param maxAcc 最大加速度[deg/s^2]
+ */
+void ServoAxis::setLimits(float maxVel, float maxAcc) {
+  _lock();
+  _profile.setLimits(maxVel, maxAcc);
+  _unlock();
+}
+
+/**
+ * @brief ループ処理
+ *
+ * @details 経過時間からプロファイル上の途中位置を求めてサーボに指示する。
+ * SERVO_BACKEND_TIMER ではタイマータスクで行うため何もしない
+ */
+void ServoAxis::loop(void) {
+#ifndef SERVO_BACKEND_TIMER
+  if (_isMoving) {
+    _updatePresent();
+    _servo.setTargetAngle(_presentAngle);
+  }
+  _servo.loop();
+#endif
+}
+
+/**
+ * @brief 経過時間からプロファイル上の現在の指示角度・速度を更新する
+ *
+ */
+void ServoAxis::_updatePresent(void) {
+  float t = (micros() - _startTime) / 1000000.0f;
+  if (_profile.isFinished(t)) {
+    _presentAngle = _targetAngle;
+    _presentVelocity = 0;
+    _isMoving = false;
+  } else {
+    _presentAngle = _profile.getPosition(t);
+    _presentVelocity = _profile.getVelocity(t);
+  }
+}
+
+/**
+ * @brief タイマータスクと共有する状態を排他する
+ *
+ */
+void ServoAxis::_lock(void) {
+#ifdef SERVO_BACKEND_TIMER
+  portENTER_CRITICAL(&_mux);
+#endif
+}
+
+/**
+ * @brief タイマータスクと共有する状態の排他を解除する
+ *
+ */
+void ServoAxis::_unlock(void) {
+#ifdef SERVO_BACKEND_TIMER
+  portEXIT_CRITICAL(&_mux);
+#endif
+}
+
+#ifdef SERVO_BACKEND_TIMER
+/**
+ * @brief 途中位置の更新周期ごとの処理（esp_timerタスクで実行）
+ *
+ * @details 途中位置の計算は排他区間内で行い、PWM出力は排他区間の外で行う
+ *
+ * @param arg ServoAxisのインスタンス
+ */
+void ServoAxis::_onTimer(void *arg) {
+  ServoAxis *axis = static_cast<ServoAxis *>(arg);
+  axis->_lock();
+  bool isMoving = axis->_isMoving;
+  if (isMoving) axis->_updatePresent();
+  float angle = axis->_presentAngle;
+  axis->_unlock();
+  if (isMoving) axis->_writeAngle(angle);
+}
+
+/**
+ * @brief 角度に対応するパルス幅をPWM出力する
+ *
+ * @param angle 角度[deg]
+ */
+void ServoAxis::_writeAngle(float angle) {
+  float pulse = PULSE_CENTER + angle * PULSE_PER_DEG;
+  float period = 1000000.0f / PWM_FREQUENCY;
+  uint32_t maxDuty = (1UL << PWM_RESOLUTION) - 1;
+  ledcWrite(_channel, (uint32_t)(pulse / period * maxDuty + 0.5f));
+}
+#endif
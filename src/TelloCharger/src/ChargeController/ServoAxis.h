@@ -0,0 +1,83 @@
+/**
+ * @file ServoAxis.h
+ * @brief 速度プロファイル付きサーボ軸クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details ServoESP32に台形速度プロファイルの途中位置を毎周期指示することで、
+ * 加減速を制限しながらサーボを動かす。
+ * ServoESP32自体の速度制限は途中位置に遅れなく追従できるよう十分大きくしている。
+ *
+ * ビルドフラグ SERVO_BACKEND_TIMER を定義すると、途中位置の計算とPWM出力を
+ * 高優先度のesp_timerタスクで一定周期に行い、loop()の呼び出し周期の揺らぎが
+ * サーボの動きに影響しないようにする（ServoESP32は使用しない）
+ */
+
+#pragma once
+#include <Arduino.h>
+#ifdef SERVO_BACKEND_TIMER
+#include <esp_timer.h>
+#else
+#include <ServoESP32.h>
+#endif
+
+#include "MotionProfile.h"
+
+class ServoAxis {
+ public:
+  ServoAxis(uint8_t, uint8_t, float, float, float);
+  ~ServoAxis();
+  float getTargetAngle(void);
+  void setTargetAngle(float);
+  void hold(void);
+  float getPresentAngle(void);
+  float getPresentVelocity(void);
+  bool isTargetAngle(void);
+  float getRemainingTime(void);
+  float getTimeToReach(float, float);
+  void setLimits(float, float);
+  void loop(void);
+
+  static const float TRACKING_VEL;
+#ifdef SERVO_BACKEND_TIMER
+  static const uint32_t UPDATE_PERIOD;
+  static const uint32_t PWM_FREQUENCY;
+  static const uint8_t PWM_RESOLUTION;
+  static const float PULSE_CENTER;
+  static const float PULSE_PER_DEG;
+#endif
+
+ private:
+  ServoAxis(const ServoAxis &) = delete;
+  ServoAxis &operator=(const ServoAxis &) = delete;
+  void _updatePresent(void);
+  void _lock(void);
+  void _unlock(void);
+
+#ifdef SERVO_BACKEND_TIMER
+  static void _onTimer(void *);
+  void _writeAngle(float);
+
+  /** PWMチャンネル */
+  uint8_t _channel;
+  /** 途中位置を更新する周期タイマー */
+  esp_timer_handle_t _timer;
+  /** タイマータスクと共有する状態の排他制御 */
+  portMUX_TYPE _mux;
+#else
+  /** サーボモータ */
+  ServoESP32 _servo;
+#endif
+  /** 速度プロファイル */
+  MotionProfile _profile;
+  /** 目標角度[deg] */
+  float _targetAngle;
+  /** 現在の指示角度[deg] */
+  volatile float _presentAngle;
+  /** 現在の指示速度[deg/s] */
+  volatile float _presentVelocity;
+  /** プロファイルの開始時刻[us] */
+  uint32_t _startTime;
+  /** プロファイルに沿って移動中かどうか */
+  volatile bool _isMoving;
+};
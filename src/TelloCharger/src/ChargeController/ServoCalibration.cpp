@@ -0,0 +1,285 @@
+/**
+ * @file ServoCalibration.cpp
+ * @brief サーボ角度キャリブレーションクラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 個体ごとに調整したサーボ角度をNVSに保存し、起動時に読み込む。
+ * 保存値がない・不正な場合は既定の角度を使用する。
+ * 実機で確認済みの項目（フラグ）も角度と一緒に保存する
+ */
+
+#include "ServoCalibration.h"
+
+#include <Log.h>
+#include <Preferences.h>
+
+/** 角度が一致しているとみなす許容誤差[deg] */
+const float ServoCalibration::ANGLE_TOLERANCE = 0.5;
+/** 既定の角度[deg]（ServoAngleTypeの順） */
+const float ServoCalibration::DEFAULT_ANGLES[ANGLE_TYPE_NUM] = {
+    -45, 8, 14, -56, 0, 52,
+};
+/** 設定可能な角度の最小値[deg] */
+const float ServoCalibration::MIN_ANGLE = -90;
+/** 設定可能な角度の最大値[deg] */
+const float ServoCalibration::MAX_ANGLE = 90;
+/** 角度テーブルを保存する名前空間の基本名（BayConfig::getNamespace()参照） */
+const char *ServoCalibration::NAMESPACE = "servo";
+/** NVSのキー（保存形式のバージョン） */
+const char *ServoCalibration::KEY_VERSION = "version";
+/** NVSのキー（角度テーブル） */
+const char *ServoCalibration::KEY_ANGLES = "angles";
+/** NVSのキー（実機で確認済みの項目。保存値がなければ未確認） */
+const char *ServoCalibration::KEY_FLAGS = "flags";
+/** 保存形式のバージョン（角度テーブルの構成を変えたら上げる） */
+const uint8_t ServoCalibration::VERSION = 1;
+
+/**
+ * @brief Construct a new Servo Calibration:: Servo Calibration object
+ *
+ * @details 既定の角度テーブルで初期化してから、ベイの保存値があれば
+ * 読み込んで置き換える（生成できる時期はBayConfig::getNamespace()参照）
+ *
+ * @param bay 充電ベイの構成
+ */
+ServoCalibration::ServoCalibration(const BayConfig &bay)
+    : _flags(0), _isLoaded(false), _namespace(bay.getNamespace(NAMESPACE)) {
+  reset();
+  load();
+}
+
+/**
+ * @brief Destroy the Servo Calibration:: Servo Calibration object
+ *
+ */
+ServoCalibration::~ServoCalibration() {}
+
+/**
+ * @brief NVSから角度テーブルを読み込む
+ *
+ * @return true 読み込み成功
+ * @return false 保存値がない、または不正（現在の角度テーブルを維持する）
+ */
+bool ServoCalibration::load(void) {
+  Preferences prefs;
+  if (!prefs.begin(_namespace.c_str(), true)) return false;
+  float angles[ANGLE_TYPE_NUM];
+  bool isRead = prefs.getUChar(KEY_VERSION, 0) == VERSION &&
+                prefs.getBytesLength(KEY_ANGLES) == sizeof(angles) &&
+                prefs.getBytes(KEY_ANGLES, angles, sizeof(angles)) ==
+                    sizeof(angles);
+  uint8_t flags = prefs.getUChar(KEY_FLAGS, 0);
+  prefs.end();
+  if (!isRead) return false;
+  if (!_isValid(angles)) {
+    logger.warn("ServoCalibration.load(): Invalid calibration in NVS");
+    return false;
+  }
+  memcpy(_angles, angles, sizeof(_angles));
+  _flags = flags;
+  _isLoaded = true;
+  logger.info("ServoCalibration.load(): " + toString());
+  return true;
+}
+
+/**
+ * @brief 現在の角度テーブルをNVSに保存する
+ *
+ * @return true 保存成功
+ * @return false 保存失敗
+ */
+bool ServoCalibration::save(void) {
+  Preferences prefs;
+  if (!prefs.begin(_namespace.c_str(), false)) return false;
+  bool isWritten =
+      prefs.putBytes(KEY_ANGLES, _angles, sizeof(_angles)) ==
+          sizeof(_angles) &&
+      prefs.putUChar(KEY_FLAGS, _flags) == sizeof(uint8_t) &&
+      prefs.putUChar(KEY_VERSION, VERSION) == sizeof(uint8_t);
+  prefs.end();
+  if (isWritten) {
+    _isLoaded = true;
+    logger.info("ServoCalibration.save(): " + toString());
+  } else {
+    logger.error("ServoCalibration.save(): Failed to write NVS");
+  }
+  return isWritten;
+}
+
+/**
+ * @brief 角度テーブルを既定値に戻す（NVSの保存値は変更しない）
+ *
+ * @details 既定値は実機で確認していないため、フラグもすべて消去する
+ */
+void ServoCalibration::reset(void) {
+  memcpy(_angles, DEFAULT_ANGLES, sizeof(_angles));
+  _flags = 0;
+  _isLoaded = false;
+}
+
+/**
+ * @brief NVSの保存値を使用しているかどうか
+ *
+ * @return true NVSの保存値
+ * @return false 既定値
+ */
+bool ServoCalibration::isLoaded(void) { return _isLoaded; }
+
+/**
+ * @brief 角度を取得する
+ *
+ * @param type 角度の種類
+ * @return float 角度[deg]
+ */
+float ServoCalibration::getAngle(ServoAngleType type) {
+  if (type >= ANGLE_TYPE_NUM) return 0;
+  return _angles[type];
+}
+
+/**
+ * @brief 角度を設定する（NVSへは保存しない）
+ *
+ * @details 設定後の角度テーブルが角度の大小関係を満たさない場合は設定しない
+ *
+ * @param type 角度の種類
+ * @param angle 角度[deg]
+ * @return true 設定成功
+ * @return false 不正な角度
+ */
+bool ServoCalibration::setAngle(ServoAngleType type, float angle) {
+  if (type >= ANGLE_TYPE_NUM) return false;
+  float angles[ANGLE_TYPE_NUM];
+  memcpy(angles, _angles, sizeof(angles));
+  angles[type] = angle;
+  if (!_isValid(angles)) {
+    logger.warn("ServoCalibration.setAngle(): Invalid angle. " +
+                String(getName(type)) + " = " + String(angle));
+    return false;
+  }
+  _angles[type] = angle;
+  return true;
+}
+
+/**
+ * @brief 実機で確認済みの項目かどうか
+ *
+ * @param flag 項目
+ * @return true 確認済み
+ * @return false 未確認
+ */
+bool ServoCalibration::hasFlag(CalibrationFlagType flag) {
+  return (_flags & flag) != 0;
+}
+
+/**
+ * @brief 実機で確認済みの項目を設定する（NVSへは保存しない）
+ *
+ * @param flag 項目
+ * @param isSet 確認済みならtrue
+ */
+void ServoCalibration::setFlag(CalibrationFlagType flag, bool isSet) {
+  if (isSet) {
+    _flags |= flag;
+  } else {
+    _flags &= ~flag;
+  }
+}
+
+/**
+ * @brief 角度テーブルの文字列を取得する
+ *
+ * @return String 角度テーブルの文字列
+ */
+String ServoCalibration::toString(void) {
+  String str = "Servo Calibration (";
+  str += _isLoaded ? "nvs)" : "default)";
+  for (uint8_t i = 0; i < ANGLE_TYPE_NUM; i++) {
+    str += (i == 0 ? " " : ", ");
+    str += String(getName((ServoAngleType)i)) + " = " + String(_angles[i]);
+  }
+  const CalibrationFlagType flags[] = {FLAG_FAST_MOTION, FLAG_USB_CLEAR};
+  for (uint8_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+    str += ", " + String(getFlagName(flags[i])) + " = " +
+           String(hasFlag(flags[i]) ? "true" : "false");
+  }
+  return str;
+}
+
+/**
+ * @brief 2つの角度が一致しているとみなせるかどうか
+ *
+ * @param angle 角度[deg]
+ * @param reference 比較する角度[deg]
+ * @return true 許容誤差以内
+ * @return false
+ */
+bool ServoCalibration::isNear(float angle, float reference) {
+  return fabsf(angle - reference) <= ANGLE_TOLERANCE;
+}
+
+/**
+ * @brief 角度の種類の名前を取得する
+ *
+ * @param type 角度の種類
+ * @return const char* 名前
+ */
+const char *ServoCalibration::getName(ServoAngleType type) {
+  switch (type) {
+    case ANGLE_DRONE_RELEASE:
+      return "droneRelease";
+    case ANGLE_DRONE_CATCH:
+      return "droneCatch";
+    case ANGLE_DRONE_CATCH_ONCE:
+      return "droneCatchOnce";
+    case ANGLE_USB_OFF:
+      return "usbOff";
+    case ANGLE_USB_CLEAR:
+      return "usbClear";
+    case ANGLE_USB_ON:
+      return "usbOn";
+    default:
+      return "unknown";
+  }
+}
+
+/**
+ * @brief 実機で確認済みの項目の名前を取得する
+ *
+ * @param flag 項目
+ * @return const char* 名前
+ */
+const char *ServoCalibration::getFlagName(CalibrationFlagType flag) {
+  switch (flag) {
+    case FLAG_FAST_MOTION:
+      return "fastMotion";
+    case FLAG_USB_CLEAR:
+      return "usbClear";
+    default:
+      return "unknown";
+  }
+}
+
+/**
+ * @brief 角度テーブルが正しいかどうか
+ *
+ * @details 各角度が可動範囲内であり、
+ * 捕獲サーボは 離す < 捕まえる、
+ * USBサーボは 離す < 干渉しない < 接触させる の順であること。
+ * 隣り合う角度は許容誤差より離れていなければ判定できないため不正とする
+ *
+ * @param angles 角度テーブル
+ * @return true 正しい
+ * @return false 不正
+ */
+bool ServoCalibration::_isValid(const float *angles) {
+  for (uint8_t i = 0; i < ANGLE_TYPE_NUM; i++) {
+    if (!(angles[i] >= MIN_ANGLE && angles[i] <= MAX_ANGLE)) return false;
+  }
+  float margin = ANGLE_TOLERANCE * 2;
+  return angles[ANGLE_DRONE_RELEASE] + margin < angles[ANGLE_DRONE_CATCH] &&
+         angles[ANGLE_DRONE_RELEASE] + margin <
+             angles[ANGLE_DRONE_CATCH_ONCE] &&
+         angles[ANGLE_USB_OFF] + margin < angles[ANGLE_USB_CLEAR] &&
+         angles[ANGLE_USB_CLEAR] + margin < angles[ANGLE_USB_ON];
+}
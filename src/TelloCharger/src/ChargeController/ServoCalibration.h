@@ -0,0 +1,79 @@
+/**
+ * @file ServoCalibration.h
+ * @brief サーボ角度キャリブレーションクラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 個体ごとに調整したサーボ角度をNVSに保存し、起動時に読み込む。
+ * 保存値がない・不正な場合は既定の角度を使用する。
+ * 実機で確認済みの項目（フラグ）も角度と一緒に保存する
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#include "BayConfig.h"
+
+class ServoCalibration {
+ public:
+  typedef enum eServoAngle {
+    /** ドローンを離すときの捕獲サーボ角度 */
+    ANGLE_DRONE_RELEASE,
+    /** ドローンを捕まえるときの捕獲サーボ角度 */
+    ANGLE_DRONE_CATCH,
+    /** ドローンを位置決めで捕まえるときの捕獲サーボ角度 */
+    ANGLE_DRONE_CATCH_ONCE,
+    /** USBを離すときのUSBサーボ角度 */
+    ANGLE_USB_OFF,
+    /** USBアームが捕獲アームに干渉しないUSBサーボ角度 */
+    ANGLE_USB_CLEAR,
+    /** USBを接触させるときのUSBサーボ角度 */
+    ANGLE_USB_ON,
+    ANGLE_TYPE_NUM,
+  } ServoAngleType;
+
+  typedef enum eCalibrationFlag {
+    /** 高速な速度・加速度の制限で動かしてよい（実機で確認済み） */
+    FLAG_FAST_MOTION = 0x01,
+    /** ANGLE_USB_CLEARを実機で教示済み（両アームの動作を重ねてよい） */
+    FLAG_USB_CLEAR = 0x02,
+  } CalibrationFlagType;
+
+  ServoCalibration(const BayConfig &);
+  ~ServoCalibration();
+  bool load(void);
+  bool save(void);
+  void reset(void);
+  bool isLoaded(void);
+  float getAngle(ServoAngleType);
+  bool setAngle(ServoAngleType, float);
+  bool hasFlag(CalibrationFlagType);
+  void setFlag(CalibrationFlagType, bool);
+  String toString(void);
+  static bool isNear(float, float);
+  static const char *getName(ServoAngleType);
+  static const char *getFlagName(CalibrationFlagType);
+
+  static const float ANGLE_TOLERANCE;
+
+ private:
+  static bool _isValid(const float *);
+
+  /** 角度テーブル[deg] */
+  float _angles[ANGLE_TYPE_NUM];
+  /** 実機で確認済みの項目（CalibrationFlagTypeの論理和） */
+  uint8_t _flags;
+  /** NVSの保存値を使用しているかどうか */
+  bool _isLoaded;
+  /** 角度テーブルの保存先（NAMESPACEにベイ番号を付けたもの） */
+  String _namespace;
+
+  static const float DEFAULT_ANGLES[ANGLE_TYPE_NUM];
+  static const float MIN_ANGLE;
+  static const float MAX_ANGLE;
+  static const char *NAMESPACE;
+  static const char *KEY_VERSION;
+  static const char *KEY_ANGLES;
+  static const char *KEY_FLAGS;
+  static const uint8_t VERSION;
+};
@@ -4,36 +4,52 @@
  * @author Tatsuya Miyazaki
  * @date 2023/5/5
  *
- * @details サーボモータを管理するクラス
+ * @details サーボモータを管理するクラス。
+ * 各動作の角度はServoCalibrationの角度テーブル（NVSに保存）から取得し、
+ * 到達判定は許容誤差付きで行う
  */
 
 #include "ServoController.h"
 
-/** ドローンを離すときのサーボ角度[deg] */
-const int16_t ServoController::DRONE_RELEASE_ANGLE = -45;
-/** ドローンを捕まえるときのサーボ角度[deg] */
-const int16_t ServoController::DRONE_CATCH_ANGLE = 8;
-/** ドローンを位置決めで捕まえるときのサーボ角度[deg] */
-const int16_t ServoController::DRONE_CATCH_ANGLE_ONCE = 14;
-/** USBを離すときのサーボ角度[deg] */
-const int16_t ServoController::USB_OFF_ANGLE = -56;
-/** USBを接触させるときのサーボ角度[deg] */
-const int16_t ServoController::USB_ON_ANGLE = 52;
-/** 捕獲サーボの速度[deg/s] */
+/** 捕獲アームの到達とUSBアームの干渉領域への進入の間に確保する余裕[sec] */
+const float ServoController::OVERLAP_MARGIN = 0.1;
+/** 捕獲サーボの最大速度[deg/s] */
 const float ServoController::SERVO_CATCH_VEL = 60;
-/** USBサーボの速度[deg/s] */
+/** 捕獲サーボの最大加速度[deg/s^2]（0: 加減速なしの等速移動） */
+const float ServoController::SERVO_CATCH_ACC = 0;
+/** USBサーボの最大速度[deg/s] */
 const float ServoController::SERVO_USB_VEL = 150;
+/** USBサーボの最大加速度[deg/s^2]（0: 加減速なしの等速移動） */
+const float ServoController::SERVO_USB_ACC = 0;
+/** 高速設定の捕獲サーボの最大速度[deg/s]（実機で確認してから使う） */
+const float ServoController::FAST_CATCH_VEL = 120;
+/** 高速設定の捕獲サーボの最大加速度[deg/s^2] */
+const float ServoController::FAST_CATCH_ACC = 480;
+/** 高速設定のUSBサーボの最大速度[deg/s] */
+const float ServoController::FAST_USB_VEL = 300;
+/** 高速設定のUSBサーボの最大加速度[deg/s^2] */
+const float ServoController::FAST_USB_ACC = 1200;
 
 /**
  * @brief Construct a new Servo Controller:: Servo Controller object
  *
- * @param catchPin 捕獲サーボの制御PIN
- * @param usbPin USBサーボの制御PIN
+ * @details 高速設定が実機で確認済み（角度テーブルのフラグ）なら高速設定で動かす
+ *
+ * @param bay 充電ベイの構成（制御PIN・PWMチャンネル）
  */
-ServoController::ServoController(uint8_t catchPin, uint8_t usbPin)
-    : _servoCatch(
-          ServoESP32(0, catchPin, DRONE_RELEASE_ANGLE, SERVO_CATCH_VEL)),
-      _servoUsb(ServoESP32(2, usbPin, USB_OFF_ANGLE, SERVO_USB_VEL)) {}
+ServoController::ServoController(const BayConfig &bay)
+    : _calibration(bay),
+      _servoCatch(bay.servoCatchChannel, bay.servoCatchPin,
+                  _angle(ServoCalibration::ANGLE_DRONE_RELEASE),
+                  SERVO_CATCH_VEL, SERVO_CATCH_ACC),
+      _servoUsb(bay.servoUsbChannel, bay.servoUsbPin,
+                _angle(ServoCalibration::ANGLE_USB_OFF), SERVO_USB_VEL,
+                SERVO_USB_ACC),
+      _moveType(MOVE_NONE),
+      _moveId(0),
+      _moveStartTime(0) {
+  resetLimits();
+}
 
 /**
  * @brief Destroy the Servo Controller:: Servo Controller object
@@ -56,6 +72,7 @@ float ServoController::getServoCatch(void) {
  * @param angle 捕獲サーボの角度
  */
 void ServoController::setServoCatch(float angle) {
+  _startMove(MOVE_NONE);
   _servoCatch.setTargetAngle(angle);
 }
 
@@ -72,6 +89,7 @@ float ServoController::getServoUsb(void) { return _servoUsb.getTargetAngle(); }
  * @param angle USBサーボの角度
  */
 void ServoController::setServoUsb(float angle) {
+  _startMove(MOVE_NONE);
   _servoUsb.setTargetAngle(angle);
 }
 
@@ -80,7 +98,7 @@ void ServoController::setServoUsb(float angle) {
  *
  */
 void ServoController::catchDrone(void) {
-  _servoCatch.setTargetAngle(DRONE_CATCH_ANGLE);
+  _moveTo(_servoCatch, ServoCalibration::ANGLE_DRONE_CATCH, MOVE_CATCH);
 }
 
 /**
@@ -88,7 +106,8 @@ void ServoController::catchDrone(void) {
  *
  */
 void ServoController::catchDroneOnce(void) {
-  _servoCatch.setTargetAngle(DRONE_CATCH_ANGLE_ONCE);
+  _moveTo(_servoCatch, ServoCalibration::ANGLE_DRONE_CATCH_ONCE,
+          MOVE_CATCH_ONCE);
 }
 
 /**
@@ -96,7 +115,7 @@ void ServoController::catchDroneOnce(void) {
  *
  */
 void ServoController::releaseDrone(void) {
-  _servoCatch.setTargetAngle(DRONE_RELEASE_ANGLE);
+  _moveTo(_servoCatch, ServoCalibration::ANGLE_DRONE_RELEASE, MOVE_RELEASE);
 }
 
 /**
@@ -104,7 +123,7 @@ void ServoController::releaseDrone(void) {
  *
  */
 void ServoController::connectUsb(void) {
-  _servoUsb.setTargetAngle(USB_ON_ANGLE);
+  _moveTo(_servoUsb, ServoCalibration::ANGLE_USB_ON, MOVE_USB_ON);
 }
 
 /**
@@ -112,7 +131,17 @@ void ServoController::connectUsb(void) {
  *
  */
 void ServoController::disconnectUsb(void) {
-  _servoUsb.setTargetAngle(USB_OFF_ANGLE);
+  _moveTo(_servoUsb, ServoCalibration::ANGLE_USB_OFF, MOVE_USB_OFF);
+}
+
+/**
+ * @brief 両方のサーボを現在の指示角度で止める
+ *
+ * @details 中断した動作の種類（getMoveType()）はそのまま残す
+ */
+void ServoController::hold(void) {
+  _servoCatch.hold();
+  _servoUsb.hold();
 }
 
 /**
@@ -122,8 +151,8 @@ void ServoController::disconnectUsb(void) {
  * @return false
  */
 bool ServoController::isCatchDrone(void) {
-  return (_servoCatch.getPresentAngle() == (float)(DRONE_CATCH_ANGLE) ||
-          _servoCatch.getPresentAngle() == (float)(DRONE_CATCH_ANGLE_ONCE));
+  return _isNear(_servoCatch, ServoCalibration::ANGLE_DRONE_CATCH) ||
+         _isNear(_servoCatch, ServoCalibration::ANGLE_DRONE_CATCH_ONCE);
 }
 
 /**
@@ -133,7 +162,7 @@ bool ServoController::isCatchDrone(void) {
  * @return false
  */
 bool ServoController::isReleaseDrone(void) {
-  return _servoCatch.getPresentAngle() == (float)(DRONE_RELEASE_ANGLE);
+  return _isNear(_servoCatch, ServoCalibration::ANGLE_DRONE_RELEASE);
 }
 
 /**
@@ -143,7 +172,7 @@ bool ServoController::isReleaseDrone(void) {
  * @return false
  */
 bool ServoController::isConnectUsb(void) {
-  return _servoUsb.getPresentAngle() == (float)(USB_ON_ANGLE);
+  return _isNear(_servoUsb, ServoCalibration::ANGLE_USB_ON);
 }
 
 /**
@@ -153,7 +182,7 @@ bool ServoController::isConnectUsb(void) {
  * @return false
  */
 bool ServoController::isDisconnectUsb(void) {
-  return _servoUsb.getPresentAngle() == (float)(USB_OFF_ANGLE);
+  return _isNear(_servoUsb, ServoCalibration::ANGLE_USB_OFF);
 }
 
 /**
@@ -166,9 +195,122 @@ bool ServoController::isTargetAngle(void) {
   return _servoCatch.isTargetAngle() && _servoUsb.isTargetAngle();
 }
 
+/**
+ * @brief USBアームが干渉領域の外にあるかどうか
+ *
+ * @details USBアームが干渉領域の外にあり、かつ領域内へ向かっていなければ、
+ * 捕獲アームを動かしてよい。
+ * 干渉しない角度を実機で教示するまでは、USBを切断し終えるまで待つ
+ *
+ * @return true
+ * @return false
+ */
+bool ServoController::isUsbClear(void) {
+  if (!_calibration.hasFlag(ServoCalibration::FLAG_USB_CLEAR)) {
+    return isDisconnectUsb();
+  }
+  float clearAngle = _angle(ServoCalibration::ANGLE_USB_CLEAR);
+  return _servoUsb.getPresentAngle() <= clearAngle &&
+         _servoUsb.getTargetAngle() <= clearAngle;
+}
+
+/**
+ * @brief USBアームを接続方向に動かし始めてよいかどうか
+ *
+ * @details 捕獲アームが捕獲位置へ移動中でも、USBアームが干渉領域に入る前に
+ * 捕獲アームが到達するのであれば動かし始めてよい
+ *
+ * @return true
+ * @return false
+ */
+bool ServoController::canConnectUsb(void) {
+  return getConnectUsbDelay() == 0;
+}
+
+/**
+ * @brief USBアームを接続方向に動かし始めてよくなるまでの時間を取得する
+ *
+ * @details 捕獲アームの残り移動時間と、USBアームが干渉領域に入るまでの時間から
+ * 求める。捕獲アームが捕獲位置に向かっていない、または干渉しない角度を
+ * 実機で教示していなければ負の値を返す（捕獲アームの到達を待つ）
+ *
+ * @return int32_t 待ち時間[ms]（0: すぐに動かしてよい、負: 判定できない）
+ */
+int32_t ServoController::getConnectUsbDelay(void) {
+  if (!_calibration.hasFlag(ServoCalibration::FLAG_USB_CLEAR)) return -1;
+  float target = _servoCatch.getTargetAngle();
+  if (!ServoCalibration::isNear(
+          target, _angle(ServoCalibration::ANGLE_DRONE_CATCH)) &&
+      !ServoCalibration::isNear(
+          target, _angle(ServoCalibration::ANGLE_DRONE_CATCH_ONCE))) {
+    return -1;
+  }
+  float delay =
+      _servoCatch.getRemainingTime() + OVERLAP_MARGIN -
+      _servoUsb.getTimeToReach(_angle(ServoCalibration::ANGLE_USB_ON),
+                               _angle(ServoCalibration::ANGLE_USB_CLEAR));
+  if (delay <= 0) return 0;
+  // 切り上げて、待ち時間の経過後には必ず動かしてよい状態にする
+  return (int32_t)ceil(delay * 1000);
+}
+
+/**
+ * @brief サーボの速度・加速度の制限を既定値に戻す
+ *
+ * @details 角度テーブルで高速設定が確認済みなら高速設定、
+ * そうでなければ従来の等速移動の制限にする
+ */
+void ServoController::resetLimits(void) {
+  if (_calibration.hasFlag(ServoCalibration::FLAG_FAST_MOTION)) {
+    _servoCatch.setLimits(FAST_CATCH_VEL, FAST_CATCH_ACC);
+    _servoUsb.setLimits(FAST_USB_VEL, FAST_USB_ACC);
+  } else {
+    _servoCatch.setLimits(SERVO_CATCH_VEL, SERVO_CATCH_ACC);
+    _servoUsb.setLimits(SERVO_USB_VEL, SERVO_USB_ACC);
+  }
+}
+
+/**
+ * @brief 最後に開始した動作の種類を取得する
+ *
+ * @return ServoMoveType 動作の種類
+ */
+ServoController::ServoMoveType ServoController::getMoveType(void) {
+  return _moveType;
+}
+
+/**
+ * @brief 動作の番号を取得する
+ *
+ * @details 動作を開始するたびに変わるため、新しい動作の検知に使う
+ *
+ * @return uint32_t 動作の番号
+ */
+uint32_t ServoController::getMoveId(void) { return _moveId; }
+
+/**
+ * @brief 最後に動作を開始した時刻を取得する
+ *
+ * @return uint32_t 時刻[ms]
+ */
+uint32_t ServoController::getMoveStartTime(void) { return _moveStartTime; }
+
 /**
  * @brief WASDでサーボの角度を微調整する
  *
+ * @details w/s: USBサーボ、a/d: 捕獲サーボを1degずつ動かす。
+ * 調整した角度は以下のキーで角度テーブルに登録し、pでNVSに保存する
+ * - 1: ドローンを離す角度（捕獲サーボ）
+ * - 2: ドローンを捕まえる角度（捕獲サーボ）
+ * - 3: ドローンを位置決めで捕まえる角度（捕獲サーボ）
+ * - 4: USBを離す角度（USBサーボ）
+ * - 5: USBアームが干渉しない角度（USBサーボ。登録すると両アームの動作を重ねる）
+ * - 6: USBを接触させる角度（USBサーボ）
+ * - f: 高速設定の使用を切り替える（実機で動作を確認してからpで保存する）
+ * - p: 角度テーブルをNVSに保存する
+ * - l: 角度テーブルをNVSから読み込み直す
+ * - x: 角度テーブルを既定値に戻す（NVSは変更しない）
+ *
  * @param input キーボード入力
  */
 void ServoController::wasdControl(char input) {
@@ -185,6 +327,43 @@ void ServoController::wasdControl(char input) {
     case 'd':
       setServoCatch(getServoCatch() + 1);
       break;
+    case '1':
+      _teachAngle(ServoCalibration::ANGLE_DRONE_RELEASE);
+      break;
+    case '2':
+      _teachAngle(ServoCalibration::ANGLE_DRONE_CATCH);
+      break;
+    case '3':
+      _teachAngle(ServoCalibration::ANGLE_DRONE_CATCH_ONCE);
+      break;
+    case '4':
+      _teachAngle(ServoCalibration::ANGLE_USB_OFF);
+      break;
+    case '5':
+      _teachAngle(ServoCalibration::ANGLE_USB_CLEAR);
+      break;
+    case '6':
+      _teachAngle(ServoCalibration::ANGLE_USB_ON);
+      break;
+    case 'f':
+      _calibration.setFlag(
+          ServoCalibration::FLAG_FAST_MOTION,
+          !_calibration.hasFlag(ServoCalibration::FLAG_FAST_MOTION));
+      resetLimits();
+      logger.info("ServoController: " + _calibration.toString() +
+                  " (press p to save)");
+      break;
+    case 'p':
+      _calibration.save();
+      break;
+    case 'l':
+      _calibration.load();
+      resetLimits();
+      break;
+    case 'x':
+      _calibration.reset();
+      resetLimits();
+      break;
     default:
       break;
   }
@@ -200,6 +379,81 @@ void ServoController::loop(void) {
   _servoUsb.loop();
 }
 
+/**
+ * @brief 角度テーブルの角度を取得する
+ *
+ * @param type 角度の種類
+ * @return float 角度[deg]
+ */
+float ServoController::_angle(ServoCalibration::ServoAngleType type) {
+  return _calibration.getAngle(type);
+}
+
+/**
+ * @brief サーボが角度テーブルの角度で止まっているかどうか
+ *
+ * @details 動作を開始した直後は現在角度が許容誤差以内に残っているため、
+ * 移動中は到達していないものとする（動作の二重開始を防ぐ）
+ *
+ * @param servo サーボ
+ * @param type 角度の種類
+ * @return true 停止中かつ許容誤差以内
+ * @return false
+ */
+bool ServoController::_isNear(ServoAxis &servo,
+                              ServoCalibration::ServoAngleType type) {
+  return servo.isTargetAngle() &&
+         ServoCalibration::isNear(servo.getPresentAngle(), _angle(type));
+}
+
+/**
+ * @brief 角度テーブルの角度へサーボを動かす
+ *
+ * @details 指示角度が変わる場合のみ動作の開始として記録する
+ *
+ * @param servo サーボ
+ * @param type 角度の種類
+ * @param move 動作の種類
+ */
+void ServoController::_moveTo(ServoAxis &servo,
+                              ServoCalibration::ServoAngleType type,
+                              ServoMoveType move) {
+  float angle = _angle(type);
+  if (!ServoCalibration::isNear(servo.getTargetAngle(), angle)) {
+    _startMove(move);
+  }
+  servo.setTargetAngle(angle);
+}
+
+/**
+ * @brief 動作の開始を記録する
+ *
+ * @param move 動作の種類
+ */
+void ServoController::_startMove(ServoMoveType move) {
+  _moveType = move;
+  _moveId++;
+  _moveStartTime = millis();
+}
+
+/**
+ * @brief 現在の指示角度を角度テーブルに登録する
+ *
+ * @param type 角度の種類
+ */
+void ServoController::_teachAngle(ServoCalibration::ServoAngleType type) {
+  bool isCatch = type <= ServoCalibration::ANGLE_DRONE_CATCH_ONCE;
+  float angle = isCatch ? getServoCatch() : getServoUsb();
+  if (_calibration.setAngle(type, angle)) {
+    if (type == ServoCalibration::ANGLE_USB_CLEAR) {
+      // 実機で干渉しないことを確かめた角度なので、動作を重ねてよい
+      _calibration.setFlag(ServoCalibration::FLAG_USB_CLEAR, true);
+    }
+    logger.info("ServoController: " + String(ServoCalibration::getName(type)) +
+                " = " + String(angle) + " (press p to save)");
+  }
+}
+
 /**
  * @brief サーボ角度の文字列を取得する
  *
@@ -4,21 +4,42 @@
  * @author Tatsuya Miyazaki
  * @date 2023/5/5
  *
- * @details サーボモータを管理するクラス
+ * @details サーボモータを管理するクラス。
+ * 各動作の角度はServoCalibrationの角度テーブル（NVSに保存）から取得し、
+ * 到達判定は許容誤差付きで行う
  */
 
 #pragma once
 #include <Arduino.h>
-#include <ServoESP32.h>
 
+#include "BayConfig.h"
 #include "Log.h"
+#include "ServoAxis.h"
+#include "ServoCalibration.h"
 
 class ServoController {
  public:
-  ServoController(uint8_t, uint8_t);
+  typedef enum eServoMove {
+    /** 動作なし・手動操作 */
+    MOVE_NONE,
+    /** ドローンを捕獲する */
+    MOVE_CATCH,
+    /** ドローンを位置決め捕獲する */
+    MOVE_CATCH_ONCE,
+    /** ドローンをリリースする */
+    MOVE_RELEASE,
+    /** USBを接続する */
+    MOVE_USB_ON,
+    /** USBを切断する */
+    MOVE_USB_OFF,
+    MOVE_TYPE_NUM,
+  } ServoMoveType;
+
+  ServoController(const BayConfig &);
   ~ServoController();
-  ServoESP32 *servoCatch(void) { return &_servoCatch; }
-  ServoESP32 *servoUsb(void) { return &_servoUsb; }
+  ServoAxis *servoCatch(void) { return &_servoCatch; }
+  ServoAxis *servoUsb(void) { return &_servoUsb; }
+  ServoCalibration *calibration(void) { return &_calibration; }
   float getServoCatch(void);
   void setServoCatch(float);
   float getServoUsb(void);
@@ -28,26 +49,50 @@ class ServoController {
   void releaseDrone(void);
   void connectUsb(void);
   void disconnectUsb(void);
+  void hold(void);
   bool isCatchDrone(void);
   bool isReleaseDrone(void);
   bool isConnectUsb(void);
   bool isDisconnectUsb(void);
   bool isTargetAngle(void);
+  bool isUsbClear(void);
+  bool canConnectUsb(void);
+  int32_t getConnectUsbDelay(void);
+  void resetLimits(void);
+  ServoMoveType getMoveType(void);
+  uint32_t getMoveId(void);
+  uint32_t getMoveStartTime(void);
   void wasdControl(char);
   void loop(void);
   String toString(void);
 
  private:
+  float _angle(ServoCalibration::ServoAngleType);
+  bool _isNear(ServoAxis &, ServoCalibration::ServoAngleType);
+  void _teachAngle(ServoCalibration::ServoAngleType);
+  void _moveTo(ServoAxis &, ServoCalibration::ServoAngleType, ServoMoveType);
+  void _startMove(ServoMoveType);
+
+  /** 角度テーブル（サーボの初期角度に使うため先に初期化する） */
+  ServoCalibration _calibration;
   /** ドローン捕獲サーボ */
-  ServoESP32 _servoCatch;
+  ServoAxis _servoCatch;
   /** USBを動かすサーボ */
-  ServoESP32 _servoUsb;
+  ServoAxis _servoUsb;
+  /** 最後に開始した動作の種類 */
+  ServoMoveType _moveType;
+  /** 動作を開始するたびに更新する番号 */
+  uint32_t _moveId;
+  /** 最後に動作を開始した時刻[ms] */
+  uint32_t _moveStartTime;
 
-  static const int16_t DRONE_RELEASE_ANGLE;
-  static const int16_t DRONE_CATCH_ANGLE;
-  static const int16_t DRONE_CATCH_ANGLE_ONCE;
-  static const int16_t USB_OFF_ANGLE;
-  static const int16_t USB_ON_ANGLE;
+  static const float OVERLAP_MARGIN;
   static const float SERVO_CATCH_VEL;
+  static const float SERVO_CATCH_ACC;
   static const float SERVO_USB_VEL;
+  static const float SERVO_USB_ACC;
+  static const float FAST_CATCH_VEL;
+  static const float FAST_CATCH_ACC;
+  static const float FAST_USB_VEL;
+  static const float FAST_USB_ACC;
 };
@@ -0,0 +1,423 @@
+/**
+ * @file ServoStallDetector.cpp
+ * @brief サーボ電流波形によるストール検知クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 動作の種類ごとに、動作開始からの経過時間に対するサーボ電流の
+ * 正常範囲（平均と分散）を学習し、範囲を連続して上回ればストールと判定する。
+ * 記録を終えた動作は、呼び出し側が正常に終わったと確定（commitMove()）して
+ * から学習する。サーボ電流が流れていた時間が学習値より長すぎる動作は
+ * 学習しない（判定を始める前の異常な動作で正常範囲が広がるのを防ぐ）。
+ * 学習済みの正常範囲はNVSに保存し、起動時に読み込む
+ */
+
+#include "ServoStallDetector.h"
+
+#include <Log.h>
+#include <Preferences.h>
+
+#include "CheckServoCurrent.h"
+
+/** 時間区間の長さ[ms]（BIN_TIME * BIN_NUM が動作を監視する時間） */
+const uint32_t ServoStallDetector::BIN_TIME = 50;
+/** 判定に使うために必要な学習回数 */
+const uint16_t ServoStallDetector::MIN_LEARN_COUNT = 10;
+/** 学習の重み付けに使う回数（これより古い動作の影響は指数的に減衰する） */
+const uint16_t ServoStallDetector::LEARN_WINDOW = 50;
+/** 学習が済んだ後にNVSに保存する間隔[回] */
+const uint16_t ServoStallDetector::SAVE_INTERVAL = 20;
+/** 正常範囲とみなす標準偏差の倍率 */
+const float ServoStallDetector::SIGMA_FACTOR = 4.0;
+/** 正常範囲の平均値からの最小の余裕[mA]（ノイズによる誤検知を防ぐ） */
+const float ServoStallDetector::MIN_MARGIN = 100.0;
+/** ストールと判定する連続超過回数 */
+const uint8_t ServoStallDetector::STALL_COUNT = 3;
+/** 動作時間の外れ値判定に使うために必要な学習回数 */
+const uint16_t ServoStallDetector::MIN_DURATION_COUNT = 3;
+/** 動作時間の平均値からの最小の余裕[ms]（時間区間の分解能による揺れを許容） */
+const float ServoStallDetector::MIN_DURATION_MARGIN = 200.0;
+/** 学習した正常範囲を保存する名前空間の基本名 */
+const char *ServoStallDetector::NAMESPACE = "stall";
+/** NVSのキー（保存形式のバージョン） */
+const char *ServoStallDetector::KEY_VERSION = "version";
+/** 保存形式のバージョン（時間区間の構成を変えたら上げる） */
+const uint8_t ServoStallDetector::VERSION = 1;
+
+/**
+ * @brief Construct a new Servo Stall Detector:: Servo Stall Detector object
+ *
+ * @details 学習前の状態から始め、このベイで学習済みの正常範囲があれば
+ * 読み込んで判定に使う（NVSを読むため生成時期に注意。
+ * BayConfig::getNamespace()参照）
+ *
+ * @param bay 充電ベイの構成
+ */
+ServoStallDetector::ServoStallDetector(const BayConfig &bay)
+    : _moveType(ServoController::MOVE_NONE),
+      _moveStartTime(0),
+      _recordedBins(0),
+      _isStalled(false),
+      _pendingType(ServoController::MOVE_NONE),
+      _pendingBins(0),
+      _overCount(0),
+      _namespace(bay.getNamespace(NAMESPACE)) {
+  _clear();
+  load();
+}
+
+/**
+ * @brief Destroy the Servo Stall Detector:: Servo Stall Detector object
+ *
+ */
+ServoStallDetector::~ServoStallDetector() {}
+
+/**
+ * @brief 動作の記録を開始する
+ *
+ * @details 記録中の動作は、この動作の開始までに経過した区間を確定待ちにする
+ *
+ * @param type 動作の種類
+ * @param startTime 動作の開始時刻[ms]
+ */
+void ServoStallDetector::startMove(ServoController::ServoMoveType type,
+                                   uint32_t startTime) {
+  finishMove(startTime);
+  _moveType = type;
+  _moveStartTime = startTime;
+  _recordedBins = 0;
+  _isStalled = false;
+  _overCount = 0;
+}
+
+/**
+ * @brief サーボ電流を記録し、ストールしているかどうかを判定する
+ *
+ * @param now 現在時刻[ms]
+ * @param current サーボ電流[mA]
+ * @return true ストールを検知した（動作ごとに1回のみ）
+ * @return false
+ */
+bool ServoStallDetector::update(uint32_t now, float current) {
+  if (_moveType == ServoController::MOVE_NONE || _isStalled) return false;
+  uint32_t elapsed = now - _moveStartTime;
+  if (elapsed >= BIN_TIME * BIN_NUM) {
+    // 監視時間が過ぎれば記録を終了する
+    finishMove(now);
+    return false;
+  }
+  uint8_t bin = _getBin(elapsed);
+  while (_recordedBins <= bin) {
+    _record[_recordedBins++] = current;
+  }
+  if (current > _record[bin]) _record[bin] = current;
+
+  const EnvelopeBin &envelope = _envelope[_moveType][bin];
+  if (envelope.count < MIN_LEARN_COUNT) {
+    _overCount = 0;
+    return false;
+  }
+  if (current > getThreshold(_moveType, elapsed)) {
+    _overCount++;
+  } else {
+    _overCount = 0;
+  }
+  if (_overCount < STALL_COUNT) return false;
+  _isStalled = true;
+  return true;
+}
+
+/**
+ * @brief 動作の記録を終了する
+ *
+ * @details ストールを検知しなかった動作は、経過しきった時間区間を確定待ちに
+ * する（前の確定待ちの動作は学習せずに破棄する）。
+ * 次の動作で打ち切られた区間（経過しきっていない区間）は学習しない
+ *
+ * @param now 現在時刻[ms]
+ */
+void ServoStallDetector::finishMove(uint32_t now) {
+  if (_moveType != ServoController::MOVE_NONE && !_isStalled) {
+    uint32_t completedBins = (now - _moveStartTime) / BIN_TIME;
+    _pendingType = _moveType;
+    _pendingBins =
+        completedBins < _recordedBins ? completedBins : _recordedBins;
+    memcpy(_pending, _record, sizeof(_pending));
+  }
+  abortMove();
+}
+
+/**
+ * @brief 確定待ちの動作を正常に終わったものとして学習する
+ *
+ * @details 過電流のタイムアウトや非常停止に至らなかったことを呼び出し側が
+ * 確認してから呼ぶ。動作時間が学習値から外れていれば学習しない
+ */
+void ServoStallDetector::commitMove(void) {
+  if (_pendingType == ServoController::MOVE_NONE) return;
+  if (_pendingBins > 0) {
+    uint32_t duration = _getDuration();
+    if (_isDurationNormal(duration)) {
+      _learn();
+    } else {
+      logger.warn("ServoStallDetector: Skipped learning. type = " +
+                  String(_pendingType) +
+                  ", duration = " + String(duration));
+    }
+  }
+  _pendingType = ServoController::MOVE_NONE;
+  _pendingBins = 0;
+}
+
+/**
+ * @brief 動作の記録を学習せずに破棄する
+ *
+ * @details 充電中などサーボ以外の電流が含まれる場合に使う
+ */
+void ServoStallDetector::abortMove(void) {
+  _moveType = ServoController::MOVE_NONE;
+  _recordedBins = 0;
+  _overCount = 0;
+}
+
+/**
+ * @brief 記録中と確定待ちの動作を学習せずに破棄する
+ *
+ * @details 過電流のタイムアウト、ストール、非常停止のときに使う
+ */
+void ServoStallDetector::rejectMove(void) {
+  abortMove();
+  _pendingType = ServoController::MOVE_NONE;
+  _pendingBins = 0;
+}
+
+/**
+ * @brief 動作の種類が学習済みかどうか
+ *
+ * @param type 動作の種類
+ * @return true 学習済み
+ * @return false 学習中（ストール判定を行わない）
+ */
+bool ServoStallDetector::isLearned(ServoController::ServoMoveType type) {
+  return getLearnedCount(type) >= MIN_LEARN_COUNT;
+}
+
+/**
+ * @brief 動作の種類ごとの学習回数を取得する
+ *
+ * @param type 動作の種類
+ * @return uint16_t 学習回数
+ */
+uint16_t ServoStallDetector::getLearnedCount(
+    ServoController::ServoMoveType type) {
+  if (type >= ServoController::MOVE_TYPE_NUM) return 0;
+  return _learnedCount[type];
+}
+
+/**
+ * @brief ストールと判定する電流のしきい値を取得する
+ *
+ * @param type 動作の種類
+ * @param elapsed 動作開始からの経過時間[ms]
+ * @return float しきい値[mA]
+ */
+float ServoStallDetector::getThreshold(ServoController::ServoMoveType type,
+                                       uint32_t elapsed) {
+  if (type >= ServoController::MOVE_TYPE_NUM) return 0;
+  const EnvelopeBin &envelope = _envelope[type][_getBin(elapsed)];
+  float margin = SIGMA_FACTOR * sqrtf(envelope.var);
+  if (margin < MIN_MARGIN) margin = MIN_MARGIN;
+  return envelope.mean + margin;
+}
+
+/**
+ * @brief NVSから学習済みの正常範囲を読み込む
+ *
+ * @return true 読み込み成功
+ * @return false 保存値がない、または保存形式が異なる
+ */
+bool ServoStallDetector::load(void) {
+  Preferences prefs;
+  if (!prefs.begin(_namespace.c_str(), true)) return false;
+  if (prefs.getUChar(KEY_VERSION, 0) != VERSION) {
+    prefs.end();
+    return false;
+  }
+  for (uint8_t type = ServoController::MOVE_NONE + 1;
+       type < ServoController::MOVE_TYPE_NUM; type++) {
+    String key = _getKey((ServoController::ServoMoveType)type);
+    if (prefs.getBytesLength(key.c_str()) != sizeof(_envelope[type])) {
+      continue;
+    }
+    prefs.getBytes(key.c_str(), _envelope[type], sizeof(_envelope[type]));
+    uint16_t count = 0;
+    for (uint8_t bin = 0; bin < BIN_NUM; bin++) {
+      if (_envelope[type][bin].count > count) {
+        count = _envelope[type][bin].count;
+      }
+    }
+    _learnedCount[type] = count;
+    key = _getDurationKey((ServoController::ServoMoveType)type);
+    if (prefs.getBytesLength(key.c_str()) == sizeof(_duration[type])) {
+      prefs.getBytes(key.c_str(), &_duration[type], sizeof(_duration[type]));
+    }
+    logger.info("ServoStallDetector.load(): type = " + String(type) +
+                ", count = " + String(count));
+  }
+  prefs.end();
+  return true;
+}
+
+/**
+ * @brief 動作の種類の正常範囲をNVSに保存する
+ *
+ * @param type 動作の種類
+ * @return true 保存成功
+ * @return false 保存失敗
+ */
+bool ServoStallDetector::save(ServoController::ServoMoveType type) {
+  if (type == ServoController::MOVE_NONE ||
+      type >= ServoController::MOVE_TYPE_NUM) {
+    return false;
+  }
+  Preferences prefs;
+  if (!prefs.begin(_namespace.c_str(), false)) return false;
+  String key = _getKey(type);
+  String durationKey = _getDurationKey(type);
+  bool isWritten =
+      prefs.putBytes(key.c_str(), _envelope[type], sizeof(_envelope[type])) ==
+          sizeof(_envelope[type]) &&
+      prefs.putBytes(durationKey.c_str(), &_duration[type],
+                     sizeof(_duration[type])) == sizeof(_duration[type]) &&
+      prefs.putUChar(KEY_VERSION, VERSION) == sizeof(uint8_t);
+  prefs.end();
+  if (!isWritten) {
+    logger.error("ServoStallDetector.save(): Failed to write NVS");
+  }
+  return isWritten;
+}
+
+/**
+ * @brief 学習した正常範囲を消去する（NVSの保存値も消去する）
+ *
+ */
+void ServoStallDetector::reset(void) {
+  _clear();
+  Preferences prefs;
+  if (prefs.begin(_namespace.c_str(), false)) {
+    prefs.clear();
+    prefs.end();
+  }
+  logger.info("ServoStallDetector.reset(): Cleared learned envelopes");
+}
+
+/**
+ * @brief 学習した正常範囲と記録中・確定待ちの動作を消去する
+ *
+ */
+void ServoStallDetector::_clear(void) {
+  memset(_envelope, 0, sizeof(_envelope));
+  memset(_learnedCount, 0, sizeof(_learnedCount));
+  memset(_duration, 0, sizeof(_duration));
+  rejectMove();
+}
+
+/**
+ * @brief 経過時間から時間区間を取得する
+ *
+ * @param elapsed 動作開始からの経過時間[ms]
+ * @return uint8_t 時間区間
+ */
+uint8_t ServoStallDetector::_getBin(uint32_t elapsed) {
+  uint32_t bin = elapsed / BIN_TIME;
+  return bin < BIN_NUM ? bin : BIN_NUM - 1;
+}
+
+/**
+ * @brief 確定待ちの動作でサーボ電流が流れていた時間を取得する
+ *
+ * @details 最後にサーボ電流が稼働中のしきい値以上だった時間区間までの時間。
+ * 記録の最後まで流れていれば記録した時間全体になる
+ *
+ * @return uint32_t 動作時間[ms]
+ */
+uint32_t ServoStallDetector::_getDuration(void) {
+  uint8_t bins = _pendingBins;
+  while (bins > 0 && !CheckServoCurrent::isServoMoving(_pending[bins - 1])) {
+    bins--;
+  }
+  return bins * BIN_TIME;
+}
+
+/**
+ * @brief 動作時間が学習値の範囲内かどうか
+ *
+ * @details 次の動作で打ち切られると短くなるため、長い側のみ判定する。
+ * 学習回数がMIN_DURATION_COUNTに満たない間は判定しない
+ *
+ * @param duration 動作時間[ms]
+ * @return true 範囲内
+ * @return false 学習値より長すぎる
+ */
+bool ServoStallDetector::_isDurationNormal(uint32_t duration) {
+  const DurationStats &stats = _duration[_pendingType];
+  if (stats.count < MIN_DURATION_COUNT) return true;
+  float margin = SIGMA_FACTOR * sqrtf(stats.var);
+  if (margin < MIN_DURATION_MARGIN) margin = MIN_DURATION_MARGIN;
+  return duration <= stats.mean + margin;
+}
+
+/**
+ * @brief 確定待ちの動作の電流と動作時間で正常範囲を更新する
+ *
+ * @details 平均・分散は学習回数がLEARN_WINDOWに達した後は指数移動平均で更新する
+ */
+void ServoStallDetector::_learn(void) {
+  for (uint8_t bin = 0; bin < _pendingBins; bin++) {
+    EnvelopeBin &envelope = _envelope[_pendingType][bin];
+    if (envelope.count < LEARN_WINDOW) envelope.count++;
+    float x = _pending[bin];
+    float delta = x - envelope.mean;
+    envelope.mean += delta / envelope.count;
+    envelope.var += (delta * (x - envelope.mean) - envelope.var) /
+                    envelope.count;
+  }
+  DurationStats &stats = _duration[_pendingType];
+  if (stats.count < LEARN_WINDOW) stats.count++;
+  float x = _getDuration();
+  float delta = x - stats.mean;
+  stats.mean += delta / stats.count;
+  stats.var += (delta * (x - stats.mean) - stats.var) / stats.count;
+
+  uint16_t &count = _learnedCount[_pendingType];
+  if (count < UINT16_MAX) count++;
+  if (count == MIN_LEARN_COUNT) {
+    logger.info("ServoStallDetector: Learned envelope. type = " +
+                String(_pendingType));
+  }
+  if (count >= MIN_LEARN_COUNT &&
+      (count - MIN_LEARN_COUNT) % SAVE_INTERVAL == 0) {
+    save(_pendingType);
+  }
+}
+
+/**
+ * @brief 動作の種類ごとのNVSのキーを取得する
+ *
+ * @param type 動作の種類
+ * @return String キー
+ */
+String ServoStallDetector::_getKey(ServoController::ServoMoveType type) {
+  return "env" + String((uint8_t)type);
+}
+
+/**
+ * @brief 動作の種類ごとの動作時間のNVSのキーを取得する
+ *
+ * @param type 動作の種類
+ * @return String キー
+ */
+String ServoStallDetector::_getDurationKey(
+    ServoController::ServoMoveType type) {
+  return "dur" + String((uint8_t)type);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file ServoStallDetector.h
+ * @brief サーボ電流波形によるストール検知クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 動作の種類ごとに、動作開始からの経過時間に対するサーボ電流の
+ * 正常範囲（平均と分散）を学習し、範囲を連続して上回ればストールと判定する。
+ * 記録を終えた動作は、呼び出し側が正常に終わったと確定（commitMove()）して
+ * から学習する。サーボ電流が流れていた時間が学習値より長すぎる動作は
+ * 学習しない（判定を始める前の異常な動作で正常範囲が広がるのを防ぐ）。
+ * 学習済みの正常範囲はNVSに保存し、起動時に読み込む
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#include "BayConfig.h"
+#include "ServoController.h"
+
+class ServoStallDetector {
+ public:
+  ServoStallDetector(const BayConfig &);
+  ~ServoStallDetector();
+  void startMove(ServoController::ServoMoveType, uint32_t);
+  bool update(uint32_t, float);
+  void finishMove(uint32_t);
+  void commitMove(void);
+  void abortMove(void);
+  void rejectMove(void);
+  bool isLearned(ServoController::ServoMoveType);
+  uint16_t getLearnedCount(ServoController::ServoMoveType);
+  float getThreshold(ServoController::ServoMoveType, uint32_t);
+  bool load(void);
+  bool save(ServoController::ServoMoveType);
+  void reset(void);
+
+  /** 正常範囲を学習する時間区間の数 */
+  static const uint8_t BIN_NUM = 40;
+  static const uint32_t BIN_TIME;
+  static const uint16_t MIN_LEARN_COUNT;
+  static const uint16_t LEARN_WINDOW;
+  static const uint16_t SAVE_INTERVAL;
+  static const float SIGMA_FACTOR;
+  static const float MIN_MARGIN;
+  static const uint8_t STALL_COUNT;
+  static const uint16_t MIN_DURATION_COUNT;
+  static const float MIN_DURATION_MARGIN;
+
+ private:
+  /**
+   * @brief 時間区間ごとの電流の正常範囲
+   */
+  struct EnvelopeBin {
+    /** 電流の平均値[mA] */
+    float mean;
+    /** 電流の分散[mA^2] */
+    float var;
+    /** 学習した動作の回数 */
+    uint16_t count;
+  };
+
+  /**
+   * @brief サーボ電流が流れていた時間の学習値
+   */
+  struct DurationStats {
+    /** 平均値[ms] */
+    float mean;
+    /** 分散[ms^2] */
+    float var;
+    /** 学習した動作の回数 */
+    uint16_t count;
+  };
+
+  uint8_t _getBin(uint32_t);
+  uint32_t _getDuration(void);
+  bool _isDurationNormal(uint32_t);
+  void _learn(void);
+  void _clear(void);
+  static String _getKey(ServoController::ServoMoveType);
+  static String _getDurationKey(ServoController::ServoMoveType);
+
+  /** 学習した正常範囲 */
+  EnvelopeBin _envelope[ServoController::MOVE_TYPE_NUM][BIN_NUM];
+  /** 学習した動作の回数 */
+  uint16_t _learnedCount[ServoController::MOVE_TYPE_NUM];
+  /** 学習したサーボ電流が流れていた時間 */
+  DurationStats _duration[ServoController::MOVE_TYPE_NUM];
+  /** 記録中の動作の種類 */
+  ServoController::ServoMoveType _moveType;
+  /** 記録中の動作の開始時刻[ms] */
+  uint32_t _moveStartTime;
+  /** 記録中の動作の時間区間ごとの最大電流[mA] */
+  float _record[BIN_NUM];
+  /** 記録済みの時間区間の数 */
+  uint8_t _recordedBins;
+  /** 記録中の動作でストールを検知したかどうか */
+  bool _isStalled;
+  /** 確定待ちの動作の種類（MOVE_NONEならなし） */
+  ServoController::ServoMoveType _pendingType;
+  /** 確定待ちの動作の時間区間ごとの最大電流[mA] */
+  float _pending[BIN_NUM];
+  /** 確定待ちの動作の学習する時間区間の数 */
+  uint8_t _pendingBins;
+  /** 正常範囲を連続して上回った回数 */
+  uint8_t _overCount;
+  /** 正常範囲の保存先（ベイごとに分ける） */
+  String _namespace;
+
+  static const char *NAMESPACE;
+  static const char *KEY_VERSION;
+  static const uint8_t VERSION;
+};
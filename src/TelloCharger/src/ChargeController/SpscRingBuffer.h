@@ -0,0 +1,80 @@
+/**
+ * @file SpscRingBuffer.h
+ * @brief 単一生産者/単一消費者のロックフリーリングバッファ
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 生産者タスクと消費者タスクがそれぞれ1つの場合に限り、
+ * ロックを取らずにデータを受け渡すためのリングバッファ
+ */
+
+#pragma once
+#include <stdint.h>
+
+#include <atomic>
+
+template <typename T, uint32_t N>
+class SpscRingBuffer {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+ public:
+  SpscRingBuffer() : _head(0), _tail(0) {}
+
+  /**
+   * @brief データを追加する（生産者側からのみ呼び出すこと）
+   *
+   * @param item 追加するデータ
+   * @return true 追加できた
+   * @return false バッファが満杯のため追加できなかった
+   */
+  bool push(const T &item) {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) >= N) return false;
+    _buffer[head & (N - 1)] = item;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief データを取り出す（消費者側からのみ呼び出すこと）
+   *
+   * @param item 取り出したデータの格納先
+   * @return true 取り出せた
+   * @return false バッファが空だった
+   */
+  bool pop(T &item) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) return false;
+    item = _buffer[tail & (N - 1)];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief 格納されているデータ数を取得する
+   *
+   * @return uint32_t データ数
+   */
+  uint32_t size(void) const {
+    return _head.load(std::memory_order_acquire) -
+           _tail.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief バッファの容量を取得する
+   *
+   * @return uint32_t 容量
+   */
+  static uint32_t capacity(void) { return N; }
+
+ private:
+  SpscRingBuffer(const SpscRingBuffer &) = delete;
+  SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+  /** データ格納領域 */
+  T _buffer[N];
+  /** 書き込み位置（生産者のみ更新） */
+  std::atomic<uint32_t> _head;
+  /** 読み出し位置（消費者のみ更新） */
+  std::atomic<uint32_t> _tail;
+};
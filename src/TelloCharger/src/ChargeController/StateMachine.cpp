@@ -0,0 +1,269 @@
+/**
+ * @file StateMachine.cpp
+ * @brief テーブル駆動の階層状態機械
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 状態テーブル・遷移テーブルに依存しない共通処理
+ * （イベントキュー、タイムアウト、遷移回数・滞在時間の統計）
+ */
+
+#include "StateMachine.h"
+
+const uint8_t StateMachineBase::NO_STATE;
+const uint8_t StateMachineBase::MAX_STATE_NUM;
+const uint8_t StateMachineBase::QUEUE_SIZE;
+/** 状態に入場した（入場直後の条件判定に使う） */
+const uint8_t StateMachineBase::EVENT_ENTERED = 0;
+/** 状態のタイムアウトが経過した */
+const uint8_t StateMachineBase::EVENT_TIMEOUT = 1;
+/** 1回のdispatch()で処理するイベントの最大数（遷移の無限連鎖の防止） */
+const uint8_t StateMachineBase::MAX_DISPATCH = 16;
+
+/**
+ * @brief Construct a new State Machine Base:: State Machine Base object
+ *
+ * @details 状態ID 0 を初期状態とする
+ */
+StateMachineBase::StateMachineBase()
+    : _state(0),
+      _timeout(0),
+      _timeoutStart(0),
+      _isTimeoutPosted(false),
+      _queueHead(0),
+      _queueCount(0),
+      _transitionCount(0),
+      _droppedEventCount(0),
+      _trace(NULL),
+      _traceId(0),
+      _event(TRACE_EVENT_START) {
+  for (uint8_t i = 0; i < MAX_STATE_NUM; i++) {
+    _enterCount[i] = 0;
+    _dwellTime[i] = 0;
+    _maxDwellTime[i] = 0;
+    _enterTime[i] = millis();
+  }
+  _enterCount[0] = 1;
+}
+
+/**
+ * @brief Destroy the State Machine Base:: State Machine Base object
+ *
+ */
+StateMachineBase::~StateMachineBase() {}
+
+/**
+ * @brief 未処理のイベントを破棄し、指定した状態に遷移する
+ *
+ * @param state 遷移先の状態
+ */
+void StateMachineBase::start(uint8_t state) {
+  uint8_t event = _event;
+  _event = TRACE_EVENT_START;
+  _queueCount = 0;
+  _transit(state);
+  _transitionCount++;
+  _event = event;
+}
+
+/**
+ * @brief 入場・退出処理を行わずに指定した状態にする
+ *
+ * @details 未処理のイベントは破棄する。滞在時間の統計は親状態を含めて記録する
+ *
+ * @param state 状態
+ */
+void StateMachineBase::reset(uint8_t state) {
+  uint8_t event = _event;
+  _event = TRACE_EVENT_RESET;
+  _queueCount = 0;
+  for (uint8_t s = _state; s < MAX_STATE_NUM; s = _getParent(s)) _exit(s);
+  for (uint8_t s = state; s < MAX_STATE_NUM; s = _getParent(s)) _enter(s);
+  _setLeaf(state, 0);
+  _event = event;
+}
+
+/**
+ * @brief イベントをキューに追加する
+ *
+ * @param event イベント
+ * @return true 追加した
+ * @return false キューが一杯で破棄した
+ */
+bool StateMachineBase::post(uint8_t event) {
+  if (_queueCount >= QUEUE_SIZE) {
+    _droppedEventCount++;
+    return false;
+  }
+  _queue[(_queueHead + _queueCount) % QUEUE_SIZE] = event;
+  _queueCount++;
+  return true;
+}
+
+/**
+ * @brief タイムアウトを判定し、キュー内のイベントを処理する
+ *
+ * @details 処理中に発行されたイベント（EVENT_ENTEREDなど）も続けて処理するため、
+ * 条件を満たした遷移は1回の呼び出しで連鎖して進む
+ *
+ * @return true イベントを処理した
+ * @return false 処理するイベントがなかった
+ */
+bool StateMachineBase::dispatch(void) {
+  if (_timeout != 0 && !_isTimeoutPosted &&
+      millis() - _timeoutStart >= _timeout) {
+    _isTimeoutPosted = true;
+    post(EVENT_TIMEOUT);
+  }
+  if (_queueCount == 0) return false;
+  for (uint8_t i = 0; i < MAX_DISPATCH && _queueCount > 0; i++) {
+    uint8_t event = _queue[_queueHead];
+    _queueHead = (_queueHead + 1) % QUEUE_SIZE;
+    _queueCount--;
+    _event = event;
+    _handle(event);
+  }
+  _event = TRACE_EVENT_START;
+  return true;
+}
+
+/**
+ * @brief 現在の状態を取得する
+ *
+ * @return uint8_t 現在の状態
+ */
+uint8_t StateMachineBase::getState(void) { return _state; }
+
+/**
+ * @brief 未処理のイベントがあるかどうか
+ *
+ * @return true
+ * @return false
+ */
+bool StateMachineBase::hasEvent(void) { return _queueCount > 0; }
+
+/**
+ * @brief 現在の状態のタイムアウトを設定する
+ *
+ * @details 呼び出した時刻からの時間を設定する。0でタイムアウトを無効にする
+ *
+ * @param timeout タイムアウト[ms]
+ */
+void StateMachineBase::setTimeout(uint32_t timeout) {
+  _timeout = timeout;
+  _timeoutStart = millis();
+  _isTimeoutPosted = false;
+}
+
+/**
+ * @brief 遷移回数を取得する
+ *
+ * @return uint32_t 遷移回数（状態を変えない遷移を含む）
+ */
+uint32_t StateMachineBase::getTransitionCount(void) { return _transitionCount; }
+
+/**
+ * @brief キュー溢れで破棄したイベント数を取得する
+ *
+ * @return uint32_t 破棄したイベント数
+ */
+uint32_t StateMachineBase::getDroppedEventCount(void) {
+  return _droppedEventCount;
+}
+
+/**
+ * @brief 状態への入場回数を取得する
+ *
+ * @param state 状態
+ * @return uint32_t 入場回数
+ */
+uint32_t StateMachineBase::getEnterCount(uint8_t state) {
+  return state < MAX_STATE_NUM ? _enterCount[state] : 0;
+}
+
+/**
+ * @brief 状態の累積滞在時間を取得する
+ *
+ * @details 滞在中の状態は現在までの時間を含める
+ *
+ * @param state 状態
+ * @return uint32_t 累積滞在時間[ms]
+ */
+uint32_t StateMachineBase::getDwellTime(uint8_t state) {
+  if (state >= MAX_STATE_NUM) return 0;
+  if (isIn(state)) return _dwellTime[state] + millis() - _enterTime[state];
+  return _dwellTime[state];
+}
+
+/**
+ * @brief 状態の最大滞在時間を取得する
+ *
+ * @details 滞在中の状態は現在までの時間を含める
+ *
+ * @param state 状態
+ * @return uint32_t 最大滞在時間[ms]
+ */
+uint32_t StateMachineBase::getMaxDwellTime(uint8_t state) {
+  if (state >= MAX_STATE_NUM) return 0;
+  if (isIn(state)) {
+    uint32_t dwell = millis() - _enterTime[state];
+    if (dwell > _maxDwellTime[state]) return dwell;
+  }
+  return _maxDwellTime[state];
+}
+
+/**
+ * @brief 遷移の記録先を設定する
+ *
+ * @param trace 記録先（NULLで記録しない）
+ * @param id 記録時の制御ID
+ */
+void StateMachineBase::setTrace(TraceSink *trace, uint8_t id) {
+  _trace = trace;
+  _traceId = id;
+}
+
+/**
+ * @brief 親状態を取得する
+ *
+ * @param state 状態
+ * @return uint8_t 親状態（NO_STATEで最上位）
+ */
+uint8_t StateMachineBase::getParent(uint8_t state) { return _getParent(state); }
+
+/**
+ * @brief 状態への入場を記録する
+ *
+ * @param state 状態
+ */
+void StateMachineBase::_enter(uint8_t state) {
+  if (state >= MAX_STATE_NUM) return;
+  _enterCount[state]++;
+  _enterTime[state] = millis();
+}
+
+/**
+ * @brief 状態からの退出を記録する
+ *
+ * @param state 状態
+ */
+void StateMachineBase::_exit(uint8_t state) {
+  if (state >= MAX_STATE_NUM) return;
+  uint32_t dwell = millis() - _enterTime[state];
+  _dwellTime[state] += dwell;
+  if (dwell > _maxDwellTime[state]) _maxDwellTime[state] = dwell;
+}
+
+/**
+ * @brief 現在の状態を更新し、タイムアウトを開始する
+ *
+ * @details 現在の状態が変わるのはここのみのため、遷移の記録もここで行う
+ *
+ * @param state 状態
+ * @param timeout タイムアウト[ms]
+ */
+void StateMachineBase::_setLeaf(uint8_t state, uint32_t timeout) {
+  if (_trace != NULL) _trace->record(_traceId, _event, _state, state);
+  _state = state;
+  setTimeout(timeout);
+}
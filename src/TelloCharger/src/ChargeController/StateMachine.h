@@ -0,0 +1,343 @@
+/**
+ * @file StateMachine.h
+ * @brief テーブル駆動の階層状態機械
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 状態テーブルと遷移テーブルから状態機械を構成する。
+ * 状態は親状態を持つことができ、イベントは現在の状態から親状態へ順に
+ * 遷移テーブルを検索して処理する（親状態の遷移は全ての子状態で共有される）。
+ * 遷移時は共通の親状態までの退出処理、遷移処理、目的の状態までの入場処理の
+ * 順に実行し、入場後にEVENT_ENTEREDを発行する。
+ * 状態ごとにタイムアウトを設定でき、経過するとEVENT_TIMEOUTを発行する。
+ * 状態IDは状態テーブルの添字と一致させ、遷移先は子状態を持たない状態とすること。
+ * イベントキューは制御ループからのみ操作する（割り込み・他タスクからは不可）。
+ * 記録先（TraceSink）を設定すると、遷移のたびに記録する（状態を変えずに
+ * 遷移処理のみ行った場合は遷移先をNO_STATEとして記録する）
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#include "TraceRecord.h"
+
+/**
+ * @brief イベントを遷移テーブルのイベントマスクに変換する
+ *
+ * @param event イベント
+ * @return uint16_t イベントマスク
+ */
+constexpr uint16_t eventMask(uint8_t event) { return (uint16_t)1 << event; }
+
+class StateMachineBase {
+ public:
+  StateMachineBase();
+  virtual ~StateMachineBase();
+  void start(uint8_t);
+  void reset(uint8_t);
+  bool post(uint8_t);
+  bool dispatch(void);
+  uint8_t getState(void);
+  bool hasEvent(void);
+  void setTimeout(uint32_t);
+  uint32_t getTransitionCount(void);
+  uint32_t getDroppedEventCount(void);
+  uint32_t getEnterCount(uint8_t);
+  uint32_t getDwellTime(uint8_t);
+  uint32_t getMaxDwellTime(uint8_t);
+  void setTrace(TraceSink *, uint8_t);
+  uint8_t getParent(uint8_t);
+  virtual bool isIn(uint8_t) = 0;
+  virtual uint8_t getStateNum(void) = 0;
+  virtual const char *getStateName(uint8_t) = 0;
+
+  /** 状態なし（遷移先に指定すると状態を変えずに遷移処理のみ行う） */
+  static const uint8_t NO_STATE = 0xFF;
+  /** 状態の最大数 */
+  static const uint8_t MAX_STATE_NUM = 12;
+  /** イベントキューの長さ */
+  static const uint8_t QUEUE_SIZE = 8;
+  static const uint8_t EVENT_ENTERED;
+  static const uint8_t EVENT_TIMEOUT;
+  static const uint8_t MAX_DISPATCH;
+
+ protected:
+  virtual bool _handle(uint8_t) = 0;
+  virtual void _transit(uint8_t) = 0;
+  virtual uint8_t _getParent(uint8_t) = 0;
+  void _enter(uint8_t);
+  void _exit(uint8_t);
+  void _setLeaf(uint8_t, uint32_t);
+
+  /** 現在の状態 */
+  uint8_t _state;
+  /** 現在の状態のタイムアウト[ms]（0で無効） */
+  uint32_t _timeout;
+  /** タイムアウトの起点[ms] */
+  uint32_t _timeoutStart;
+  /** タイムアウトを発行済みかどうか */
+  bool _isTimeoutPosted;
+  /** イベントキュー */
+  uint8_t _queue[QUEUE_SIZE];
+  /** キューの先頭位置 */
+  uint8_t _queueHead;
+  /** キュー内のイベント数 */
+  uint8_t _queueCount;
+  /** 遷移回数 */
+  uint32_t _transitionCount;
+  /** キュー溢れで破棄したイベント数 */
+  uint32_t _droppedEventCount;
+  /** 状態ごとの入場回数 */
+  uint32_t _enterCount[MAX_STATE_NUM];
+  /** 状態ごとの累積滞在時間[ms] */
+  uint32_t _dwellTime[MAX_STATE_NUM];
+  /** 状態ごとの最大滞在時間[ms] */
+  uint32_t _maxDwellTime[MAX_STATE_NUM];
+  /** 状態ごとの入場時刻[ms] */
+  uint32_t _enterTime[MAX_STATE_NUM];
+  /** 遷移の記録先（NULLで記録しない） */
+  TraceSink *_trace;
+  /** 記録時の制御ID */
+  uint8_t _traceId;
+  /** 処理中のイベント（記録用） */
+  uint8_t _event;
+
+ private:
+  StateMachineBase(const StateMachineBase &) = delete;
+  StateMachineBase &operator=(const StateMachineBase &) = delete;
+};
+
+/**
+ * @brief 所有クラスのメンバ関数を条件・処理とする状態機械
+ *
+ * @tparam T 状態機械を所有するクラス
+ */
+template <class T>
+class StateMachine : public StateMachineBase {
+ public:
+  /** 遷移条件 */
+  typedef bool (T::*Guard)(void);
+  /** 入場・退出・遷移処理 */
+  typedef void (T::*Action)(void);
+
+  /**
+   * @brief 状態テーブルの要素
+   */
+  struct State {
+    /** 親状態（NO_STATEで最上位） */
+    uint8_t parent;
+    /** 状態名 */
+    const char *name;
+    /** 入場処理 */
+    Action entry;
+    /** 退出処理 */
+    Action exit;
+    /** タイムアウト[ms]（0で無効） */
+    uint32_t timeout;
+  };
+
+  /**
+   * @brief 遷移テーブルの要素
+   */
+  struct Transition {
+    /** 遷移元の状態 */
+    uint8_t source;
+    /** 遷移するイベントのマスク */
+    uint16_t events;
+    /** 遷移条件（NULLで常に遷移） */
+    Guard guard;
+    /** 遷移処理 */
+    Action action;
+    /** 遷移先の状態（NO_STATEで状態を変えない） */
+    uint8_t target;
+  };
+
+  StateMachine(T *, const State *, uint8_t, const Transition *, uint8_t);
+  bool isIn(uint8_t) override;
+  uint8_t getStateNum(void) override;
+  const char *getStateName(uint8_t) override;
+
+ protected:
+  bool _handle(uint8_t) override;
+  void _transit(uint8_t) override;
+  uint8_t _getParent(uint8_t) override;
+
+ private:
+  void _transit(uint8_t, Action);
+  bool _isAncestor(uint8_t, uint8_t);
+
+  /** 所有クラス */
+  T *_owner;
+  /** 状態テーブル */
+  const State *_states;
+  /** 状態数 */
+  uint8_t _stateNum;
+  /** 遷移テーブル */
+  const Transition *_transitions;
+  /** 遷移数 */
+  uint8_t _transitionNum;
+};
+
+/**
+ * @brief Construct a new State Machine object
+ *
+ * @param owner 状態機械を所有するクラス
+ * @param states 状態テーブル（状態IDの順）
+ * @param stateNum 状態数
+ * @param transitions 遷移テーブル（先に一致した遷移を優先する）
+ * @param transitionNum 遷移数
+ */
+template <class T>
+StateMachine<T>::StateMachine(T *owner, const State *states, uint8_t stateNum,
+                              const Transition *transitions,
+                              uint8_t transitionNum)
+    : _owner(owner),
+      _states(states),
+      _stateNum(stateNum < MAX_STATE_NUM ? stateNum : MAX_STATE_NUM),
+      _transitions(transitions),
+      _transitionNum(transitionNum) {}
+
+/**
+ * @brief 指定した状態（またはその子状態）にいるかどうか
+ *
+ * @param state 状態
+ * @return true
+ * @return false
+ */
+template <class T>
+bool StateMachine<T>::isIn(uint8_t state) {
+  return _isAncestor(state, _state);
+}
+
+/**
+ * @brief 状態数を取得する
+ *
+ * @return uint8_t 状態数
+ */
+template <class T>
+uint8_t StateMachine<T>::getStateNum(void) {
+  return _stateNum;
+}
+
+/**
+ * @brief 状態名を取得する
+ *
+ * @param state 状態
+ * @return const char* 状態名
+ */
+template <class T>
+const char *StateMachine<T>::getStateName(uint8_t state) {
+  return state < _stateNum ? _states[state].name : "";
+}
+
+/**
+ * @brief イベントを処理する
+ *
+ * @details 現在の状態から親状態へ順に、イベントが一致し遷移条件を満たす
+ * 最初の遷移を実行する
+ *
+ * @param event イベント
+ * @return true 遷移した
+ * @return false 一致する遷移がない
+ */
+template <class T>
+bool StateMachine<T>::_handle(uint8_t event) {
+  uint16_t mask = eventMask(event);
+  for (uint8_t state = _state; state < _stateNum;
+       state = _states[state].parent) {
+    for (uint8_t i = 0; i < _transitionNum; i++) {
+      const Transition &transition = _transitions[i];
+      if (transition.source != state || (transition.events & mask) == 0)
+        continue;
+      if (transition.guard != NULL && !(_owner->*transition.guard)()) continue;
+      if (transition.target == NO_STATE) {
+        if (transition.action != NULL) {
+          (_owner->*transition.action)();
+          if (_trace != NULL) {
+            _trace->record(_traceId, _event, _state, NO_STATE);
+          }
+        }
+      } else {
+        _transit(transition.target, transition.action);
+      }
+      _transitionCount++;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief 遷移処理なしで指定した状態に遷移する
+ *
+ * @param target 遷移先の状態
+ */
+template <class T>
+void StateMachine<T>::_transit(uint8_t target) {
+  _transit(target, NULL);
+}
+
+/**
+ * @brief 指定した状態に遷移する
+ *
+ * @details 現在の状態と遷移先の状態の共通の親状態までを退出し、
+ * 遷移処理の後に遷移先の状態まで入場する。
+ * 自己遷移の場合は退出・入場を行い、タイムアウトを再開する
+ *
+ * @param target 遷移先の状態
+ * @param action 遷移処理
+ */
+template <class T>
+void StateMachine<T>::_transit(uint8_t target, Action action) {
+  uint8_t common = _states[_state].parent;
+  while (common < _stateNum && !_isAncestor(common, target)) {
+    common = _states[common].parent;
+  }
+  for (uint8_t state = _state; state != common;
+       state = _states[state].parent) {
+    if (_states[state].exit != NULL) (_owner->*_states[state].exit)();
+    _exit(state);
+  }
+  if (action != NULL) (_owner->*action)();
+  uint8_t path[MAX_STATE_NUM];
+  uint8_t depth = 0;
+  for (uint8_t state = target; state != common && depth < MAX_STATE_NUM;
+       state = _states[state].parent) {
+    path[depth++] = state;
+  }
+  // 入場処理からタイムアウトを変更できるよう先に現在の状態を更新する
+  _setLeaf(target, _states[target].timeout);
+  while (depth > 0) {
+    uint8_t state = path[--depth];
+    _enter(state);
+    if (_states[state].entry != NULL) (_owner->*_states[state].entry)();
+  }
+  post(EVENT_ENTERED);
+}
+
+/**
+ * @brief 親状態を取得する
+ *
+ * @param state 状態
+ * @return uint8_t 親状態（NO_STATEで最上位）
+ */
+template <class T>
+uint8_t StateMachine<T>::_getParent(uint8_t state) {
+  return state < _stateNum ? _states[state].parent : NO_STATE;
+}
+
+/**
+ * @brief 状態が指定した状態自身またはその子状態かどうか
+ *
+ * @param ancestor 親状態
+ * @param state 状態
+ * @return true
+ * @return false
+ */
+template <class T>
+bool StateMachine<T>::_isAncestor(uint8_t ancestor, uint8_t state) {
+  for (; state < _stateNum; state = _states[state].parent) {
+    if (state == ancestor) return true;
+  }
+  return false;
+}
@@ -0,0 +1,233 @@
+/**
+ * @file StreamingStats.cpp
+ * @brief 逐次統計量クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details サンプルを保持せずに、最小値・最大値・平均・分散（Welford法）と
+ * P50/P95/P99（P²アルゴリズムによる近似値）を逐次更新する。
+ * メモリ使用量はサンプル数によらず一定
+ */
+
+#include "StreamingStats.h"
+
+/**
+ * @brief Construct a new P2Quantile::P2Quantile object
+ *
+ * @param p 推定するパーセンタイル（0〜1）
+ */
+P2Quantile::P2Quantile(float p) : _p(p) { reset(); }
+
+/**
+ * @brief 推定値を初期化する
+ *
+ */
+void P2Quantile::reset(void) {
+  _count = 0;
+  for (uint8_t i = 0; i < 5; i++) {
+    _height[i] = 0;
+    _position[i] = i;
+  }
+  _desired[0] = 0;
+  _desired[1] = 2 * _p;
+  _desired[2] = 4 * _p;
+  _desired[3] = 2 + 2 * _p;
+  _desired[4] = 4;
+}
+
+/**
+ * @brief サンプルを入力する
+ *
+ * @param x サンプル
+ */
+void P2Quantile::add(float x) {
+  if (_count < 5) {
+    // 最初の5サンプルは昇順に並べてマーカーの初期値とする
+    uint8_t i = _count++;
+    for (; i > 0 && _height[i - 1] > x; i--) _height[i] = _height[i - 1];
+    _height[i] = x;
+    return;
+  }
+  _count++;
+
+  // xが入る区間を探し、最小・最大のマーカーを更新する
+  uint8_t k;
+  if (x < _height[0]) {
+    _height[0] = x;
+    k = 0;
+  } else if (x >= _height[4]) {
+    _height[4] = x;
+    k = 3;
+  } else {
+    for (k = 0; k < 3 && x >= _height[k + 1]; k++) {
+    }
+  }
+  for (uint8_t i = k + 1; i < 5; i++) _position[i] += 1;
+  const float increment[5] = {0, _p / 2, _p, (1 + _p) / 2, 1};
+  for (uint8_t i = 0; i < 5; i++) _desired[i] += increment[i];
+
+  // 中間のマーカーを理想位置に近づける
+  for (uint8_t i = 1; i < 4; i++) {
+    double d = _desired[i] - _position[i];
+    if ((d >= 1 && _position[i + 1] - _position[i] > 1) ||
+        (d <= -1 && _position[i - 1] - _position[i] < -1)) {
+      int8_t sign = d > 0 ? 1 : -1;
+      float height = _parabolic(i, sign);
+      if (_height[i - 1] < height && height < _height[i + 1]) {
+        _height[i] = height;
+      } else {
+        _height[i] = _linear(i, sign);
+      }
+      _position[i] += sign;
+    }
+  }
+}
+
+/**
+ * @brief 区分放物線補間でマーカーの高さを求める
+ *
+ * @param i マーカー番号
+ * @param d 移動方向（±1）
+ * @return float マーカーの高さ
+ */
+float P2Quantile::_parabolic(uint8_t i, int8_t d) {
+  double n0 = _position[i - 1];
+  double n1 = _position[i];
+  double n2 = _position[i + 1];
+  return _height[i] +
+         d / (n2 - n0) *
+             ((n1 - n0 + d) * (_height[i + 1] - _height[i]) / (n2 - n1) +
+              (n2 - n1 - d) * (_height[i] - _height[i - 1]) / (n1 - n0));
+}
+
+/**
+ * @brief 線形補間でマーカーの高さを求める
+ *
+ * @param i マーカー番号
+ * @param d 移動方向（±1）
+ * @return float マーカーの高さ
+ */
+float P2Quantile::_linear(uint8_t i, int8_t d) {
+  return _height[i] + d * (_height[i + d] - _height[i]) /
+                          (_position[i + d] - _position[i]);
+}
+
+/**
+ * @brief パーセンタイルの推定値を取得する
+ *
+ * @details サンプルが5個未満のときは入力済みのサンプルから求める
+ *
+ * @return float 推定値（サンプルがなければ0）
+ */
+float P2Quantile::get(void) {
+  if (_count == 0) return 0;
+  if (_count < 5) return _height[(uint8_t)(_p * (_count - 1) + 0.5f)];
+  return _height[2];
+}
+
+/**
+ * @brief Construct a new StreamingStats::StreamingStats object
+ *
+ */
+StreamingStats::StreamingStats() : _p50(0.50), _p95(0.95), _p99(0.99) {
+  reset();
+}
+
+/**
+ * @brief 統計量を初期化する
+ *
+ */
+void StreamingStats::reset(void) {
+  _count = 0;
+  _min = 0;
+  _max = 0;
+  _mean = 0;
+  _m2 = 0;
+  _p50.reset();
+  _p95.reset();
+  _p99.reset();
+}
+
+/**
+ * @brief サンプルを入力する
+ *
+ * @param x サンプル
+ */
+void StreamingStats::add(float x) {
+  if (_count == UINT32_MAX) return;
+  if (_count == 0 || x < _min) _min = x;
+  if (_count == 0 || x > _max) _max = x;
+  _count++;
+  // Welford法（大きな値の二乗和をとらないため桁落ちしにくい）
+  double delta = x - _mean;
+  _mean += delta / _count;
+  _m2 += delta * (x - _mean);
+  _p50.add(x);
+  _p95.add(x);
+  _p99.add(x);
+}
+
+/**
+ * @brief サンプル数を取得する
+ *
+ * @return uint32_t サンプル数
+ */
+uint32_t StreamingStats::getCount(void) { return _count; }
+
+/**
+ * @brief 最小値を取得する
+ *
+ * @return float 最小値
+ */
+float StreamingStats::getMin(void) { return _min; }
+
+/**
+ * @brief 最大値を取得する
+ *
+ * @return float 最大値
+ */
+float StreamingStats::getMax(void) { return _max; }
+
+/**
+ * @brief 平均値を取得する
+ *
+ * @return float 平均値
+ */
+float StreamingStats::getMean(void) { return _mean; }
+
+/**
+ * @brief 分散（不偏分散）を取得する
+ *
+ * @return float 分散
+ */
+float StreamingStats::getVariance(void) {
+  return _count < 2 ? 0 : _m2 / (_count - 1);
+}
+
+/**
+ * @brief 標準偏差を取得する
+ *
+ * @return float 標準偏差
+ */
+float StreamingStats::getStdDev(void) { return sqrt(getVariance()); }
+
+/**
+ * @brief 中央値（P50）の推定値を取得する
+ *
+ * @return float P50
+ */
+float StreamingStats::getP50(void) { return _p50.get(); }
+
+/**
+ * @brief 95パーセンタイルの推定値を取得する
+ *
+ * @return float P95
+ */
+float StreamingStats::getP95(void) { return _p95.get(); }
+
+/**
+ * @brief 99パーセンタイルの推定値を取得する
+ *
+ * @return float P99
+ */
+float StreamingStats::getP99(void) { return _p99.get(); }
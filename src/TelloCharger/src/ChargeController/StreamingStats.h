@@ -0,0 +1,74 @@
+/**
+ * @file StreamingStats.h
+ * @brief 逐次統計量クラス
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details サンプルを保持せずに、最小値・最大値・平均・分散（Welford法）と
+ * P50/P95/P99（P²アルゴリズムによる近似値）を逐次更新する。
+ * メモリ使用量はサンプル数によらず一定
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief P²アルゴリズムによるパーセンタイルの逐次推定
+ *
+ * @details 5個のマーカーの高さと位置を区分放物線補間で更新し、
+ * 中央のマーカーの高さをパーセンタイルの推定値とする
+ * （Jain & Chlamtac, 1985）
+ */
+class P2Quantile {
+ public:
+  P2Quantile(float);
+  void reset(void);
+  void add(float);
+  float get(void);
+
+ private:
+  float _parabolic(uint8_t, int8_t);
+  float _linear(uint8_t, int8_t);
+
+  /** 推定するパーセンタイル（0〜1） */
+  float _p;
+  /** 入力したサンプル数 */
+  uint32_t _count;
+  /** マーカーの高さ */
+  float _height[5];
+  /** マーカーの位置（長期間の積算で桁落ちしないよう倍精度） */
+  double _position[5];
+  /** マーカーの理想位置 */
+  double _desired[5];
+};
+
+class StreamingStats {
+ public:
+  StreamingStats();
+  void reset(void);
+  void add(float);
+  uint32_t getCount(void);
+  float getMin(void);
+  float getMax(void);
+  float getMean(void);
+  float getVariance(void);
+  float getStdDev(void);
+  float getP50(void);
+  float getP95(void);
+  float getP99(void);
+
+ private:
+  /** サンプル数 */
+  uint32_t _count;
+  /** 最小値 */
+  float _min;
+  /** 最大値 */
+  float _max;
+  /** 平均値 */
+  double _mean;
+  /** 平均からの偏差の二乗和 */
+  double _m2;
+  P2Quantile _p50;
+  P2Quantile _p95;
+  P2Quantile _p99;
+};
@@ -0,0 +1,93 @@
+/**
+ * @file TraceRecord.h
+ * @brief 状態遷移トレースの記録形式
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 状態遷移1回分の記録と、記録を受け取るインタフェース。
+ * ホスト側の再生ツール（tools/trace_replay）と共有するため、
+ * Arduinoのヘッダに依存しないこと。
+ * 記録は以下の形式（リトルエンディアン、1件24バイト）
+ *
+ * | オフセット | 型 | 内容 |
+ * |---|---|---|
+ * | 0 | uint32 | 遷移時刻[us]（micros()） |
+ * | 4 | uint16 | 通し番号（下位16bit、欠落の検出用） |
+ * | 6 | uint8 | 制御ID（トレースのメタデータの添字） |
+ * | 7 | uint8 | イベント（ControlBase::ControlEventType、TRACE_EVENT_*） |
+ * | 8 | uint8 | 遷移元の状態 |
+ * | 9 | uint8 | 遷移先の状態（0xFF: 状態を変えずに遷移処理のみ） |
+ * | 10 | uint8 | フラグ（TRACE_FLAG_*） |
+ * | 11 | uint8 | 予約（0） |
+ * | 12 | int16 | 捕獲サーボの現在角度[0.1deg] |
+ * | 14 | int16 | 捕獲サーボの指示角度[0.1deg] |
+ * | 16 | int16 | USBサーボの現在角度[0.1deg] |
+ * | 18 | int16 | USBサーボの指示角度[0.1deg] |
+ * | 20 | int16 | 充電電流[mA] |
+ * | 22 | int16 | サーボ電流[mA] |
+ */
+
+#pragma once
+#include <stdint.h>
+
+/** start()による遷移（イベントなし） */
+static const uint8_t TRACE_EVENT_START = 0xFF;
+/** reset()による遷移（入場・退出処理なし） */
+static const uint8_t TRACE_EVENT_RESET = 0xFE;
+/** MOSFETがON */
+static const uint8_t TRACE_FLAG_FET_ON = 0x01;
+
+/**
+ * @brief 状態遷移1回分の記録
+ */
+struct TraceRecord {
+  /** 遷移時刻[us] */
+  uint32_t time;
+  /** 通し番号（下位16bit） */
+  uint16_t sequence;
+  /** 制御ID */
+  uint8_t component;
+  /** イベント */
+  uint8_t event;
+  /** 遷移元の状態 */
+  uint8_t fromState;
+  /** 遷移先の状態（0xFF: 状態を変えずに遷移処理のみ） */
+  uint8_t toState;
+  /** フラグ */
+  uint8_t flags;
+  /** 予約 */
+  uint8_t reserved;
+  /** 捕獲サーボの現在角度[0.1deg] */
+  int16_t catchAngle;
+  /** 捕獲サーボの指示角度[0.1deg] */
+  int16_t catchTarget;
+  /** USBサーボの現在角度[0.1deg] */
+  int16_t usbAngle;
+  /** USBサーボの指示角度[0.1deg] */
+  int16_t usbTarget;
+  /** 充電電流[mA] */
+  int16_t chargeCurrent;
+  /** サーボ電流[mA] */
+  int16_t servoCurrent;
+};
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord must be 24 bytes");
+
+/**
+ * @brief 状態遷移の記録先
+ */
+class TraceSink {
+ public:
+  virtual ~TraceSink() {}
+
+  /**
+   * @brief 状態遷移を記録する
+   *
+   * @param component 制御ID
+   * @param event イベント
+   * @param fromState 遷移元の状態
+   * @param toState 遷移先の状態
+   */
+  virtual void record(uint8_t component, uint8_t event, uint8_t fromState,
+                      uint8_t toState) = 0;
+};
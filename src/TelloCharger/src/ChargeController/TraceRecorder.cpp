@@ -0,0 +1,347 @@
+/**
+ * @file TraceRecorder.cpp
+ * @brief 状態遷移トレースの記録
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ */
+
+#include "TraceRecorder.h"
+
+#include <Log.h>
+#include <Preferences.h>
+#include <math.h>
+
+const uint16_t TraceRecorder::TRACE_SIZE;
+const uint8_t TraceRecorder::MAX_COMPONENT_NUM;
+const uint8_t TraceRecorder::NO_COMPONENT;
+/** ヘッダのサイズ[byte] */
+const size_t TraceRecorder::HEADER_SIZE = 16;
+/** 制御のメタデータのサイズ[byte]（状態を除く） */
+const size_t TraceRecorder::COMPONENT_SIZE = 24;
+/** 状態のメタデータのサイズ[byte] */
+const size_t TraceRecorder::STATE_SIZE = 20;
+/** flush()で記録を退避する名前空間の基本名 */
+const char *TraceRecorder::NAMESPACE = "trace";
+/** NVSのキー（保存形式のバージョン） */
+const char *TraceRecorder::KEY_VERSION = "version";
+/** NVSのキー（記録） */
+const char *TraceRecorder::KEY_RECORDS = "records";
+/** NVSのキー（保存時点の総記録数） */
+const char *TraceRecorder::KEY_TOTAL = "total";
+/** 保存形式のバージョン（TraceRecordの構成・値の意味を変えたら上げる） */
+const uint8_t TraceRecorder::VERSION = 2;
+
+/**
+ * @brief 任意のオフセットからの読み出し範囲だけを格納する書き込み先
+ *
+ * @details 先頭から順に全体を書き込み、[index, index + maxLen) の範囲のみ
+ * バッファに格納する
+ */
+class TraceWriter {
+ public:
+  TraceWriter(uint8_t *buffer, size_t maxLen, size_t index)
+      : _buffer(buffer), _maxLen(maxLen), _index(index), _pos(0) {}
+
+  void put(uint8_t value) {
+    if (_pos >= _index && _pos - _index < _maxLen) {
+      _buffer[_pos - _index] = value;
+    }
+    _pos++;
+  }
+
+  void put16(uint16_t value) {
+    put(value & 0xFF);
+    put(value >> 8);
+  }
+
+  void put32(uint32_t value) {
+    put16(value & 0xFFFF);
+    put16(value >> 16);
+  }
+
+  void putString(const char *str, size_t len) {
+    size_t n = 0;
+    for (; n < len && str[n] != '\0'; n++) put(str[n]);
+    for (; n < len; n++) put(0);
+  }
+
+  void putBytes(const void *data, size_t len) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) put(bytes[i]);
+  }
+
+  /** 読み出し範囲の終端まで書き込んだかどうか */
+  bool isFull(void) { return _pos >= _index + _maxLen; }
+
+  /** バッファに格納したサイズ[byte] */
+  size_t getLength(void) {
+    return _pos > _index ? min(_pos - _index, _maxLen) : 0;
+  }
+
+ private:
+  uint8_t *_buffer;
+  size_t _maxLen;
+  size_t _index;
+  size_t _pos;
+};
+
+/**
+ * @brief 値を丸めてint16_tの範囲に収める
+ *
+ * @param value 値
+ * @param scale 倍率
+ * @return int16_t 値×倍率
+ */
+static int16_t toInt16(float value, float scale) {
+  long scaled = lroundf(value * scale);
+  return (int16_t)constrain(scaled, (long)INT16_MIN, (long)INT16_MAX);
+}
+
+/**
+ * @brief Construct a new Trace Recorder:: Trace Recorder object
+ *
+ * @param servo サーボ制御部
+ * @param fet MOSFET制御部
+ * @param current 電流計測部
+ * @param bay 充電ベイの構成（記録の保存先）
+ */
+TraceRecorder::TraceRecorder(ServoController *servo, FETController *fet,
+                             CurrentReader *current, const BayConfig &bay)
+    : _servo(servo),
+      _fet(fet),
+      _current(current),
+      _componentNum(0),
+      _mux(portMUX_INITIALIZER_UNLOCKED),
+      _totalCount(0),
+      _exportCount(0),
+      _exportTotalCount(0),
+      _exportSource(SOURCE_RAM),
+      _namespace(bay.getNamespace(NAMESPACE)) {}
+
+/**
+ * @brief Destroy the Trace Recorder:: Trace Recorder object
+ *
+ */
+TraceRecorder::~TraceRecorder() {}
+
+/**
+ * @brief 制御を登録し、状態遷移の記録を開始する
+ *
+ * @details 子制御も続けて登録する（制御IDは登録順に割り当てる）
+ *
+ * @param control 制御
+ * @param parent 親制御ID
+ * @return true 登録した
+ * @return false 登録数の上限を超えた（子制御を含めて記録しない）
+ */
+bool TraceRecorder::addControl(ControlBase *control, uint8_t parent) {
+  if (_componentNum >= MAX_COMPONENT_NUM) {
+    logger.warn("TraceRecorder.addControl(): Too many controls. name = " +
+                control->getName());
+    return false;
+  }
+  uint8_t id = _componentNum++;
+  _components[id] = control;
+  _parents[id] = parent;
+  control->getStateMachine()->setTrace(this, id);
+  for (uint8_t i = 0; i < control->getChildNum(); i++) {
+    addControl(control->getChild(i), id);
+  }
+  return true;
+}
+
+/**
+ * @brief 状態遷移を記録する（制御ループからのみ呼び出すこと）
+ *
+ * @param component 制御ID
+ * @param event イベント
+ * @param fromState 遷移元の状態
+ * @param toState 遷移先の状態
+ */
+void TraceRecorder::record(uint8_t component, uint8_t event,
+                           uint8_t fromState, uint8_t toState) {
+  uint32_t total = _totalCount.load(std::memory_order_relaxed);
+  TraceRecord record;
+  record.time = micros();
+  record.sequence = (uint16_t)total;
+  record.component = component;
+  record.event = event;
+  record.fromState = fromState;
+  record.toState = toState;
+  record.flags = _fet->read() ? TRACE_FLAG_FET_ON : 0;
+  record.reserved = 0;
+  record.catchAngle = toInt16(_servo->servoCatch()->getPresentAngle(), 10);
+  record.catchTarget = toInt16(_servo->servoCatch()->getTargetAngle(), 10);
+  record.usbAngle = toInt16(_servo->servoUsb()->getPresentAngle(), 10);
+  record.usbTarget = toInt16(_servo->servoUsb()->getTargetAngle(), 10);
+  record.chargeCurrent = toInt16(_current->getCurrent(), 1);
+  record.servoCurrent = toInt16(_current->getServoCurrent(), 1);
+  portENTER_CRITICAL(&_mux);
+  _records[total % TRACE_SIZE] = record;
+  _totalCount.store(total + 1, std::memory_order_release);
+  portEXIT_CRITICAL(&_mux);
+}
+
+/**
+ * @brief 起動からの総記録数を取得する
+ *
+ * @return uint32_t 総記録数
+ */
+uint32_t TraceRecorder::getTotalCount(void) {
+  return _totalCount.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief 直近の記録をNVSに保存する
+ *
+ * @details 制御ループ以外のタスクから呼び出すこと（NVSへの書き込みで
+ * 数十msかかる）。保存した記録は読み出し用の記録にもなる
+ *
+ * @return true 保存成功
+ * @return false 記録がない、または保存失敗
+ */
+bool TraceRecorder::flush(void) {
+  _copy();
+  if (_exportCount == 0) return false;
+  Preferences prefs;
+  if (!prefs.begin(_namespace.c_str(), false)) return false;
+  size_t size = sizeof(TraceRecord) * _exportCount;
+  bool isWritten =
+      prefs.putBytes(KEY_RECORDS, _exportRecords, size) == size &&
+      prefs.putUInt(KEY_TOTAL, _exportTotalCount) == sizeof(uint32_t) &&
+      prefs.putUChar(KEY_VERSION, VERSION) == sizeof(uint8_t);
+  prefs.end();
+  if (isWritten) {
+    logger.info("TraceRecorder.flush(): Saved " + String(_exportCount) +
+                " records");
+  } else {
+    logger.error("TraceRecorder.flush(): Failed to write NVS");
+  }
+  return isWritten;
+}
+
+/**
+ * @brief 読み出す記録を準備する
+ *
+ * @details 記録を読み出し用の領域に複写する。読み出し用の領域は1つで、
+ * 次の準備・保存で上書きされるため、読み出しを終えるまで同じタスクから
+ * 続けて呼び出すこと（分割して送信する場合は先に全体を複写しておく）
+ *
+ * @param source 読み出し元
+ * @return true 準備した
+ * @return false NVSに有効な記録がない
+ */
+bool TraceRecorder::prepare(SourceType source) {
+  if (source == SOURCE_FLASH) return _load();
+  _copy();
+  return true;
+}
+
+/**
+ * @brief 準備した記録のバイナリ形式でのサイズを取得する
+ *
+ * @return size_t サイズ[byte]（記録がなければ0）
+ */
+size_t TraceRecorder::getBinarySize(void) {
+  if (_exportCount == 0) return 0;
+  return HEADER_SIZE + _getMetaSize() + sizeof(TraceRecord) * _exportCount;
+}
+
+/**
+ * @brief 準備した記録をバイナリ形式で読み出す
+ *
+ * @details HTTPレスポンスのように分割して読み出せるよう、
+ * 任意のオフセットから読み出せる
+ *
+ * @param buffer 格納先
+ * @param maxLen 格納先のサイズ[byte]
+ * @param index 読み出し開始位置[byte]
+ * @return size_t 格納したサイズ[byte]
+ */
+size_t TraceRecorder::readBinary(uint8_t *buffer, size_t maxLen,
+                                 size_t index) {
+  if (index >= getBinarySize()) return 0;
+  TraceWriter writer(buffer, maxLen, index);
+  writer.putString("TTRC", 4);
+  writer.put(VERSION);
+  writer.put(_exportSource);
+  writer.put(_componentNum);
+  writer.put(sizeof(TraceRecord));
+  writer.put16(_exportCount);
+  writer.put16(0);
+  writer.put32(_exportTotalCount);
+  for (uint8_t id = 0; id < _componentNum && !writer.isFull(); id++) {
+    StateMachineBase *machine = _components[id]->getStateMachine();
+    uint8_t stateNum = machine->getStateNum();
+    writer.put(_parents[id]);
+    writer.put(stateNum);
+    writer.putString(_components[id]->getName().c_str(), COMPONENT_SIZE - 2);
+    for (uint8_t state = 0; state < stateNum; state++) {
+      writer.put(machine->getParent(state));
+      writer.putString(machine->getStateName(state), STATE_SIZE - 1);
+    }
+  }
+  // ESP32はリトルエンディアンのため記録はそのまま出力する
+  for (uint16_t i = 0; i < _exportCount && !writer.isFull(); i++) {
+    writer.putBytes(&_exportRecords[i], sizeof(TraceRecord));
+  }
+  return writer.getLength();
+}
+
+/**
+ * @brief リングバッファの記録を古い順に読み出し用の領域へ複写する
+ *
+ * @details 複写中に制御ループが記録を上書きしないよう、
+ * クリティカルセクション内で複写する（128件で十数us）
+ */
+void TraceRecorder::_copy(void) {
+  portENTER_CRITICAL(&_mux);
+  uint32_t total = _totalCount.load(std::memory_order_relaxed);
+  uint16_t count = total < TRACE_SIZE ? total : TRACE_SIZE;
+  for (uint16_t i = 0; i < count; i++) {
+    _exportRecords[i] = _records[(total - count + i) % TRACE_SIZE];
+  }
+  portEXIT_CRITICAL(&_mux);
+  _exportCount = count;
+  _exportTotalCount = total;
+  _exportSource = SOURCE_RAM;
+}
+
+/**
+ * @brief NVSに保存した記録を読み出し用の領域に読み込む
+ *
+ * @return true 読み込み成功
+ * @return false 保存値がない、または不正
+ */
+bool TraceRecorder::_load(void) {
+  _exportCount = 0;
+  Preferences prefs;
+  if (!prefs.begin(_namespace.c_str(), true)) return false;
+  size_t size = prefs.getBytesLength(KEY_RECORDS);
+  bool isRead = prefs.getUChar(KEY_VERSION, 0) == VERSION && size > 0 &&
+                size <= sizeof(_exportRecords) &&
+                size % sizeof(TraceRecord) == 0 &&
+                prefs.getBytes(KEY_RECORDS, _exportRecords, size) == size;
+  uint32_t total = prefs.getUInt(KEY_TOTAL, 0);
+  prefs.end();
+  if (!isRead) return false;
+  _exportCount = size / sizeof(TraceRecord);
+  _exportTotalCount = total;
+  _exportSource = SOURCE_FLASH;
+  return true;
+}
+
+/**
+ * @brief メタデータのサイズを取得する
+ *
+ * @return size_t サイズ[byte]
+ */
+size_t TraceRecorder::_getMetaSize(void) {
+  size_t size = 0;
+  for (uint8_t id = 0; id < _componentNum; id++) {
+    size += COMPONENT_SIZE +
+            STATE_SIZE * _components[id]->getStateMachine()->getStateNum();
+  }
+  return size;
+}
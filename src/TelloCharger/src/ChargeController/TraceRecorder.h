@@ -0,0 +1,119 @@
+/**
+ * @file TraceRecorder.h
+ * @brief 状態遷移トレースの記録
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 登録した制御の状態遷移を、遷移時のサーボ角度・MOSFETの状態・
+ * 電流値とともに固定長のリングバッファ（RAM）に記録する。
+ * 記録は制御ループからのみ行い、1件あたり数usで完了する
+ * （文字列の生成やメモリ確保は行わない）。
+ * 読み出し時は記録中のバッファを複写してから以下のバイナリ形式
+ * （リトルエンディアン）で取り出す。flush()で直近の記録をNVSに保存し、
+ * 再起動後も読み出せる
+ *
+ * | オフセット | 型 | 内容 |
+ * |---|---|---|
+ * | 0 | char[4] | マジック "TTRC" |
+ * | 4 | uint8 | フォーマットバージョン（1） |
+ * | 5 | uint8 | 読み出し元（SourceType） |
+ * | 6 | uint8 | 制御数 |
+ * | 7 | uint8 | 記録1件のサイズ（24） |
+ * | 8 | uint16 | 記録数 |
+ * | 10 | uint16 | 予約（0） |
+ * | 12 | uint32 | 起動からの総記録数 |
+ * | 16 | component[] | 制御のメタデータ（制御IDの順） |
+ * | - | record[] | 記録（古い順、TraceRecord.h参照） |
+ *
+ * component は uint8 親制御ID（0xFFで最上位）、uint8 状態数、
+ * char[22] 制御名（NUL埋め）の24バイトに続けて、
+ * 状態ごとに uint8 親状態（0xFFで最上位）、char[19] 状態名（NUL埋め）の
+ * 20バイトを状態IDの順に並べる。
+ * メタデータは読み出し時点のファームウェアのものを出力するため、
+ * NVSに保存した記録は同じファームウェアで読み出すこと
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#include <atomic>
+
+#include "BayConfig.h"
+#include "ControlBase.h"
+#include "CurrentReader.h"
+#include "FETController.h"
+#include "ServoController.h"
+#include "TraceRecord.h"
+
+class TraceRecorder : public TraceSink {
+ public:
+  typedef enum eSource {
+    /** RAMのリングバッファ */
+    SOURCE_RAM,
+    /** NVSに保存した記録 */
+    SOURCE_FLASH,
+  } SourceType;
+
+  TraceRecorder(ServoController *, FETController *, CurrentReader *,
+                const BayConfig &);
+  ~TraceRecorder();
+  bool addControl(ControlBase *, uint8_t parent = NO_COMPONENT);
+  void record(uint8_t, uint8_t, uint8_t, uint8_t) override;
+  uint32_t getTotalCount(void);
+  bool flush(void);
+  bool prepare(SourceType);
+  size_t getBinarySize(void);
+  size_t readBinary(uint8_t *, size_t, size_t);
+
+  /** 記録する件数 */
+  static const uint16_t TRACE_SIZE = 128;
+  /** 登録できる制御の最大数 */
+  static const uint8_t MAX_COMPONENT_NUM = 16;
+  /** 親制御なし */
+  static const uint8_t NO_COMPONENT = 0xFF;
+  static const size_t HEADER_SIZE;
+  static const size_t COMPONENT_SIZE;
+  static const size_t STATE_SIZE;
+
+ private:
+  TraceRecorder(const TraceRecorder &) = delete;
+  TraceRecorder &operator=(const TraceRecorder &) = delete;
+  void _copy(void);
+  bool _load(void);
+  size_t _getMetaSize(void);
+
+  /** サーボ制御部 */
+  ServoController *_servo;
+  /** MOSFET制御部 */
+  FETController *_fet;
+  /** 電流計測部 */
+  CurrentReader *_current;
+  /** 登録した制御（制御IDの順） */
+  ControlBase *_components[MAX_COMPONENT_NUM];
+  /** 制御ごとの親制御ID */
+  uint8_t _parents[MAX_COMPONENT_NUM];
+  /** 登録した制御の数 */
+  uint8_t _componentNum;
+  /** 記録の上書きと複写を排他するクリティカルセクション */
+  portMUX_TYPE _mux;
+  /** 記録（リングバッファ） */
+  TraceRecord _records[TRACE_SIZE];
+  /** 起動からの総記録数（制御ループのみ更新） */
+  std::atomic<uint32_t> _totalCount;
+  /** 読み出し用に複写した記録（古い順） */
+  TraceRecord _exportRecords[TRACE_SIZE];
+  /** 複写した記録数 */
+  uint16_t _exportCount;
+  /** 複写時点の総記録数 */
+  uint32_t _exportTotalCount;
+  /** 複写した記録の読み出し元 */
+  SourceType _exportSource;
+  /** 退避先（他のベイの記録を上書きしないようベイごとに分ける） */
+  String _namespace;
+
+  static const char *NAMESPACE;
+  static const char *KEY_VERSION;
+  static const char *KEY_RECORDS;
+  static const char *KEY_TOTAL;
+  static const uint8_t VERSION;
+};
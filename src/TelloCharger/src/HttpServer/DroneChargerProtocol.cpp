@@ -8,7 +8,7 @@
  *  内部ユーティリティ
  * ==============================================================*/
 namespace {
-template<size_t CAP = 192>
+template<size_t CAP = 256>
 bool deserialize(const String& json, StaticJsonDocument<CAP>& doc)
 {
   return !deserializeJson(doc, json);
@@ -25,13 +25,28 @@ bool deserialize(const String& json, StaticJsonDocument<CAP>& doc)
  */
 String buildChargeStatusJson(const ChargeStatus& s)
 {
-  StaticJsonDocument<192> doc;
+  StaticJsonDocument<512> doc;
+  doc["version"]                = s.version;
   doc["charge"]                 = s.charge;
   doc["current"]                = s.current;
   doc["chargingTime"]           = s.chargingTime;
+  doc["chargeAmount"]           = s.chargeAmount;
+  doc["chargeEnergy"]           = s.chargeEnergy;
+  doc["busVoltage"]             = s.busVoltage;
+  doc["minBusVoltage"]          = s.minBusVoltage;
+  doc["power"]                  = s.power;
+  doc["samplingRate"]           = s.samplingRate;
+  doc["soc"]                    = s.soc;
+  doc["timeToFull"]             = s.timeToFull;
+  doc["targetSoc"]              = s.targetSoc;
+  doc["profile"]                = s.profile;
+  doc["sensorHealth"]           = s.sensorHealth;
+  doc["sensorFailedCount"]      = s.sensorFailedCount;
+  doc["sensorRecoveredCount"]   = s.sensorRecoveredCount;
   doc["isStartChargeExecuting"] = s.isStartChargeExecuting;
   doc["isStopChargeExecuting"]  = s.isStopChargeExecuting;
   doc["isPowerOnExecuting"]     = s.isPowerOnExecuting;
+  doc["isCalibrateExecuting"]   = s.isCalibrateExecuting;
 
   String out;
   serializeJson(doc, out);
@@ -46,20 +61,287 @@ String buildChargeStatusJson(const ChargeStatus& s)
  */
 ChargeStatus parseChargeStatusJson(const String& json)
 {
-  ChargeStatus s{false, 0, 0, false, false, false, false};
-  StaticJsonDocument<192> doc;
+  ChargeStatus s{0, false, 0, 0, 0, 0, 0, 0, 0, 0, -1, -1, 100, "", 0, 0, 0,
+                 false, false, false, false, false};
+  StaticJsonDocument<768> doc;
   if (!deserialize(json, doc)) return s;
 
+  s.version                = doc["version"]                | 0;
   s.charge                 = doc["charge"]                 | false;
   s.current                = doc["current"]                | 0.0;
   s.chargingTime           = doc["chargingTime"]           | 0.0;
+  s.chargeAmount           = doc["chargeAmount"]           | 0.0;
+  s.chargeEnergy           = doc["chargeEnergy"]           | 0.0;
+  s.busVoltage             = doc["busVoltage"]             | 0.0;
+  s.minBusVoltage          = doc["minBusVoltage"]          | 0.0;
+  s.power                  = doc["power"]                  | 0.0;
+  s.samplingRate           = doc["samplingRate"]           | 0;
+  s.soc                    = doc["soc"]                    | -1.0;
+  s.timeToFull             = doc["timeToFull"]             | -1.0;
+  s.targetSoc              = doc["targetSoc"]              | 100;
+  s.profile                = doc["profile"]                | "";
+  s.sensorHealth           = doc["sensorHealth"]           | 0;
+  s.sensorFailedCount      = doc["sensorFailedCount"]      | 0;
+  s.sensorRecoveredCount   = doc["sensorRecoveredCount"]   | 0;
   s.isStartChargeExecuting = doc["isStartChargeExecuting"] | false;
   s.isStopChargeExecuting  = doc["isStopChargeExecuting"]  | false;
   s.isPowerOnExecuting     = doc["isPowerOnExecuting"]     | false;
+  s.isCalibrateExecuting   = doc["isCalibrateExecuting"]   | false;
+  s.valid = true;
+  return s;
+}
+
+/* ==============================================================
+ *  ChargeStats
+ * ==============================================================*/
+/**
+ * @brief StatsValue を JSON オブジェクトに設定（内部ヘルパ）
+ */
+static void setStatsValue(JsonObject obj, const StatsValue& v)
+{
+  obj["count"]  = v.count;
+  obj["min"]    = v.min;
+  obj["max"]    = v.max;
+  obj["mean"]   = v.mean;
+  obj["stddev"] = v.stddev;
+  obj["p50"]    = v.p50;
+  obj["p95"]    = v.p95;
+  obj["p99"]    = v.p99;
+}
+
+/**
+ * @brief JSON オブジェクトから StatsValue を取得（内部ヘルパ）
+ */
+static StatsValue getStatsValue(JsonObjectConst obj)
+{
+  StatsValue v;
+  v.count  = obj["count"]  | 0;
+  v.min    = obj["min"]    | 0.0;
+  v.max    = obj["max"]    | 0.0;
+  v.mean   = obj["mean"]   | 0.0;
+  v.stddev = obj["stddev"] | 0.0;
+  v.p50    = obj["p50"]    | 0.0;
+  v.p95    = obj["p95"]    | 0.0;
+  v.p99    = obj["p99"]    | 0.0;
+  return v;
+}
+
+/**
+ * @brief ChargeStatsScope を JSON オブジェクトに設定（内部ヘルパ）
+ */
+static void setStatsScope(JsonObject obj, const ChargeStatsScope& s)
+{
+  setStatsValue(obj.createNestedObject("chargeCurrent"), s.chargeCurrent);
+  setStatsValue(obj.createNestedObject("servoCurrent"),  s.servoCurrent);
+  setStatsValue(obj.createNestedObject("loopTime"),      s.loopTime);
+  setStatsValue(obj.createNestedObject("commandLatency"), s.commandLatency);
+}
+
+/**
+ * @brief JSON オブジェクトから ChargeStatsScope を取得（内部ヘルパ）
+ */
+static ChargeStatsScope getStatsScope(JsonObjectConst obj)
+{
+  ChargeStatsScope s;
+  s.chargeCurrent = getStatsValue(obj["chargeCurrent"]);
+  s.servoCurrent  = getStatsValue(obj["servoCurrent"]);
+  s.loopTime      = getStatsValue(obj["loopTime"]);
+  s.commandLatency = getStatsValue(obj["commandLatency"]);
+  return s;
+}
+
+/**
+ * @brief ChargeStats 構造体を JSON 文字列にシリアライズ
+ * @details 2 スコープ × 4 項目 × 8 値で約 1.2KB 必要（HTTP の /stats と同じ
+ *          2048 を確保）。容量不足なら欠けた JSON を返さず空文字列を返す
+ * @param[in] s 送信する ChargeStats
+ * @return シリアライズ済み JSON（容量不足なら空文字列）
+ */
+String buildChargeStatsJson(const ChargeStats& s)
+{
+  StaticJsonDocument<2048> doc;
+  setStatsScope(doc.createNestedObject("session"),  s.session);
+  setStatsScope(doc.createNestedObject("lifetime"), s.lifetime);
+
+  String out;
+  if (doc.overflowed()) return out;
+  serializeJson(doc, out);
+  return out;
+}
+
+/**
+ * @brief /charge/stats JSON を ChargeStats 構造体へデシリアライズ
+ * @param[in] json 受信した JSON 文字列
+ * @retval ChargeStats.valid = true  パース成功
+ * @retval ChargeStats.valid = false パース失敗
+ */
+ChargeStats parseChargeStatsJson(const String& json)
+{
+  ChargeStats s = {};
+  StaticJsonDocument<2048> doc;
+  if (!deserialize(json, doc)) return s;
+
+  s.session  = getStatsScope(doc["session"]);
+  s.lifetime = getStatsScope(doc["lifetime"]);
+  s.valid = true;
+  return s;
+}
+
+/* ==============================================================
+ *  LoopStats
+ * ==============================================================*/
+/**
+ * @brief LoopStats 構造体を JSON 文字列にシリアライズ
+ * @param[in] s 送信する LoopStats
+ * @return シリアライズ済み JSON
+ */
+String buildLoopStatsJson(const LoopStats& s)
+{
+  StaticJsonDocument<2048> doc;
+  setStatsValue(doc.createNestedObject("loop"),              s.loop);
+  setStatsValue(doc.createNestedObject("period"),            s.period);
+  setStatsValue(doc.createNestedObject("currentReader"),     s.currentReader);
+  setStatsValue(doc.createNestedObject("startCharge"),       s.startCharge);
+  setStatsValue(doc.createNestedObject("stopCharge"),        s.stopCharge);
+  setStatsValue(doc.createNestedObject("powerOnDrone"),      s.powerOnDrone);
+  setStatsValue(doc.createNestedObject("calibrate"),         s.calibrate);
+  setStatsValue(doc.createNestedObject("checkServoCurrent"), s.checkServoCurrent);
+  setStatsValue(doc.createNestedObject("servo"),             s.servo);
+
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+/**
+ * @brief /charge/stats/loop JSON を LoopStats 構造体へデシリアライズ
+ * @param[in] json 受信した JSON 文字列
+ * @retval LoopStats.valid = true  パース成功
+ * @retval LoopStats.valid = false パース失敗
+ */
+LoopStats parseLoopStatsJson(const String& json)
+{
+  LoopStats s = {};
+  StaticJsonDocument<2048> doc;
+  if (!deserialize(json, doc)) return s;
+
+  s.loop              = getStatsValue(doc["loop"]);
+  s.period            = getStatsValue(doc["period"]);
+  s.currentReader     = getStatsValue(doc["currentReader"]);
+  s.startCharge       = getStatsValue(doc["startCharge"]);
+  s.stopCharge        = getStatsValue(doc["stopCharge"]);
+  s.powerOnDrone      = getStatsValue(doc["powerOnDrone"]);
+  s.calibrate         = getStatsValue(doc["calibrate"]);
+  s.checkServoCurrent = getStatsValue(doc["checkServoCurrent"]);
+  s.servo             = getStatsValue(doc["servo"]);
+  s.valid = true;
+  return s;
+}
+
+/* ==============================================================
+ *  ChargeQueueStatus
+ * ==============================================================*/
+/**
+ * @brief ChargeQueueStatus 構造体を JSON 文字列にシリアライズ
+ * @param[in] s 送信する ChargeQueueStatus
+ * @return シリアライズ済み JSON
+ */
+String buildChargeQueueStatusJson(const ChargeQueueStatus& s)
+{
+  StaticJsonDocument<2048> doc;
+  doc["timeToFree"] = s.timeToFree;
+  doc["capacity"]   = s.capacity;
+  JsonArray reservations = doc.createNestedArray("reservations");
+  for (const ChargeQueueEntry& e : s.reservations) {
+    JsonObject obj = reservations.createNestedObject();
+    obj["ticket"]      = e.ticket;
+    obj["droneId"]     = e.droneId;
+    obj["profile"]     = e.profile;
+    obj["eta"]         = e.eta;
+    obj["waitingTime"] = e.waitingTime;
+  }
+
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+/**
+ * @brief /charge/queue/status JSON を ChargeQueueStatus 構造体へデシリアライズ
+ * @param[in] json 受信した JSON 文字列
+ * @retval ChargeQueueStatus.valid = true  パース成功
+ * @retval ChargeQueueStatus.valid = false パース失敗
+ */
+ChargeQueueStatus parseChargeQueueStatusJson(const String& json)
+{
+  ChargeQueueStatus s{-1, 0, {}, false};
+  StaticJsonDocument<2048> doc;
+  if (!deserialize(json, doc)) return s;
+
+  s.timeToFree = doc["timeToFree"] | -1.0;
+  s.capacity   = doc["capacity"]   | 0;
+  for (JsonObjectConst obj : doc["reservations"].as<JsonArrayConst>()) {
+    ChargeQueueEntry e;
+    e.ticket      = obj["ticket"]      | 0;
+    e.droneId     = obj["droneId"]     | "";
+    e.profile     = obj["profile"]     | "";
+    e.eta         = obj["eta"]         | -1.0;
+    e.waitingTime = obj["waitingTime"] | 0.0;
+    s.reservations.push_back(e);
+  }
   s.valid = true;
   return s;
 }
 
+/* ==============================================================
+ *  PadFreeEvent
+ * ==============================================================*/
+/**
+ * @brief PadFreeEvent 構造体を JSON 文字列にシリアライズ
+ * @param[in] e 送信する PadFreeEvent
+ * @return シリアライズ済み JSON
+ */
+String buildPadFreeEventJson(const PadFreeEvent& e)
+{
+  StaticJsonDocument<384> doc;
+  doc["session"]      = e.session;
+  doc["release"]      = e.release;
+  doc["profile"]      = e.profile;
+  doc["chargingTime"] = e.chargingTime;
+  doc["chargeAmount"] = e.chargeAmount;
+  doc["soc"]          = e.soc;
+  doc["next"]         = e.next;
+  doc["queueLength"]  = e.queueLength;
+
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+/**
+ * @brief /charge/pad/free JSON を PadFreeEvent 構造体へデシリアライズ
+ * @param[in] json 受信した JSON 文字列
+ * @retval PadFreeEvent.valid = true  パース成功
+ * @retval PadFreeEvent.valid = false パース失敗
+ */
+PadFreeEvent parsePadFreeEventJson(const String& json)
+{
+  PadFreeEvent e{0, "", "", 0, 0, -1, "", 0, false};
+  StaticJsonDocument<384> doc;
+  if (!deserialize(json, doc)) return e;
+
+  e.session      = doc["session"]      | 0;
+  e.release      = doc["release"]      | "";
+  e.profile      = doc["profile"]      | "";
+  e.chargingTime = doc["chargingTime"] | 0.0;
+  e.chargeAmount = doc["chargeAmount"] | 0.0;
+  e.soc          = doc["soc"]          | -1.0;
+  e.next         = doc["next"]         | "";
+  e.queueLength  = doc["queueLength"]  | 0;
+  e.valid = true;
+  return e;
+}
+
 /* ==============================================================
  *  Request 共通
  * ==============================================================*/
@@ -93,14 +375,151 @@ static RequestHeader parseRequestJson(const String& json)
 }
 
 /* ---- build wrappers ---- */
-String buildChargeStartRequestJson(const RequestHeader& h){ return buildRequestJson(h); }
 String buildChargeStopRequestJson (const RequestHeader& h){ return buildRequestJson(h); }
 String buildPowerOnRequestJson    (const RequestHeader& h){ return buildRequestJson(h); }
+String buildCalibrateRequestJson  (const RequestHeader& h){ return buildRequestJson(h); }
+String buildLoopStatsResetRequestJson(const RequestHeader& h){ return buildRequestJson(h); }
 
 /* ---- parse wrappers ---- */
-RequestHeader parseChargeStartRequestJson(const String& j){ return parseRequestJson(j); }
 RequestHeader parseChargeStopRequestJson (const String& j){ return parseRequestJson(j); }
 RequestHeader parsePowerOnRequestJson    (const String& j){ return parseRequestJson(j); }
+RequestHeader parseCalibrateRequestJson  (const String& j){ return parseRequestJson(j); }
+RequestHeader parseLoopStatsResetRequestJson(const String& j){ return parseRequestJson(j); }
+
+/* ==============================================================
+ *  ChargeStartRequest
+ * ==============================================================*/
+/**
+ * @brief ChargeStartRequest 構造体を JSON 文字列にシリアライズ
+ * @param[in] r 送信する ChargeStartRequest
+ * @return シリアライズ済み JSON（profile が空なら profile を含まない）
+ */
+String buildChargeStartRequestJson(const ChargeStartRequest& r)
+{
+  StaticJsonDocument<192> doc;
+  doc["timestamp"] = r.header.timestamp;
+  doc["req_id"]    = r.header.req_id;
+  if (r.profile.length() > 0) doc["profile"] = r.profile;
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+/**
+ * @brief /charge/start/request JSON を ChargeStartRequest 構造体へデシリアライズ
+ * @param[in] json 受信した JSON 文字列
+ * @retval ChargeStartRequest.valid = true  パース成功（profile は省略可）
+ * @retval ChargeStartRequest.valid = false パース失敗
+ */
+ChargeStartRequest parseChargeStartRequestJson(const String& json)
+{
+  ChargeStartRequest r{parseRequestJson(json), "", false};
+  if (!r.header.valid) return r;
+  StaticJsonDocument<192> doc;
+  if (!deserialize(json, doc)) return r;
+  r.profile = doc["profile"] | "";
+  r.valid   = true;
+  return r;
+}
+
+/* ==============================================================
+ *  ChargePolicyRequest
+ * ==============================================================*/
+/**
+ * @brief ChargePolicyRequest 構造体を JSON 文字列にシリアライズ
+ * @param[in] r 送信する ChargePolicyRequest
+ * @return シリアライズ済み JSON
+ */
+String buildChargePolicyRequestJson(const ChargePolicyRequest& r)
+{
+  StaticJsonDocument<192> doc;
+  doc["timestamp"] = r.header.timestamp;
+  doc["req_id"]    = r.header.req_id;
+  if (r.targetSoc > 0)        doc["targetSoc"] = r.targetSoc;
+  if (r.profile.length() > 0) doc["profile"]   = r.profile;
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+/**
+ * @brief /charge/policy/request JSON を ChargePolicyRequest 構造体へデシリアライズ
+ * @param[in] json 受信した JSON 文字列
+ * @retval ChargePolicyRequest.valid = true  パース成功
+ * @retval ChargePolicyRequest.valid = false パース失敗（targetSoc・profile ともになしを含む）
+ */
+ChargePolicyRequest parseChargePolicyRequestJson(const String& json)
+{
+  ChargePolicyRequest r{parseRequestJson(json), 0, "", false};
+  if (!r.header.valid) return r;
+  StaticJsonDocument<192> doc;
+  if (!deserialize(json, doc)) return r;
+  if (!doc.containsKey("targetSoc") && !doc.containsKey("profile")) return r;
+  r.targetSoc = doc["targetSoc"] | 0;
+  r.profile   = doc["profile"]   | "";
+  r.valid     = true;
+  return r;
+}
+
+/* ==============================================================
+ *  ChargeQueueRequest
+ * ==============================================================*/
+/**
+ * @brief ChargeQueueRequest 構造体を JSON 文字列にシリアライズ（内部ヘルパ）
+ */
+static String buildQueueRequestJson(const ChargeQueueRequest& r)
+{
+  StaticJsonDocument<256> doc;
+  doc["timestamp"] = r.header.timestamp;
+  doc["req_id"]    = r.header.req_id;
+  if (r.droneId.length() > 0) doc["droneId"] = r.droneId;
+  if (r.profile.length() > 0) doc["profile"] = r.profile;
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+/**
+ * @brief 予約・予約取り消し要求の JSON を ChargeQueueRequest 構造体へデシリアライズ（内部ヘルパ）
+ */
+static ChargeQueueRequest parseQueueRequestJson(const String& json)
+{
+  ChargeQueueRequest r{parseRequestJson(json), "", "", false};
+  if (!r.header.valid) return r;
+  StaticJsonDocument<256> doc;
+  if (!deserialize(json, doc)) return r;
+  r.droneId = doc["droneId"] | "";
+  r.profile = doc["profile"] | "";
+  r.valid   = true;
+  return r;
+}
+
+String buildChargeQueueEnqueueRequestJson(const ChargeQueueRequest& r){ return buildQueueRequestJson(r); }
+String buildChargeQueueDequeueRequestJson(const ChargeQueueRequest& r){ return buildQueueRequestJson(r); }
+
+/**
+ * @brief /charge/queue/enqueue/request JSON を ChargeQueueRequest 構造体へデシリアライズ
+ * @param[in] json 受信した JSON 文字列
+ * @retval ChargeQueueRequest.valid = true  パース成功（profile は省略可）
+ * @retval ChargeQueueRequest.valid = false パース失敗（droneId なしを含む）
+ */
+ChargeQueueRequest parseChargeQueueEnqueueRequestJson(const String& json)
+{
+  ChargeQueueRequest r = parseQueueRequestJson(json);
+  r.valid = r.valid && r.droneId.length() > 0;
+  return r;
+}
+
+/**
+ * @brief /charge/queue/dequeue/request JSON を ChargeQueueRequest 構造体へデシリアライズ
+ * @param[in] json 受信した JSON 文字列
+ * @retval ChargeQueueRequest.valid = true  パース成功（droneId は省略可）
+ * @retval ChargeQueueRequest.valid = false パース失敗
+ */
+ChargeQueueRequest parseChargeQueueDequeueRequestJson(const String& json)
+{
+  return parseQueueRequestJson(json);
+}
 
 /* ==============================================================
  *  Response 共通
@@ -140,8 +559,18 @@ static ResponseHeader parseResponseJson(const String& json)
 String buildChargeStartResponseJson(const ResponseHeader& h){ return buildResponseJson(h); }
 String buildChargeStopResponseJson (const ResponseHeader& h){ return buildResponseJson(h); }
 String buildPowerOnResponseJson    (const ResponseHeader& h){ return buildResponseJson(h); }
+String buildChargePolicyResponseJson(const ResponseHeader& h){ return buildResponseJson(h); }
+String buildCalibrateResponseJson  (const ResponseHeader& h){ return buildResponseJson(h); }
+String buildLoopStatsResetResponseJson(const ResponseHeader& h){ return buildResponseJson(h); }
+String buildChargeQueueEnqueueResponseJson(const ResponseHeader& h){ return buildResponseJson(h); }
+String buildChargeQueueDequeueResponseJson(const ResponseHeader& h){ return buildResponseJson(h); }
 
 /* ---- parse wrappers ---- */
 ResponseHeader parseChargeStartResponseJson(const String& j){ return parseResponseJson(j); }
 ResponseHeader parseChargeStopResponseJson (const String& j){ return parseResponseJson(j); }
 ResponseHeader parsePowerOnResponseJson    (const String& j){ return parseResponseJson(j); }
+ResponseHeader parseChargePolicyResponseJson(const String& j){ return parseResponseJson(j); }
+ResponseHeader parseCalibrateResponseJson  (const String& j){ return parseResponseJson(j); }
+ResponseHeader parseLoopStatsResetResponseJson(const String& j){ return parseResponseJson(j); }
+ResponseHeader parseChargeQueueEnqueueResponseJson(const String& j){ return parseResponseJson(j); }
+ResponseHeader parseChargeQueueDequeueResponseJson(const String& j){ return parseResponseJson(j); }
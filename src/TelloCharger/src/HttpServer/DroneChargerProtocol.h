@@ -2,17 +2,119 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+#include <vector>
+
 /* ---------- ペイロード構造体 ---------- */
 /**
  * @brief 充電状態
  */
 struct ChargeStatus {
+  uint32_t version;
   bool charge;
   float current;
   float chargingTime;
+  float chargeAmount;
+  float chargeEnergy;
+  float busVoltage;
+  float minBusVoltage;
+  float power;
+  uint16_t samplingRate;
+  float soc;
+  float timeToFull;
+  uint8_t targetSoc;
+  String profile;
+  uint8_t sensorHealth;
+  uint32_t sensorFailedCount;
+  uint32_t sensorRecoveredCount;
   bool isStartChargeExecuting;
   bool isStopChargeExecuting;
   bool isPowerOnExecuting;
+  bool isCalibrateExecuting;
+  bool valid;
+};
+
+/**
+ * @brief 統計量
+ */
+struct StatsValue {
+  uint32_t count;
+  float min;
+  float max;
+  float mean;
+  float stddev;
+  float p50;
+  float p95;
+  float p99;
+};
+
+/**
+ * @brief 統計の範囲ごとの統計量
+ */
+struct ChargeStatsScope {
+  StatsValue chargeCurrent;
+  StatsValue servoCurrent;
+  StatsValue loopTime;
+  StatsValue commandLatency;
+};
+
+/**
+ * @brief 統計情報
+ */
+struct ChargeStats {
+  ChargeStatsScope session;
+  ChargeStatsScope lifetime;
+  bool valid;
+};
+
+/**
+ * @brief 制御ループの処理時間・周期の統計量（単位は us）
+ */
+struct LoopStats {
+  StatsValue loop;
+  StatsValue period;
+  StatsValue currentReader;
+  StatsValue startCharge;
+  StatsValue stopCharge;
+  StatsValue powerOnDrone;
+  StatsValue calibrate;
+  StatsValue checkServoCurrent;
+  StatsValue servo;
+  bool valid;
+};
+
+/**
+ * @brief 充電ベイの予約
+ */
+struct ChargeQueueEntry {
+  uint32_t ticket;
+  String droneId;
+  String profile;
+  float eta;          // 充電ベイが空くまでの推定時間[sec]（推定不可なら -1）
+  float waitingTime;  // 予約してからの経過時間[sec]
+};
+
+/**
+ * @brief 充電ベイの予約キューの状態
+ */
+struct ChargeQueueStatus {
+  float timeToFree;  // 充電ベイが空くまでの推定時間[sec]（空いていれば 0）
+  uint8_t capacity;
+  std::vector<ChargeQueueEntry> reservations;  // 受付順
+  bool valid;
+};
+
+/**
+ * @brief 充電ベイが空いたことの通知
+ */
+struct PadFreeEvent {
+  uint32_t session;  // 起動からの充電の通し番号
+  String release;    // 充電の終了理由
+  String profile;
+  float chargingTime;
+  float chargeAmount;
+  float soc;
+  String next;  // 予約の先頭のドローンID（予約がなければ空）
+  uint8_t queueLength;
   bool valid;
 };
 
@@ -25,6 +127,35 @@ struct RequestHeader {
   bool valid;
 };
 
+/**
+ * @brief 充電開始要求
+ */
+struct ChargeStartRequest {
+  RequestHeader header;
+  String profile;  // 空なら既定のプロファイル
+  bool valid;
+};
+
+/**
+ * @brief 充電ポリシー変更要求
+ */
+struct ChargePolicyRequest {
+  RequestHeader header;
+  uint8_t targetSoc;  // 0 なら変更しない
+  String profile;     // 空なら変更しない
+  bool valid;
+};
+
+/**
+ * @brief 充電ベイの予約・予約取り消し要求
+ */
+struct ChargeQueueRequest {
+  RequestHeader header;
+  String droneId;  // 予約取り消しで空なら先頭の予約
+  String profile;  // 予約のみ。空なら既定のプロファイル
+  bool valid;
+};
+
 /**
  * @brief レスポンスヘッダ
  */
@@ -37,18 +168,46 @@ struct ResponseHeader {
 
 /* ---------- 送信用ビルド関数（構造体 → JSON） ---------- */
 String buildChargeStatusJson(const ChargeStatus& src);
-String buildChargeStartRequestJson(const RequestHeader& src);
+String buildChargeStatsJson(const ChargeStats& src);
+String buildLoopStatsJson(const LoopStats& src);
+String buildChargeQueueStatusJson(const ChargeQueueStatus& src);
+String buildPadFreeEventJson(const PadFreeEvent& src);
+String buildChargeStartRequestJson(const ChargeStartRequest& src);
 String buildChargeStopRequestJson(const RequestHeader& src);
 String buildPowerOnRequestJson(const RequestHeader& src);
+String buildChargePolicyRequestJson(const ChargePolicyRequest& src);
+String buildCalibrateRequestJson(const RequestHeader& src);
+String buildLoopStatsResetRequestJson(const RequestHeader& src);
+String buildChargeQueueEnqueueRequestJson(const ChargeQueueRequest& src);
+String buildChargeQueueDequeueRequestJson(const ChargeQueueRequest& src);
 String buildChargeStartResponseJson(const ResponseHeader& src);
 String buildChargeStopResponseJson(const ResponseHeader& src);
 String buildPowerOnResponseJson(const ResponseHeader& src);
+String buildChargePolicyResponseJson(const ResponseHeader& src);
+String buildCalibrateResponseJson(const ResponseHeader& src);
+String buildLoopStatsResetResponseJson(const ResponseHeader& src);
+String buildChargeQueueEnqueueResponseJson(const ResponseHeader& src);
+String buildChargeQueueDequeueResponseJson(const ResponseHeader& src);
 
 /* ---------- 受信用パース関数（JSON →構造体） ---------- */
 ChargeStatus parseChargeStatusJson(const String& json);
-RequestHeader parseChargeStartRequestJson(const String& json);
+ChargeStats parseChargeStatsJson(const String& json);
+LoopStats parseLoopStatsJson(const String& json);
+ChargeQueueStatus parseChargeQueueStatusJson(const String& json);
+PadFreeEvent parsePadFreeEventJson(const String& json);
+ChargeStartRequest parseChargeStartRequestJson(const String& json);
 RequestHeader parseChargeStopRequestJson(const String& json);
 RequestHeader parsePowerOnRequestJson(const String& json);
+ChargePolicyRequest parseChargePolicyRequestJson(const String& json);
+RequestHeader parseCalibrateRequestJson(const String& json);
+RequestHeader parseLoopStatsResetRequestJson(const String& json);
+ChargeQueueRequest parseChargeQueueEnqueueRequestJson(const String& json);
+ChargeQueueRequest parseChargeQueueDequeueRequestJson(const String& json);
 ResponseHeader parseChargeStartResponseJson(const String& json);
 ResponseHeader parseChargeStopResponseJson(const String& json);
 ResponseHeader parsePowerOnResponseJson(const String& json);
+ResponseHeader parseChargePolicyResponseJson(const String& json);
+ResponseHeader parseCalibrateResponseJson(const String& json);
+ResponseHeader parseLoopStatsResetResponseJson(const String& json);
+ResponseHeader parseChargeQueueEnqueueResponseJson(const String& json);
+ResponseHeader parseChargeQueueDequeueResponseJson(const String& json);
@@ -9,16 +9,20 @@
 
 #include "HttpServer.h"
 
-ChargeController *HttpServer::_charger = nullptr;
+#include <memory>
+#include <vector>
+
+ChargeStation *HttpServer::_station = nullptr;
 
 /**
  * @brief Construct a new Http Server:: Http Server object
  *
  * @param httpPort 待ち受けポート番号
+ * @param station 充電ステーション
  */
-HttpServer::HttpServer(uint16_t httpPort, ChargeController *charger)
+HttpServer::HttpServer(uint16_t httpPort, ChargeStation *station)
     : _server(AsyncWebServer(httpPort)), _bAvailable(false) {
-  _charger = charger;
+  _station = station;
   _defineApi();
   _server.onNotFound(_notFound);
   DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
@@ -74,16 +78,50 @@ void HttpServer::_notFound(AsyncWebServerRequest *request) {
  * @brief 充電状態取得要求
  *
  * @param request
+ * @param charger 対象の充電ベイの充電制御部
  */
-void HttpServer::_onChargeGet(AsyncWebServerRequest *request) {
+void HttpServer::_onChargeGet(AsyncWebServerRequest *request,
+                              ChargeController *charger) {
+  ChargeSnapshot snapshot = charger->getSnapshot();
   AsyncJsonResponse *response = new AsyncJsonResponse();
   JsonObject root = response->getRoot();
-  root["charge"] = _charger->isCharging();
-  root["current"] = _charger->getCurrent();
-  root["chargingTime"] = _charger->getChargeTimeSec();
-  root["isStartChargeExecuting"] = _charger->isStartChargeExecuting();
-  root["isStopChargeExecuting"] = _charger->isStopChargeExecuting();
-  root["isPowerOnExecuting"] = _charger->isPowerOnExecuting();
+  root["version"] = snapshot.version;
+  root["charge"] = snapshot.isCharging;
+  root["current"] = snapshot.current;
+  root["chargingTime"] = snapshot.chargeTime;
+  root["chargeAmount"] = snapshot.chargeAmount;
+  root["chargeEnergy"] = snapshot.chargeEnergy;
+  root["busVoltage"] = snapshot.busVoltage;
+  root["minBusVoltage"] = snapshot.minBusVoltage;
+  root["power"] = snapshot.power;
+  root["samplingRate"] = snapshot.samplingRate;
+  root["chargePhase"] = (int)snapshot.chargePhase;
+  root["soc"] = snapshot.soc;
+  root["timeToFull"] = snapshot.timeToFull;
+  root["targetSoc"] = snapshot.targetSoc;
+  root["profile"] = ChargePolicy::getName(snapshot.profile);
+  JsonObject sensor = root.createNestedObject("sensor");
+  sensor["health"] = (int)snapshot.sensorHealth;
+  sensor["failedCount"] = snapshot.sensorFailedCount;
+  sensor["recoveredCount"] = snapshot.sensorRecoveredCount;
+  JsonObject samplingTime = root.createNestedObject("samplingTime");
+  samplingTime["low"] =
+      snapshot.samplingModeTime[CurrentReader::SAMPLING_LOW] / 1000.0;
+  samplingTime["normal"] =
+      snapshot.samplingModeTime[CurrentReader::SAMPLING_NORMAL] / 1000.0;
+  samplingTime["high"] =
+      snapshot.samplingModeTime[CurrentReader::SAMPLING_HIGH] / 1000.0;
+  root["isStartChargeExecuting"] = snapshot.isStartChargeExecuting;
+  root["isStopChargeExecuting"] = snapshot.isStopChargeExecuting;
+  root["isPowerOnExecuting"] = snapshot.isPowerOnExecuting;
+  root["isCalibrateExecuting"] = snapshot.isCalibrateExecuting;
+  PowerSample sample = snapshot.latestSample;
+  JsonObject latest = root.createNestedObject("latestSample");
+  latest["time"] = sample.time;
+  latest["busVoltage"] = sample.busVoltage;
+  latest["shuntVoltage"] = sample.shuntVoltage;
+  latest["current"] = sample.current;
+  latest["power"] = sample.power;
   response->setLength();
   request->send(response);
   String str = "";
@@ -96,50 +134,906 @@ void HttpServer::_onChargeGet(AsyncWebServerRequest *request) {
  *
  * @param request
  * @param json
+ * @param charger 対象の充電ベイの充電制御部
  */
 void HttpServer::_onChargePut(AsyncWebServerRequest *request,
-                              JsonVariant &json) {
+                              JsonVariant &json, ChargeController *charger) {
   JsonObject jsonObj = json.as<JsonObject>();
   String str = "";
   serializeJson(jsonObj, str);
   logger.info("onChargePut: recieve " + str);
-  if (jsonObj.containsKey("charge")) {
-    bool charge = jsonObj["charge"];
-    if (charge)
-      _charger->startCharge();
-    else
-      _charger->stopCharge();
-
-    // レスポンス
-    request->send(200);
-    logger.info("onChargePut: send 200 ok");
-  } else {
+  if (!jsonObj.containsKey("charge") && !jsonObj.containsKey("targetSoc")) {
     // chargeのキーがない
     request->send(400);
     logger.info("onChargePut: send 400 Bad Request");
+    return;
+  }
+  ChargePolicy::ProfileType profile = ChargePolicy::PROFILE_NUM;
+  if (jsonObj.containsKey("profile")) {
+    profile = ChargePolicy::findByName(jsonObj["profile"].as<const char *>());
+    if (profile == ChargePolicy::PROFILE_NUM) {
+      // 未知のプロファイル
+      request->send(400);
+      logger.info("onChargePut: send 400 Bad Request");
+      return;
+    }
+  }
+  // 充電開始でリリースする充電率がプロファイルの値に戻るため、充電開始を先に送る
+  CommandFuture future;
+  if (jsonObj.containsKey("charge")) {
+    bool charge = jsonObj["charge"];
+    ChargeCommand command(charge ? ChargeCommand::COMMAND_START_CHARGE
+                                 : ChargeCommand::COMMAND_STOP_CHARGE,
+                          ChargeCommand::SOURCE_HTTP);
+    if (profile != ChargePolicy::PROFILE_NUM) command.profile = profile;
+    future = charger->submit(command);
+    if (future.getStatus() == CommandFuture::STATUS_REJECTED) {
+      _sendCommandResponse(request, future, "onChargePut");
+      return;
+    }
   }
+  if (jsonObj.containsKey("targetSoc")) {
+    // コマンドは送信順に実行されるため、最後のコマンドの実行結果を返せばよい
+    ChargeCommand command(ChargeCommand::COMMAND_SET_TARGET_SOC,
+                          ChargeCommand::SOURCE_HTTP);
+    command.targetSoc = jsonObj["targetSoc"].as<uint8_t>();
+    future = charger->submit(command);
+  }
+  _sendCommandResponse(request, future, "onChargePut");
 }
 
 /**
  * @brief ドローン電源ON要求
  *
  * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onPowerOnPut(AsyncWebServerRequest *request,
+                               ChargeController *charger) {
+  CommandFuture future = charger->submit(ChargeCommand(
+      ChargeCommand::COMMAND_POWER_ON_DRONE, ChargeCommand::SOURCE_HTTP));
+  _sendCommandResponse(request, future, "onPowerOnPut");
+}
+
+/**
+ * @brief サーボ角度テーブル取得要求
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onCalibrationGet(AsyncWebServerRequest *request,
+                                   ChargeController *charger) {
+  const char *results[] = {"none", "succeeded", "failed"};
+  ChargeSnapshot snapshot = charger->getSnapshot();
+  ServoCalibration *calibration = charger->getServoCalibration();
+  AsyncJsonResponse *response = new AsyncJsonResponse();
+  JsonObject root = response->getRoot();
+  root["isExecuting"] = snapshot.isCalibrateExecuting;
+  root["result"] = results[snapshot.calibrateResult];
+  root["source"] = calibration->isLoaded() ? "nvs" : "default";
+  JsonObject angles = root.createNestedObject("angles");
+  for (uint8_t type = 0; type < ServoCalibration::ANGLE_TYPE_NUM; type++) {
+    ServoCalibration::ServoAngleType angleType =
+        (ServoCalibration::ServoAngleType)type;
+    angles[ServoCalibration::getName(angleType)] =
+        calibration->getAngle(angleType);
+  }
+  JsonObject flags = root.createNestedObject("flags");
+  flags[ServoCalibration::getFlagName(ServoCalibration::FLAG_FAST_MOTION)] =
+      calibration->hasFlag(ServoCalibration::FLAG_FAST_MOTION);
+  flags[ServoCalibration::getFlagName(ServoCalibration::FLAG_USB_CLEAR)] =
+      calibration->hasFlag(ServoCalibration::FLAG_USB_CLEAR);
+  response->setLength();
+  request->send(response);
+  logger.info("onCalibrationGet: send 200 ok");
+}
+
+/**
+ * @brief アーム角度自動キャリブレーション開始要求
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onCalibrationPut(AsyncWebServerRequest *request,
+                                   ChargeController *charger) {
+  CommandFuture future = charger->submit(ChargeCommand(
+      ChargeCommand::COMMAND_CALIBRATE, ChargeCommand::SOURCE_HTTP));
+  _sendCommandResponse(request, future, "onCalibrationPut");
+}
+
+/**
+ * @brief 充電ポリシー取得要求
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onPolicyGet(AsyncWebServerRequest *request,
+                              ChargeController *charger) {
+  AsyncJsonResponse *response = new AsyncJsonResponse(false, 2048);
+  _setPolicy(response->getRoot(), charger);
+  response->setLength();
+  request->send(response);
+  logger.info("onPolicyGet: send 200 ok");
+}
+
+/**
+ * @brief 充電ポリシー変更要求
+ *
+ * @details profiles にプロファイル名をキーとして変更する項目のみを指定する。
+ * default で充電開始要求にプロファイルの指定がないときのプロファイルを
+ * 変更する。変更はNVSに保存し、次の充電開始から反映する。
+ * 1つでも不正な値があれば何も変更せずに400を返す
+ *
+ * @param request
+ * @param json
+ * @param charger 対象の充電ベイの充電制御部
  */
-void HttpServer::_onPowerOnPut(AsyncWebServerRequest *request) {
-  _charger->powerOnDrone();
+void HttpServer::_onPolicyPut(AsyncWebServerRequest *request,
+                              JsonVariant &json, ChargeController *charger) {
+  JsonObject jsonObj = json.as<JsonObject>();
+  String str = "";
+  serializeJson(jsonObj, str);
+  logger.info("onPolicyPut: recieve " + str);
+  ChargePolicy *policy = charger->getPolicy();
+  ChargePolicy::ProfileType defaultType = policy->getDefault();
+  if (jsonObj.containsKey("default")) {
+    defaultType =
+        ChargePolicy::findByName(jsonObj["default"].as<const char *>());
+  }
+  bool isValid = defaultType != ChargePolicy::PROFILE_NUM;
+  ChargeProfile profiles[ChargePolicy::PROFILE_NUM];
+  JsonObject values = jsonObj["profiles"];
+  for (uint8_t i = 0; i < ChargePolicy::PROFILE_NUM; i++) {
+    ChargePolicy::ProfileType type = (ChargePolicy::ProfileType)i;
+    profiles[i] = policy->getProfile(type);
+    JsonObject value = values[ChargePolicy::getName(type)];
+    if (value.isNull()) continue;
+    ChargeProfile &p = profiles[i];
+    p.chargingCurrent = value["chargingCurrent"] | p.chargingCurrent;
+    p.stopCurrent = value["stopCurrent"] | p.stopCurrent;
+    p.fullChargeTime = value["fullChargeTime"] | p.fullChargeTime;
+    p.noCurrentTime = value["noCurrentTime"] | p.noCurrentTime;
+    p.targetSoc = value["targetSoc"] | p.targetSoc;
+    p.catchCnt = value["catchCnt"] | p.catchCnt;
+    p.retryCnt = value["retryCnt"] | p.retryCnt;
+    isValid = isValid && ChargePolicy::isValid(p);
+  }
+  if (!isValid) {
+    request->send(400);
+    logger.info("onPolicyPut: send 400 Bad Request");
+    return;
+  }
+  for (uint8_t i = 0; i < ChargePolicy::PROFILE_NUM; i++) {
+    policy->setProfile((ChargePolicy::ProfileType)i, profiles[i]);
+  }
+  policy->setDefault(defaultType);
+  if (!policy->save()) {
+    request->send(500);
+    logger.warn("onPolicyPut: send 500 Internal Server Error");
+    return;
+  }
+
   // レスポンス
+  AsyncJsonResponse *response = new AsyncJsonResponse(false, 2048);
+  _setPolicy(response->getRoot(), charger);
+  response->setLength();
+  request->send(response);
+  logger.info("onPolicyPut: send 200 ok");
+}
+
+/**
+ * @brief 充電ポリシーをJSONに設定する
+ *
+ * @param obj 設定先
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_setPolicy(JsonObject obj, ChargeController *charger) {
+  ChargePolicy *policy = charger->getPolicy();
+  obj["default"] = ChargePolicy::getName(policy->getDefault());
+  obj["active"] = ChargePolicy::getName(charger->getProfileType());
+  obj["source"] = policy->isLoaded() ? "nvs" : "default";
+  JsonObject profiles = obj.createNestedObject("profiles");
+  for (uint8_t i = 0; i < ChargePolicy::PROFILE_NUM; i++) {
+    ChargePolicy::ProfileType type = (ChargePolicy::ProfileType)i;
+    ChargeProfile profile = policy->getProfile(type);
+    JsonObject value = profiles.createNestedObject(ChargePolicy::getName(type));
+    value["chargingCurrent"] = profile.chargingCurrent;
+    value["stopCurrent"] = profile.stopCurrent;
+    value["fullChargeTime"] = profile.fullChargeTime;
+    value["noCurrentTime"] = profile.noCurrentTime;
+    value["targetSoc"] = profile.targetSoc;
+    value["catchCnt"] = profile.catchCnt;
+    value["retryCnt"] = profile.retryCnt;
+  }
+}
+
+/**
+ * @brief 充電ベイの予約キュー取得要求
+ *
+ * @details 予約を受付順に、充電ベイが空くまでの推定待ち時間とともに返す。
+ * クエリパラメータ droneId を指定すればその予約のみを返す（なければ404）
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onQueueGet(AsyncWebServerRequest *request,
+                             ChargeController *charger) {
+  if (request->hasParam("droneId")) {
+    _sendReservation(request, charger,
+                     request->getParam("droneId")->value().c_str(), 200,
+                     "onQueueGet");
+    return;
+  }
+  ChargeSnapshot snapshot = charger->getSnapshot();
+  ChargeReservation reservations[ChargeQueue::QUEUE_SIZE];
+  float etas[ChargeQueue::QUEUE_SIZE];
+  ChargePolicy::ProfileType defaultProfile = charger->getPolicy()->getDefault();
+  uint8_t length = charger->getQueue()->estimate(
+      snapshot, defaultProfile, reservations, etas, ChargeQueue::QUEUE_SIZE);
+
+  AsyncJsonResponse *response = new AsyncJsonResponse(false, 2048);
+  JsonObject root = response->getRoot();
+  root["timeToFree"] = snapshot.timeToRelease;
+  root["capacity"] = ChargeQueue::QUEUE_SIZE;
+  JsonArray array = root.createNestedArray("reservations");
+  for (uint8_t i = 0; i < length; i++) {
+    JsonObject obj = array.createNestedObject();
+    _setReservation(obj, reservations[i], defaultProfile);
+    obj["position"] = i;
+    obj["eta"] = etas[i];
+  }
+  response->setLength();
+  request->send(response);
+  logger.info("onQueueGet: send 200 ok");
+}
+
+/**
+ * @brief 充電ベイの予約要求
+ *
+ * @details droneId の予約を末尾に追加し、推定待ち時間とともに201を返す。
+ * profile を省略すれば充電開始時の既定のプロファイルで充電する。
+ * ドローンID・プロファイルが不正なら400、予約済みなら409、
+ * キューが一杯なら503を返す
+ *
+ * @param request
+ * @param json
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onQueuePost(AsyncWebServerRequest *request,
+                              JsonVariant &json, ChargeController *charger) {
+  JsonObject jsonObj = json.as<JsonObject>();
+  String str = "";
+  serializeJson(jsonObj, str);
+  logger.info("onQueuePost: recieve " + str);
+  const char *droneId = jsonObj["droneId"] | "";
+  uint8_t profile = ChargeCommand::PROFILE_DEFAULT;
+  if (jsonObj.containsKey("profile")) {
+    profile = ChargePolicy::findByName(jsonObj["profile"].as<const char *>());
+    if (profile == ChargePolicy::PROFILE_NUM) {
+      request->send(400);
+      logger.info("onQueuePost: send 400 Bad Request");
+      return;
+    }
+  }
+  ChargeReservation reservation;
+  switch (charger->getQueue()->enqueue(droneId, profile, reservation)) {
+    case ChargeQueue::RESULT_OK:
+      _sendReservation(request, charger, reservation.droneId, 201,
+                       "onQueuePost");
+      break;
+    case ChargeQueue::RESULT_DUPLICATE:
+      request->send(409);
+      logger.info("onQueuePost: send 409 Conflict");
+      break;
+    case ChargeQueue::RESULT_FULL:
+      request->send(503);
+      logger.warn("onQueuePost: send 503 Service Unavailable");
+      break;
+    default:
+      request->send(400);
+      logger.info("onQueuePost: send 400 Bad Request");
+      break;
+  }
+}
+
+/**
+ * @brief 予約の取り出し要求
+ *
+ * @details クエリパラメータ droneId を指定すればその予約を取り消し、
+ * 省略すれば先頭の予約を取り出して、取り出した予約を返す。
+ * 予約がなければ404を返す
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onQueueDelete(AsyncWebServerRequest *request,
+                                ChargeController *charger) {
+  String droneId = request->hasParam("droneId")
+                       ? request->getParam("droneId")->value()
+                       : String("");
+  ChargeReservation reservation;
+  if (charger->getQueue()->dequeue(droneId.c_str(), reservation) !=
+      ChargeQueue::RESULT_OK) {
+    request->send(404);
+    logger.info("onQueueDelete: send 404 Not Found");
+    return;
+  }
+  AsyncJsonResponse *response = new AsyncJsonResponse(false, 256);
+  _setReservation(response->getRoot(), reservation,
+                  charger->getPolicy()->getDefault());
+  response->setLength();
+  request->send(response);
+  logger.info("onQueueDelete: send 200 ok");
+}
+
+/**
+ * @brief 予約を推定待ち時間とともに応答する
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ * @param droneId ドローンID（予約がなければ404を返す）
+ * @param code 予約があるときのステータスコード
+ * @param handler ログ出力用のハンドラ名
+ */
+void HttpServer::_sendReservation(AsyncWebServerRequest *request,
+                                  ChargeController *charger,
+                                  const char *droneId, int code,
+                                  const char *handler) {
+  ChargeSnapshot snapshot = charger->getSnapshot();
+  ChargeReservation reservations[ChargeQueue::QUEUE_SIZE];
+  float etas[ChargeQueue::QUEUE_SIZE];
+  ChargePolicy::ProfileType defaultProfile = charger->getPolicy()->getDefault();
+  uint8_t length = charger->getQueue()->estimate(
+      snapshot, defaultProfile, reservations, etas, ChargeQueue::QUEUE_SIZE);
+  for (uint8_t i = 0; i < length; i++) {
+    if (strcmp(reservations[i].droneId, droneId) != 0) continue;
+    AsyncJsonResponse *response = new AsyncJsonResponse(false, 256);
+    JsonObject root = response->getRoot();
+    _setReservation(root, reservations[i], defaultProfile);
+    root["position"] = i;
+    root["eta"] = etas[i];
+    response->setCode(code);
+    response->setLength();
+    request->send(response);
+    logger.info(String(handler) + ": send " + String(code));
+    return;
+  }
+  request->send(404);
+  logger.info(String(handler) + ": send 404 Not Found");
+}
+
+/**
+ * @brief 予約をJSONに設定する
+ *
+ * @param obj 設定先
+ * @param reservation 予約
+ * @param defaultProfile プロファイルの指定がない予約のプロファイル
+ */
+void HttpServer::_setReservation(JsonObject obj,
+                                 const ChargeReservation &reservation,
+                                 ChargePolicy::ProfileType defaultProfile) {
+  obj["ticket"] = reservation.ticket;
+  obj["droneId"] = reservation.droneId;
+  obj["profile"] =
+      ChargePolicy::getName(reservation.getProfile(defaultProfile));
+  obj["waitingTime"] = (millis() - reservation.time) / 1000.0f;
+}
+
+/**
+ * @brief コマンドの実行結果を応答する
+ *
+ * @details 通信タスク（AsyncTCP）を止めないよう実行の完了は待たない。
+ * 実行済みなら200、実行待ちなら受付済みとして202とコマンド番号
+ * （GET /command で実行結果を参照できる）、キューが一杯で受け付けられなければ
+ * 503を返す。制御ループが実行を拒否していれば409、実行できなければ500を返す
+ *
+ * @param request
+ * @param future 送信したコマンドのハンドル
+ * @param handler ログ出力用のハンドラ名
+ */
+void HttpServer::_sendCommandResponse(AsyncWebServerRequest *request,
+                                      CommandFuture future,
+                                      const char *handler) {
+  switch (future.getStatus()) {
+    case CommandFuture::STATUS_DONE:
+      request->send(200);
+      logger.info(String(handler) + ": send 200 ok");
+      break;
+    case CommandFuture::STATUS_PENDING: {
+      AsyncJsonResponse *response = new AsyncJsonResponse();
+      JsonObject root = response->getRoot();
+      root["commandId"] = future.getSequence();
+      response->setCode(202);
+      response->setLength();
+      request->send(response);
+      logger.info(String(handler) + ": send 202 Accepted");
+      break;
+    }
+    case CommandFuture::STATUS_REFUSED:
+      request->send(409);
+      logger.warn(String(handler) + ": send 409 Conflict");
+      break;
+    case CommandFuture::STATUS_FAILED:
+      request->send(500);
+      logger.error(String(handler) + ": send 500 Internal Server Error");
+      break;
+    default:
+      request->send(503);
+      logger.warn(String(handler) + ": send 503 Service Unavailable");
+      break;
+  }
+}
+
+/**
+ * @brief 実行済みのコマンドの実行結果を表す文字列を取得する
+ *
+ * @param status 実行結果
+ * @return const char* 実行結果（accepted:受理, rejected:拒否, failed:失敗,
+ * unknown:不明）
+ */
+const char *HttpServer::_getCommandResultName(
+    CommandFuture::StatusType status) {
+  switch (status) {
+    case CommandFuture::STATUS_DONE:
+      return "accepted";
+    case CommandFuture::STATUS_REFUSED:
+      return "rejected";
+    case CommandFuture::STATUS_FAILED:
+      return "failed";
+    default:
+      return "unknown";
+  }
+}
+
+/**
+ * @brief コマンドの実行結果取得要求
+ *
+ * @details 202応答で返したコマンド番号をクエリ文字列 id で指定する。
+ * 実行済みなら実行結果（受理・拒否・失敗）も返す。結果の保持期間を
+ * 過ぎたコマンドの実行結果は不明とする
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onCommandGet(AsyncWebServerRequest *request,
+                               ChargeController *charger) {
+  if (!request->hasParam("id")) {
+    request->send(400);
+    logger.info("onCommandGet: send 400 Bad Request");
+    return;
+  }
+  uint32_t id = strtoul(request->getParam("id")->value().c_str(), NULL, 10);
+  CommandFuture future = charger->findCommand(id);
+  if (future.getStatus() == CommandFuture::STATUS_REJECTED) {
+    request->send(404);
+    logger.info("onCommandGet: send 404 Not Found");
+    return;
+  }
+  AsyncJsonResponse *response = new AsyncJsonResponse();
+  JsonObject root = response->getRoot();
+  root["commandId"] = id;
+  CommandFuture::StatusType status = future.getStatus();
+  root["status"] = status == CommandFuture::STATUS_PENDING ? "pending" : "done";
+  if (status != CommandFuture::STATUS_PENDING) {
+    root["result"] = _getCommandResultName(status);
+  }
+  response->setLength();
+  request->send(response);
+  logger.info("onCommandGet: send 200 ok");
+}
+
+/**
+ * @brief 電流波形キャプチャ取得要求
+ *
+ * @details 凍結済みの波形をバイナリ形式（CurrentCapture.h参照）で返す。
+ * 波形が凍結されていなければ204を返す。
+ * 送信中にキャプチャが再開（arm）されても壊れた波形を返さないよう、
+ * 送信開始時に波形を複写し、複写から分割して送信する
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onCaptureGet(AsyncWebServerRequest *request,
+                               ChargeController *charger) {
+  CurrentCapture *capture = charger->getCapture();
+  size_t size = capture->getBinarySize();
+  if (size == 0) {
+    request->send(204);
+    logger.info("onCaptureGet: send 204 No Content");
+    return;
+  }
+  // 複写は凍結中に同じタスク（armと同じ通信タスク）で行うため競合しない
+  std::shared_ptr<std::vector<uint8_t>> binary(new std::vector<uint8_t>(size));
+  size = capture->readBinary(binary->data(), size, 0);
+  // 波形は数KBあるため、送信バッファに分割して書き込む
+  AsyncWebServerResponse *response = request->beginResponse(
+      "application/octet-stream", size,
+      [binary, size](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        if (index >= size) return 0;
+        size_t len = min(maxLen, size - index);
+        memcpy(buffer, binary->data() + index, len);
+        return len;
+      });
+  request->send(response);
+  logger.info("onCaptureGet: send " + String(size) + " bytes");
+}
+
+/**
+ * @brief 状態遷移トレース取得要求
+ *
+ * @details 直近の状態遷移の記録をバイナリ形式（TraceRecorder.h参照）で返す。
+ * source=flashでNVSに保存した記録を返す。記録がなければ204を返す。
+ * 送信中に次の取得要求・保存要求で出力用の記録が上書きされても
+ * 混ざった記録を返さないよう、送信開始時に複写し、複写から分割して送信する
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onTraceGet(AsyncWebServerRequest *request,
+                             ChargeController *charger) {
+  TraceRecorder *trace = charger->getTrace();
+  bool isFlash = request->hasParam("source") &&
+                 request->getParam("source")->value() == "flash";
+  trace->prepare(isFlash ? TraceRecorder::SOURCE_FLASH
+                         : TraceRecorder::SOURCE_RAM);
+  size_t size = trace->getBinarySize();
+  if (size == 0) {
+    request->send(204);
+    logger.info("onTraceGet: send 204 No Content");
+    return;
+  }
+  // 出力用の記録の準備・複写・保存はすべて通信タスクで行うため競合しない
+  std::shared_ptr<std::vector<uint8_t>> binary(new std::vector<uint8_t>(size));
+  size = trace->readBinary(binary->data(), size, 0);
+  AsyncWebServerResponse *response = request->beginResponse(
+      "application/octet-stream", size,
+      [binary, size](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        if (index >= size) return 0;
+        size_t len = min(maxLen, size - index);
+        memcpy(buffer, binary->data() + index, len);
+        return len;
+      });
+  request->send(response);
+  logger.info("onTraceGet: send " + String(size) + " bytes");
+}
+
+/**
+ * @brief 状態遷移トレース保存要求
+ *
+ * @details 直近の状態遷移の記録をNVSに保存する（再起動後も取得できる）
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onTraceFlushPut(AsyncWebServerRequest *request,
+                                  ChargeController *charger) {
+  if (!charger->getTrace()->flush()) {
+    request->send(500);
+    logger.warn("onTraceFlushPut: send 500 Internal Server Error");
+    return;
+  }
+  request->send(200);
+  logger.info("onTraceFlushPut: send 200 ok");
+}
+
+/**
+ * @brief 電流波形キャプチャ設定要求
+ *
+ * @details threshold[mA]でしきい値トリガを設定（0以下で無効）、
+ * armで次の波形の待ち受けを再開、triggerで手動トリガする
+ *
+ * @param request
+ * @param json
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onCapturePut(AsyncWebServerRequest *request,
+                               JsonVariant &json, ChargeController *charger) {
+  JsonObject jsonObj = json.as<JsonObject>();
+  String str = "";
+  serializeJson(jsonObj, str);
+  logger.info("onCapturePut: recieve " + str);
+  CurrentCapture *capture = charger->getCapture();
+  if (jsonObj.containsKey("threshold")) {
+    capture->setThreshold(jsonObj["threshold"].as<float>());
+  }
+  if (jsonObj["arm"] | false) capture->arm();
+  if (jsonObj["trigger"] | false) {
+    capture->trigger(CurrentCapture::TRIGGER_MANUAL);
+  }
+
+  // レスポンス
+  AsyncJsonResponse *response = new AsyncJsonResponse();
+  JsonObject root = response->getRoot();
+  root["state"] = (int)capture->getState();
+  root["threshold"] = capture->getThreshold();
+  response->setLength();
+  request->send(response);
+  logger.info("onCapturePut: send 200 ok");
+}
+
+/**
+ * @brief 統計情報取得要求
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onStatsGet(AsyncWebServerRequest *request,
+                             ChargeController *charger) {
+  AsyncJsonResponse *response = new AsyncJsonResponse(false, 2048);
+  JsonObject root = response->getRoot();
+  _setStats(root.createNestedObject("session"), charger,
+            ChargeController::STATS_SESSION);
+  _setStats(root.createNestedObject("lifetime"), charger,
+            ChargeController::STATS_LIFETIME);
+  response->setLength();
+  request->send(response);
+  logger.info("onStatsGet: send 200 ok");
+}
+
+/**
+ * @brief 統計の範囲ごとの統計量をJSONに設定する
+ *
+ * @param obj 設定先
+ * @param charger 対象の充電ベイの充電制御部
+ * @param scope 統計の範囲
+ */
+void HttpServer::_setStats(JsonObject obj, ChargeController *charger,
+                           ChargeController::StatsScopeType scope) {
+  const char *names[ChargeController::STATS_TYPE_NUM] = {
+      "chargeCurrent", "servoCurrent", "loopTime", "commandLatency"};
+  for (uint8_t type = 0; type < ChargeController::STATS_TYPE_NUM; type++) {
+    StreamingStats *stats =
+        charger->getStats((ChargeController::StatsType)type, scope);
+    JsonObject value = obj.createNestedObject(names[type]);
+    value["count"] = stats->getCount();
+    value["min"] = stats->getMin();
+    value["max"] = stats->getMax();
+    value["mean"] = stats->getMean();
+    value["stddev"] = stats->getStdDev();
+    value["p50"] = stats->getP50();
+    value["p95"] = stats->getP95();
+    value["p99"] = stats->getP99();
+  }
+}
+
+/**
+ * @brief 制御の状態遷移の統計取得要求
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onControlStatsGet(AsyncWebServerRequest *request,
+                                    ChargeController *charger) {
+  const char *names[ChargeController::CONTROL_TYPE_NUM] = {
+      "startCharge", "stopCharge", "powerOnDrone", "calibrate",
+      "checkServoCurrent"};
+  AsyncJsonResponse *response = new AsyncJsonResponse(false, 8192);
+  JsonObject root = response->getRoot();
+  for (uint8_t type = 0; type < ChargeController::CONTROL_TYPE_NUM; type++) {
+    _setControlStats(
+        root.createNestedObject(names[type]),
+        charger->getControl((ChargeController::ControlType)type));
+  }
+  response->setLength();
+  request->send(response);
+  logger.info("onControlStatsGet: send 200 ok");
+}
+
+/**
+ * @brief 制御の状態遷移の統計をJSONに設定する
+ *
+ * @details 子制御はクラス名をキーとしてchildrenに設定する
+ *
+ * @param obj 設定先
+ * @param control 制御部
+ */
+void HttpServer::_setControlStats(JsonObject obj, ControlBase *control) {
+  StateMachineBase *machine = control->getStateMachine();
+  obj["state"] = machine->getStateName(machine->getState());
+  obj["transitions"] = machine->getTransitionCount();
+  obj["droppedEvents"] = machine->getDroppedEventCount();
+  JsonObject states = obj.createNestedObject("states");
+  for (uint8_t state = 0; state < machine->getStateNum(); state++) {
+    JsonObject value = states.createNestedObject(machine->getStateName(state));
+    value["enterCount"] = machine->getEnterCount(state);
+    value["dwellTime"] = machine->getDwellTime(state);
+    value["maxDwellTime"] = machine->getMaxDwellTime(state);
+  }
+  if (control->getChildNum() == 0) return;
+  JsonObject children = obj.createNestedObject("children");
+  for (uint8_t i = 0; i < control->getChildNum(); i++) {
+    ControlBase *child = control->getChild(i);
+    _setControlStats(children.createNestedObject(child->getName()), child);
+  }
+}
+
+#ifdef LOOP_PROFILE
+/**
+ * @brief 制御ループの処理時間・周期の統計取得要求
+ *
+ * @details 処理ごとに統計量[us]とヒストグラム（サンプルのある区間の
+ * 上限[us]とサンプル数。最後の区間は上限なし）を返す
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onLoopStatsGet(AsyncWebServerRequest *request,
+                                 ChargeController *charger) {
+  LoopProfiler *profiler = charger->getLoopProfiler();
+  AsyncJsonResponse *response = new AsyncJsonResponse(false, 8192);
+  JsonObject root = response->getRoot();
+  for (uint8_t section = 0; section < LoopProfiler::SECTION_NUM; section++) {
+    LoopProfiler::SectionType type = (LoopProfiler::SectionType)section;
+    const LoopHistogram *histogram = profiler->getHistogram(type);
+    JsonObject value = root.createNestedObject(LoopProfiler::getName(type));
+    value["count"] = histogram->getCount();
+    value["min"] = histogram->getMin();
+    value["max"] = histogram->getMax();
+    value["mean"] = histogram->getMean();
+    value["stddev"] = histogram->getStdDev();
+    value["p50"] = histogram->getPercentile(0.5);
+    value["p95"] = histogram->getPercentile(0.95);
+    value["p99"] = histogram->getPercentile(0.99);
+    JsonArray buckets = value.createNestedArray("histogram");
+    for (uint8_t i = 0; i < LoopHistogram::BUCKET_NUM; i++) {
+      if (histogram->getBucket(i) == 0) continue;
+      JsonObject bucket = buckets.createNestedObject();
+      if (i < LoopHistogram::BUCKET_NUM - 1) {
+        bucket["upperBound"] = LoopHistogram::getBucketUpperBound(i);
+      }
+      bucket["count"] = histogram->getBucket(i);
+    }
+  }
+  response->setLength();
+  request->send(response);
+  logger.info("onLoopStatsGet: send 200 ok");
+}
+
+/**
+ * @brief 制御ループの処理時間・周期の統計リセット要求
+ *
+ * @details リセットは制御ループの次の周期の先頭で行われる
+ *
+ * @param request
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_onLoopStatsDelete(AsyncWebServerRequest *request,
+                                    ChargeController *charger) {
+  charger->getLoopProfiler()->reset();
   request->send(200);
-  logger.info("onChargePut: send 200 ok");
+  logger.info("onLoopStatsDelete: send 200 ok");
+}
+#endif
+
+/**
+ * @brief 充電ベイ一覧取得要求
+ *
+ * @param request
+ */
+void HttpServer::_onBaysGet(AsyncWebServerRequest *request) {
+  AsyncJsonResponse *response = new AsyncJsonResponse(true);
+  JsonArray root = response->getRoot();
+  for (uint8_t i = 0; i < _station->getBayNum(); i++) {
+    ChargeSnapshot snapshot = _station->getBay(i)->getSnapshot();
+    JsonObject bay = root.createNestedObject();
+    bay["id"] = i;
+    bay["charge"] = snapshot.isCharging;
+    bay["current"] = snapshot.current;
+    bay["soc"] = snapshot.soc;
+    bay["sensorHealth"] = (int)snapshot.sensorHealth;
+    bay["timeToFree"] = snapshot.timeToRelease;
+    bay["queueLength"] = _station->getBay(i)->getQueue()->getLength();
+  }
+  response->setLength();
+  request->send(response);
+  logger.info("onBaysGet: send 200 ok");
 }
 
 /**
  * @brief APIの定義
  *
+ * @details 従来のパスはベイ0、/bay/<ベイ番号>/ 以下のパスは各ベイの操作とする
  */
 void HttpServer::_defineApi(void) {
-  _server.on("/charge", HTTP_GET, _onChargeGet);
-  AsyncCallbackJsonWebHandler *handler =
-      new AsyncCallbackJsonWebHandler("/charge", _onChargePut);
-  _server.addHandler(handler);
-  _server.on("/power/on", HTTP_PUT, _onPowerOnPut);
+  _server.on("/bays", HTTP_GET, _onBaysGet);
+  _defineBayApi("", _station->getBay(0));
+  for (uint8_t i = 0; i < _station->getBayNum(); i++) {
+    _defineBayApi("/bay/" + String(i), _station->getBay(i));
+  }
+}
+
+/**
+ * @brief 充電ベイごとのAPIの定義
+ *
+ * @param prefix パスの接頭辞
+ * @param charger 対象の充電ベイの充電制御部
+ */
+void HttpServer::_defineBayApi(const String &prefix,
+                               ChargeController *charger) {
+  // /charge のハンドラは /charge/ 以下のパスにも一致するため先に登録する
+  _server.on((prefix + "/charge/queue").c_str(), HTTP_GET,
+             [charger](AsyncWebServerRequest *request) {
+               _onQueueGet(request, charger);
+             });
+  _server.on((prefix + "/charge/queue").c_str(), HTTP_DELETE,
+             [charger](AsyncWebServerRequest *request) {
+               _onQueueDelete(request, charger);
+             });
+  AsyncCallbackJsonWebHandler *queueHandler = new AsyncCallbackJsonWebHandler(
+      prefix + "/charge/queue",
+      [charger](AsyncWebServerRequest *request, JsonVariant &json) {
+        _onQueuePost(request, json, charger);
+      });
+  queueHandler->setMethod(HTTP_POST);
+  _server.addHandler(queueHandler);
+  _server.on((prefix + "/charge/policy").c_str(), HTTP_GET,
+             [charger](AsyncWebServerRequest *request) {
+               _onPolicyGet(request, charger);
+             });
+  _server.addHandler(new AsyncCallbackJsonWebHandler(
+      prefix + "/charge/policy",
+      [charger](AsyncWebServerRequest *request, JsonVariant &json) {
+        _onPolicyPut(request, json, charger);
+      }));
+  _server.on((prefix + "/charge").c_str(), HTTP_GET,
+             [charger](AsyncWebServerRequest *request) {
+               _onChargeGet(request, charger);
+             });
+  _server.addHandler(new AsyncCallbackJsonWebHandler(
+      prefix + "/charge",
+      [charger](AsyncWebServerRequest *request, JsonVariant &json) {
+        _onChargePut(request, json, charger);
+      }));
+  _server.on((prefix + "/command").c_str(), HTTP_GET,
+             [charger](AsyncWebServerRequest *request) {
+               _onCommandGet(request, charger);
+             });
+  _server.on((prefix + "/power/on").c_str(), HTTP_PUT,
+             [charger](AsyncWebServerRequest *request) {
+               _onPowerOnPut(request, charger);
+             });
+  _server.on((prefix + "/servo/calibration").c_str(), HTTP_GET,
+             [charger](AsyncWebServerRequest *request) {
+               _onCalibrationGet(request, charger);
+             });
+  _server.on((prefix + "/servo/calibration").c_str(), HTTP_PUT,
+             [charger](AsyncWebServerRequest *request) {
+               _onCalibrationPut(request, charger);
+             });
+  _server.on((prefix + "/current/capture").c_str(), HTTP_GET,
+             [charger](AsyncWebServerRequest *request) {
+               _onCaptureGet(request, charger);
+             });
+  _server.on((prefix + "/trace/flush").c_str(), HTTP_PUT,
+             [charger](AsyncWebServerRequest *request) {
+               _onTraceFlushPut(request, charger);
+             });
+  _server.on((prefix + "/trace").c_str(), HTTP_GET,
+             [charger](AsyncWebServerRequest *request) {
+               _onTraceGet(request, charger);
+             });
+  // /stats のハンドラは /stats/ 以下のパスにも一致するため後に登録する
+  _server.on((prefix + "/stats/control").c_str(), HTTP_GET,
+             [charger](AsyncWebServerRequest *request) {
+               _onControlStatsGet(request, charger);
+             });
+#ifdef LOOP_PROFILE
+  _server.on((prefix + "/stats/loop").c_str(), HTTP_GET,
+             [charger](AsyncWebServerRequest *request) {
+               _onLoopStatsGet(request, charger);
+             });
+  _server.on((prefix + "/stats/loop").c_str(), HTTP_DELETE,
+             [charger](AsyncWebServerRequest *request) {
+               _onLoopStatsDelete(request, charger);
+             });
+#endif
+  _server.on((prefix + "/stats").c_str(), HTTP_GET,
+             [charger](AsyncWebServerRequest *request) {
+               _onStatsGet(request, charger);
+             });
+  _server.addHandler(new AsyncCallbackJsonWebHandler(
+      prefix + "/current/capture",
+      [charger](AsyncWebServerRequest *request, JsonVariant &json) {
+        _onCapturePut(request, json, charger);
+      }));
 }
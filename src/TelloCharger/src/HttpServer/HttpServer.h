@@ -15,26 +15,61 @@
 #include <ESPAsyncWebServer.h>
 #include <Log.h>
 
-#include "../ChargeController/ChargeController.h"
+#include "../ChargeController/ChargeStation.h"
 
 class HttpServer {
  public:
-  HttpServer(uint16_t, ChargeController *);
+  HttpServer(uint16_t, ChargeStation *);
   ~HttpServer();
   void begin(void);
   void end(void);
 
  private:
   static void _notFound(AsyncWebServerRequest *);
-  static void _onChargeGet(AsyncWebServerRequest *);
-  static void _onChargePut(AsyncWebServerRequest *, JsonVariant &);
-  static void _onPowerOnPut(AsyncWebServerRequest *);
+  static void _onBaysGet(AsyncWebServerRequest *);
+  static void _onChargeGet(AsyncWebServerRequest *, ChargeController *);
+  static void _onChargePut(AsyncWebServerRequest *, JsonVariant &,
+                           ChargeController *);
+  static void _onPolicyGet(AsyncWebServerRequest *, ChargeController *);
+  static void _onPolicyPut(AsyncWebServerRequest *, JsonVariant &,
+                           ChargeController *);
+  static void _setPolicy(JsonObject, ChargeController *);
+  static void _onQueueGet(AsyncWebServerRequest *, ChargeController *);
+  static void _onQueuePost(AsyncWebServerRequest *, JsonVariant &,
+                           ChargeController *);
+  static void _onQueueDelete(AsyncWebServerRequest *, ChargeController *);
+  static void _sendReservation(AsyncWebServerRequest *, ChargeController *,
+                               const char *, int, const char *);
+  static void _setReservation(JsonObject, const ChargeReservation &,
+                              ChargePolicy::ProfileType);
+  static void _onPowerOnPut(AsyncWebServerRequest *, ChargeController *);
+  static void _onCalibrationGet(AsyncWebServerRequest *, ChargeController *);
+  static void _onCalibrationPut(AsyncWebServerRequest *, ChargeController *);
+  static void _onCaptureGet(AsyncWebServerRequest *, ChargeController *);
+  static void _onTraceGet(AsyncWebServerRequest *, ChargeController *);
+  static void _onTraceFlushPut(AsyncWebServerRequest *, ChargeController *);
+  static void _onStatsGet(AsyncWebServerRequest *, ChargeController *);
+  static void _setStats(JsonObject, ChargeController *,
+                        ChargeController::StatsScopeType);
+  static void _onControlStatsGet(AsyncWebServerRequest *, ChargeController *);
+  static void _setControlStats(JsonObject, ControlBase *);
+#ifdef LOOP_PROFILE
+  static void _onLoopStatsGet(AsyncWebServerRequest *, ChargeController *);
+  static void _onLoopStatsDelete(AsyncWebServerRequest *, ChargeController *);
+#endif
+  static void _onCapturePut(AsyncWebServerRequest *, JsonVariant &,
+                            ChargeController *);
+  static void _sendCommandResponse(AsyncWebServerRequest *, CommandFuture,
+                                   const char *);
+  static void _onCommandGet(AsyncWebServerRequest *, ChargeController *);
+  static const char *_getCommandResultName(CommandFuture::StatusType);
   void _defineApi(void);
+  void _defineBayApi(const String &, ChargeController *);
 
   /** HTTPサーバーインスタンス */
   AsyncWebServer _server;
-  /** 充電管理部のインスタンス */
-  static ChargeController *_charger;
+  /** 充電ステーションのインスタンス */
+  static ChargeStation *_station;
   /** サーバーが待ち受け中かどうか */
   bool _bAvailable;
 };
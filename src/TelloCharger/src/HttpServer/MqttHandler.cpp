@@ -13,19 +13,22 @@ MqttHandler* g_handler = nullptr;
 /**
  * @brief コンストラクタ
  * @param client    初期化済み MQTTClientESP32
- * @param charger   充電制御オブジェクト
+ * @param station   充電ステーション
  * @param macAddr   MAC アドレス文字列（例：DEFAULT_MAC_ADDRESS）
  *
  * - 必要なトピックを Subscribe
  * - コールバックを登録
  * - ステータス Publish 周期は 500 ms 固定
  */
-MqttHandler::MqttHandler(MQTTClientESP32* client, ChargeController* charger,
+MqttHandler::MqttHandler(MQTTClientESP32* client, ChargeStation* station,
                          const String& macAddr)
     : client_(client),
-      charger_(charger),
+      station_(station),
       timer_(Timer(CYCLE_MS)),
-      base_("drone-charger/" + macAddr + "/") {
+      statsTimer_(Timer(STATS_CYCLE_MS)),
+      base_("drone-charger/" + macAddr + "/"),
+      lastSession_(station->getBayNum(), 0),
+      queueRevision_(station->getBayNum(), 0) {
   g_handler = this;
   subscribe_();
   attachCallback_();
@@ -37,24 +40,76 @@ MqttHandler::MqttHandler(MQTTClientESP32* client, ChargeController* charger,
  *
  * - 500 ms ごとに MQTT 健全性を確認
  * - OK なら `/charge/status` を Publish
+ * - 充電が完了していれば `/charge/pad/free` を、予約が変わっていれば
+ *   `/charge/queue/status` を Publish（予約キューは 10 s ごとにも Publish）
+ * - 10 s ごとに `/charge/stats`（LOOP_PROFILE 定義時は `/charge/stats/loop` も）
+ *   を Publish
+ * - 従来のトピックにはベイ0を、ベイが複数あれば `bay/<n>/` 付きのトピックにも
+ *   各ベイを Publish
  * - 高速に呼んでも問題ない非ブロッキング実装
  */
 void MqttHandler::loop() {
+  uint8_t bayNum = station_->getBayNum();
   if (timer_.isCycleTime()) {
     if (client_ && client_->healthCheck()) {
-      publishStatus_();
+      publishStatus_(station_->getBay(0), base_);
+      for (uint8_t i = 0; bayNum > 1 && i < bayNum; i++) {
+        publishStatus_(station_->getBay(i), bayPrefix_(i));
+      }
+      for (uint8_t i = 0; i < bayNum; i++) publishQueueEvents_(i, false);
+    }
+  }
+  if (statsTimer_.isCycleTime()) {
+    if (client_ && client_->healthCheck()) {
+      for (uint8_t i = 0; i < bayNum; i++) publishQueueEvents_(i, true);
+      publishStats_(station_->getBay(0), base_);
+#ifdef LOOP_PROFILE
+      publishLoopStats_(station_->getBay(0), base_);
+#endif
+      for (uint8_t i = 0; bayNum > 1 && i < bayNum; i++) {
+        publishStats_(station_->getBay(i), bayPrefix_(i));
+#ifdef LOOP_PROFILE
+        publishLoopStats_(station_->getBay(i), bayPrefix_(i));
+#endif
+      }
     }
   }
 }
 
 // =====================  private  ==============================
+/**
+ * @brief ベイのトピックのプレフィクスを取得
+ */
+String MqttHandler::bayPrefix_(uint8_t bay) {
+  return base_ + "bay/" + String(bay) + "/";
+}
+
 /**
  * @brief 各種トピックを Subscribe
+ *
+ * - 従来のトピック（ベイ0）と、全ベイの `bay/<n>/` 付きのトピック
  */
 void MqttHandler::subscribe_() {
-  client_->subscribe(base_ + "charge/start/request");
-  client_->subscribe(base_ + "charge/stop/request");
-  client_->subscribe(base_ + "power/on/request");
+  subscribeBay_(base_);
+  for (uint8_t i = 0; i < station_->getBayNum(); i++) {
+    subscribeBay_(bayPrefix_(i));
+  }
+}
+
+/**
+ * @brief ベイごとのトピックを Subscribe
+ */
+void MqttHandler::subscribeBay_(const String& prefix) {
+  client_->subscribe(prefix + "charge/start/request");
+  client_->subscribe(prefix + "charge/stop/request");
+  client_->subscribe(prefix + "power/on/request");
+  client_->subscribe(prefix + "charge/policy/request");
+  client_->subscribe(prefix + "servo/calibrate/request");
+  client_->subscribe(prefix + "charge/queue/enqueue/request");
+  client_->subscribe(prefix + "charge/queue/dequeue/request");
+#ifdef LOOP_PROFILE
+  client_->subscribe(prefix + "charge/stats/loop/reset/request");
+#endif
 }
 
 /**
@@ -67,20 +122,222 @@ void MqttHandler::attachCallback_() {
 /**
  * @brief /charge/status を Publish
  */
-void MqttHandler::publishStatus_() {
+void MqttHandler::publishStatus_(ChargeController* charger,
+                                 const String& prefix) {
+  ChargeSnapshot snapshot = charger->getSnapshot();
   ChargeStatus st{
-      charger_->isCharging(),
-      charger_->getCurrent(),
-      charger_->getChargeTimeSec(),
-      charger_->isStartChargeExecuting(),
-      charger_->isStopChargeExecuting(),
-      charger_->isPowerOnExecuting(),
+      snapshot.version,
+      snapshot.isCharging,
+      snapshot.current,
+      snapshot.chargeTime,
+      snapshot.chargeAmount,
+      snapshot.chargeEnergy,
+      snapshot.busVoltage,
+      snapshot.minBusVoltage,
+      snapshot.power,
+      snapshot.samplingRate,
+      snapshot.soc,
+      snapshot.timeToFull,
+      snapshot.targetSoc,
+      ChargePolicy::getName(snapshot.profile),
+      snapshot.sensorHealth,
+      snapshot.sensorFailedCount,
+      snapshot.sensorRecoveredCount,
+      snapshot.isStartChargeExecuting,
+      snapshot.isStopChargeExecuting,
+      snapshot.isPowerOnExecuting,
+      snapshot.isCalibrateExecuting,
   };
   String payload = buildChargeStatusJson(st);
-  client_->publish(base_ + "charge/status", payload);
+  client_->publish(prefix + "charge/status", payload);
   logger.debug("Publish status: " + payload);
 }
 
+/**
+ * @brief 予約キュー関連を Publish
+ *
+ * - 前回から充電が完了していれば `/charge/pad/free` を Publish
+ * - 充電の完了・予約の変更があれば（isPeriodic なら常に）
+ *   `/charge/queue/status` を Publish
+ * - ベイ0は従来のトピックにも Publish
+ * - 接続できない間に完了した充電は、再接続後に通知する
+ */
+void MqttHandler::publishQueueEvents_(uint8_t bay, bool isPeriodic) {
+  ChargeController* charger = station_->getBay(bay);
+  ChargeSnapshot snapshot = charger->getSnapshot();
+  uint32_t revision = charger->getQueue()->getRevision();
+  bool isPadFree = snapshot.lastSession.count != lastSession_[bay];
+  bool isChanged = isPadFree || revision != queueRevision_[bay];
+  lastSession_[bay] = snapshot.lastSession.count;
+  queueRevision_[bay] = revision;
+  if (!isChanged && !isPeriodic) return;
+
+  ChargeQueueStatus status = makeQueueStatus_(charger, snapshot);
+  String prefixes[] = {base_, bayPrefix_(bay)};
+  uint8_t first = bay == 0 ? 0 : 1;
+  uint8_t last = station_->getBayNum() > 1 ? 1 : 0;
+  for (uint8_t i = first; i <= last; i++) {
+    if (isPadFree) publishPadFree_(snapshot, status, prefixes[i]);
+    publishQueue_(status, prefixes[i]);
+  }
+}
+
+/**
+ * @brief 予約キューの状態を生成
+ *
+ * - 各予約の推定待ち時間は充電ベイが空くまでの推定時間と
+ *   先に並ぶ予約の充電時間の学習値から求める
+ */
+ChargeQueueStatus MqttHandler::makeQueueStatus_(
+    ChargeController* charger, const ChargeSnapshot& snapshot) {
+  ChargeReservation reservations[ChargeQueue::QUEUE_SIZE];
+  float etas[ChargeQueue::QUEUE_SIZE];
+  ChargePolicy::ProfileType defaultProfile = charger->getPolicy()->getDefault();
+  uint8_t length = charger->getQueue()->estimate(
+      snapshot, defaultProfile, reservations, etas, ChargeQueue::QUEUE_SIZE);
+  ChargeQueueStatus status{snapshot.timeToRelease, ChargeQueue::QUEUE_SIZE,
+                           {}, true};
+  for (uint8_t i = 0; i < length; i++) {
+    const ChargeReservation& r = reservations[i];
+    status.reservations.push_back(ChargeQueueEntry{
+        r.ticket,
+        r.droneId,
+        ChargePolicy::getName(r.getProfile(defaultProfile)),
+        etas[i],
+        (millis() - r.time) / 1000.0f,
+    });
+  }
+  return status;
+}
+
+/**
+ * @brief /charge/queue/status を Publish
+ */
+void MqttHandler::publishQueue_(const ChargeQueueStatus& status,
+                                const String& prefix) {
+  String payload = buildChargeQueueStatusJson(status);
+  client_->publish(prefix + "charge/queue/status", payload);
+  logger.debug("Publish queue: " + payload);
+}
+
+/**
+ * @brief /charge/pad/free を Publish
+ *
+ * - 直近に完了した充電の結果と、予約の先頭のドローンIDを通知
+ */
+void MqttHandler::publishPadFree_(const ChargeSnapshot& snapshot,
+                                  const ChargeQueueStatus& status,
+                                  const String& prefix) {
+  const ChargeSession::Result& session = snapshot.lastSession;
+  PadFreeEvent event{
+      session.count,
+      ChargeSession::getReleaseName(session.release),
+      ChargePolicy::getName(session.profile),
+      session.chargeTime,
+      session.chargeAmount,
+      session.soc,
+      status.reservations.empty() ? String("")
+                                  : status.reservations.front().droneId,
+      (uint8_t)status.reservations.size(),
+      true,
+  };
+  String payload = buildPadFreeEventJson(event);
+  client_->publish(prefix + "charge/pad/free", payload);
+  logger.info("Publish pad free: " + payload);
+}
+
+namespace {
+/**
+ * @brief StreamingStats を StatsValue に変換
+ */
+StatsValue toStatsValue(StreamingStats* stats) {
+  return StatsValue{stats->getCount(), stats->getMin(),    stats->getMax(),
+                    stats->getMean(),  stats->getStdDev(), stats->getP50(),
+                    stats->getP95(),   stats->getP99()};
+}
+
+/**
+ * @brief 統計の範囲ごとの統計量を取得
+ */
+ChargeStatsScope toStatsScope(ChargeController* charger,
+                              ChargeController::StatsScopeType scope) {
+  return ChargeStatsScope{
+      toStatsValue(
+          charger->getStats(ChargeController::STATS_CHARGE_CURRENT, scope)),
+      toStatsValue(
+          charger->getStats(ChargeController::STATS_SERVO_CURRENT, scope)),
+      toStatsValue(charger->getStats(ChargeController::STATS_LOOP_TIME, scope)),
+      toStatsValue(
+          charger->getStats(ChargeController::STATS_COMMAND_LATENCY, scope)),
+  };
+}
+}  // namespace
+
+/**
+ * @brief /charge/stats を Publish
+ */
+void MqttHandler::publishStats_(ChargeController* charger,
+                                const String& prefix) {
+  ChargeStats stats{
+      toStatsScope(charger, ChargeController::STATS_SESSION),
+      toStatsScope(charger, ChargeController::STATS_LIFETIME),
+      true,
+  };
+  String payload = buildChargeStatsJson(stats);
+  if (payload.length() == 0) {
+    logger.warn("Failed to build stats: JSON document overflowed");
+    return;
+  }
+  client_->publish(prefix + "charge/stats", payload);
+  logger.debug("Publish stats: " + payload);
+}
+
+#ifdef LOOP_PROFILE
+namespace {
+/**
+ * @brief LoopHistogram を StatsValue に変換
+ */
+StatsValue toStatsValue(const LoopHistogram* histogram) {
+  return StatsValue{histogram->getCount(),
+                    histogram->getMin(),
+                    histogram->getMax(),
+                    histogram->getMean(),
+                    histogram->getStdDev(),
+                    histogram->getPercentile(0.5),
+                    histogram->getPercentile(0.95),
+                    histogram->getPercentile(0.99)};
+}
+}  // namespace
+
+/**
+ * @brief /charge/stats/loop を Publish
+ */
+void MqttHandler::publishLoopStats_(ChargeController* charger,
+                                    const String& prefix) {
+  LoopProfiler* profiler = charger->getLoopProfiler();
+  StatsValue values[LoopProfiler::SECTION_NUM];
+  for (uint8_t section = 0; section < LoopProfiler::SECTION_NUM; section++) {
+    values[section] = toStatsValue(
+        profiler->getHistogram((LoopProfiler::SectionType)section));
+  }
+  LoopStats stats{
+      values[LoopProfiler::SECTION_LOOP],
+      values[LoopProfiler::SECTION_PERIOD],
+      values[LoopProfiler::SECTION_CURRENT_READER],
+      values[LoopProfiler::SECTION_START_CHARGE],
+      values[LoopProfiler::SECTION_STOP_CHARGE],
+      values[LoopProfiler::SECTION_POWER_ON_DRONE],
+      values[LoopProfiler::SECTION_CALIBRATE],
+      values[LoopProfiler::SECTION_CHECK_SERVO_CURRENT],
+      values[LoopProfiler::SECTION_SERVO],
+      true,
+  };
+  String payload = buildLoopStatsJson(stats);
+  client_->publish(prefix + "charge/stats/loop", payload);
+  logger.debug("Publish loop stats: " + payload);
+}
+#endif
+
 // ---------- メッセージコールバック関連 -------------------------
 /**
  * @brief MQTT ライブラリが呼び出すスタティックコールバック
@@ -95,16 +352,46 @@ void MqttHandler::onMessageStatic_(String topic, String payload) {
 
 /**
  * @brief トピックごとの処理をディスパッチ
+ *
+ * - `bay/<n>/` 付きのトピックはベイ n、それ以外はベイ0への要求とする
+ * - 応答は要求と同じプレフィクスのトピックへ Publish
  */
 void MqttHandler::onMessage_(const String& topic, const String& payload) {
   logger.info("Received: " + topic + " | " + payload);
 
-  if (topic == base_ + "charge/start/request") {
-    handleChargeStart_(payload);
-  } else if (topic == base_ + "charge/stop/request") {
-    handleChargeStop_(payload);
-  } else if (topic == base_ + "power/on/request") {
-    handlePowerOn_(payload);
+  String prefix = base_;
+  ChargeController* charger = station_->getBay(0);
+  if (topic.startsWith(base_ + "bay/")) {
+    int start = base_.length() + 4;
+    int end = topic.indexOf('/', start);
+    String bay = end > start ? topic.substring(start, end) : String("");
+    charger = bay.length() > 0 ? station_->getBay(bay.toInt()) : nullptr;
+    if (!charger || bayPrefix_(bay.toInt()) != topic.substring(0, end + 1)) {
+      logger.warn("Unknown bay: " + topic);
+      return;
+    }
+    prefix = topic.substring(0, end + 1);
+  }
+  String name = topic.substring(prefix.length());
+
+  if (name == "charge/start/request") {
+    handleChargeStart_(charger, prefix, payload);
+  } else if (name == "charge/stop/request") {
+    handleChargeStop_(charger, prefix, payload);
+  } else if (name == "power/on/request") {
+    handlePowerOn_(charger, prefix, payload);
+  } else if (name == "charge/policy/request") {
+    handleChargePolicy_(charger, prefix, payload);
+  } else if (name == "servo/calibrate/request") {
+    handleCalibrate_(charger, prefix, payload);
+  } else if (name == "charge/queue/enqueue/request") {
+    handleQueueEnqueue_(charger, prefix, payload);
+  } else if (name == "charge/queue/dequeue/request") {
+    handleQueueDequeue_(charger, prefix, payload);
+#ifdef LOOP_PROFILE
+  } else if (name == "charge/stats/loop/reset/request") {
+    handleLoopStatsReset_(charger, prefix, payload);
+#endif
   } else {
     logger.warn("Unhandled topic: " + topic);
   }
@@ -114,26 +401,40 @@ void MqttHandler::onMessage_(const String& topic, const String& payload) {
 /**
  * @brief 充電開始要求を処理
  */
-void MqttHandler::handleChargeStart_(const String& payload) {
-  RequestHeader req = parseChargeStartRequestJson(payload);
-  ResponseHeader res = {req.req_id, "SUCCESS", "", true};
+void MqttHandler::handleChargeStart_(ChargeController* charger,
+                                     const String& prefix,
+                                     const String& payload) {
+  ChargeStartRequest req = parseChargeStartRequestJson(payload);
+  ResponseHeader res = {req.header.req_id, "SUCCESS", "", true};
+  ChargePolicy::ProfileType profile =
+      ChargePolicy::findByName(req.profile.c_str());
 
   if (!req.valid) {
     res.status = "FAILURE";
     res.error = "ChargeStartRequest JSON が不正";
     logger.error(res.error + ": " + payload);
+  } else if (req.profile.length() > 0 && profile == ChargePolicy::PROFILE_NUM) {
+    res.status = "FAILURE";
+    res.error = "未知の充電プロファイル";
+    logger.error(res.error + ": " + req.profile);
   } else {
-    charger_->startCharge();
+    ChargeCommand command(ChargeCommand::COMMAND_START_CHARGE,
+                          ChargeCommand::SOURCE_MQTT,
+                          req.header.req_id.c_str());
+    if (profile != ChargePolicy::PROFILE_NUM) command.profile = profile;
+    submitCommand_(charger, command, res);
   }
 
-  client_->publish(base_ + "charge/start/response",
+  client_->publish(prefix + "charge/start/response",
                    buildChargeStartResponseJson(res));
 }
 
 /**
  * @brief 充電停止要求を処理
  */
-void MqttHandler::handleChargeStop_(const String& payload) {
+void MqttHandler::handleChargeStop_(ChargeController* charger,
+                                    const String& prefix,
+                                    const String& payload) {
   RequestHeader req = parseChargeStopRequestJson(payload);
   ResponseHeader res = {req.req_id, "SUCCESS", "", true};
 
@@ -142,17 +443,23 @@ void MqttHandler::handleChargeStop_(const String& payload) {
     res.error = "ChargeStopRequest JSON が不正";
     logger.error(res.error + ": " + payload);
   } else {
-    charger_->stopCharge();
+    submitCommand_(charger,
+                   ChargeCommand(ChargeCommand::COMMAND_STOP_CHARGE,
+                                 ChargeCommand::SOURCE_MQTT,
+                                 req.req_id.c_str()),
+                   res);
   }
 
-  client_->publish(base_ + "charge/stop/response",
+  client_->publish(prefix + "charge/stop/response",
                    buildChargeStopResponseJson(res));
 }
 
 /**
  * @brief 電源 ON 要求を処理
  */
-void MqttHandler::handlePowerOn_(const String& payload) {
+void MqttHandler::handlePowerOn_(ChargeController* charger,
+                                 const String& prefix,
+                                 const String& payload) {
   RequestHeader req = parsePowerOnRequestJson(payload);
   ResponseHeader res = {req.req_id, "SUCCESS", "", true};
 
@@ -161,8 +468,224 @@ void MqttHandler::handlePowerOn_(const String& payload) {
     res.error = "PowerOnRequest JSON が不正";
     logger.error(res.error + ": " + payload);
   } else {
-    charger_->powerOnDrone();
+    submitCommand_(charger,
+                   ChargeCommand(ChargeCommand::COMMAND_POWER_ON_DRONE,
+                                 ChargeCommand::SOURCE_MQTT,
+                                 req.req_id.c_str()),
+                   res);
   }
 
-  client_->publish(base_ + "power/on/response", buildPowerOnResponseJson(res));
+  client_->publish(prefix + "power/on/response", buildPowerOnResponseJson(res));
+}
+
+/**
+ * @brief 充電ポリシー変更要求を処理
+ */
+void MqttHandler::handleChargePolicy_(ChargeController* charger,
+                                      const String& prefix,
+                                      const String& payload) {
+  ChargePolicyRequest req = parseChargePolicyRequestJson(payload);
+  ResponseHeader res = {req.header.req_id, "SUCCESS", "", true};
+  ChargePolicy::ProfileType profile =
+      ChargePolicy::findByName(req.profile.c_str());
+
+  if (!req.valid) {
+    res.status = "FAILURE";
+    res.error = "ChargePolicyRequest JSON が不正";
+    logger.error(res.error + ": " + payload);
+  } else if (req.profile.length() > 0 && profile == ChargePolicy::PROFILE_NUM) {
+    res.status = "FAILURE";
+    res.error = "未知の充電プロファイル";
+    logger.error(res.error + ": " + req.profile);
+  } else {
+    // 既定のプロファイルの変更は NVS に保存し、次の充電開始から反映する
+    if (profile != ChargePolicy::PROFILE_NUM) {
+      charger->getPolicy()->setDefault(profile);
+      if (!charger->getPolicy()->save()) {
+        res.status = "FAILURE";
+        res.error = "充電ポリシーの保存に失敗";
+        logger.error(res.error + ": req_id = " + res.req_id);
+      }
+    }
+    if (req.targetSoc > 0 && res.status == "SUCCESS") {
+      ChargeCommand command(ChargeCommand::COMMAND_SET_TARGET_SOC,
+                            ChargeCommand::SOURCE_MQTT,
+                            req.header.req_id.c_str());
+      command.targetSoc = req.targetSoc;
+      submitCommand_(charger, command, res);
+    }
+  }
+
+  client_->publish(prefix + "charge/policy/response",
+                   buildChargePolicyResponseJson(res));
+}
+
+/**
+ * @brief アーム角度自動キャリブレーション要求を処理
+ */
+void MqttHandler::handleCalibrate_(ChargeController* charger,
+                                   const String& prefix,
+                                   const String& payload) {
+  RequestHeader req = parseCalibrateRequestJson(payload);
+  ResponseHeader res = {req.req_id, "SUCCESS", "", true};
+
+  if (!req.valid) {
+    res.status = "FAILURE";
+    res.error = "CalibrateRequest JSON が不正";
+    logger.error(res.error + ": " + payload);
+  } else {
+    submitCommand_(charger,
+                   ChargeCommand(ChargeCommand::COMMAND_CALIBRATE,
+                                 ChargeCommand::SOURCE_MQTT,
+                                 req.req_id.c_str()),
+                   res);
+  }
+
+  client_->publish(prefix + "servo/calibrate/response",
+                   buildCalibrateResponseJson(res));
+}
+
+namespace {
+/**
+ * @brief 予約キューの操作結果をエラーメッセージに変換（成功なら空）
+ */
+String toQueueError(ChargeQueue::ResultType result) {
+  switch (result) {
+    case ChargeQueue::RESULT_OK:
+      return "";
+    case ChargeQueue::RESULT_INVALID_ID:
+      return "ドローンIDが不正";
+    case ChargeQueue::RESULT_DUPLICATE:
+      return "予約済みのドローンID";
+    case ChargeQueue::RESULT_FULL:
+      return "予約キューが一杯";
+    default:
+      return "予約がない";
+  }
+}
+}  // namespace
+
+/**
+ * @brief 充電ベイの予約要求を処理
+ *
+ * - 予約は末尾に追加し、推定待ち時間は `/charge/queue/status` で通知する
+ */
+void MqttHandler::handleQueueEnqueue_(ChargeController* charger,
+                                      const String& prefix,
+                                      const String& payload) {
+  ChargeQueueRequest req = parseChargeQueueEnqueueRequestJson(payload);
+  ResponseHeader res = {req.header.req_id, "SUCCESS", "", true};
+  ChargePolicy::ProfileType profile =
+      ChargePolicy::findByName(req.profile.c_str());
+
+  if (!req.valid) {
+    res.status = "FAILURE";
+    res.error = "ChargeQueueEnqueueRequest JSON が不正";
+    logger.error(res.error + ": " + payload);
+  } else if (req.profile.length() > 0 && profile == ChargePolicy::PROFILE_NUM) {
+    res.status = "FAILURE";
+    res.error = "未知の充電プロファイル";
+    logger.error(res.error + ": " + req.profile);
+  } else {
+    ChargeReservation reservation;
+    ChargeQueue::ResultType result = charger->getQueue()->enqueue(
+        req.droneId.c_str(),
+        profile != ChargePolicy::PROFILE_NUM ? (uint8_t)profile
+                                             : ChargeCommand::PROFILE_DEFAULT,
+        reservation);
+    if (result != ChargeQueue::RESULT_OK) {
+      res.status = "FAILURE";
+      res.error = toQueueError(result);
+      logger.error(res.error + ": " + req.droneId);
+    }
+  }
+
+  client_->publish(prefix + "charge/queue/enqueue/response",
+                   buildChargeQueueEnqueueResponseJson(res));
+}
+
+/**
+ * @brief 予約の取り出し要求を処理
+ *
+ * - droneId を指定すればその予約を取り消し、省略すれば先頭の予約を取り出す
+ */
+void MqttHandler::handleQueueDequeue_(ChargeController* charger,
+                                      const String& prefix,
+                                      const String& payload) {
+  ChargeQueueRequest req = parseChargeQueueDequeueRequestJson(payload);
+  ResponseHeader res = {req.header.req_id, "SUCCESS", "", true};
+
+  if (!req.valid) {
+    res.status = "FAILURE";
+    res.error = "ChargeQueueDequeueRequest JSON が不正";
+    logger.error(res.error + ": " + payload);
+  } else {
+    ChargeReservation reservation;
+    ChargeQueue::ResultType result =
+        charger->getQueue()->dequeue(req.droneId.c_str(), reservation);
+    if (result != ChargeQueue::RESULT_OK) {
+      res.status = "FAILURE";
+      res.error = toQueueError(result);
+      logger.error(res.error + ": " + req.droneId);
+    }
+  }
+
+  client_->publish(prefix + "charge/queue/dequeue/response",
+                   buildChargeQueueDequeueResponseJson(res));
+}
+
+#ifdef LOOP_PROFILE
+/**
+ * @brief ループ処理時間・周期の統計リセット要求を処理
+ *
+ * - リセットは制御ループの次の周期の先頭で行われる
+ */
+void MqttHandler::handleLoopStatsReset_(ChargeController* charger,
+                                        const String& prefix,
+                                        const String& payload) {
+  RequestHeader req = parseLoopStatsResetRequestJson(payload);
+  ResponseHeader res = {req.req_id, "SUCCESS", "", true};
+
+  if (!req.valid) {
+    res.status = "FAILURE";
+    res.error = "LoopStatsResetRequest JSON が不正";
+    logger.error(res.error + ": " + payload);
+  } else {
+    charger->getLoopProfiler()->reset();
+  }
+
+  client_->publish(prefix + "charge/stats/loop/reset/response",
+                   buildLoopStatsResetResponseJson(res));
+}
+#endif
+
+/**
+ * @brief コマンドを充電制御へ送信し、結果を応答ヘッダに反映
+ *
+ * - 制御ループで実行されるまで最大 COMMAND_TIMEOUT_MS 待つ
+ * - 待ち時間内に実行されなくても受付済みなら SUCCESS（受付順に実行される）
+ * - キューが一杯で受け付けられなければ FAILURE
+ * - 制御ループが実行を拒否した・実行できなかった場合も FAILURE
+ */
+void MqttHandler::submitCommand_(ChargeController* charger,
+                                 const ChargeCommand& command,
+                                 ResponseHeader& res) {
+  CommandFuture future = charger->submit(command);
+  CommandFuture::StatusType status = future.wait(COMMAND_TIMEOUT_MS);
+  if (status == CommandFuture::STATUS_REJECTED) {
+    res.status = "FAILURE";
+    res.error = "コマンドキューが一杯";
+    logger.error(res.error + ": req_id = " + res.req_id);
+  } else if (status == CommandFuture::STATUS_REFUSED) {
+    res.status = "FAILURE";
+    res.error = "制御ループが実行を拒否（電流センサの異常など）";
+    logger.error(res.error + ": req_id = " + res.req_id);
+  } else if (status == CommandFuture::STATUS_FAILED) {
+    res.status = "FAILURE";
+    res.error = "コマンドを実行できない";
+    logger.error(res.error + ": req_id = " + res.req_id);
+  } else if (status == CommandFuture::STATUS_PENDING) {
+    logger.warn("Command accepted but not yet executed: req_id = " +
+                res.req_id);
+  }
 }
@@ -3,7 +3,10 @@
 #include <MQTTClientESP32.h>
 #include <Timer.h>
 
-#include "../ChargeController/ChargeController.h"
+#include <vector>
+
+#include "../ChargeController/ChargeStation.h"
+#include "DroneChargerProtocol.h"
 
 /**
  * @class MqttHandler
@@ -12,16 +15,19 @@
  * - コマンドトピックの Subscribe / 解析
  * - ChargeController への指示出し
  * - 応答メッセージおよび充電ステータスの Publish
+ * - 充電ベイの予約キューの状態と、充電ベイが空いたことの通知の Publish
+ *
+ * 従来のトピックはベイ0、"bay/<ベイ番号>/" を付けたトピックは各ベイを扱う
  */
 class MqttHandler {
  public:
   /**
    * @brief コンストラクタ
    * @param client   初期化済み MQTTClientESP32
-   * @param charger  充電制御オブジェクト
+   * @param station  充電ステーション
    * @param macAddr  MAC アドレス文字列（トピックプレフィクス生成用）
    */
-  MqttHandler(MQTTClientESP32* client, ChargeController* charger,
+  MqttHandler(MQTTClientESP32* client, ChargeStation* station,
               const String& macAddr);
 
   /**
@@ -33,15 +39,40 @@ class MqttHandler {
  private:
   /* ---------------- 内部状態 ---------------- */
   MQTTClientESP32* client_;    ///< MQTT クライアント
-  ChargeController* charger_;  ///< 充電制御オブジェクト
+  ChargeStation* station_;     ///< 充電ステーション
   Timer timer_;                ///< タイマ
+  Timer statsTimer_;           ///< 統計情報送信タイマ
   String base_;                ///< "drone-charger/<MAC>/" プレフィクス
   uint32_t prevMs_{0};
+  std::vector<uint32_t> lastSession_;   ///< ベイごとの通知済みの充電の通し番号
+  std::vector<uint32_t> queueRevision_; ///< ベイごとの通知済みの予約の変更回数
   static constexpr uint32_t CYCLE_MS = 500;  ///< ステータス送信周期[ms]
+  static constexpr uint32_t STATS_CYCLE_MS = 10000;  ///< 統計情報送信周期[ms]
+  static constexpr uint32_t COMMAND_TIMEOUT_MS = 200;  ///< コマンド完了待ち[ms]
 
   /* -------------- 内部ユーティリティ -------------- */
-  void publishStatus_();   ///< /charge/status を Publish
+  String bayPrefix_(uint8_t bay);  ///< "<base>bay/<ベイ番号>/" プレフィクス
+  void publishStatus_(ChargeController* charger,
+                      const String& prefix);  ///< /charge/status を Publish
+  void publishStats_(ChargeController* charger,
+                     const String& prefix);  ///< /charge/stats を Publish
+#ifdef LOOP_PROFILE
+  void publishLoopStats_(
+      ChargeController* charger,
+      const String& prefix);  ///< /charge/stats/loop を Publish
+#endif
+  void publishQueueEvents_(uint8_t bay,
+                           bool isPeriodic);  ///< 予約キュー関連を Publish
+  ChargeQueueStatus makeQueueStatus_(
+      ChargeController* charger,
+      const ChargeSnapshot& snapshot);  ///< 予約キューの状態を生成
+  void publishQueue_(const ChargeQueueStatus& status,
+                     const String& prefix);  ///< /charge/queue/status を Publish
+  void publishPadFree_(const ChargeSnapshot& snapshot,
+                       const ChargeQueueStatus& status,
+                       const String& prefix);  ///< /charge/pad/free を Publish
   void subscribe_();       ///< 必要トピックを Subscribe
+  void subscribeBay_(const String& prefix);  ///< ベイのトピックを Subscribe
   void attachCallback_();  ///< MQTT コールバック登録
 
   /* -------------- コールバック -------------- */
@@ -49,7 +80,25 @@ class MqttHandler {
   void onMessage_(const String& topic, const String& payload);
 
   /* -------------- 個別ハンドラ -------------- */
-  void handleChargeStart_(const String& payload);  ///< 充電開始要求
-  void handleChargeStop_(const String& payload);   ///< 充電停止要求
-  void handlePowerOn_(const String& payload);      ///< 電源 ON 要求
+  // charger: 対象ベイの充電制御、prefix: 応答トピックのプレフィクス
+  void handleChargeStart_(ChargeController* charger, const String& prefix,
+                          const String& payload);  ///< 充電開始要求
+  void handleChargeStop_(ChargeController* charger, const String& prefix,
+                         const String& payload);  ///< 充電停止要求
+  void handlePowerOn_(ChargeController* charger, const String& prefix,
+                      const String& payload);  ///< 電源 ON 要求
+  void handleChargePolicy_(ChargeController* charger, const String& prefix,
+                           const String& payload);  ///< 充電ポリシー変更要求
+  void handleCalibrate_(ChargeController* charger, const String& prefix,
+                        const String& payload);  ///< キャリブレーション要求
+  void handleQueueEnqueue_(ChargeController* charger, const String& prefix,
+                           const String& payload);  ///< 充電ベイの予約要求
+  void handleQueueDequeue_(ChargeController* charger, const String& prefix,
+                           const String& payload);  ///< 予約の取り出し要求
+#ifdef LOOP_PROFILE
+  void handleLoopStatsReset_(ChargeController* charger, const String& prefix,
+                             const String& payload);  ///< ループ統計リセット要求
+#endif
+  void submitCommand_(ChargeController* charger, const ChargeCommand& command,
+                      ResponseHeader& res);  ///< コマンド送信と結果の反映
 };
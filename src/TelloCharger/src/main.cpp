@@ -4,10 +4,11 @@
 #include <MacUtils.h>
 #include <WiFiESP32.h>
 
-#include "ChargeController/ChargeController.h"
+#include "ChargeController/ChargeStation.h"
 #include "HttpServer/DroneChargerProtocol.h"
 #include "HttpServer/HttpServer.h"
 #include "HttpServer/MqttHandler.h"
+#include "pinConfig.h"
 #include "ssid.h"
 
 /** WiFiのSSID（ssid.h（git管理対象外）にて定義） */
@@ -25,8 +26,12 @@ MQTTClientESP32 *mqttClient;
 MqttHandler *mqttHandler;
 /** WebAPIインスタンス */
 HttpServer *server;
-/** 充電制御インスタンス */
+/** 充電ステーションインスタンス */
+ChargeStation *station;
+/** ボタン・シリアル入力で操作する充電ベイ（ベイ0）の充電制御インスタンス */
 ChargeController *charger;
+/** 制御ループのスケジューラ（割り込みから参照するためポインタを保持） */
+ControlScheduler *scheduler;
 
 /**
  * @brief WiFi通信用Task
@@ -46,9 +51,9 @@ void taskWifi(void *) {
     // ESP.restart();
   }
 
-  server = new HttpServer(httpPort, charger);
+  server = new HttpServer(httpPort, station);
   mqttClient = new MQTTClientESP32(MQTT_HOST, MQTT_PORT, MQTT_BUFFER_SIZE);
-  mqttHandler = new MqttHandler(mqttClient, charger, DEFAULT_MAC_ADDRESS);
+  mqttHandler = new MqttHandler(mqttClient, station, DEFAULT_MAC_ADDRESS);
 
   while (true) {
     if (wifi->healthCheck()) {
@@ -61,32 +66,69 @@ void taskWifi(void *) {
   }
 }
 
+/**
+ * @brief ボタン入力の割り込み処理
+ *
+ * @details 待機中の制御ループを起床させ、ボタンの判定をすぐに行う
+ */
+void IRAM_ATTR onButtonChange(void) {
+  scheduler->wakeFromISR(ControlScheduler::WAKE_BUTTON);
+}
+
+#if ARDUINO_USB_CDC_ON_BOOT
+/**
+ * @brief USB CDCのシリアル受信時の処理
+ *
+ */
+void onSerialEvent(void *, esp_event_base_t, int32_t, void *) {
+  scheduler->wake(ControlScheduler::WAKE_SERIAL);
+}
+#else
+/**
+ * @brief UARTのシリアル受信時の処理
+ *
+ */
+void onSerialReceive(void) { scheduler->wake(ControlScheduler::WAKE_SERIAL); }
+#endif
+
 void setup() {
   auto cfg = M5.config();
   M5.begin(cfg);
-  charger = new ChargeController();
-  // WiFi通信用Taskを起動 Core 0
-  xTaskCreatePinnedToCore(taskWifi, "taskWifi", 4096, NULL, 1, NULL, 0);
+  station = new ChargeStation();
+  charger = station->getBay(0);
+  scheduler = station->getScheduler();
+  // 待機中の制御ループをボタン・シリアル入力で起床させる
+  attachInterrupt(BUTTON_PIN, onButtonChange, CHANGE);
+#if ARDUINO_USB_CDC_ON_BOOT
+  Serial.onEvent(ARDUINO_HW_CDC_RX_EVENT, onSerialEvent);
+#else
+  Serial.onReceive(onSerialReceive);
+#endif
+  // WiFi通信用Taskを起動 Core 0（統計情報のJSON生成のためスタックを多めに確保）
+  xTaskCreatePinnedToCore(taskWifi, "taskWifi", 8192, NULL, 1, NULL, 0);
 }
 
 void loop() {
   // ボタン押下時の処理
   M5.update();
   if (M5.BtnA.wasPressed()) {
-    if (charger->isReleaseDrone())
-      charger->startCharge();
-    else
-      charger->stopCharge();
+    // 通信タスクからの要求と同じ順序で処理するためコマンドとして送信する
+    charger->submit(ChargeCommand(charger->isReleaseDrone()
+                                      ? ChargeCommand::COMMAND_START_CHARGE
+                                      : ChargeCommand::COMMAND_STOP_CHARGE,
+                                  ChargeCommand::SOURCE_BUTTON));
   }
 
   // キーボードからのWASD入力時の処理
-  if (Serial.available()) {
+  while (Serial.available()) {
     // 文字が届いていればを読み込む
     char input = Serial.read();
     charger->wasdControl(input);
   }
 
-  // 制御部のループ処理
-  charger->loop();
-  delay(10);
+  // 全ベイの制御部のループ処理
+  station->loop();
+
+  // いずれかのベイが動作中なら一定周期で、全ベイ待機中は起床要因が届くまで待つ
+  scheduler->wait(station->isActive());
 }
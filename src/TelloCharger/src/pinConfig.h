@@ -9,6 +9,12 @@
 #define CHARGE_CONTROL_PIN 5
 #define INA_SDA_PIN 38
 #define INA_SCL_PIN 39
+/** ボタンのピン番号 */
+#define BUTTON_PIN 41
+// 2台目の充電ベイ（BAY_NUM=2）
+#define SERVO_CATCH_PIN_1 8
+#define SERVO_USB_PIN_1 1
+#define CHARGE_CONTROL_PIN_1 2
 #else
 // Atom 系
 /** 捕獲サーボのピン番号 */
@@ -19,4 +25,23 @@
 #define CHARGE_CONTROL_PIN 22
 #define INA_SDA_PIN 25
 #define INA_SCL_PIN 21
+/** ボタンのピン番号 */
+#define BUTTON_PIN 39
+// 2台目の充電ベイ（BAY_NUM=2）
+#define SERVO_CATCH_PIN_1 33
+#define SERVO_USB_PIN_1 32
+#define CHARGE_CONTROL_PIN_1 26
+#endif
+
+/** INA219のI2Cアドレス */
+#define INA_ADDRESS 0x40
+/** 2台目の充電ベイのINA219のI2Cアドレス（A0をVSにつなぐ） */
+#define INA_ADDRESS_1 0x41
+
+#ifndef BAY_NUM
+/** 充電ベイの数（build_flags で変更する） */
+#define BAY_NUM 1
+#endif
+#if BAY_NUM < 1 || BAY_NUM > 2
+#error "BAY_NUM must be 1 or 2 (add pins for more bays)"
 #endif
@@ -23,6 +23,6 @@
 #define MQTT_HOST "192.168.0.100"
 /** MQTTのポート番号 */
 #define MQTT_PORT 1883
-/** MQTTのバッファサイズ(デフォルトは256バイト) */
+/** MQTTのバッファサイズ(デフォルトは256バイト。charge/statsはトピック込みで1KBを超えるため拡張する) */
 // #define MQTT_BUFFER_SIZE 32768
-#define MQTT_BUFFER_SIZE 256
+#define MQTT_BUFFER_SIZE 2048
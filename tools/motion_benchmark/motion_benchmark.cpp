@@ -0,0 +1,274 @@
+/**
+ * @file motion_benchmark.cpp
+ * @brief 充電シーケンスの所要時間のベンチマーク（ホスト用）
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details ファームウェアと同じ速度プロファイル（MotionProfile.h/.cpp）を
+ * 制御ループの周期で進め、充電シーケンスの所要時間を求める。
+ * 既定の設定（加減速なしの等速移動）と、実機で確認してから使う高速設定
+ * （台形速度プロファイル）を比較する。
+ * 各シーケンスはファームウェアの状態遷移と同じ順にアームを動かす。
+ * - startCharge(): ControlArmChargeを捕獲回数・リトライ回数を指定して実行
+ *   （既定はControlStartChargeと同じ2回・1回）。
+ *   捕獲は「位置決め捕獲→リリース」を繰り返してから捕獲し、USBを接続する。
+ *   リトライではUSBを切断し、捕獲アームをリリースしてから捕獲をやり直す
+ * - stopCharge(): ControlArmInit（USBを切断してから捕獲アームをリリース）
+ * - powerOnDrone(): ControlArmCharge（捕獲1回・リトライなし）、電源ボタンの
+ *   押下待ち、ControlArmInit
+ * 各動作は制御ループの周期ごとに到達を判定し、到達を検知した周期に次の動作を
+ * 開始するものとする（ServoController::loop()と状態機械の1周期遅れを含む）。
+ * それぞれの設定について、動作を1つずつ順に実行する場合（usbClearが未教示）と、
+ * 捕獲アームとUSBアームの動作を重ねる場合（usbClearを教示済み）を求める。
+ * 重ねる場合は、USBアームが干渉領域に入る前に捕獲アームが到達する時点で
+ * USBの接続を始め（ServoController::getConnectUsbDelay()）、USBアームが
+ * 干渉領域を出た時点で捕獲アームのリリースを始める
+ * （ServoController::isUsbClear()）。
+ * 角度・速度・待ち時間はファームウェアの既定値（ServoCalibration.cpp、
+ * ServoController.cpp、ControlArmCharge.cpp、ControlPowerOnDrone.cpp、
+ * ControlStartCharge.cpp）に合わせている
+ *
+ * ビルド（リポジトリのルートで実行）
+ *
+ *     g++ -std=gnu++11 -Isrc/TelloCharger/src/ChargeController \
+ *         tools/motion_benchmark/motion_benchmark.cpp \
+ *         src/TelloCharger/src/ChargeController/MotionProfile.cpp \
+ *         -o motion_benchmark
+ *
+ * 使い方
+ *
+ *     ./motion_benchmark [CATCH_CNT RETRY_CNT]
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "MotionProfile.h"
+
+/** 制御ループの周期[ms] */
+static const uint32_t LOOP_PERIOD = 10;
+/** ドローンをリリースする角度[deg] */
+static const float ANGLE_DRONE_RELEASE = -45;
+/** ドローンを捕獲する角度[deg] */
+static const float ANGLE_DRONE_CATCH = 8;
+/** ドローンを位置決め捕獲する角度[deg] */
+static const float ANGLE_DRONE_CATCH_ONCE = 14;
+/** USBを切断する角度[deg] */
+static const float ANGLE_USB_OFF = -56;
+/** USBアームが捕獲アームに干渉しない角度[deg] */
+static const float ANGLE_USB_CLEAR = 0;
+/** USBを接続する角度[deg] */
+static const float ANGLE_USB_ON = 52;
+/** 捕獲アームの到達とUSBアームの干渉領域への進入の間に確保する余裕[sec] */
+static const float OVERLAP_MARGIN = 0.1;
+/** USB接続後にサーボ電流の収束を待つ時間[sec] */
+static const float SETTLE_TIME = 5;
+/** ドローンの電源ボタンを押し続ける時間[sec] */
+static const float POWER_ON_WAIT = 2;
+/** 充電開始時の捕獲繰り返し回数（ControlStartCharge::CATCH_CNT） */
+static const int CATCH_CNT = 2;
+/** 充電開始時のUSB接続のリトライ回数（ControlStartCharge::RETRY_CNT） */
+static const int RETRY_CNT = 1;
+
+/**
+ * @brief サーボ軸の速度・加速度の制限
+ */
+struct AxisLimits {
+  /** 最大速度[deg/s] */
+  float vel;
+  /** 最大加速度[deg/s^2]（0なら加減速なしの等速移動） */
+  float acc;
+};
+
+/**
+ * @brief 比較するサーボ設定
+ */
+struct Config {
+  /** 設定名 */
+  const char *name;
+  /** 捕獲サーボ */
+  AxisLimits catchAxis;
+  /** USBサーボ */
+  AxisLimits usbAxis;
+};
+
+/** 既定の設定（等速移動）と高速設定（台形速度プロファイル） */
+static const Config CONFIGS[] = {
+    {"default", {60, 0}, {150, 0}},
+    {"fast", {120, 480}, {300, 1200}},
+};
+
+/**
+ * @brief 1動作の所要時間を制御ループの周期単位で求める
+ *
+ * @param limits サーボ軸の制限
+ * @param from 開始角度[deg]
+ * @param to 目標角度[deg]
+ * @return float 所要時間[sec]（到達を検知する周期を含む）
+ */
+static float move(const AxisLimits &limits, float from, float to) {
+  MotionProfile profile(limits.vel, limits.acc);
+  profile.plan(from, to);
+  uint32_t ticks = 0;
+  while (!profile.isFinished(ticks * LOOP_PERIOD / 1000.0f)) ticks++;
+  // 到達した周期の次の周期で状態機械が到達を検知して次の動作を開始する
+  return (ticks + 1) * LOOP_PERIOD / 1000.0f;
+}
+
+/**
+ * @brief 経過時間を制御ループの周期単位に切り上げる
+ *
+ * @param time 経過時間[sec]
+ * @return float 周期単位の経過時間[sec]
+ */
+static float toTicks(float time) {
+  float period = LOOP_PERIOD / 1000.0f;
+  return ceilf(time / period - 1e-4f) * period;
+}
+
+/**
+ * @brief 動作の途中で指定した角度を通過するまでの時間を求める
+ *
+ * @param limits サーボ軸の制限
+ * @param from 開始角度[deg]
+ * @param to 目標角度[deg]
+ * @param angle 通過する角度[deg]
+ * @return float 通過を検知するまでの時間[sec]
+ */
+static float reach(const AxisLimits &limits, float from, float to,
+                   float angle) {
+  MotionProfile profile(limits.vel, limits.acc);
+  profile.plan(from, to);
+  return toTicks(profile.getTimeToReach(angle)) + LOOP_PERIOD / 1000.0f;
+}
+
+/**
+ * @brief 最後の捕獲からUSBを接続し終えるまでの時間
+ *
+ * @param config サーボ設定
+ * @param isOverlap 動作を重ねるかどうか
+ * @return float 所要時間[sec]
+ */
+static float catchAndConnect(const Config &config, bool isOverlap) {
+  float catchTime =
+      move(config.catchAxis, ANGLE_DRONE_RELEASE, ANGLE_DRONE_CATCH);
+  float usbTime = move(config.usbAxis, ANGLE_USB_OFF, ANGLE_USB_ON);
+  if (!isOverlap) return catchTime + usbTime;
+  // 捕獲開始時に設定したタイムアウトの次の周期でUSBを動かし始める
+  MotionProfile catchProfile(config.catchAxis.vel, config.catchAxis.acc);
+  catchProfile.plan(ANGLE_DRONE_RELEASE, ANGLE_DRONE_CATCH);
+  MotionProfile usbProfile(config.usbAxis.vel, config.usbAxis.acc);
+  usbProfile.plan(ANGLE_USB_OFF, ANGLE_USB_ON);
+  float delay = catchProfile.getDuration() + OVERLAP_MARGIN -
+                usbProfile.getTimeToReach(ANGLE_USB_CLEAR);
+  float usbStart = toTicks(delay > 0 ? delay : 0.001f);
+  float connectTime = usbStart + usbTime;
+  return connectTime > catchTime ? connectTime : catchTime;
+}
+
+/**
+ * @brief USBを切断してから捕獲アームをリリースし終えるまでの時間
+ *
+ * @param config サーボ設定
+ * @param isOverlap 動作を重ねるかどうか
+ * @return float 所要時間[sec]
+ */
+static float disconnectAndRelease(const Config &config, bool isOverlap) {
+  float usbTime = move(config.usbAxis, ANGLE_USB_ON, ANGLE_USB_OFF);
+  float releaseTime =
+      move(config.catchAxis, ANGLE_DRONE_CATCH, ANGLE_DRONE_RELEASE);
+  if (!isOverlap) return usbTime + releaseTime;
+  float clearTime =
+      reach(config.usbAxis, ANGLE_USB_ON, ANGLE_USB_OFF, ANGLE_USB_CLEAR);
+  float time = clearTime + releaseTime;
+  return time > usbTime ? time : usbTime;
+}
+
+/**
+ * @brief ControlArmChargeの所要時間
+ *
+ * @details アームが初期位置（リリース・USB切断）にある状態から開始する
+ *
+ * @param config サーボ設定
+ * @param isOverlap 動作を重ねるかどうか
+ * @param catchCnt 捕獲繰り返し回数
+ * @param retryCnt USB接続するまでの動作をリトライする回数
+ * @return float 所要時間[sec]（USB接続後の待ち時間を含む）
+ */
+static float armCharge(const Config &config, bool isOverlap, int catchCnt,
+                       int retryCnt) {
+  float time = 0;
+  for (int retry = 0; retry <= retryCnt; retry++) {
+    if (retry > 0) time += disconnectAndRelease(config, isOverlap);
+    for (int i = 0; i + 1 < catchCnt; i++) {
+      time += move(config.catchAxis, ANGLE_DRONE_RELEASE,
+                   ANGLE_DRONE_CATCH_ONCE);
+      time += move(config.catchAxis, ANGLE_DRONE_CATCH_ONCE,
+                   ANGLE_DRONE_RELEASE);
+    }
+    time += catchAndConnect(config, isOverlap);
+  }
+  return time + SETTLE_TIME;
+}
+
+/**
+ * @brief ControlArmInitの所要時間
+ *
+ * @details アームが充電位置（捕獲・USB接続）にある状態から開始する
+ *
+ * @param config サーボ設定
+ * @param isOverlap 動作を重ねるかどうか
+ * @return float 所要時間[sec]
+ */
+static float armInit(const Config &config, bool isOverlap) {
+  return disconnectAndRelease(config, isOverlap);
+}
+
+int main(int argc, char **argv) {
+  int catchCnt = CATCH_CNT;
+  int retryCnt = RETRY_CNT;
+  if (argc == 3) {
+    catchCnt = atoi(argv[1]);
+    retryCnt = atoi(argv[2]);
+  }
+  if ((argc != 1 && argc != 3) || catchCnt < 1 || retryCnt < 0) {
+    fprintf(stderr, "usage: %s [CATCH_CNT RETRY_CNT]\n", argv[0]);
+    return 1;
+  }
+  static const char *NAMES[] = {"startCharge()", "stopCharge()",
+                                "powerOnDrone()"};
+  printf("catchCnt = %d, retryCnt = %d\n", catchCnt, retryCnt);
+  printf("%-16s", "sequence");
+  for (int overlap = 0; overlap < 2; overlap++) {
+    for (int i = 0; i < 2; i++) {
+      char name[16];
+      snprintf(name, sizeof(name), "%s%s", CONFIGS[i].name,
+               overlap ? "+overlap" : "");
+      printf(" %15s", name);
+    }
+  }
+  printf("\n");
+  for (int j = 0; j < 3; j++) {
+    printf("%-16s", NAMES[j]);
+    for (int overlap = 0; overlap < 2; overlap++) {
+      for (int i = 0; i < 2; i++) {
+        const Config &config = CONFIGS[i];
+        bool isOverlap = overlap != 0;
+        float result;
+        if (j == 0) {
+          result = armCharge(config, isOverlap, catchCnt, retryCnt);
+        } else if (j == 1) {
+          result = armInit(config, isOverlap);
+        } else {
+          result = armCharge(config, isOverlap, 1, 0) + POWER_ON_WAIT +
+                   armInit(config, isOverlap);
+        }
+        printf(" %14.2fs", result);
+      }
+    }
+    printf("\n");
+  }
+  return 0;
+}
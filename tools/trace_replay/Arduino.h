@@ -0,0 +1,95 @@
+/**
+ * @file Arduino.h
+ * @brief 再生ツール用のArduino.hの代替
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details ファームウェアの制御（ControlBase.h以下）をホストでビルドするために
+ * 必要な定義のみを提供する。
+ * millis()・micros()は再生中の記録の時刻を返す（trace_replay.cppで定義）。
+ * FreeRTOSの排他制御は再生が単一スレッドのため何もしない
+ */
+
+#pragma once
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+using std::max;
+using std::min;
+
+uint32_t millis(void);
+uint32_t micros(void);
+
+#define constrain(amt, low, high) \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef void *TaskHandle_t;
+typedef void *QueueHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef uint32_t TickType_t;
+
+/**
+ * @brief スピンロック（再生では使わない）
+ */
+typedef struct {
+  int owner;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED \
+  { 0 }
+#define portENTER_CRITICAL(mux) (void)(mux)
+#define portEXIT_CRITICAL(mux) (void)(mux)
+#define IRAM_ATTR
+
+/**
+ * @brief 文字列（ログ出力に使う範囲のみ）
+ */
+class String {
+ public:
+  String() {}
+  String(const char *value) : _value(value) {}
+  String(const std::string &value) : _value(value) {}
+  String(char value) : _value(1, value) {}
+  String(int value) : _value(std::to_string(value)) {}
+  String(unsigned int value) : _value(std::to_string(value)) {}
+  String(long value) : _value(std::to_string(value)) {}
+  String(unsigned long value) : _value(std::to_string(value)) {}
+  String(long long value) : _value(std::to_string(value)) {}
+  String(unsigned long long value) : _value(std::to_string(value)) {}
+  String(float value, unsigned int decimals = 2)
+      : String((double)value, decimals) {}
+  String(double value, unsigned int decimals = 2) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    _value = buffer;
+  }
+
+  String operator+(const String &other) const {
+    return String(_value + other._value);
+  }
+  friend String operator+(const char *lhs, const String &rhs) {
+    return String(std::string(lhs) + rhs._value);
+  }
+  String &operator+=(const String &other) {
+    _value += other._value;
+    return *this;
+  }
+  bool operator==(const String &other) const {
+    return _value == other._value;
+  }
+  bool operator!=(const String &other) const {
+    return _value != other._value;
+  }
+  const char *c_str(void) const { return _value.c_str(); }
+  unsigned int length(void) const { return _value.size(); }
+
+ private:
+  std::string _value;
+};
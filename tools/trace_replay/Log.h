@@ -0,0 +1,38 @@
+/**
+ * @file Log.h
+ * @brief 再生ツール用のLog.hの代替
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 再生中の制御が出力するログは、--log を指定したときのみ
+ * 標準エラーに出力する
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief ログ出力
+ */
+class Logger {
+ public:
+  Logger() : _isEnabled(false) {}
+  void setEnabled(bool isEnabled) { _isEnabled = isEnabled; }
+  void error(const String &message) { _print("E", message); }
+  void warn(const String &message) { _print("W", message); }
+  void info(const String &message) { _print("I", message); }
+  void debug(const String &message) { _print("D", message); }
+  void trace(const String &message) { _print("T", message); }
+
+ private:
+  void _print(const char *level, const String &message) {
+    if (_isEnabled) {
+      fprintf(stderr, "  %10.3f %s %s\n", millis() / 1000.0, level,
+              message.c_str());
+    }
+  }
+
+  bool _isEnabled;
+};
+
+extern Logger logger;
@@ -0,0 +1,51 @@
+/**
+ * @file Preferences.h
+ * @brief 再生ツール用のPreferences.hの代替
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details NVSを持たないため、読み出しは常に空（既定値）となり、
+ * 書き込みは破棄する
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief 空のNVS
+ */
+class Preferences {
+ public:
+  bool begin(const char *name, bool readOnly = false) {
+    (void)name;
+    (void)readOnly;
+    return false;
+  }
+  void end(void) {}
+  bool clear(void) { return false; }
+  uint8_t getUChar(const char *key, uint8_t defaultValue = 0) {
+    (void)key;
+    return defaultValue;
+  }
+  size_t putUChar(const char *key, uint8_t value) {
+    (void)key;
+    (void)value;
+    return 0;
+  }
+  size_t getBytesLength(const char *key) {
+    (void)key;
+    return 0;
+  }
+  size_t getBytes(const char *key, void *buffer, size_t len) {
+    (void)key;
+    (void)buffer;
+    (void)len;
+    return 0;
+  }
+  size_t putBytes(const char *key, const void *value, size_t len) {
+    (void)key;
+    (void)value;
+    (void)len;
+    return 0;
+  }
+};
@@ -0,0 +1,196 @@
+/**
+ * @file ReplayHardware.cpp
+ * @brief 再生ツール用のサーボ・MOSFET・電流センサの模擬
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 記録にない値（電流センサの接続状態、充電量など）は
+ * 正常時の値を返す
+ */
+
+#include "ReplayHardware.h"
+
+#include <map>
+
+/** I2Cバス（型のみ） */
+TwoWire Wire;
+
+/** サーボの現在角度[deg] */
+static std::map<const ServoAxis *, float> presentAngles;
+/** MOSFETの状態 */
+static std::map<const FETController *, bool> fetStates;
+/** 充電電流・サーボ電流[mA] */
+static std::map<const CurrentReader *, std::pair<float, float> > currents;
+
+/**
+ * @brief サーボの現在角度を設定する
+ *
+ * @param axis サーボ軸
+ * @param angle 現在角度[deg]
+ */
+void setPresentAngle(ServoAxis *axis, float angle) {
+  presentAngles[axis] = angle;
+}
+
+/**
+ * @brief 電流値を設定する
+ *
+ * @param reader 電流センサ
+ * @param current 充電電流[mA]
+ * @param servoCurrent サーボ電流[mA]
+ */
+void setCurrent(CurrentReader *reader, float current, float servoCurrent) {
+  currents[reader] = std::make_pair(current, servoCurrent);
+}
+
+/** 指示角度への追従速度[deg/s]（再生では使わない） */
+const float ServoAxis::TRACKING_VEL = 1000;
+
+/**
+ * @brief Construct a new ServoAxis object
+ *
+ * @param channel PWMのチャンネル
+ * @param pin ピン番号
+ * @param initAngle 初期角度[deg]
+ * @param maxVel 最大速度[deg/s]
+ * @param maxAcc 最大加速度[deg/s^2]
+ */
+ServoAxis::ServoAxis(uint8_t channel, uint8_t pin, float initAngle,
+                     float maxVel, float maxAcc)
+    : _servo(channel, pin, initAngle, TRACKING_VEL),
+      _profile(maxVel, maxAcc),
+      _targetAngle(initAngle),
+      _presentAngle(initAngle),
+      _presentVelocity(0),
+      _startTime(0),
+      _isMoving(false) {
+  presentAngles[this] = initAngle;
+}
+
+ServoAxis::~ServoAxis() { presentAngles.erase(this); }
+
+float ServoAxis::getTargetAngle(void) { return _targetAngle; }
+
+/**
+ * @brief 指示角度を設定する
+ *
+ * @details 残り時間の計算用に速度プロファイルのみ計画する（現在角度は
+ * 記録の値を与える）
+ *
+ * @param angle 指示角度[deg]
+ */
+void ServoAxis::setTargetAngle(float angle) {
+  if (angle == _targetAngle) return;
+  _profile.plan(getPresentAngle(), angle, 0);
+  _startTime = micros();
+  _targetAngle = angle;
+}
+
+void ServoAxis::hold(void) { _targetAngle = getPresentAngle(); }
+
+float ServoAxis::getPresentAngle(void) { return presentAngles[this]; }
+
+float ServoAxis::getPresentVelocity(void) { return 0; }
+
+/**
+ * @brief 指示角度に到達したかどうか
+ *
+ * @return true 現在角度と指示角度の差がREPLAY_ANGLE_TOLERANCE以内
+ * @return false
+ */
+bool ServoAxis::isTargetAngle(void) {
+  return fabsf(getPresentAngle() - _targetAngle) <= REPLAY_ANGLE_TOLERANCE;
+}
+
+float ServoAxis::getRemainingTime(void) {
+  if (isTargetAngle()) return 0;
+  float remaining =
+      _profile.getDuration() - (micros() - _startTime) / 1000000.0f;
+  return remaining > 0 ? remaining : 0;
+}
+
+float ServoAxis::getTimeToReach(float target, float angle) {
+  MotionProfile profile = _profile;
+  profile.plan(getPresentAngle(), target, 0);
+  return profile.getTimeToReach(angle);
+}
+
+void ServoAxis::setLimits(float maxVel, float maxAcc) {
+  _profile.setLimits(maxVel, maxAcc);
+}
+
+void ServoAxis::loop(void) {}
+
+/**
+ * @brief Construct a new FETController object
+ *
+ * @param pin ピン番号
+ */
+FETController::FETController(uint8_t pin) : _pin(pin) { off(); }
+
+FETController::~FETController() { fetStates.erase(this); }
+
+void FETController::on(void) { fetStates[this] = true; }
+
+void FETController::off(void) { fetStates[this] = false; }
+
+bool FETController::read(void) { return fetStates[this]; }
+
+Ina219::Ina219(uint8_t address, TwoWire *wire)
+    : _address(address), _wire(wire), _step(TRIGGER), _triggerTime(0) {}
+
+Ina219::~Ina219() {}
+
+CurrentCapture::CurrentCapture() {}
+
+CurrentCapture::~CurrentCapture() {}
+
+void CurrentCapture::trigger(CaptureTriggerType type) { (void)type; }
+
+/** 既定のサンプリングレート[Hz]（再生では使わない） */
+const uint16_t CurrentReader::DEFAULT_SAMPLING_RATE = 0;
+
+/**
+ * @brief Construct a new CurrentReader object
+ *
+ * @details I2Cバスを使わず、サンプリング用のタスクも生成しない
+ *
+ * @param bus 全ベイで共有するI2Cバス（再生では使わない）
+ * @param address 電流センサのI2Cアドレス
+ * @param cycleTime 移動平均フィルタの更新周期[ms]
+ * @param samplingRate サンプリングレート[Hz]（再生では使わない）
+ */
+CurrentReader::CurrentReader(I2cBus *bus, uint8_t address, uint32_t cycleTime,
+                             uint16_t samplingRate)
+    : _bus(bus), _ina219(address), _cycleTime(cycleTime) {
+  (void)samplingRate;
+  currents[this] = std::make_pair(0.0f, 0.0f);
+}
+
+CurrentReader::~CurrentReader() { currents.erase(this); }
+
+/**
+ * @brief 電流センサが応答しているかどうか（記録にないため常に応答する）
+ *
+ * @return true
+ */
+bool CurrentReader::isConnect(void) { return true; }
+
+float CurrentReader::getCurrent(void) { return currents[this].first; }
+
+float CurrentReader::getServoCurrent(void) { return currents[this].second; }
+
+void CurrentReader::resetMinBusVoltage(void) {}
+
+void CurrentReader::startCoulombCounter(void) {}
+
+void CurrentReader::stopCoulombCounter(void) {}
+
+/**
+ * @brief 充電電荷量を取得する（記録にないため常に0）
+ *
+ * @return float 充電電荷量[mAh]
+ */
+float CurrentReader::getChargeAmount(void) { return 0; }
+
+CurrentCapture *CurrentReader::getCapture(void) { return &_capture; }
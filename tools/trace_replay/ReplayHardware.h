@@ -0,0 +1,24 @@
+/**
+ * @file ReplayHardware.h
+ * @brief 再生ツール用のサーボ・MOSFET・電流センサの模擬
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details ファームウェアのServoAxis・FETController・CurrentReaderを
+ * 同じ宣言（ヘッダ）のまま置き換え、記録の値を入力として与える。
+ * サーボの現在角度・電流は記録の値を設定し、指示角度・MOSFETの状態は
+ * 再生中の制御の操作で変わる（記録に合わせる場合はsetTargetAngle()・
+ * on()/off()を呼び出す）。
+ * ServoAxisは現在角度と指示角度の差が記録の分解能以内で到達とみなす
+ */
+
+#pragma once
+#include "CurrentReader.h"
+#include "FETController.h"
+#include "ServoAxis.h"
+
+/** 到達とみなす現在角度と指示角度の差[deg]（記録の分解能） */
+static const float REPLAY_ANGLE_TOLERANCE = 0.1f;
+
+void setPresentAngle(ServoAxis *, float);
+void setCurrent(CurrentReader *, float, float);
@@ -0,0 +1,24 @@
+/**
+ * @file ServoESP32.h
+ * @brief 再生ツール用のServoESP32.hの代替
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details サーボ軸（ServoAxis）は模擬するため、型のみを提供する
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief サーボ（再生では使わない）
+ */
+class ServoESP32 {
+ public:
+  ServoESP32(uint8_t channel, uint8_t pin, float angle, float vel) {
+    (void)channel;
+    (void)pin;
+    (void)angle;
+    (void)vel;
+  }
+};
@@ -0,0 +1,33 @@
+/**
+ * @file Timer.h
+ * @brief 再生ツール用のTimer.hの代替
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 再生中の記録の時刻（millis()）で経過時間を計る
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief 経過時間の計測
+ */
+class Timer {
+ public:
+  Timer(uint32_t cycleTime = 0)
+      : _cycleTime(cycleTime), _startTime(millis()), _cycleStart(millis()) {}
+  void startTimer(void) { _startTime = millis(); }
+  void stopTimer(void) {}
+  uint32_t getTime(void) { return millis() - _startTime; }
+  bool isCycleTime(void) {
+    if (_cycleTime == 0 || millis() - _cycleStart < _cycleTime) return false;
+    _cycleStart = millis();
+    return true;
+  }
+
+ private:
+  uint32_t _cycleTime;
+  uint32_t _startTime;
+  uint32_t _cycleStart;
+};
@@ -0,0 +1,18 @@
+/**
+ * @file Wire.h
+ * @brief 再生ツール用のWire.hの代替
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details 電流センサは模擬するため、I2Cバスは型のみを提供する
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief I2Cバス（再生では使わない）
+ */
+class TwoWire {};
+
+extern TwoWire Wire;
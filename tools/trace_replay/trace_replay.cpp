@@ -0,0 +1,886 @@
+/**
+ * @file trace_replay.cpp
+ * @brief 状態遷移トレースの再生ツール（ホスト用）
+ * @author Tatsuya Miyazaki
+ * @date 2026/10/17
+ *
+ * @details GET /trace で取得したトレース（TraceRecorder.h参照）を読み込み、
+ * 遷移の時系列を出力しながら、ファームウェアの制御（ControlBase.h以下の
+ * 遷移テーブル・遷移条件・遷移処理）で記録を再生し、状態ごとの入場回数・
+ * 滞在時間を出力する。
+ * サーボ・MOSFET・電流センサは模擬し（ReplayHardware.h参照）、
+ * 記録のサーボの現在角度・電流を入力として与える。
+ * 記録を古い順に1件ずつ刺激として扱い、記録のイベントを制御の状態機械に
+ * 発行して処理させ（start・resetは同じ操作を行う）、遷移先が記録と
+ * 一致するかを照合する。刺激の処理中に起きた遷移（入場後のEVENT_ENTERED、
+ * 子制御の開始など）は同じ制御の次の記録と照合する。
+ * 状態を変えずに遷移処理のみ行った遷移（遷移先 "-"）も同様に照合する。
+ * 以下を不一致として報告し、記録に合わせてから再生を続ける
+ *
+ * - 再生中の状態と記録の遷移元が異なる（記録の欠落など）
+ * - 記録のイベントで記録の遷移先に遷移しない
+ * - 記録にない遷移が起きた
+ * - 遷移後の指示角度・MOSFETの状態が記録と異なる（ChargeControllerが
+ *   制御の外で操作した場合を含む）
+ *
+ * 記録にない入力（電流センサの接続状態、充電量）は正常時の値とし、
+ * サーボの校正角度・捕獲回数・リトライ回数はファームウェアの既定値とする
+ * （--angle・--count で変更できる）。
+ * 記録の欠落（通し番号の飛び）も検出して報告する
+ *
+ * ビルド（リポジトリのルートで実行）
+ *
+ *     C=src/TelloCharger/src/ChargeController
+ *     g++ -std=gnu++11 -Itools/trace_replay -I$C/.. -I$C \
+ *         tools/trace_replay/{ReplayHardware,trace_replay}.cpp \
+ *         $C/BayConfig.cpp $C/CheckServoCurrent.cpp \
+ *         $C/Control{ArmCharge,ArmInit,Base,Calibrate}.cpp \
+ *         $C/Control{PowerOnDrone,StartCharge,StopCharge}.cpp \
+ *         $C/MotionProfile.cpp $C/StateMachine.cpp \
+ *         $C/Servo{Calibration,Controller,StallDetector}.cpp -o trace_replay
+ *
+ * 使い方
+ *
+ *     curl -o trace.bin http://<充電器のアドレス>/trace
+ *     ./trace_replay trace.bin          # 時系列と再生結果を出力
+ *     ./trace_replay trace.bin --csv    # 時系列をCSVで出力（再生結果は標準エラー）
+ *     ./trace_replay trace.bin --log    # 再生中の制御のログを標準エラーに出力
+ *     ./trace_replay trace.bin --angle droneCatch=10 --angle usbOn=50
+ *                                       # 校正角度（GET /servo/calibration）
+ *     ./trace_replay trace.bin --count 3/1
+ *                                       # 捕獲/リトライ回数（GET /policy）
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BayConfig.h"
+#include "CheckServoCurrent.h"
+#include "ControlCalibrate.h"
+#include "ControlPowerOnDrone.h"
+#include "ControlStartCharge.h"
+#include "ControlStopCharge.h"
+#include "Log.h"
+#include "ReplayHardware.h"
+#include "ServoController.h"
+#include "StateMachine.h"
+#include "TraceRecord.h"
+
+/** 再生中の時刻[us]（桁あふれを補正済み） */
+static uint64_t now = 0;
+
+/** ログ出力 */
+Logger logger;
+
+/**
+ * @brief 再生中の時刻を取得する
+ *
+ * @return uint32_t 時刻[ms]
+ */
+uint32_t millis(void) { return (uint32_t)(now / 1000); }
+
+/**
+ * @brief 再生中の時刻を取得する
+ *
+ * @return uint32_t 時刻[us]
+ */
+uint32_t micros(void) { return (uint32_t)now; }
+
+/** フォーマットバージョン */
+static const uint8_t VERSION = 2;
+/** ヘッダのサイズ[byte] */
+static const size_t HEADER_SIZE = 16;
+/** 制御のメタデータのサイズ[byte]（状態を除く） */
+static const size_t COMPONENT_SIZE = 24;
+/** 状態のメタデータのサイズ[byte] */
+static const size_t STATE_SIZE = 20;
+/** 親制御なし */
+static const uint8_t NO_COMPONENT = 0xFF;
+
+/** イベント名（ControlBase::ControlEventTypeの順） */
+static const char *EVENT_NAMES[] = {
+    "ENTERED",     "TIMEOUT",      "SERVO_STARTED", "SERVO_REACHED",
+    "USB_CLEAR",   "SERVO_MOVING", "SERVO_IDLE",    "FET_CHANGED",
+    "CHILD_DONE",  "STALL",        "CONTACT",
+};
+
+/**
+ * @brief 状態のメタデータ
+ */
+struct StateInfo {
+  /** 親状態 */
+  uint8_t parent;
+  /** 状態名 */
+  std::string name;
+};
+
+/**
+ * @brief 制御のメタデータ
+ */
+struct ComponentInfo {
+  /** 親制御ID */
+  uint8_t parent;
+  /** 制御名 */
+  std::string name;
+  /** 状態（状態IDの順） */
+  std::vector<StateInfo> states;
+};
+
+/**
+ * @brief 読み込んだトレース
+ */
+struct Trace {
+  /** 読み出し元（0: RAM, 1: NVS） */
+  uint8_t source;
+  /** 起動からの総記録数 */
+  uint32_t totalCount;
+  /** 制御のメタデータ（制御IDの順） */
+  std::vector<ComponentInfo> components;
+  /** 記録（古い順） */
+  std::vector<TraceRecord> records;
+};
+
+/**
+ * @brief リトルエンディアンのバイト列を先頭から読み出す
+ */
+class Reader {
+ public:
+  Reader(const std::vector<uint8_t> &data) : _data(data), _pos(0) {}
+
+  bool has(size_t len) { return _pos + len <= _data.size(); }
+
+  uint8_t u8(void) { return _data[_pos++]; }
+
+  uint16_t u16(void) {
+    uint16_t value = _data[_pos] | (_data[_pos + 1] << 8);
+    _pos += 2;
+    return value;
+  }
+
+  int16_t i16(void) { return (int16_t)u16(); }
+
+  uint32_t u32(void) {
+    uint32_t value = u16();
+    return value | ((uint32_t)u16() << 16);
+  }
+
+  std::string str(size_t len) {
+    std::string value;
+    for (size_t i = 0; i < len; i++) {
+      char c = (char)_data[_pos + i];
+      if (c == '\0') break;
+      value += c;
+    }
+    _pos += len;
+    return value;
+  }
+
+ private:
+  const std::vector<uint8_t> &_data;
+  size_t _pos;
+};
+
+/**
+ * @brief トレースを読み込む
+ *
+ * @param path ファイルパス
+ * @param trace 格納先
+ * @return true 読み込み成功
+ * @return false ファイルがない、または形式が不正
+ */
+static bool load(const char *path, Trace &trace) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return false;
+  }
+  std::vector<uint8_t> data;
+  uint8_t buffer[4096];
+  size_t len;
+  while ((len = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.insert(data.end(), buffer, buffer + len);
+  }
+  fclose(file);
+
+  Reader reader(data);
+  if (!reader.has(HEADER_SIZE) || reader.str(4) != "TTRC") {
+    fprintf(stderr, "not a trace file\n");
+    return false;
+  }
+  uint8_t version = reader.u8();
+  trace.source = reader.u8();
+  uint8_t componentNum = reader.u8();
+  uint8_t recordSize = reader.u8();
+  uint16_t recordCount = reader.u16();
+  reader.u16();
+  trace.totalCount = reader.u32();
+  if (version != VERSION || recordSize != sizeof(TraceRecord)) {
+    fprintf(stderr, "unsupported version %u (record size %u)\n", version,
+            recordSize);
+    return false;
+  }
+  for (uint8_t id = 0; id < componentNum; id++) {
+    if (!reader.has(COMPONENT_SIZE)) return false;
+    ComponentInfo component;
+    component.parent = reader.u8();
+    uint8_t stateNum = reader.u8();
+    component.name = reader.str(COMPONENT_SIZE - 2);
+    if (stateNum > StateMachineBase::MAX_STATE_NUM ||
+        !reader.has(STATE_SIZE * stateNum)) {
+      fprintf(stderr, "invalid metadata of %s\n", component.name.c_str());
+      return false;
+    }
+    for (uint8_t state = 0; state < stateNum; state++) {
+      StateInfo info;
+      info.parent = reader.u8();
+      info.name = reader.str(STATE_SIZE - 1);
+      component.states.push_back(info);
+    }
+    trace.components.push_back(component);
+  }
+  for (uint16_t i = 0; i < recordCount; i++) {
+    if (!reader.has(sizeof(TraceRecord))) {
+      fprintf(stderr, "truncated at record %u\n", i);
+      return false;
+    }
+    TraceRecord record;
+    record.time = reader.u32();
+    record.sequence = reader.u16();
+    record.component = reader.u8();
+    record.event = reader.u8();
+    record.fromState = reader.u8();
+    record.toState = reader.u8();
+    record.flags = reader.u8();
+    record.reserved = reader.u8();
+    record.catchAngle = reader.i16();
+    record.catchTarget = reader.i16();
+    record.usbAngle = reader.i16();
+    record.usbTarget = reader.i16();
+    record.chargeCurrent = reader.i16();
+    record.servoCurrent = reader.i16();
+    trace.records.push_back(record);
+  }
+  return true;
+}
+
+/**
+ * @brief 制御の名前を親制御から順に連結して取得する
+ *
+ * @param trace トレース
+ * @param id 制御ID
+ * @return std::string 名前（例: ControlStartCharge/ControlArmInit）
+ */
+static std::string getPath(const Trace &trace, uint8_t id) {
+  if (id >= trace.components.size()) return "#" + std::to_string(id);
+  const ComponentInfo &component = trace.components[id];
+  if (component.parent == NO_COMPONENT) return component.name;
+  return getPath(trace, component.parent) + "/" + component.name;
+}
+
+/**
+ * @brief 状態名を取得する
+ *
+ * @param trace トレース
+ * @param id 制御ID
+ * @param state 状態
+ * @return std::string 状態名（遷移処理のみの遷移先は "-"）
+ */
+static std::string getStateName(const Trace &trace, uint8_t id,
+                                uint8_t state) {
+  if (state == StateMachineBase::NO_STATE) return "-";
+  if (id < trace.components.size() &&
+      state < trace.components[id].states.size()) {
+    return trace.components[id].states[state].name;
+  }
+  return "#" + std::to_string(state);
+}
+
+/**
+ * @brief イベント名を取得する
+ *
+ * @param event イベント
+ * @return std::string イベント名
+ */
+static std::string getEventName(uint8_t event) {
+  if (event == TRACE_EVENT_START) return "start";
+  if (event == TRACE_EVENT_RESET) return "reset";
+  if (event < sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0])) {
+    return EVENT_NAMES[event];
+  }
+  return "EVENT_" + std::to_string(event);
+}
+
+
+/**
+ * @brief 記録1件を時系列の1行として出力する
+ *
+ * @param trace トレース
+ * @param record 記録
+ * @param start 先頭の記録の時刻[us]
+ * @param time 記録の時刻（桁あふれを補正済み）[us]
+ * @param isCsv CSV形式で出力するかどうか
+ */
+static void print(const Trace &trace, const TraceRecord &record,
+                  uint64_t start, uint64_t time, bool isCsv) {
+  const char *format =
+      isCsv ? "%.3f,%u,%s,%s,%s,%s,%d,%.1f,%.1f,%.1f,%.1f,%.3f,%.3f\n"
+            : "%10.3f %5u %-36s %-13s %-16s -> %-16s fet=%d "
+              "catch=%.1f/%.1f usb=%.1f/%.1f I=%.3f Is=%.3f\n";
+  printf(format, (time - start) / 1000.0, record.sequence,
+         getPath(trace, record.component).c_str(),
+         getEventName(record.event).c_str(),
+         getStateName(trace, record.component, record.fromState).c_str(),
+         getStateName(trace, record.component, record.toState).c_str(),
+         (record.flags & TRACE_FLAG_FET_ON) != 0, record.catchAngle / 10.0,
+         record.catchTarget / 10.0, record.usbAngle / 10.0,
+         record.usbTarget / 10.0, record.chargeCurrent / 1000.0,
+         record.servoCurrent / 1000.0);
+}
+
+/**
+ * @brief 再生する制御と模擬したハードウェア
+ *
+ * @details ChargeControllerと同じ構成・順序で制御を生成する
+ */
+struct Station {
+  Station(const BayConfig &bay)
+      : servo(bay),
+        fet(bay.chargeControlPin),
+        current(NULL, bay.inaAddress, 0),
+        chargeTimer(),
+        startCharge(&servo, &fet, &current, &chargeTimer),
+        stopCharge(&servo, &fet, &current, &chargeTimer),
+        powerOnDrone(&servo, &fet, &current, &chargeTimer),
+        calibrate(&servo, &fet, &current, &chargeTimer),
+        checkServoCurrent(&servo, &fet, &current, bay) {}
+
+  ServoController servo;
+  FETController fet;
+  CurrentReader current;
+  Timer chargeTimer;
+  ControlStartCharge startCharge;
+  ControlStopCharge stopCharge;
+  ControlPowerOnDrone powerOnDrone;
+  ControlCalibrate calibrate;
+  CheckServoCurrent checkServoCurrent;
+};
+
+/**
+ * @brief 制御1つ分の再生
+ */
+struct Replay {
+  /** 再生する制御（NULLなら再生しない） */
+  ControlBase *control;
+  /** この制御の記録の添字（古い順） */
+  std::vector<size_t> records;
+  /** 次に照合する記録（recordsの添字） */
+  size_t next;
+  /** 最初の記録を再生したかどうか */
+  bool isStarted;
+  /** 遷移元・遷移先の不一致の数 */
+  uint32_t mismatchCount;
+  /** 記録にない遷移の数 */
+  uint32_t unexpectedCount;
+  /** 指示角度・MOSFETの状態の不一致の数 */
+  uint32_t divergenceCount;
+};
+
+/**
+ * @brief 記録を制御で再生し、起きた遷移を記録と照合するクラス
+ *
+ * @details 制御の状態機械の記録先として登録し、遷移のたびに同じ制御の
+ * 次の記録と照合する
+ */
+class Replayer : public TraceSink {
+ public:
+  Replayer(const Trace &, Station &, FILE *);
+  void setCount(uint8_t, uint8_t);
+  void run(bool);
+  void summarize(void);
+  void record(uint8_t, uint8_t, uint8_t, uint8_t) override;
+
+ private:
+  void _addControl(ControlBase *, const std::string &,
+                   std::map<std::string, ControlBase *> &);
+  void _replay(size_t);
+  void _start(ControlBase *);
+  bool _isReplayed(size_t);
+  void _reset(StateMachineBase *, uint8_t);
+  void _setInput(const TraceRecord &);
+  void _setOutput(Replay &, const TraceRecord &, bool);
+
+  /** 照合する記録の範囲（刺激の記録からの件数） */
+  static const size_t LOOKAHEAD = 16;
+
+  /** トレース */
+  const Trace &_trace;
+  /** 再生する制御 */
+  Station &_station;
+  /** 報告の出力先 */
+  FILE *_out;
+  /** 制御ごとの再生（制御IDの順） */
+  std::vector<Replay> _replays;
+  /** 記録の時刻（桁あふれを補正済み）[us] */
+  std::vector<uint64_t> _times;
+  /** 刺激として処理中の記録 */
+  size_t _index;
+  /** 記録との照合を止めているかどうか */
+  bool _isMuted;
+  /** 充電開始時の捕獲回数・リトライ回数を指定したかどうか */
+  bool _hasCount;
+  /** 充電開始時の捕獲回数 */
+  uint8_t _catchCnt;
+  /** 充電開始時のリトライ回数 */
+  uint8_t _retryCnt;
+};
+
+/**
+ * @brief Construct a new Replayer object
+ *
+ * @details トレースの制御と再生する制御を名前（親制御からの連結）で
+ * 対応付ける。状態数が異なる制御は再生しない
+ *
+ * @param trace トレース
+ * @param station 再生する制御
+ * @param out 報告の出力先
+ */
+Replayer::Replayer(const Trace &trace, Station &station, FILE *out)
+    : _trace(trace),
+      _station(station),
+      _out(out),
+      _replays(trace.components.size()),
+      _index(0),
+      _isMuted(false),
+      _hasCount(false),
+      _catchCnt(0),
+      _retryCnt(0) {
+  // TraceRecorderに登録する順（ChargeControllerのコンストラクタ参照）
+  std::map<std::string, ControlBase *> controls;
+  _addControl(&station.startCharge, "", controls);
+  _addControl(&station.stopCharge, "", controls);
+  _addControl(&station.powerOnDrone, "", controls);
+  _addControl(&station.calibrate, "", controls);
+  _addControl(&station.checkServoCurrent, "", controls);
+
+  for (uint8_t id = 0; id < _replays.size(); id++) {
+    Replay &replay = _replays[id];
+    replay.next = 0;
+    replay.isStarted = false;
+    replay.mismatchCount = 0;
+    replay.unexpectedCount = 0;
+    replay.divergenceCount = 0;
+    std::string path = getPath(trace, id);
+    std::map<std::string, ControlBase *>::iterator it = controls.find(path);
+    replay.control = it != controls.end() ? it->second : NULL;
+    if (replay.control == NULL) {
+      fprintf(out, "  ! %s: not found in firmware, not replayed\n",
+              path.c_str());
+      continue;
+    }
+    StateMachineBase *machine = replay.control->getStateMachine();
+    if (machine->getStateNum() != trace.components[id].states.size()) {
+      fprintf(out, "  ! %s: %u states in trace, %u in firmware, not replayed\n",
+              path.c_str(), (unsigned)trace.components[id].states.size(),
+              machine->getStateNum());
+      replay.control = NULL;
+      continue;
+    }
+    machine->setTrace(this, id);
+  }
+
+  uint64_t time = trace.records.empty() ? 0 : trace.records[0].time;
+  for (size_t i = 0; i < trace.records.size(); i++) {
+    const TraceRecord &record = trace.records[i];
+    // micros()は約71分で桁あふれするため、前の記録より戻った分を補正する
+    time += (uint32_t)(record.time - (uint32_t)time);
+    _times.push_back(time);
+    if (record.component < _replays.size()) {
+      _replays[record.component].records.push_back(i);
+    }
+  }
+}
+
+/**
+ * @brief 制御と子制御を名前で登録する
+ *
+ * @param control 制御
+ * @param parent 親制御の名前（最上位なら空）
+ * @param controls 登録先
+ */
+void Replayer::_addControl(ControlBase *control, const std::string &parent,
+                           std::map<std::string, ControlBase *> &controls) {
+  // メタデータの制御名は COMPONENT_SIZE - 2 文字で切り詰められる
+  std::string name = std::string(control->getName().c_str())
+                         .substr(0, COMPONENT_SIZE - 2);
+  std::string path = parent.empty() ? name : parent + "/" + name;
+  controls[path] = control;
+  for (uint8_t i = 0; i < control->getChildNum(); i++) {
+    _addControl(control->getChild(i), path, controls);
+  }
+}
+
+/**
+ * @brief 充電開始時の捕獲回数・リトライ回数を設定する
+ *
+ * @details 設定しなければControlStartCharge::start()の既定値とする
+ *
+ * @param catchCnt 捕獲繰り返し回数
+ * @param retryCnt USB接続するまでの動作をリトライする回数
+ */
+void Replayer::setCount(uint8_t catchCnt, uint8_t retryCnt) {
+  _hasCount = true;
+  _catchCnt = catchCnt;
+  _retryCnt = retryCnt;
+}
+
+/**
+ * @brief 全ての記録を古い順に出力・再生する
+ *
+ * @param isCsv CSV形式で出力するかどうか
+ */
+void Replayer::run(bool isCsv) {
+  if (_trace.records.empty()) return;
+  // 先頭の記録より前の指示角度・MOSFETの状態は分からないため記録に合わせる
+  _setInput(_trace.records[0]);
+  Replay initial = Replay();
+  _setOutput(initial, _trace.records[0], false);
+  for (size_t i = 0; i < _trace.records.size(); i++) {
+    const TraceRecord &record = _trace.records[i];
+    if (i > 0 && (uint16_t)(_trace.records[i - 1].sequence + 1) !=
+                     record.sequence) {
+      fprintf(_out, "  ! %u records lost before sequence %u\n",
+              (uint16_t)(record.sequence - _trace.records[i - 1].sequence -
+                         1),
+              record.sequence);
+    }
+    print(_trace, record, _times[0], _times[i], isCsv);
+    _replay(i);
+  }
+}
+
+/**
+ * @brief 記録1件を刺激として再生する
+ *
+ * @details 記録のイベントを発行して処理させ、記録の遷移先に遷移したかを
+ * 照合する。遷移しなかった場合は記録の遷移先に合わせる。
+ * EVENT_ENTEREDは遷移処理で、EVENT_TIMEOUTは滞在時間の経過で
+ * 状態機械が発行するため、未処理の場合のみEVENT_ENTEREDを発行する
+ *
+ * @param index 記録の添字
+ */
+void Replayer::_replay(size_t index) {
+  const TraceRecord &record = _trace.records[index];
+  if (record.component >= _replays.size() || _isReplayed(index)) return;
+  Replay &replay = _replays[record.component];
+  if (replay.control == NULL) return;
+  _index = index;
+  now = _times[index];
+  _setInput(record);
+
+  std::string path = getPath(_trace, record.component);
+  StateMachineBase *machine = replay.control->getStateMachine();
+  if (machine->getState() != record.fromState) {
+    // 記録開始前の遷移は不一致としない
+    if (replay.isStarted) {
+      replay.mismatchCount++;
+      fprintf(_out, "  ! %s: replayed state %s, recorded from %s\n",
+              path.c_str(),
+              getStateName(_trace, record.component, machine->getState())
+                  .c_str(),
+              getStateName(_trace, record.component, record.fromState)
+                  .c_str());
+    }
+    _reset(machine, record.fromState);
+  }
+  replay.isStarted = true;
+
+  if (record.event == TRACE_EVENT_START) {
+    _start(replay.control);
+  } else if (record.event == TRACE_EVENT_RESET) {
+    machine->reset(record.toState);
+  } else if (record.event != StateMachineBase::EVENT_ENTERED &&
+             record.event != StateMachineBase::EVENT_TIMEOUT) {
+    machine->post(record.event);
+  }
+  machine->dispatch();
+  if (!_isReplayed(index) && record.event == StateMachineBase::EVENT_ENTERED) {
+    machine->post(record.event);
+    machine->dispatch();
+  }
+  if (_isReplayed(index)) return;
+
+  replay.mismatchCount++;
+  fprintf(_out, "  ! %s: replay reached %s, recorded %s\n", path.c_str(),
+          getStateName(_trace, record.component, machine->getState()).c_str(),
+          getStateName(_trace, record.component, record.toState).c_str());
+  replay.next++;
+  _reset(machine, record.toState != StateMachineBase::NO_STATE
+                      ? record.toState
+                      : record.fromState);
+  _setOutput(replay, record, false);
+}
+
+/**
+ * @brief 制御を開始する
+ *
+ * @details ChargeControllerと同じく、引数や前処理を持つ制御はその
+ * start()を呼び出す（子制御は通常、親制御の遷移処理で開始される）
+ *
+ * @param control 制御
+ */
+void Replayer::_start(ControlBase *control) {
+  if (control == &_station.startCharge) {
+    if (_hasCount) {
+      _station.startCharge.start(_catchCnt, _retryCnt);
+    } else {
+      _station.startCharge.start();
+    }
+  } else if (control == &_station.calibrate) {
+    _station.calibrate.start();
+  } else {
+    control->start();
+  }
+}
+
+/**
+ * @brief 記録を再生（照合）済みかどうか
+ *
+ * @param index 記録の添字
+ * @return true 再生済み
+ * @return false 未処理
+ */
+bool Replayer::_isReplayed(size_t index) {
+  const Replay &replay = _replays[_trace.records[index].component];
+  return replay.next >= replay.records.size() ||
+         replay.records[replay.next] > index;
+}
+
+/**
+ * @brief 記録と照合せずに状態機械を指定した状態にする
+ *
+ * @param machine 状態機械
+ * @param state 状態
+ */
+void Replayer::_reset(StateMachineBase *machine, uint8_t state) {
+  _isMuted = true;
+  machine->reset(state);
+  _isMuted = false;
+}
+
+/**
+ * @brief 記録のサーボの現在角度・電流を入力として与える
+ *
+ * @param record 記録
+ */
+void Replayer::_setInput(const TraceRecord &record) {
+  setPresentAngle(_station.servo.servoCatch(), record.catchAngle / 10.0f);
+  setPresentAngle(_station.servo.servoUsb(), record.usbAngle / 10.0f);
+  setCurrent(&_station.current, record.chargeCurrent, record.servoCurrent);
+}
+
+/**
+ * @brief 指示角度・MOSFETの状態を記録と比較し、異なれば記録に合わせる
+ *
+ * @param replay 制御の再生
+ * @param record 記録
+ * @param isChecked 不一致を報告するかどうか
+ */
+void Replayer::_setOutput(Replay &replay, const TraceRecord &record,
+                          bool isChecked) {
+  ServoAxis *servoCatch = _station.servo.servoCatch();
+  ServoAxis *servoUsb = _station.servo.servoUsb();
+  float catchTarget = record.catchTarget / 10.0f;
+  float usbTarget = record.usbTarget / 10.0f;
+  bool isFetOn = (record.flags & TRACE_FLAG_FET_ON) != 0;
+  bool isCatchDiverged =
+      fabsf(servoCatch->getTargetAngle() - catchTarget) >
+      REPLAY_ANGLE_TOLERANCE;
+  bool isUsbDiverged =
+      fabsf(servoUsb->getTargetAngle() - usbTarget) > REPLAY_ANGLE_TOLERANCE;
+  bool isFetDiverged = _station.fet.read() != isFetOn;
+  if (!isCatchDiverged && !isUsbDiverged && !isFetDiverged) return;
+  if (isChecked) {
+    replay.divergenceCount++;
+    fprintf(_out,
+            "  ! %s: replayed catch=%.1f usb=%.1f fet=%d, "
+            "recorded catch=%.1f usb=%.1f fet=%d\n",
+            getPath(_trace, record.component).c_str(),
+            servoCatch->getTargetAngle(), servoUsb->getTargetAngle(),
+            _station.fet.read(), catchTarget, usbTarget, isFetOn);
+  }
+  if (isCatchDiverged) servoCatch->setTargetAngle(catchTarget);
+  if (isUsbDiverged) servoUsb->setTargetAngle(usbTarget);
+  if (isFetDiverged) isFetOn ? _station.fet.on() : _station.fet.off();
+}
+
+/**
+ * @brief 再生中の遷移を記録と照合する
+ *
+ * @details 同じ制御の次の記録と一致すれば、その記録の時刻・入力に進め、
+ * 遷移処理後の指示角度・MOSFETの状態を比較する
+ *
+ * @param component 制御ID
+ * @param event イベント
+ * @param fromState 遷移元の状態
+ * @param toState 遷移先の状態
+ */
+void Replayer::record(uint8_t component, uint8_t event, uint8_t fromState,
+                      uint8_t toState) {
+  if (_isMuted || component >= _replays.size()) return;
+  Replay &replay = _replays[component];
+  if (replay.next < replay.records.size()) {
+    size_t index = replay.records[replay.next];
+    const TraceRecord &record = _trace.records[index];
+    if (index < _index + LOOKAHEAD && record.event == event &&
+        record.fromState == fromState && record.toState == toState) {
+      replay.next++;
+      now = _times[index];
+      _setInput(record);
+      // reset()では遷移処理を行わないため、制御の外での操作として扱う
+      _setOutput(replay, record, event != TRACE_EVENT_RESET);
+      return;
+    }
+  }
+  replay.unexpectedCount++;
+  fprintf(_out, "  ! %s: unexpected %s %s -> %s\n",
+          getPath(_trace, component).c_str(), getEventName(event).c_str(),
+          getStateName(_trace, component, fromState).c_str(),
+          getStateName(_trace, component, toState).c_str());
+}
+
+/**
+ * @brief 再生結果（状態ごとの入場回数・滞在時間）を出力する
+ */
+void Replayer::summarize(void) {
+  uint32_t mismatchCount = 0;
+  uint32_t unexpectedCount = 0;
+  uint32_t divergenceCount = 0;
+  fprintf(_out, "\nreplay\n");
+  for (uint8_t id = 0; id < _replays.size(); id++) {
+    Replay &replay = _replays[id];
+    if (replay.control == NULL || !replay.isStarted) continue;
+    mismatchCount += replay.mismatchCount;
+    unexpectedCount += replay.unexpectedCount;
+    divergenceCount += replay.divergenceCount;
+    StateMachineBase *machine = replay.control->getStateMachine();
+    fprintf(_out,
+            "%s: records=%u mismatches=%u unexpected=%u diverged=%u "
+            "state=%s\n",
+            getPath(_trace, id).c_str(), (unsigned)replay.records.size(),
+            replay.mismatchCount, replay.unexpectedCount,
+            replay.divergenceCount,
+            getStateName(_trace, id, machine->getState()).c_str());
+    for (uint8_t state = 0; state < machine->getStateNum(); state++) {
+      if (machine->getEnterCount(state) == 0) continue;
+      fprintf(_out, "  %-18s enter=%u dwell=%ums max=%ums\n",
+              machine->getStateName(state), machine->getEnterCount(state),
+              machine->getDwellTime(state), machine->getMaxDwellTime(state));
+    }
+  }
+  fprintf(_out, "total: mismatches=%u unexpected=%u diverged=%u\n",
+          mismatchCount, unexpectedCount, divergenceCount);
+}
+
+/**
+ * @brief 校正角度を設定する
+ *
+ * @details 角度の大小関係を満たす順に設定する
+ *
+ * @param calibration 校正角度
+ * @param angles 名前と角度[deg]
+ * @return true 設定成功
+ * @return false 名前が不正、または大小関係を満たさない
+ */
+static bool setAngles(ServoCalibration *calibration,
+                      std::vector<std::pair<std::string, float> > angles) {
+  while (!angles.empty()) {
+    size_t count = angles.size();
+    for (size_t i = 0; i < angles.size();) {
+      bool isSet = false;
+      for (uint8_t type = 0; type < ServoCalibration::ANGLE_TYPE_NUM;
+           type++) {
+        ServoCalibration::ServoAngleType angleType =
+            (ServoCalibration::ServoAngleType)type;
+        if (angles[i].first == ServoCalibration::getName(angleType)) {
+          isSet = calibration->setAngle(angleType, angles[i].second);
+          break;
+        }
+      }
+      if (isSet) {
+        angles.erase(angles.begin() + i);
+      } else {
+        i++;
+      }
+    }
+    if (angles.size() == count) {
+      fprintf(stderr, "invalid angle %s=%.1f\n", angles[0].first.c_str(),
+              angles[0].second);
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const char *path = NULL;
+  bool isCsv = false;
+  int catchCnt = -1;
+  int retryCnt = -1;
+  int counts[2];
+  std::vector<std::pair<std::string, float> > angles;
+  for (int i = 1; i < argc; i++) {
+    const char *separator =
+        i + 1 < argc ? strchr(argv[i + 1], '=') : (const char *)NULL;
+    if (strcmp(argv[i], "--csv") == 0) {
+      isCsv = true;
+    } else if (strcmp(argv[i], "--log") == 0) {
+      logger.setEnabled(true);
+    } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc &&
+               sscanf(argv[i + 1], "%d/%d", &counts[0], &counts[1]) == 2) {
+      i++;
+      catchCnt = counts[0];
+      retryCnt = counts[1];
+    } else if (strcmp(argv[i], "--angle") == 0 && separator != NULL) {
+      i++;
+      angles.push_back(std::make_pair(
+          std::string(argv[i], separator - argv[i]), atof(separator + 1)));
+    } else if (path == NULL && argv[i][0] != '-') {
+      path = argv[i];
+    } else {
+      path = NULL;
+      break;
+    }
+  }
+  if (path == NULL) {
+    fprintf(stderr,
+            "usage: %s trace.bin [--csv] [--log] [--count CATCH/RETRY] "
+            "[--angle NAME=VALUE]...\n",
+            argv[0]);
+    return 2;
+  }
+  Trace trace;
+  if (!load(path, trace)) return 1;
+  FILE *out = isCsv ? stderr : stdout;
+
+  uint32_t lost = trace.totalCount - trace.records.size();
+  fprintf(out, "source=%s components=%u records=%u total=%u lost=%u\n",
+          trace.source == 1 ? "flash" : "ram",
+          (unsigned)trace.components.size(), (unsigned)trace.records.size(),
+          trace.totalCount, lost);
+  if (isCsv) {
+    printf("time_ms,sequence,component,event,from,to,fet,catch,catch_target,"
+           "usb,usb_target,charge_current,servo_current\n");
+  }
+
+  Station station(*BayConfig::get(0));
+  if (!setAngles(station.servo.calibration(), angles)) return 2;
+  Replayer replayer(trace, station, out);
+  if (catchCnt >= 0) replayer.setCount(catchCnt, retryCnt);
+  replayer.run(isCsv);
+  replayer.summarize();
+  return 0;
+}